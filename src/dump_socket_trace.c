@@ -0,0 +1,143 @@
+/* dump_socket_trace.c
+
+   2026 Oct 14
+
+   Print a trace of the commands the scheduler sent to the camera and
+   telescope controllers (see socket_trace.c): a line for each command
+   with the time it was sent (sec after the recording started), how long
+   the reply took, the port, what send_command() returned, the command
+   and the reply. Newlines in the command and reply are printed as \n.
+
+   With -s, print instead for each port and command (its first word)
+   the number sent, the mean and largest latency, and the number that
+   failed.
+
+   syntax: dump_socket_trace [-s] trace_file
+*/
+
+#include "scheduler.h"
+
+#define MAX_TRACE_COMMANDS 256 /* distinct port and first word pairs in the summary */
+#define TRACE_WORD_LEN 32
+
+typedef struct {
+    int port;
+    char word[TRACE_WORD_LEN];
+    int n;
+    int n_failed;
+    double latency_sum;
+    double latency_max;
+} Trace_Command_Stats;
+
+Trace_Command_Stats stats[MAX_TRACE_COMMANDS];
+int num_stats=0;
+
+/************************************************************/
+
+static void print_escaped(char *s, FILE *output)
+{
+    for(;*s!=0;s++){
+       if(*s=='\n')fprintf(output,"\\n");
+       else if(*s=='\r')fprintf(output,"\\r");
+       else fputc(*s,output);
+    }
+}
+
+/************************************************************/
+
+static void add_stats(Socket_Trace_Record *r, char *command)
+{
+    Trace_Command_Stats *c;
+    int i,len;
+
+    len=strcspn(command," \n\r");
+    if(len>TRACE_WORD_LEN-1)len=TRACE_WORD_LEN-1;
+
+    for(i=0;i<num_stats;i++){
+       if(stats[i].port==r->port&&strncmp(stats[i].word,command,len)==0&&
+          stats[i].word[len]==0)break;
+    }
+    if(i==num_stats){
+       if(num_stats>=MAX_TRACE_COMMANDS)return;
+       c=stats+num_stats++;
+       memset((void *)c,0,sizeof(Trace_Command_Stats));
+       c->port=r->port;
+       strncpy(c->word,command,len);
+       c->word[len]=0;
+    }
+
+    c=stats+i;
+    c->n++;
+    if(r->status!=0)c->n_failed++;
+    c->latency_sum+=r->latency;
+    if(r->latency>c->latency_max)c->latency_max=r->latency;
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    FILE *input;
+    Socket_Trace_Header header;
+    Socket_Trace_Record r;
+    char command[MAXBUFSIZE],reply[MAXBUFSIZE];
+    int i,summary,result;
+    long n;
+    double t_last;
+
+    summary=0;
+    if(argc==3&&strcmp(argv[1],"-s")==0){
+       summary=1;
+    }
+    else if(argc!=2){
+       fprintf(stderr,"syntax: dump_socket_trace [-s] trace_file\n");
+       exit(-1);
+    }
+
+    input=fopen(argv[argc-1],"r");
+    if(input==NULL){
+       fprintf(stderr,"dump_socket_trace: can't open %s\n",argv[argc-1]);
+       exit(-1);
+    }
+
+    if(read_socket_trace_header(input,&header)!=0){
+       fprintf(stderr,"dump_socket_trace: %s is not a socket trace of this version\n",argv[argc-1]);
+       exit(-1);
+    }
+
+    fprintf(stdout,"# trace started at unix time %.3f\n",header.t_start);
+
+    n=0;
+    t_last=0.0;
+    while((result=read_socket_trace_record(input,&r,command,reply,MAXBUFSIZE))==0){
+       n++;
+       t_last=r.t_send;
+       if(summary){
+          add_stats(&r,command);
+          continue;
+       }
+       fprintf(stdout,"%12.6f %9.6f %5d %2d ",r.t_send,r.latency,r.port,r.status);
+       print_escaped(command,stdout);
+       fprintf(stdout," | ");
+       print_escaped(reply,stdout);
+       fprintf(stdout,"\n");
+    }
+    if(result<0){
+       fprintf(stderr,"dump_socket_trace: %s ends in a partial record\n",argv[argc-1]);
+    }
+
+    if(summary){
+       fprintf(stdout,"# %ld commands over %.3f h\n",n,t_last/3600.0);
+       fprintf(stdout,"# port command              n  failed  mean_latency  max_latency (sec)\n");
+       for(i=0;i<num_stats;i++){
+          fprintf(stdout,"%6d %-16s %8d %7d  %12.6f %12.6f\n",stats[i].port,stats[i].word,
+             stats[i].n,stats[i].n_failed,stats[i].latency_sum/stats[i].n,stats[i].latency_max);
+       }
+    }
+
+    fclose(input);
+
+    exit(0);
+}
+
+/************************************************************/
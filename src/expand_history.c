@@ -0,0 +1,222 @@
+/* expand_history.c
+
+   2026 Oct 14
+
+   Print a survey history written by write_history() (see
+   scheduler_history.c) in the format of print_history(): for each
+   record, the jd less HISTORY_JD_OFFSET and a character for each field,
+
+      "n" : n observations done (the number, if 10 or more)
+      "." : completed
+
+   Lines already in that format are printed as they are. Delta records
+   before the first snapshot can't be expanded, and are skipped. With
+   -c only the last record (the current state) is printed.
+
+   syntax: expand_history [-c] [history_file]
+
+   where history_file is HISTORY_FILE by default, and "-" is the
+   standard input.
+*/
+
+#include "scheduler.h"
+
+/************************************************************/
+
+/* make room for num_fields in n_done and n_required. Return 0, or -1 on
+   error */
+
+static int grow_fields(int num_fields, int *max_fields, int **n_done, int **n_required)
+{
+    int n;
+
+    if(num_fields<=*max_fields)return(0);
+
+    n=*max_fields>0 ? *max_fields : 1024;
+    while(n<num_fields)n=2*n;
+
+    *n_done=(int *)realloc(*n_done,n*sizeof(int));
+    *n_required=(int *)realloc(*n_required,n*sizeof(int));
+    if(*n_done==NULL||*n_required==NULL){
+       fprintf(stderr,"expand_history: can't allocate %d fields\n",n);
+       fflush(stderr);
+       return(-1);
+    }
+    memset((void *)(*n_done+*max_fields),0,(n-*max_fields)*sizeof(int));
+    memset((void *)(*n_required+*max_fields),0,(n-*max_fields)*sizeof(int));
+    *max_fields=n;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* print the state of the fields as print_history() does */
+
+static void print_expanded(double jd, int num_fields, int *n_done, int *n_required,
+        FILE *output)
+{
+    int i;
+
+    fprintf(output,"%12.6f ",jd);
+    for(i=0;i<num_fields;i++){
+       if(n_done[i]==n_required[i]){
+          fputc('.',output);
+       }
+       else if(n_done[i]>=0&&n_done[i]<10){
+          fputc('0'+n_done[i],output);
+       }
+       else{
+          fprintf(output,"%d",n_done[i]);
+       }
+    }
+    fprintf(output,"\n");
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    FILE *input;
+    char *file_name,*line,*s,*end,*last_line;
+    size_t line_size,last_size;
+    double jd;
+    int i,j,n,num_fields,max_fields,current_only,have_snapshot,last_is_text;
+    int n_records,n_skipped,n_bad;
+    int *n_done,*n_required;
+
+    current_only=0;
+    file_name=HISTORY_FILE;
+    for(i=1;i<argc;i++){
+       if(strcmp(argv[i],"-c")==0)current_only=1;
+       else if(argv[i][0]=='-'&&argv[i][1]!=0){
+          fprintf(stderr,"syntax: expand_history [-c] [history_file]\n");
+          exit(-1);
+       }
+       else file_name=argv[i];
+    }
+
+    if(strcmp(file_name,"-")==0){
+       input=stdin;
+    }
+    else{
+       input=fopen(file_name,"r");
+       if(input==NULL){
+          fprintf(stderr,"expand_history: can't open file %s\n",file_name);
+          exit(-1);
+       }
+    }
+
+    line=NULL;
+    line_size=0;
+    last_line=NULL;
+    last_size=0;
+    last_is_text=0;
+    n_done=NULL;
+    n_required=NULL;
+    max_fields=0;
+    num_fields=0;
+    have_snapshot=0;
+    jd=0.0;
+    n_records=0;
+    n_skipped=0;
+    n_bad=0;
+
+    while(getline(&line,&line_size,input)>=0){
+
+       /* a line of the old format */
+
+       if(line[0]!=HISTORY_SNAPSHOT_CODE&&line[0]!=HISTORY_DELTA_CODE){
+          if(line[0]=='\n'||line[0]==0)continue;
+          if(current_only){
+             if(last_size<line_size){
+                last_size=line_size;
+                last_line=(char *)realloc(last_line,last_size);
+                if(last_line==NULL)exit(-1);
+             }
+             strcpy(last_line,line);
+             last_is_text=1;
+          }
+          else{
+             fputs(line,stdout);
+          }
+          n_records++;
+          continue;
+       }
+
+       if(line[0]==HISTORY_DELTA_CODE&&!have_snapshot){
+          n_skipped++;
+          continue;
+       }
+
+       s=line+1;
+       jd=strtod(s,&end);
+       if(end==s){
+          n_bad++;
+          continue;
+       }
+       s=end;
+       n=(int)strtol(s,&end,10);
+       if(end==s||n<0){
+          n_bad++;
+          continue;
+       }
+       s=end;
+       if(grow_fields(n,&max_fields,&n_done,&n_required)!=0)exit(-1);
+
+       if(line[0]==HISTORY_SNAPSHOT_CODE){
+          for(i=0;i<n;i++){
+             n_done[i]=(int)strtol(s,&end,10);
+             if(*end!='/')break;
+             s=end+1;
+             n_required[i]=(int)strtol(s,&end,10);
+             s=end;
+          }
+          if(i<n){
+             n_bad++;
+             continue;
+          }
+          have_snapshot=1;
+       }
+       else{
+          while(1){
+             j=(int)strtol(s,&end,10);
+             if(end==s||*end!=':')break;
+             s=end+1;
+             if(j<0||j>=n)break;
+             n_done[j]=(int)strtol(s,&end,10);
+             s=end;
+             if(*s=='/'){
+                s++;
+                n_required[j]=(int)strtol(s,&end,10);
+                s=end;
+             }
+          }
+       }
+       num_fields=n;
+       n_records++;
+
+       if(current_only)last_is_text=0;
+       else print_expanded(jd,num_fields,n_done,n_required,stdout);
+    }
+
+    if(current_only&&n_records>0){
+       if(last_is_text)fputs(last_line,stdout);
+       else print_expanded(jd,num_fields,n_done,n_required,stdout);
+    }
+
+    if(n_skipped>0||n_bad>0){
+       fprintf(stderr,"expand_history: %d delta records before the first snapshot skipped, %d bad records\n",
+          n_skipped,n_bad);
+    }
+
+    if(input!=stdin)fclose(input);
+    free(line);
+    free(last_line);
+    free(n_done);
+    free(n_required);
+
+    exit(0);
+}
+
+/************************************************************/
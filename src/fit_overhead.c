@@ -0,0 +1,54 @@
+/* fit_overhead.c
+
+   2026 Oct 14
+
+   Fit the overhead model (see scheduler_overhead.c) to the phase
+   timings of past nights, and write it where the scheduler reads it
+   at startup.
+
+   syntax: fit_overhead model_file metrics_file [metrics_file ...]
+
+   where each metrics_file is a METRICS_FILE written by the scheduler
+   and model_file is usually OVERHEAD_MODEL_FILE. Terms with fewer
+   than OVERHEAD_MIN_FIT observations keep their fixed defaults.
+*/
+
+#include "scheduler.h"
+
+extern int verbose;
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    Overhead_Model m;
+    FILE *output;
+    int n;
+
+    if(argc<3){
+       fprintf(stderr,"syntax: fit_overhead model_file metrics_file [metrics_file ...]\n");
+       exit(-1);
+    }
+
+    n=fit_overhead_model(argc-2,argv+2,&m);
+    if(n<0){
+       fprintf(stderr,"fit_overhead: can't fit the overhead model\n");
+       exit(-1);
+    }
+    if(n==0){
+       fprintf(stderr,"fit_overhead: no observations to fit\n");
+       exit(-1);
+    }
+
+    output=fopen(argv[1],"w");
+    if(output==NULL){
+       fprintf(stderr,"fit_overhead: can't open file %s for output\n",argv[1]);
+       exit(-1);
+    }
+    write_overhead_model(output,&m);
+    fclose(output);
+
+    write_overhead_model(stderr,&m);
+
+    exit(0);
+}
@@ -4,17 +4,21 @@
    determine number of obs, min_gap, max_gap, and mean_gap per
    field
 
+   2026 Oct 14: fields are the distinct positions in the log, found
+   with a sky index (sky_index.c) in place of a fixed RA_INCR by
+   DEC_INCR grid, so logs of any tiling and length can be read.
+   Observations within match_radius (deg, FIELD_MATCH_DEG by default)
+   of a field are of that field.
+
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sky_index.h"
 
-#define MAX_GRID_POINTS 10000
-#define RA1 0.0
-#define RA2 360.0
-#define DEC1 -90.0
-#define DEC2 90.0
-#define RA_INCR 4.0
-#define DEC_INCR 4.5
+#define FIELD_MATCH_DEG 0.1 /* default match_radius (deg) */
+#define MIN_FIELDS 1024 /* fields allocated to start */
 
 
 #define RA_STEP0 0.0333 /* hours = 0.5 deg. Spacing between fingers */
@@ -44,67 +48,43 @@ double sne_gap_max; /* maximum gap (days) for sne detection */
 double fom_table[MAX_GAP_COUNT+1];
 int max_fom_gap;
 
+double match_radius=FIELD_MATCH_DEG;
+Sky_Index sky;
+
 int init_fom_lookup_table(double *fom_table);
 double get_fom(double gap);
-int read_fields(char *log_file, Field *f, int *count);
-Field *field_pointer(Field *f, double ra, double dec);
-int print_field_counts(char *file, Field *field, int n_grid_points);
+int read_fields(char *log_file, Field **f, int *count);
+Field *field_pointer(Field **f, int *n_fields, int *max_fields, double ra, double dec);
+int print_field_counts(char *file, Field *field, int n_fields);
 
 /*************************************************************/
 
-main(int argc, char **argv)
+int main(int argc, char **argv)
 {
     Field *field;
-    int n_grid_points;
-    int i,j,n_fields;
+    int i,n_fields;
     int gap_count[MAX_GAP_COUNT+1];
 
-    if(argc!=5){
-       fprintf(stderr,"syntax:get_time_gaps log_file output sne_gap_min sne_gap_max\n");
+    if(argc!=5&&argc!=6){
+       fprintf(stderr,"syntax:get_time_gaps log_file output sne_gap_min sne_gap_max [match_radius]\n");
        exit(-1);
     }
 
     sscanf(argv[3],"%lf",&sne_gap_min);
     sscanf(argv[4],"%lf",&sne_gap_max);
+    if(argc==6)sscanf(argv[5],"%lf",&match_radius);
 
     max_fom_gap=init_fom_lookup_table(fom_table);
 
-    /*n_grid_points=2*(1+(RA2-RA1)/RA_INCR)*(1+(DEC2-DEC1)/DEC_INCR);*/
-    n_grid_points=2*(1+(360.0)/RA_INCR)*(1+(180.0)/DEC_INCR);
-    if(n_grid_points>MAX_GRID_POINTS){
-      fprintf(stderr,"too many grid points\n");
-      exit(-1);
-    }
-          
-                                                                                
-    field=(Field *)malloc(n_grid_points*sizeof(Field));
-    if(field==NULL){
-        fprintf(stderr,"can't allocate field_grid memory\n");
+    if(init_sky_index(&sky,SKY_INDEX_BIN_DEG)!=0){
+        fprintf(stderr,"can't allocate sky index\n");
         exit(-1);
     }
-    if(verbose){
-      fprintf(stderr,"%d grid points allocated\n",n_grid_points);
-    }
-
-    for(i=0;i<n_grid_points;i++){
-           field[i].n_obs=0;
-           field[i].jd=0.0;
-           field[i].n_tno_gaps=0;
-           field[i].n_sne_gaps=0;
-	   field[i].jd_first=0.0;
-	   field[i].jd_last=0.0;
-	   field[i].n_tno_gaps=0;
-	   field[i].n_sne_gaps=0;
-	   field[i].fom=0.0;
-           for(j=0;j<MAX_GAP_COUNT;j++){
-               field[i].gap_count[j]=0;
-           }
-    }
-
 
     for(i=0;i<=MAX_GAP_COUNT;i++)gap_count[i]=0;
 
-    n_fields=read_fields(argv[1],field,gap_count);
+    field=NULL;
+    n_fields=read_fields(argv[1],&field,gap_count);
     if(n_fields<=0){
         fprintf(stderr,"error reading fields\n");
         exit(-1);
@@ -117,15 +97,16 @@ main(int argc, char **argv)
       printf("%03d %d\n",i,gap_count[i]);
     }
 
-    print_field_counts(argv[2],field, n_grid_points);
+    print_field_counts(argv[2],field, n_fields);
 
     free(field);
+    free_sky_index(&sky);
 
     exit(0);
 }
 /*************************************************************/
 
-int print_field_counts(char *file, Field *field, int n_grid_points)
+int print_field_counts(char *file, Field *field, int n_fields)
 {
     FILE *output;
     Field *f;
@@ -143,7 +124,7 @@ int print_field_counts(char *file, Field *field, int n_grid_points)
     n_tno_fields=0;
     n_sne_fields=0;
     total_fom=0.0;
-    for(i=0;i<=n_grid_points;i++){
+    for(i=0;i<n_fields;i++){
           f=field+i;
           if(f->n_obs>0){
              fprintf(output,
@@ -173,7 +154,10 @@ int print_field_counts(char *file, Field *field, int n_grid_points)
 
 /*************************************************************/
 
-int read_fields(char *file, Field *field, int *gap_count)
+/* read the fields observed in file into *field (allocated here).
+   Return the number of fields, or -1 on error */
+
+int read_fields(char *file, Field **field, int *gap_count)
 {
     FILE *input;
     int i;
@@ -181,7 +165,7 @@ int read_fields(char *file, Field *field, int *gap_count)
     Field *f;
     double ra,dec,jd,dt;
     char s[256],shutter_flag[2];
-    int n,p;
+    int n,p,max_fields;
 
     input=fopen(file,"r");
     if(input==NULL){
@@ -193,6 +177,7 @@ int read_fields(char *file, Field *field, int *gap_count)
 
  
     n=0;
+    max_fields=0;
     while(fgets(string,1024,input)!=NULL){
         if(strstr(string,"y")!=NULL){
             sscanf(string,"%lf %lf %s %s %s %s %lf",
@@ -201,11 +186,14 @@ int read_fields(char *file, Field *field, int *gap_count)
                
             ra=ra*15.0;
 
-            f=field_pointer(field,ra,dec);
-            
+            f=field_pointer(field,&n,&max_fields,ra,dec);
+            if(f==NULL){
+               fclose(input);
+               return(-1);
+            }
 
             if(f->n_obs==0){
-               n++;
+               dt=0.0;
                f->jd_first=jd;
  	       f->ra=ra;
                f->dec=dec;
@@ -241,7 +229,7 @@ int read_fields(char *file, Field *field, int *gap_count)
 	    f->jd_last=jd;
 
             printf("field %03d  %010.6f %010.6f %07.3f %03d %03d %03d\n",
-                   (int)(f-field),f->ra,f->dec,f->jd-f->jd_first,
+                   (int)(f-*field),f->ra,f->dec,f->jd-f->jd_first,
                    f->n_obs,f->n_tno_gaps,f->n_sne_gaps);
            
         }
@@ -254,27 +242,35 @@ int read_fields(char *file, Field *field, int *gap_count)
 
 /*************************************************************/
 
-Field *field_pointer(Field *f, double ra, double dec)
-{
-    int i,i1,j,n_ra;
-    double ra1;
-
-    ra=ra+0.01;
-    
-    n_ra=360.0/RA_INCR;
-    n_ra=n_ra*2;
-
-    i=ra/RA_INCR;
-    i1=i*2;
+/* return the field of *field at ra, dec (deg), adding a new one to
+   the *n_fields if none is within match_radius. *field grows as
+   needed. Return NULL if out of memory */
 
+Field *field_pointer(Field **field, int *n_fields, int *max_fields, double ra, double dec)
+{
+    Field *f;
+    int i;
 
-    if((i*RA_INCR)+0.03<ra)i1++;
+    i=find_sky_index(&sky,ra,dec,match_radius);
+    if(i>=0)return(*field+i);
+
+    if(*n_fields==*max_fields){
+       *max_fields=(*max_fields==0) ? MIN_FIELDS : 2*(*max_fields);
+       f=(Field *)realloc(*field,(*max_fields)*sizeof(Field));
+       if(f==NULL){
+          fprintf(stderr,"can't allocate %d fields\n",*max_fields);
+          return(NULL);
+       }
+       *field=f;
+    }
 
- 
+    if(add_sky_index(&sky,ra,dec,*n_fields)!=0)return(NULL);
 
-    j=(dec+90.0)/DEC_INCR;
+    f=*field+(*n_fields);
+    memset((void *)f,0,sizeof(Field));
+    (*n_fields)++;
 
-    return(f+(j*n_ra)+i1);
+    return(f);
 }
 
 /*************************************************************/
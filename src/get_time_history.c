@@ -3,29 +3,48 @@
    read time-sorted log files and determine
    time-gap distribution for SNE fields
 
+   2026 Oct 14: the log may be a text log or a binary observation log
+   (obs_log.c). Observations are matched to fields by position with a
+   sky index (sky_index.c), so logs of any tiling and of sequences with
+   different field numbers can be read together, and the jds of each
+   field are kept in one array in place of a fixed 1000 for each of
+   5000 fields.
 */
 
-#include <stdio.h>
-#include <string.h>
+#include "scheduler.h"
+#include "sky_index.h"
 
-#define MAX_OBS_PER_FIELD 1000
-#define MAX_FIELDS 5000
-#define MAX_INTERVAL 100
+#define MAX_GAP_DAYS 100 /* longest gap (days) between observations counted */
+#define FIELD_MATCH_DEG 0.1 /* observations this close (deg) are of one field */
 
 typedef struct {
-   int index;
    int n_obs; 
-   double jd[MAX_OBS_PER_FIELD];
-} Field;
+   double *jd; /* n_obs jds, in time order */
+} Field_Obs;
 
-main(int argc, char **argv)
+/* an exposure counted */
+
+typedef struct {
+   int field;
+   double jd;
+} Obs;
+
+Sky_Index sky;
+int n_fields_found=0;
+Obs *obs=NULL;
+int n_obs=0,max_obs=0;
+
+int add_obs(double ra, double dec, double jd);
+int read_text_log(char *file);
+int read_binary_log(char *file);
+
+int main(int argc, char **argv)
 {
-   Field *f;
-   FILE *input;
+   Field_Obs *f;
+   double *jd_all;
    int i, j, n_fields,index,count5;
-   char string[1024],s[256];
-   double jd0,jd,expt;
-   int count[MAX_INTERVAL],dt,dt_max;
+   double jd0;
+   int count[MAX_GAP_DAYS],dt,dt_max;
    int n_one_nighters,n_total,integral;
 
    if(argc!=3){
@@ -34,64 +53,47 @@ main(int argc, char **argv)
    }
 
    sscanf(argv[2],"%lf",&jd0);
-   input=fopen(argv[1],"r");
-   if(input==NULL){
-       fprintf(stderr,"can't open file %s for input\n",argv[1]);
-       exit(-1);
+
+   if(init_sky_index(&sky,SKY_INDEX_BIN_DEG)!=0)exit(-1);
+
+   if(is_obs_log(argv[1])){
+      if(read_binary_log(argv[1])<0)exit(-1);
+   }
+   else if(read_text_log(argv[1])<0){
+      exit(-1);
    }
 
-   f=(Field *)malloc(MAX_FIELDS*sizeof(Field));
-   if(f==NULL){
+   /* put the jds of each field together */
+
+   f=(Field_Obs *)calloc(n_fields_found+1,sizeof(Field_Obs));
+   jd_all=(double *)malloc((n_obs+1)*sizeof(double));
+   if(f==NULL||jd_all==NULL){
       fprintf(stderr,"could not get memory for Fields\n");
       exit(-1);
    }
 
-   for(i=0;i<MAX_FIELDS;i++){f[i].n_obs=0;}
-   n_total=0;
+   for(i=0;i<n_obs;i++)f[obs[i].field].n_obs++;
+   for(index=0,j=0;index<n_fields_found;index++){
+      f[index].jd=jd_all+j;
+      j=j+f[index].n_obs;
+      f[index].n_obs=0;
+   }
 
-   while(fgets(string,1024,input)!=NULL){
-/*
-13.359190  13.626470 s 2   60.0  10.646 2454207.943576  60.250 20070417103845s # sky 15 2 2800
-2.733350   9.084310 s 2   60.0   2.149 2455467.880706  60.160 20100928090813s # sky 179 2548
-*/
-     sscanf(string,"%s %s %s %s %lf %s %lf %s %s %s %s %s %s %d",
-	s,s,s,s,&expt,s,&jd,s,s,s,s,s,s,&index);
-#if 0
-      if(strstr(string,"track")==NULL&&strstr(string,"TNO")==NULL&&(expt==60.0||expt==240.0||expt==80.0)){
-        if(index<0 || index>MAX_FIELDS){
-           fprintf(stderr,"index %d out of range\n",index);
-           exit(-1);
-        }
-        if(f[index].n_obs==MAX_OBS_PER_FIELD){
-           fprintf(stderr,"too many obs of field %d\n",index);
-           fprintf(stderr,"%s\n",string);
-           exit(-1);
-        }
-        f[index].jd[f[index].n_obs]=jd;
-        f[index].n_obs=f[index].n_obs+1;
-        if(jd>jd0)n_total++;
-      }
-#else
-      if(strstr(string,"track")==NULL&&strstr(string,"TNO")==NULL&&(expt==60.0||expt==240.0||expt==80.0)&&index>0&&index<=MAX_FIELDS){
-        if(f[index].n_obs==MAX_OBS_PER_FIELD){
-           fprintf(stderr,"too many obs of field %d\n",index);
-           exit(-1);
-        }
-        f[index].jd[f[index].n_obs]=jd;
-        f[index].n_obs=f[index].n_obs+1;
-        if(jd>jd0)n_total++;
-      }
-#endif
+   n_total=0;
+   for(i=0;i<n_obs;i++){
+      index=obs[i].field;
+      f[index].jd[f[index].n_obs]=obs[i].jd;
+      f[index].n_obs=f[index].n_obs+1;
+      if(obs[i].jd>jd0)n_total++;
    }
 
-   fclose(input);
-   for(i=0;i<MAX_INTERVAL;i++){count[i]=0;}
+   for(i=0;i<MAX_GAP_DAYS;i++){count[i]=0;}
 
    n_one_nighters=0;
    n_fields=0;
    count5=0;
    integral = 0;
-   for(i=0;i<MAX_FIELDS;i++){
+   for(i=0;i<n_fields_found;i++){
         if(f[i].n_obs==1&&f[i].jd[0]>=jd0){
             count[0]=count[0]+1;
 	    n_fields++;
@@ -115,7 +117,7 @@ main(int argc, char **argv)
                  else if (dt > 1 ){
                     integral=integral + dt;
                  }
-                 else if(dt<0||dt>MAX_INTERVAL){
+                 else if(dt<0||dt>MAX_GAP_DAYS){
                       fprintf(stderr,"dt %d out of range\n",dt);
                       exit(-1);
                  }
@@ -131,14 +133,120 @@ main(int argc, char **argv)
               n_total, n_fields,n_one_nighters,count5,integral);
 
 /*
-    for(i=0;i<MAX_INTERVAL;i++){
+    for(i=0;i<MAX_GAP_DAYS;i++){
       printf("%d %d\n",i,count[i]);
     }
 */
+    free(jd_all);
     free(f);
+    free(obs);
+    free_sky_index(&sky);
   
     exit(0);
 }
+/*************************************************************/
+
+/* count an exposure at ra, dec (deg) at jd, of the field at that
+   position (a new field if there is none yet) */
+
+int add_obs(double ra, double dec, double jd)
+{
+   Obs *o;
+   int id;
+
+   id=find_sky_index(&sky,ra,dec,FIELD_MATCH_DEG);
+   if(id<0){
+      id=n_fields_found;
+      if(add_sky_index(&sky,ra,dec,id)!=0)return(-1);
+      n_fields_found++;
+   }
+
+   if(n_obs==max_obs){
+      max_obs=(max_obs==0) ? 1024 : 2*max_obs;
+      o=(Obs *)realloc(obs,max_obs*sizeof(Obs));
+      if(o==NULL){
+         fprintf(stderr,"could not get memory for %d observations\n",max_obs);
+         return(-1);
+      }
+      obs=o;
+   }
+   obs[n_obs].field=id;
+   obs[n_obs].jd=jd;
+   n_obs++;
+
+   return(0);
+}
+
+/*************************************************************/
+
+/* count the survey exposures of 60, 240 or 80 sec that are not TNO
+   fields. Return the number counted, or -1 on error */
+
+int read_text_log(char *file)
+{
+   FILE *input;
+   char string[1024],s[256];
+   double ra,dec,jd,expt;
+   int n;
+
+   input=fopen(file,"r");
+   if(input==NULL){
+       fprintf(stderr,"can't open file %s for input\n",file);
+       return(-1);
+   }
+
+   n=0;
+   while(fgets(string,1024,input)!=NULL){
+/*
+13.359190  13.626470 s 2   60.0  10.646 2454207.943576  60.250 20070417103845s # sky 15 2 2800
+2.733350   9.084310 s 2   60.0   2.149 2455467.880706  60.160 20100928090813s # sky 179 2548
+*/
+      if(sscanf(string,"%lf %lf %s %s %lf %s %lf",&ra,&dec,s,s,&expt,s,&jd)!=7)continue;
+      if(strstr(string,"track")==NULL&&strstr(string,"TNO")==NULL&&(expt==60.0||expt==240.0||expt==80.0)){
+        if(add_obs(15.0*ra,dec,jd)!=0){
+           fclose(input);
+           return(-1);
+        }
+        n++;
+      }
+   }
+
+   fclose(input);
+
+   return(n);
+}
+
+/*************************************************************/
+
+/* as read_text_log(), from a binary observation log */
+
+int read_binary_log(char *file)
+{
+   Obs_Log_Map log;
+   Obs_Log_Columns c;
+   int i,k,n;
+
+   if(map_obs_log(file,&log)<0)return(-1);
+
+   n=0;
+   for(i=0;obs_log_columns(&log,i,&c)>0;i++){
+      for(k=0;k<c.n;k++){
+         if(c.shutter[k]==SKY_CODE&&c.survey_code[k]!=TNO_SURVEY_CODE&&
+            (c.expt[k]==60.0||c.expt[k]==240.0||c.expt[k]==80.0)){
+            if(add_obs(15.0*c.ra[k],c.dec[k],c.jd[k])!=0){
+               unmap_obs_log(&log);
+               return(-1);
+            }
+            n++;
+         }
+      }
+   }
+
+   unmap_obs_log(&log);
+
+   return(n);
+}
+
   
 
 
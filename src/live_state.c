@@ -0,0 +1,226 @@
+/* live_state.c
+
+   2026 Oct 14
+
+   Publishing the live state of the scheduler to shared memory.
+
+   Monitors used to follow the scheduler by re-reading growing text
+   files (the logs, and survey.hist written by write_history()). Here
+   the scheduler keeps a POSIX shared memory segment, LIVE_STATE_NAME,
+   holding a Live_State_Header (the last selection, whether it is
+   paused or in bad weather, and the telescope and camera status)
+   followed by a Live_Field for each field, and rewrites it with
+   publish_live_state() at each pass of the main loop and after each
+   observation. The segment is read-only to everyone but the scheduler,
+   and readers never take a lock, so they can poll it as fast as they
+   like without slowing the scheduler down.
+
+   The header's seq is a seqlock. The writer makes it odd, changes the
+   segment, and makes it even again; a reader copies the segment
+   between two reads of seq and keeps the copy only if they match and
+   are even (read_live_state() in live_state_client.c). If the fields
+   outgrow the segment it is enlarged, and readers remap it when they
+   see the new size.
+*/
+
+#include "scheduler.h"
+#include "live_state.h"
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+extern int verbose;
+
+int open_live_state(char *name, Live_State *s);
+int publish_live_state(Live_State *s, Field *sequence, int num_fields,
+        int last_field, double jd, int paused, int bad_weather,
+        Telescope_Status *tel_status, Camera_Status *cam_status);
+void close_live_state(Live_State *s);
+
+/************************************************************/
+
+static size_t live_state_size(int max_fields)
+{
+    return(sizeof(Live_State_Header)+max_fields*sizeof(Live_Field));
+}
+
+/************************************************************/
+
+/* size the segment of s for max_fields fields and map it. Return 0, or
+   -1 on error */
+
+static int map_live_state(Live_State *s, int max_fields)
+{
+    size_t size;
+    char *base;
+
+    size=live_state_size(max_fields);
+    if(ftruncate(s->fd,size)!=0){
+       fprintf(stderr,"map_live_state: can't size segment to %ld bytes\n",(long)size);
+       fflush(stderr);
+       return(-1);
+    }
+
+    base=(char *)mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,s->fd,0);
+    if(base==MAP_FAILED){
+       fprintf(stderr,"map_live_state: can't map segment\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    if(s->base!=NULL)munmap(s->base,s->size);
+    s->base=base;
+    s->size=size;
+    s->header=(Live_State_Header *)base;
+    s->fields=(Live_Field *)(base+sizeof(Live_State_Header));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Create (or take over) the segment name and set s up to publish to
+   it. Return 0, or -1 on error, in which case s publishes nothing */
+
+int open_live_state(char *name, Live_State *s)
+{
+    struct stat st;
+    int max_fields;
+
+    memset((void *)s,0,sizeof(Live_State));
+    s->fd=shm_open(name,O_RDWR|O_CREAT,0644);
+    if(s->fd<0){
+       fprintf(stderr,"open_live_state: can't open shared memory %s\n",name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* readers may still have the segment of a last run mapped, so it
+       is never shrunk (they would fault on the lost pages). Start with
+       seq odd, so they wait for the first publish */
+
+    max_fields=LIVE_STATE_MIN_FIELDS;
+    if(fstat(s->fd,&st)==0&&st.st_size>(off_t)live_state_size(max_fields)){
+       max_fields=(st.st_size-sizeof(Live_State_Header))/sizeof(Live_Field);
+    }
+
+    if(map_live_state(s,max_fields)!=0){
+       close(s->fd);
+       s->fd=-1;
+       return(-1);
+    }
+    __atomic_store_n(&(s->header->seq),s->header->seq|1,__ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset((void *)(s->base+offsetof(Live_State_Header,pid)),0,
+       s->size-offsetof(Live_State_Header,pid));
+    s->header->magic=LIVE_STATE_MAGIC;
+    s->header->version=LIVE_STATE_VERSION;
+    s->header->pid=getpid();
+    s->header->size=s->size;
+    s->header->max_fields=max_fields;
+    s->header->last_field=-1;
+    s->header->last_field_number=-1;
+    __atomic_store_n(&(s->header->seq),s->header->seq+1,__ATOMIC_RELEASE);
+
+    if(verbose){
+       fprintf(stderr,"open_live_state: publishing to %s\n",name);
+       fflush(stderr);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Publish the num_fields fields of sequence, with last_field (or -1)
+   the last selected, at jd. Return 0, or -1 if s is not open or can't
+   be enlarged */
+
+int publish_live_state(Live_State *s, Field *sequence, int num_fields,
+        int last_field, double jd, int paused, int bad_weather,
+        Telescope_Status *tel_status, Camera_Status *cam_status)
+{
+    Live_State_Header *h;
+    Live_Field *l;
+    Field *f;
+    struct timeval tv;
+    unsigned int seq;
+    int i,max_fields;
+
+    if(s->fd<0||s->base==NULL)return(-1);
+
+    h=s->header;
+    seq=h->seq;
+    __atomic_store_n(&(h->seq),seq+1,__ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if(num_fields>h->max_fields){
+       max_fields=h->max_fields;
+       while(max_fields<num_fields)max_fields=2*max_fields;
+       if(map_live_state(s,max_fields)!=0){
+          h=s->header;
+          __atomic_store_n(&(h->seq),seq+2,__ATOMIC_RELEASE);
+          return(-1);
+       }
+       h=s->header;
+       h->max_fields=max_fields;
+       h->size=s->size;
+    }
+
+    gettimeofday(&tv,NULL);
+    h->num_fields=num_fields;
+    h->paused=paused;
+    h->bad_weather=bad_weather;
+    h->last_field=last_field;
+    if(last_field>=0&&last_field<num_fields){
+       h->last_field_number=sequence[last_field].field_number;
+       h->last_selection_code=sequence[last_field].selection_code;
+    }
+    else{
+       h->last_field_number=-1;
+       h->last_selection_code=NOT_SELECTED;
+    }
+    h->n_published++;
+    h->jd=jd;
+    h->update_time=tv.tv_sec+1.0e-6*tv.tv_usec;
+    if(tel_status!=NULL)h->tel_status=*tel_status;
+    if(cam_status!=NULL)h->cam_status=*cam_status;
+
+    for(i=0;i<num_fields;i++){
+       f=sequence+i;
+       l=s->fields+i;
+       l->field_number=f->field_number;
+       l->status=f->status;
+       l->selection_code=f->selection_code;
+       l->shutter=f->shutter;
+       l->survey_code=f->survey_code;
+       l->n_done=f->n_done;
+       l->n_required=f->n_required;
+       l->doable=f->doable;
+       l->ra=f->ra;
+       l->dec=f->dec;
+       l->jd_next=f->jd_next;
+       l->time_left=f->time_left;
+    }
+
+    __atomic_store_n(&(h->seq),seq+2,__ATOMIC_RELEASE);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* stop publishing. The segment is left for readers to see the last
+   state; the next open_live_state() takes it over */
+
+void close_live_state(Live_State *s)
+{
+    if(s->base!=NULL)munmap(s->base,s->size);
+    if(s->fd>=0)close(s->fd);
+    s->base=NULL;
+    s->fd=-1;
+}
+
+/************************************************************/
@@ -0,0 +1,91 @@
+#ifndef __live_state_h
+#define __live_state_h
+
+/* live_state.h
+
+   The live state of the scheduler in a shared memory segment: the
+   status of each field, the last selection, and the telescope and
+   camera status, published by the scheduler after each change and
+   read by monitors without touching any file (see live_state.c for
+   the writer and live_state_client.c for the readers). It needs the
+   status types of scheduler.h, which is included first.
+
+   2026 Oct 14
+*/
+
+#define LIVE_STATE_NAME "/ls4_scheduler_state" /* shm_open() name */
+#define LIVE_STATE_MAGIC 0x4c53344cu /* "LS4L" */
+#define LIVE_STATE_VERSION 1
+#define LIVE_STATE_MIN_FIELDS 1024 /* fields the segment has room for at first */
+#define LIVE_STATE_MAX_TRIES 1000 /* reads retried while the writer is busy */
+
+/* the start of the segment. seq is the seqlock: odd while the writer is
+   changing the segment, and advanced by 2 for each publish */
+
+typedef struct {
+    unsigned int magic; /* LIVE_STATE_MAGIC */
+    unsigned int version; /* LIVE_STATE_VERSION */
+    unsigned int seq;
+    int pid; /* of the scheduler */
+    long size; /* bytes in the segment */
+    int max_fields; /* fields it has room for */
+    int num_fields;
+    int paused;
+    int bad_weather;
+    int last_field; /* index of the last field selected, -1 if none */
+    int last_field_number;
+    int last_selection_code; /* its enum Selection_Code */
+    int n_published;
+    double jd; /* of the last publish */
+    double update_time; /* wall clock time (sec) of the last publish */
+    Telescope_Status tel_status;
+    Camera_Status cam_status;
+} Live_State_Header;
+
+/* one field, following the header */
+
+typedef struct {
+    int field_number;
+    int status; /* READY_STATUS, DO_NOW_STATUS, ... */
+    int selection_code;
+    int shutter;
+    int survey_code;
+    int n_done;
+    int n_required;
+    int doable;
+    double ra; /* hours */
+    double dec; /* deg */
+    double jd_next;
+    double time_left; /* hours */
+} Live_Field;
+
+/* a segment mapped by the writer or by a reader */
+
+typedef struct {
+    int fd;
+    size_t size; /* bytes mapped */
+    char *base;
+    Live_State_Header *header;
+    Live_Field *fields;
+} Live_State;
+
+/* writer (live_state.c) */
+
+int open_live_state(char *name, Live_State *s);
+
+int publish_live_state(Live_State *s, Field *sequence, int num_fields,
+        int last_field, double jd, int paused, int bad_weather,
+        Telescope_Status *tel_status, Camera_Status *cam_status);
+
+void close_live_state(Live_State *s);
+
+/* readers (live_state_client.c) */
+
+int attach_live_state(char *name, Live_State *s);
+
+int read_live_state(Live_State *s, Live_State_Header *header,
+        Live_Field *fields, int max_fields);
+
+void detach_live_state(Live_State *s);
+
+#endif
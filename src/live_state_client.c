@@ -0,0 +1,150 @@
+/* live_state_client.c
+
+   2026 Oct 14
+
+   Reading the live state the scheduler publishes to shared memory
+   (see live_state.c).
+
+   attach_live_state() maps the segment read-only, so a reader can
+   never disturb the scheduler, and read_live_state() takes a
+   consistent copy of it: the header and fields are copied between two
+   reads of the seqlock, and the copy is retried if the writer was busy
+   or published in between. A reader that sees the segment has grown
+   maps it again before copying.
+*/
+
+#include "scheduler.h"
+#include "live_state.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int attach_live_state(char *name, Live_State *s);
+int read_live_state(Live_State *s, Live_State_Header *header,
+        Live_Field *fields, int max_fields);
+void detach_live_state(Live_State *s);
+
+/************************************************************/
+
+/* map the whole of the open segment of s. Return 0, or -1 if it is
+   not yet the size of a header or can't be mapped */
+
+static int remap_live_state(Live_State *s)
+{
+    struct stat st;
+    char *base;
+
+    if(fstat(s->fd,&st)!=0||st.st_size<(off_t)sizeof(Live_State_Header)){
+       fprintf(stderr,"remap_live_state: segment is too short\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    base=(char *)mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,s->fd,0);
+    if(base==MAP_FAILED){
+       fprintf(stderr,"remap_live_state: can't map segment\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    if(s->base!=NULL)munmap(s->base,s->size);
+    s->base=base;
+    s->size=st.st_size;
+    s->header=(Live_State_Header *)base;
+    s->fields=(Live_Field *)(base+sizeof(Live_State_Header));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* map the segment name, published by a running (or the last)
+   scheduler. Return 0, or -1 if there is none or it is of another
+   version */
+
+int attach_live_state(char *name, Live_State *s)
+{
+    memset((void *)s,0,sizeof(Live_State));
+    s->fd=shm_open(name,O_RDONLY,0);
+    if(s->fd<0){
+       fprintf(stderr,"attach_live_state: no shared memory %s\n",name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    if(remap_live_state(s)!=0){
+       detach_live_state(s);
+       return(-1);
+    }
+
+    if(s->header->magic!=LIVE_STATE_MAGIC||s->header->version!=LIVE_STATE_VERSION){
+       fprintf(stderr,"attach_live_state: %s is not a version %d live state\n",
+          name,LIVE_STATE_VERSION);
+       fflush(stderr);
+       detach_live_state(s);
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Copy the header of s to header, and up to max_fields of its fields
+   to fields (which may be NULL if max_fields is 0). Return the number
+   of fields copied, or -1 if no consistent copy could be taken in
+   LIVE_STATE_MAX_TRIES tries */
+
+int read_live_state(Live_State *s, Live_State_Header *header,
+        Live_Field *fields, int max_fields)
+{
+    unsigned int seq1,seq2;
+    int n,n_tries;
+    long size;
+
+    if(s->base==NULL)return(-1);
+
+    for(n_tries=0;n_tries<LIVE_STATE_MAX_TRIES;n_tries++){
+       seq1=__atomic_load_n(&(s->header->seq),__ATOMIC_ACQUIRE);
+       if(seq1&1){
+          usleep(100);
+          continue;
+       }
+
+       /* the writer enlarges the segment before changing the size in
+          the header, so a larger size is already safe to map */
+
+       size=s->header->size;
+       if(size>(long)s->size){
+          if(remap_live_state(s)!=0)return(-1);
+          continue;
+       }
+
+       memcpy((void *)header,(void *)s->header,sizeof(Live_State_Header));
+       n=header->num_fields;
+       if(n<0||n>header->max_fields)n=0;
+       if(n>max_fields)n=max_fields;
+       if((long)(sizeof(Live_State_Header)+n*sizeof(Live_Field))>(long)s->size)n=0;
+       if(n>0)memcpy((void *)fields,(void *)s->fields,n*sizeof(Live_Field));
+
+       __atomic_thread_fence(__ATOMIC_ACQUIRE);
+       seq2=__atomic_load_n(&(s->header->seq),__ATOMIC_RELAXED);
+       if(seq1==seq2)return(n);
+    }
+
+    fprintf(stderr,"read_live_state: scheduler never idle\n");
+    fflush(stderr);
+    return(-1);
+}
+
+/************************************************************/
+
+void detach_live_state(Live_State *s)
+{
+    if(s->base!=NULL)munmap(s->base,s->size);
+    if(s->fd>=0)close(s->fd);
+    s->base=NULL;
+    s->fd=-1;
+}
+
+/************************************************************/
@@ -0,0 +1,128 @@
+/* live_status.c
+
+   2026 Oct 14
+
+   Print the live state of a running scheduler from its shared memory
+   segment (see live_state.c): what it last selected and why, how many
+   fields are in each status, and the telescope and camera status it
+   last saw. With -f, a line for each field follows. With an interval,
+   the state is printed again every interval seconds, for as long as
+   the segment is there.
+
+   syntax: live_status [-f] [interval_sec]
+*/
+
+#include "scheduler.h"
+#include "live_state.h"
+#include <sys/time.h>
+
+extern char *selection_string[];
+
+/************************************************************/
+
+static void print_live_state(Live_State_Header *h, Live_Field *fields, int n,
+        int print_fields, FILE *output)
+{
+    int i,n_late,n_not_doable,n_ready,n_do_now,n_complete;
+    Live_Field *l;
+    struct timeval tv;
+
+    gettimeofday(&tv,NULL);
+    n_late=0;
+    n_not_doable=0;
+    n_ready=0;
+    n_do_now=0;
+    n_complete=0;
+    for(i=0;i<n;i++){
+       l=fields+i;
+       if(l->n_done>=l->n_required)n_complete++;
+       if(l->status==TOO_LATE_STATUS)n_late++;
+       else if(l->status==NOT_DOABLE_STATUS)n_not_doable++;
+       else if(l->status==READY_STATUS)n_ready++;
+       else if(l->status==DO_NOW_STATUS)n_do_now++;
+    }
+
+    fprintf(output,"# pid %d  publish %d  jd %14.6f  age %6.1f sec%s%s\n",
+       h->pid,h->n_published,h->jd,tv.tv_sec+1.0e-6*tv.tv_usec-h->update_time,
+       h->paused ? "  paused" : "",h->bad_weather ? "  bad weather" : "");
+    fprintf(output,"# fields %d  complete %d  do_now %d  ready %d  not doable %d  too late %d\n",
+       h->num_fields,n_complete,n_do_now,n_ready,n_not_doable,n_late);
+    if(h->last_field>=0){
+       fprintf(output,"# last field %d (number %d) %s\n",h->last_field,h->last_field_number,
+          h->last_selection_code>=0&&h->last_selection_code<=MOST_TIME_READY_LATE ?
+          selection_string[h->last_selection_code] : "?");
+    }
+    else{
+       fprintf(output,"# last field none\n");
+    }
+    fprintf(output,"# telescope ra %10.6f dec %10.5f  focus %8.5f  filter %s  dome %d\n",
+       h->tel_status.ra,h->tel_status.dec,h->tel_status.focus,
+       h->tel_status.filter_string,h->tel_status.dome_status);
+    fprintf(output,"# camera ready %d  error %d  state %s\n",
+       h->cam_status.ready,h->cam_status.error,h->cam_status.state);
+
+    if(print_fields){
+       for(i=0;i<n;i++){
+          l=fields+i;
+          fprintf(output,"%5d %5d %10.6f %10.5f %2d %d %2d %3d %3d %14.6f %8.3f %s\n",
+             i,l->field_number,l->ra,l->dec,l->status,l->doable,l->survey_code,
+             l->n_done,l->n_required,l->jd_next,l->time_left,
+             l->selection_code>=0&&l->selection_code<=MOST_TIME_READY_LATE ?
+             selection_string[l->selection_code] : "?");
+       }
+    }
+
+    fflush(output);
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    Live_State s;
+    Live_State_Header h;
+    Live_Field *fields;
+    int i,n,max_fields,print_fields,interval_sec;
+
+    print_fields=0;
+    interval_sec=0;
+    for(i=1;i<argc;i++){
+       if(strcmp(argv[i],"-f")==0)print_fields=1;
+       else if(sscanf(argv[i],"%d",&interval_sec)!=1||interval_sec<0){
+          fprintf(stderr,"syntax: live_status [-f] [interval_sec]\n");
+          exit(-1);
+       }
+    }
+
+    if(attach_live_state(LIVE_STATE_NAME,&s)!=0)exit(-1);
+
+    fields=NULL;
+    max_fields=0;
+    while(1){
+       /* make room for all the fields, in case they have grown */
+
+       if(s.header->max_fields>max_fields){
+          max_fields=s.header->max_fields;
+          fields=(Live_Field *)realloc(fields,max_fields*sizeof(Live_Field));
+          if(fields==NULL){
+             fprintf(stderr,"can't allocate %d fields\n",max_fields);
+             exit(-1);
+          }
+       }
+
+       n=read_live_state(&s,&h,fields,max_fields);
+       if(n<0)exit(-1);
+       print_live_state(&h,fields,n,print_fields,stdout);
+
+       if(interval_sec==0)break;
+       sleep(interval_sec);
+       printf("\n");
+    }
+
+    detach_live_state(&s);
+    free(fields);
+
+    exit(0);
+}
+
+/************************************************************/
@@ -0,0 +1,319 @@
+"""
+Python Binding to the C Scheduling Core
+
+This module loads libls4sched.so (built with "make shared" in src) with ctypes
+and wraps the interface of ls4sched_api.h, so the Python scheduler can choose
+fields with the same code as the C scheduler instead of its own copies of the
+selection rules.
+
+- Engine: the site, the times of the night and the fields, held in C
+- Engine.get_fields() copies the state of all the fields in one call
+- available() tells whether the library could be loaded
+
+The library is found from $LS4SCHED_LIB, or else next to this module or in
+../bin. Only the standard library is needed.
+"""
+
+import os
+import ctypes
+import logging
+from typing import List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+API_VERSION = 1
+LIBRARY_NAME = "libls4sched.so"
+STRING_LEN = 256
+MAX_STATES = 32
+
+
+class Night(ctypes.Structure):
+    """Times of the night (Ls4_Night)"""
+    _fields_ = [
+        ("jd_start", ctypes.c_double),
+        ("jd_end", ctypes.c_double),
+        ("ut_start", ctypes.c_double),
+        ("ut_end", ctypes.c_double),
+        ("lst_start", ctypes.c_double),
+        ("lst_end", ctypes.c_double),
+        ("jd_sunset", ctypes.c_double),
+        ("jd_sunrise", ctypes.c_double),
+        ("jd_evening12", ctypes.c_double),
+        ("jd_evening18", ctypes.c_double),
+        ("jd_morning12", ctypes.c_double),
+        ("jd_morning18", ctypes.c_double),
+        ("ra_moon", ctypes.c_double),
+        ("dec_moon", ctypes.c_double),
+        ("percent_moon", ctypes.c_double),
+    ]
+
+
+class FieldState(ctypes.Structure):
+    """State of one field (Ls4_Field)"""
+    _fields_ = [
+        ("field_number", ctypes.c_int),
+        ("line_number", ctypes.c_int),
+        ("status", ctypes.c_int),
+        ("doable", ctypes.c_int),
+        ("selection_code", ctypes.c_int),
+        ("shutter", ctypes.c_int),
+        ("survey_code", ctypes.c_int),
+        ("n_done", ctypes.c_int),
+        ("n_required", ctypes.c_int),
+        ("ra", ctypes.c_double),
+        ("dec", ctypes.c_double),
+        ("expt", ctypes.c_double),
+        ("interval", ctypes.c_double),
+        ("jd_rise", ctypes.c_double),
+        ("jd_set", ctypes.c_double),
+        ("jd_next", ctypes.c_double),
+        ("time_up", ctypes.c_double),
+        ("time_required", ctypes.c_double),
+        ("time_left", ctypes.c_double),
+        ("gal_long", ctypes.c_double),
+        ("gal_lat", ctypes.c_double),
+        ("ecl_long", ctypes.c_double),
+        ("ecl_lat", ctypes.c_double),
+    ]
+
+
+class CameraStatus(ctypes.Structure):
+    """Parsed camera controller status (Ls4_Camera_Status)"""
+    _fields_ = [
+        ("ready", ctypes.c_int),
+        ("error", ctypes.c_int),
+        ("error_code", ctypes.c_int),
+        ("state", ctypes.c_char * STRING_LEN),
+        ("comment", ctypes.c_char * STRING_LEN),
+        ("date", ctypes.c_char * STRING_LEN),
+        ("read_time", ctypes.c_double),
+        ("num_states", ctypes.c_int),
+        ("state_val", ctypes.c_int * MAX_STATES),
+    ]
+
+
+_lib = None
+_load_error = None
+
+
+def _declare(lib):
+    """Set the argument and result types of the library functions"""
+    engine = ctypes.c_void_p
+    double_p = ctypes.POINTER(ctypes.c_double)
+    prototypes = {
+        "ls4_api_version": (ctypes.c_int, []),
+        "ls4_engine_new": (engine, [ctypes.c_char_p, ctypes.c_int]),
+        "ls4_engine_free": (None, [engine]),
+        "ls4_set_night": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_int, ctypes.c_int]),
+        "ls4_get_night": (ctypes.c_int, [engine, ctypes.POINTER(Night), ctypes.c_size_t]),
+        "ls4_load_sequence": (ctypes.c_int, [engine, ctypes.c_char_p]),
+        "ls4_add_field": (ctypes.c_int, [engine, ctypes.c_char_p]),
+        "ls4_num_fields": (ctypes.c_int, [engine]),
+        "ls4_get_fields": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_int,
+                                          ctypes.POINTER(FieldState), ctypes.c_size_t]),
+        "ls4_init_fields": (ctypes.c_int, [engine, ctypes.c_double]),
+        "ls4_next_field": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_double, ctypes.c_int]),
+        "ls4_update_status": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_double, ctypes.c_int]),
+        "ls4_shorten_interval": (ctypes.c_int, [engine, ctypes.c_int]),
+        "ls4_record_exposure": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_double,
+                                               ctypes.c_double, ctypes.c_char_p]),
+        "ls4_reject_exposure": (ctypes.c_int, [engine, ctypes.c_int, ctypes.c_double]),
+        "ls4_selection_string": (ctypes.c_char_p, [ctypes.c_int]),
+        "ls4_lst": (ctypes.c_double, [engine, ctypes.c_double]),
+        "ls4_airmass": (ctypes.c_double, [engine, ctypes.c_double, ctypes.c_double]),
+        "ls4_sun_position": (ctypes.c_int, [ctypes.c_double, double_p, double_p]),
+        "ls4_moon_position": (ctypes.c_int, [engine, ctypes.c_double, double_p, double_p]),
+        "ls4_parse_camera_status": (ctypes.c_int, [ctypes.c_char_p, ctypes.POINTER(CameraStatus),
+                                                   ctypes.c_size_t]),
+    }
+    for name, (restype, argtypes) in prototypes.items():
+        function = getattr(lib, name)
+        function.restype = restype
+        function.argtypes = argtypes
+
+
+def load_library(path: Optional[str] = None):
+    """
+    Load libls4sched.so, once
+
+    Args:
+        path: Library to load, or None to search $LS4SCHED_LIB, this
+              module's directory and ../bin
+
+    Returns:
+        The ctypes library
+
+    Raises:
+        OSError: If it can't be found or is not of this API version
+    """
+    global _lib, _load_error
+
+    if _lib is not None:
+        return _lib
+
+    here = os.path.dirname(os.path.abspath(__file__))
+    if path is not None:
+        candidates = [path]
+    else:
+        candidates = [os.environ.get("LS4SCHED_LIB"),
+                      os.path.join(here, LIBRARY_NAME),
+                      os.path.join(here, "..", "bin", LIBRARY_NAME)]
+
+    errors = []
+    for candidate in candidates:
+        if not candidate or not os.path.exists(candidate):
+            continue
+        try:
+            lib = ctypes.CDLL(candidate)
+            _declare(lib)
+        except (OSError, AttributeError) as e:
+            errors.append(f"{candidate}: {e}")
+            continue
+        version = lib.ls4_api_version()
+        if version != API_VERSION:
+            errors.append(f"{candidate}: API version {version}, expected {API_VERSION}")
+            continue
+        _lib = lib
+        logger.debug(f"Loaded {candidate}")
+        return _lib
+
+    _load_error = "; ".join(errors) if errors else f"{LIBRARY_NAME} not found"
+    raise OSError(_load_error)
+
+
+def available() -> bool:
+    """Whether the C core can be loaded"""
+    try:
+        load_library()
+        return True
+    except OSError:
+        return False
+
+
+def selection_string(code: int) -> str:
+    """Description of a selection code"""
+    return load_library().ls4_selection_string(code).decode()
+
+
+def sun_position(jd: float) -> Tuple[float, float]:
+    """Low precision sun position at jd (RA hours, Dec degrees)"""
+    ra, dec = ctypes.c_double(), ctypes.c_double()
+    load_library().ls4_sun_position(jd, ctypes.byref(ra), ctypes.byref(dec))
+    return ra.value, dec.value
+
+
+def parse_camera_status(reply: str) -> CameraStatus:
+    """Parse a camera controller status reply as the C scheduler does"""
+    status = CameraStatus()
+    load_library().ls4_parse_camera_status(reply.encode(), ctypes.byref(status),
+                                           ctypes.sizeof(status))
+    return status
+
+
+class Engine:
+    """
+    The C scheduling core for one site and night
+
+    The core keeps some state in globals, so drive one engine at a time,
+    and from one thread.
+    """
+
+    def __init__(self, site_name: str = "DEFAULT", verbose: int = 0):
+        self._lib = load_library()
+        self._engine = self._lib.ls4_engine_new(site_name.encode(), verbose)
+        if not self._engine:
+            raise RuntimeError(f"Can't create scheduling engine for site {site_name}")
+
+    def close(self):
+        """Free the engine"""
+        if self._engine:
+            self._lib.ls4_engine_free(self._engine)
+            self._engine = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def set_night(self, year: int, month: int, day: int):
+        """Set the night starting on the given local date"""
+        self._lib.ls4_set_night(self._engine, year, month, day)
+
+    def get_night(self) -> Night:
+        """Times of the night set by set_night()"""
+        night = Night()
+        if self._lib.ls4_get_night(self._engine, ctypes.byref(night), ctypes.sizeof(night)) != 0:
+            raise RuntimeError("No night set")
+        return night
+
+    def load_sequence(self, filename: str) -> int:
+        """Replace the fields with those of a sequence file, returning the number read"""
+        return self._lib.ls4_load_sequence(self._engine, filename.encode())
+
+    def add_field(self, line: str) -> int:
+        """Add the field of one sequence line, returning its index or -1"""
+        return self._lib.ls4_add_field(self._engine, line.encode())
+
+    @property
+    def num_fields(self) -> int:
+        return self._lib.ls4_num_fields(self._engine)
+
+    def get_fields(self, first: int = 0, n: Optional[int] = None) -> List[FieldState]:
+        """State of fields first to first+n-1 (all by default), copied in one call"""
+        if n is None:
+            n = self.num_fields - first
+        if n <= 0:
+            return []
+        fields = (FieldState * n)()
+        n = self._lib.ls4_get_fields(self._engine, first, n, fields, ctypes.sizeof(FieldState))
+        return list(fields[:n])
+
+    def get_field(self, index: int) -> FieldState:
+        """State of one field"""
+        fields = self.get_fields(index, 1)
+        if not fields:
+            raise IndexError(f"No field {index}")
+        return fields[0]
+
+    def init_fields(self, jd: float) -> int:
+        """Set up the fields for the night at jd, returning the number observable"""
+        return self._lib.ls4_init_fields(self._engine, jd)
+
+    def next_field(self, i_prev: int, jd: float, bad_weather: bool = False) -> int:
+        """Index of the field to observe next, or -1"""
+        return self._lib.ls4_next_field(self._engine, i_prev, jd, int(bad_weather))
+
+    def update_status(self, index: int, jd: float, bad_weather: bool = False) -> int:
+        """Update the status of a field at jd, returning the status"""
+        return self._lib.ls4_update_status(self._engine, index, jd, int(bad_weather))
+
+    def shorten_interval(self, index: int) -> int:
+        return self._lib.ls4_shorten_interval(self._engine, index)
+
+    def record_exposure(self, index: int, jd: float, actual_expt: float,
+                        filename: str = "") -> int:
+        """Record an exposure (actual_expt in hours) of a field taken at jd"""
+        return self._lib.ls4_record_exposure(self._engine, index, jd, actual_expt,
+                                             filename.encode())
+
+    def reject_exposure(self, index: int, jd: float) -> int:
+        """Take back the last exposure of a field, so it is due again at jd"""
+        return self._lib.ls4_reject_exposure(self._engine, index, jd)
+
+    def lst(self, jd: float) -> float:
+        """Local sidereal time (hours) at jd"""
+        return self._lib.ls4_lst(self._engine, jd)
+
+    def airmass(self, ha: float, dec: float) -> float:
+        """Airmass at hour angle ha (hours) and dec (degrees)"""
+        return self._lib.ls4_airmass(self._engine, ha, dec)
+
+    def moon_position(self, jd: float) -> Tuple[float, float]:
+        """Low precision topocentric moon position at jd (RA hours, Dec degrees)"""
+        ra, dec = ctypes.c_double(), ctypes.c_double()
+        self._lib.ls4_moon_position(self._engine, jd, ctypes.byref(ra), ctypes.byref(dec))
+        return ra.value, dec.value
@@ -0,0 +1,501 @@
+/* ls4sched_api.c
+
+   2026 Oct 14
+
+   The scheduling core behind the stable interface of ls4sched_api.h,
+   for libls4sched.so.
+
+   The Python scheduler (scheduler.py) had its own copies of the field
+   selection, the status rules and the ephemerides, which drift from
+   the C code. Through this interface (and ls4sched.py) it runs the
+   same code as the scheduler instead: an Ls4_Engine holds the site,
+   the times of the night and a Field_Store, fields are read with
+   load_sequence() and set up with init_fields(), chosen with
+   select_next_field() (as run_night() chooses them), and recorded as
+   observed with record_exposure(). The caller drives the telescope
+   and camera itself.
+
+   The engine is opaque and the caller sees the fields and the night
+   only as copies in flat structures of its own size, so the Field and
+   Night_Times structures of the core can change without breaking a
+   caller.
+*/
+
+#include "scheduler.h"
+#include "ls4sched_api.h"
+
+extern int verbose;
+extern int verbose1;
+extern char *selection_string[];
+
+double lst();
+void lpsun();
+void lpmoon();
+
+struct Ls4_Engine {
+    Site_Params site;
+    struct date_time date; /* local date of the night */
+    Night_Times nt,nt_5day,nt_10day,nt_15day;
+    int night_set;
+    Field_Store store;
+    Field_Selector selector;
+    Telescope_Status tel_status; /* not used by init_fields(), but passed */
+};
+
+/************************************************************/
+
+int ls4_api_version(void)
+{
+    return(LS4_API_VERSION);
+}
+
+/************************************************************/
+
+/* Return an engine for the site site_name ("DEFAULT" for ESO La Silla,
+   or "Fake", as for load_site()), or NULL on error. verbose sets the
+   verbosity of the core, as in sched_sim */
+
+Ls4_Engine *ls4_engine_new(const char *site_name, int verbose_flag)
+{
+    Ls4_Engine *e;
+
+    /* load_site() knows only these by name, and reads any other site
+       interactively */
+
+    if(strstr(site_name,"DEFAULT")==NULL&&strstr(site_name,"Fake")==NULL&&
+         strstr(site_name,"fake")==NULL&&strstr(site_name,"FAKE")==NULL){
+       fprintf(stderr,"ls4_engine_new: unknown site %s\n",site_name);
+       fflush(stderr);
+       return(NULL);
+    }
+
+    e=(Ls4_Engine *)malloc(sizeof(Ls4_Engine));
+    if(e==NULL){
+       fprintf(stderr,"ls4_engine_new: can't allocate engine\n");
+       fflush(stderr);
+       return(NULL);
+    }
+    memset((void *)e,0,sizeof(Ls4_Engine));
+
+    verbose=verbose_flag;
+    verbose1=(verbose_flag>1);
+
+    strncpy(e->site.site_name,site_name,sizeof(e->site.site_name)-1);
+    load_site(&e->site.longit,&e->site.lat,&e->site.stdz,&e->site.use_dst,
+       e->site.zone_name,&e->site.zabr,&e->site.elevsea,&e->site.elev,
+       &e->site.horiz,e->site.site_name);
+
+    init_overhead_model(&overhead_model);
+    init_field_store(&e->store);
+    if(init_field_selector(&e->selector)!=0){
+       fprintf(stderr,"ls4_engine_new: can't initialize field selector\n");
+       fflush(stderr);
+       free(e);
+       return(NULL);
+    }
+
+    return(e);
+}
+
+/************************************************************/
+
+void ls4_engine_free(Ls4_Engine *e)
+{
+    if(e==NULL)return;
+
+    free_field_selector(&e->selector);
+    truncate_field_store(&e->store,0);
+    if(e->store.fields!=NULL)free(e->store.fields);
+    free(e);
+}
+
+/************************************************************/
+
+/* Set the night to the one starting on the local date year month day,
+   with the nights 5, 10 and 15 days later that init_fields() looks
+   ahead to. Return 0 */
+
+int ls4_set_night(Ls4_Engine *e, int year, int month, int day)
+{
+    struct date_time date;
+
+    memset((void *)&date,0,sizeof(date));
+    date.y=year;
+    date.mo=month;
+    date.d=day;
+    e->date=date;
+
+    date=e->date;
+    adjust_date(&date,5);
+    init_night(date,&e->nt_5day,&e->site,0);
+    date=e->date;
+    adjust_date(&date,10);
+    init_night(date,&e->nt_10day,&e->site,0);
+    date=e->date;
+    adjust_date(&date,15);
+    init_night(date,&e->nt_15day,&e->site,0);
+    init_night(e->date,&e->nt,&e->site,verbose);
+    e->night_set=1;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* copy the first size bytes of the times of the night to night. Return
+   0, or -1 if no night is set */
+
+int ls4_get_night(Ls4_Engine *e, Ls4_Night *night, size_t size)
+{
+    Ls4_Night n;
+
+    if(!e->night_set)return(-1);
+
+    n.jd_start=e->nt.jd_start;
+    n.jd_end=e->nt.jd_end;
+    n.ut_start=e->nt.ut_start;
+    n.ut_end=e->nt.ut_end;
+    n.lst_start=e->nt.lst_start;
+    n.lst_end=e->nt.lst_end;
+    n.jd_sunset=e->nt.jd_sunset;
+    n.jd_sunrise=e->nt.jd_sunrise;
+    n.jd_evening12=e->nt.jd_evening12;
+    n.jd_evening18=e->nt.jd_evening18;
+    n.jd_morning12=e->nt.jd_morning12;
+    n.jd_morning18=e->nt.jd_morning18;
+    n.ra_moon=e->nt.ra_moon;
+    n.dec_moon=e->nt.dec_moon;
+    n.percent_moon=e->nt.percent_moon;
+
+    memcpy((void *)night,(void *)&n,size<sizeof(n) ? size : sizeof(n));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Replace the fields of e with those of the sequence file_name. Return
+   the number read, or -1 on error */
+
+int ls4_load_sequence(Ls4_Engine *e, const char *file_name)
+{
+    char name[STR_BUF_LEN];
+    int n;
+
+    truncate_field_store(&e->store,0);
+
+    strncpy(name,file_name,STR_BUF_LEN-1);
+    name[STR_BUF_LEN-1]=0;
+    n=load_sequence(name,&e->store,0);
+    if(n<0)truncate_field_store(&e->store,0);
+
+    return(n);
+}
+
+/************************************************************/
+
+/* Add the field of one sequence line. Return its index, or -1 if the
+   line is not a field (comments and FILTER lines are taken as in a
+   sequence file) or on error. The field is set up by the next
+   ls4_init_fields() */
+
+int ls4_add_field(Ls4_Engine *e, const char *line)
+{
+    char string[STR_BUF_LEN+1];
+    Field field;
+    int index;
+
+    strncpy(string,line,STR_BUF_LEN-1);
+    string[STR_BUF_LEN-1]=0;
+
+    if(parse_sequence_line(string,e->store.num_fields+1,&field)!=1)return(-1);
+
+    index=add_field(&e->store,&field,string);
+    if(index<0)return(-1);
+    e->store.fields[index].field_number=index;
+
+    return(index);
+}
+
+/************************************************************/
+
+int ls4_num_fields(Ls4_Engine *e)
+{
+    return(e->store.num_fields);
+}
+
+/************************************************************/
+
+/* copy the first size bytes of the state of fields first to first+n-1
+   to fields, one after the other. Return the number copied */
+
+int ls4_get_fields(Ls4_Engine *e, int first, int n, Ls4_Field *fields, size_t size)
+{
+    Ls4_Field l;
+    Field *f;
+    size_t n_bytes;
+    int i;
+
+    if(first<0)return(0);
+    if(first+n>e->store.num_fields)n=e->store.num_fields-first;
+    n_bytes=size<sizeof(l) ? size : sizeof(l);
+
+    for(i=0;i<n;i++){
+       f=e->store.fields+first+i;
+       l.field_number=f->field_number;
+       l.line_number=f->line_number;
+       l.status=f->status;
+       l.doable=f->doable;
+       l.selection_code=f->selection_code;
+       l.shutter=f->shutter;
+       l.survey_code=f->survey_code;
+       l.n_done=f->n_done;
+       l.n_required=f->n_required;
+       l.ra=f->ra;
+       l.dec=f->dec;
+       l.expt=f->expt;
+       l.interval=f->interval;
+       l.jd_rise=f->jd_rise;
+       l.jd_set=f->jd_set;
+       l.jd_next=f->jd_next;
+       l.time_up=f->time_up;
+       l.time_required=f->time_required;
+       l.time_left=f->time_left;
+       l.gal_long=f->gal_long;
+       l.gal_lat=f->gal_lat;
+       l.ecl_long=f->ecl_long;
+       l.ecl_lat=f->ecl_lat;
+       memcpy((void *)((char *)fields+i*size),(void *)&l,n_bytes);
+    }
+
+    return(n > 0 ? n : 0);
+}
+
+/************************************************************/
+
+/* Set up all the fields for the night at jd, as the scheduler does at
+   the start of the night or when fields are added. Return the number
+   observable, or -1 if no night is set */
+
+int ls4_init_fields(Ls4_Engine *e, double jd)
+{
+    int n;
+
+    if(!e->night_set){
+       fprintf(stderr,"ls4_init_fields: no night set\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    n=init_fields(e->store.fields,e->store.num_fields,&e->nt,&e->nt_5day,
+       &e->nt_10day,&e->nt_15day,&e->site,jd,&e->tel_status);
+
+    /* the selector's queues were built for the fields as they were */
+
+    free_field_selector(&e->selector);
+    init_field_selector(&e->selector);
+
+    return(n);
+}
+
+/************************************************************/
+
+/* Return the index of the field to observe next at jd after field
+   i_prev (or -1), as run_night() chooses it, or -1 if there is none */
+
+int ls4_next_field(Ls4_Engine *e, int i_prev, double jd, int bad_weather)
+{
+    int i;
+
+    if(!e->night_set)return(-1);
+
+#if EVENT_DRIVEN_SELECTION
+    i=select_next_field(&e->selector,e->store.fields,e->store.num_fields,
+       i_prev,jd,bad_weather);
+#else
+    i=get_next_field(e->store.fields,e->store.num_fields,i_prev,jd,bad_weather);
+#endif
+#if LOOKAHEAD_PLANNING
+    i=plan_next_field(e->store.fields,e->store.num_fields,i_prev,jd,bad_weather,
+       i,e->nt.jd_end);
+#endif
+
+    return(i);
+}
+
+/************************************************************/
+
+/* update the status of field index at jd. Return the status, or -2 if
+   there is no such field */
+
+int ls4_update_status(Ls4_Engine *e, int index, double jd, int bad_weather)
+{
+    int status;
+
+    if(index<0||index>=e->store.num_fields)return(-2);
+
+    status=update_field_status(e->store.fields+index,jd,bad_weather);
+    touch_field(&e->selector,index);
+
+    return(status);
+}
+
+/************************************************************/
+
+/* shorten the interval of field index (see shorten_interval()) */
+
+int ls4_shorten_interval(Ls4_Engine *e, int index)
+{
+    int result;
+
+    if(index<0||index>=e->store.num_fields)return(-1);
+
+    result=shorten_interval(e->store.fields+index);
+    touch_field(&e->selector,index);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* Record an exposure of field index taken at jd, of actual_expt hours,
+   to the file filename. Return 0, or -1 if there is no such field or
+   it is complete */
+
+int ls4_record_exposure(Ls4_Engine *e, int index, double jd,
+        double actual_expt, const char *filename)
+{
+    char name[FILENAME_LENGTH+1];
+    double ut,lst_hours;
+    int result;
+
+    if(index<0||index>=e->store.num_fields||!e->night_set)return(-1);
+
+    memset((void *)name,0,sizeof(name));
+    strncpy(name,filename,FILENAME_LENGTH);
+
+    night_ut_lst(&e->nt,jd,&ut,&lst_hours);
+    result=record_exposure(e->store.fields+index,jd,ut,lst_hours,actual_expt,name);
+    touch_field(&e->selector,index);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* Take back the last exposure of field index, read out badly, so it is
+   due again at jd (as observe_next_field() does). Return 0, or -1 if
+   there is none */
+
+int ls4_reject_exposure(Ls4_Engine *e, int index, double jd)
+{
+    Field *f;
+
+    if(index<0||index>=e->store.num_fields)return(-1);
+
+    f=e->store.fields+index;
+    if(f->n_done<1)return(-1);
+    f->n_done=f->n_done-1;
+    f->jd_next=jd;
+    touch_field(&e->selector,index);
+
+    return(0);
+}
+
+/************************************************************/
+
+const char *ls4_selection_string(int code)
+{
+    if(code<NOT_SELECTED||code>MOST_TIME_READY_LATE)return("unknown");
+
+    return(selection_string[code]);
+}
+
+/************************************************************/
+
+/* local sidereal time (hours) at the site of e at jd */
+
+double ls4_lst(Ls4_Engine *e, double jd)
+{
+    return(lst(jd,e->site.longit));
+}
+
+/************************************************************/
+
+/* airmass at the site of e at hour angle ha (hours) and dec (deg) */
+
+double ls4_airmass(Ls4_Engine *e, double ha, double dec)
+{
+    return(get_airmass(ha,dec,&e->site));
+}
+
+/************************************************************/
+
+/* low precision position of the sun at jd (ra hours, dec deg) */
+
+int ls4_sun_position(double jd, double *ra, double *dec)
+{
+    lpsun(jd,ra,dec);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* low precision topocentric position of the moon at jd from the site
+   of e (ra hours, dec deg) */
+
+int ls4_moon_position(Ls4_Engine *e, double jd, double *ra, double *dec)
+{
+    double dist;
+
+    lpmoon(jd,e->site.lat,lst(jd,e->site.longit),ra,dec,&dist);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Parse a status reply of the camera controller, as parse_status()
+   does, and copy the first size bytes of the result to status. Return
+   what parse_status() returns */
+
+int ls4_parse_camera_status(const char *reply, Ls4_Camera_Status *status,
+        size_t size)
+{
+    static int names_done=0;
+    Camera_Status c;
+    Ls4_Camera_Status l;
+    char *string;
+    int i,result;
+
+    if(!names_done){
+       init_status_names();
+       names_done=1;
+    }
+
+    string=(char *)malloc(strlen(reply)+1);
+    if(string==NULL)return(-1);
+    strcpy(string,reply);
+
+    memset((void *)&c,0,sizeof(c));
+    result=parse_status(string,&c);
+    free(string);
+
+    memset((void *)&l,0,sizeof(l));
+    l.ready=c.ready;
+    l.error=c.error;
+    l.error_code=c.error_code;
+    strncpy(l.state,c.state,LS4_STRING_LEN-1);
+    strncpy(l.comment,c.comment,LS4_STRING_LEN-1);
+    strncpy(l.date,c.date,LS4_STRING_LEN-1);
+    l.read_time=c.read_time;
+    l.num_states=NUM_STATES<LS4_MAX_STATES ? NUM_STATES : LS4_MAX_STATES;
+    for(i=0;i<l.num_states;i++)l.state_val[i]=c.state_val[i];
+
+    memcpy((void *)status,(void *)&l,size<sizeof(l) ? size : sizeof(l));
+
+    return(result);
+}
+
+/************************************************************/
@@ -0,0 +1,138 @@
+#ifndef __ls4sched_api_h
+#define __ls4sched_api_h
+
+/* ls4sched_api.h
+
+   The C interface of libls4sched.so, the scheduling core as a shared
+   library for other languages (see ls4sched_api.c, and ls4sched.py for
+   the Python binding).
+
+   Only what is declared here is exported, and it stays compatible
+   within an LS4_API_VERSION: the engine is opaque, and the structures
+   are only ever added to at the end and are copied out with the size
+   the caller was built with, so a caller built against an older
+   version of this file gets the members it knows about.
+
+   The core keeps some state in globals, so a process should drive one
+   engine at a time, and from one thread.
+
+   2026 Oct 14
+*/
+
+#include <stddef.h>
+
+#define LS4_API_VERSION 1
+
+#define LS4_STRING_LEN 256 /* of the strings in Ls4_Camera_Status */
+#define LS4_MAX_STATES 32 /* room for the controller states in Ls4_Camera_Status */
+
+#if defined(__GNUC__)
+#define LS4_API __attribute__((visibility("default")))
+#else
+#define LS4_API
+#endif
+
+typedef struct Ls4_Engine Ls4_Engine;
+
+/* the times of the night set by ls4_set_night() */
+
+typedef struct {
+    double jd_start; /* observations start */
+    double jd_end; /* observations end */
+    double ut_start; /* hours */
+    double ut_end;
+    double lst_start; /* hours */
+    double lst_end;
+    double jd_sunset;
+    double jd_sunrise;
+    double jd_evening12; /* 12 and 18 degree twilights */
+    double jd_evening18;
+    double jd_morning12;
+    double jd_morning18;
+    double ra_moon; /* hours */
+    double dec_moon; /* deg */
+    double percent_moon; /* illuminated fraction */
+} Ls4_Night;
+
+/* the state of one field */
+
+typedef struct {
+    int field_number;
+    int line_number;
+    int status; /* -1 too late, 0 not doable, 1 ready, 2 do now */
+    int doable;
+    int selection_code; /* why it was last selected, see ls4_selection_string() */
+    int shutter;
+    int survey_code;
+    int n_done;
+    int n_required;
+    double ra; /* hours */
+    double dec; /* deg */
+    double expt; /* hours */
+    double interval; /* hours */
+    double jd_rise;
+    double jd_set;
+    double jd_next;
+    double time_up; /* hours */
+    double time_required; /* hours */
+    double time_left; /* hours */
+    double gal_long; /* deg */
+    double gal_lat;
+    double ecl_long;
+    double ecl_lat;
+} Ls4_Field;
+
+/* a camera controller status reply, parsed */
+
+typedef struct {
+    int ready;
+    int error;
+    int error_code;
+    char state[LS4_STRING_LEN];
+    char comment[LS4_STRING_LEN];
+    char date[LS4_STRING_LEN];
+    double read_time;
+    int num_states; /* of state_val */
+    int state_val[LS4_MAX_STATES];
+} Ls4_Camera_Status;
+
+LS4_API int ls4_api_version(void);
+
+/* the engine */
+
+LS4_API Ls4_Engine *ls4_engine_new(const char *site_name, int verbose);
+LS4_API void ls4_engine_free(Ls4_Engine *e);
+LS4_API int ls4_set_night(Ls4_Engine *e, int year, int month, int day);
+LS4_API int ls4_get_night(Ls4_Engine *e, Ls4_Night *night, size_t size);
+
+/* the fields */
+
+LS4_API int ls4_load_sequence(Ls4_Engine *e, const char *file_name);
+LS4_API int ls4_add_field(Ls4_Engine *e, const char *line);
+LS4_API int ls4_num_fields(Ls4_Engine *e);
+LS4_API int ls4_get_fields(Ls4_Engine *e, int first, int n, Ls4_Field *fields, size_t size);
+
+/* selection and observing */
+
+LS4_API int ls4_init_fields(Ls4_Engine *e, double jd);
+LS4_API int ls4_next_field(Ls4_Engine *e, int i_prev, double jd, int bad_weather);
+LS4_API int ls4_update_status(Ls4_Engine *e, int index, double jd, int bad_weather);
+LS4_API int ls4_shorten_interval(Ls4_Engine *e, int index);
+LS4_API int ls4_record_exposure(Ls4_Engine *e, int index, double jd,
+        double actual_expt, const char *filename);
+LS4_API int ls4_reject_exposure(Ls4_Engine *e, int index, double jd);
+LS4_API const char *ls4_selection_string(int code);
+
+/* ephemerides at the site of the engine */
+
+LS4_API double ls4_lst(Ls4_Engine *e, double jd);
+LS4_API double ls4_airmass(Ls4_Engine *e, double ha, double dec);
+LS4_API int ls4_sun_position(double jd, double *ra, double *dec);
+LS4_API int ls4_moon_position(Ls4_Engine *e, double jd, double *ra, double *dec);
+
+/* controller status */
+
+LS4_API int ls4_parse_camera_status(const char *reply, Ls4_Camera_Status *status,
+        size_t size);
+
+#endif
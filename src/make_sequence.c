@@ -7,6 +7,8 @@ syntax: make_sequence.csh ra1 ra2 dec1 dec2 incr
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
 
 #define MAX_GRID_POINTS 10000
 #define RA_STEP0 0.0333 /* hours = 0.5 deg. Spacing between fingers */
@@ -60,7 +62,10 @@ main(int argc, char **argv)
       exit(-1);
     }
 
-    field_grid=(Field *)malloc(n_grid_points*sizeof(Field));
+    /* fill_grid() can place more points than estimated, up to
+       MAX_GRID_POINTS */
+
+    field_grid=(Field *)malloc(MAX_GRID_POINTS*sizeof(Field));
     if(field_grid==NULL){
         fprintf(stderr,"can't allocate field_grid memory\n");
         exit(-1);
@@ -207,8 +212,11 @@ int print_grid(Field *grid, int n_points, double interval)
 {
     int i;
 
+    /* ra dec shutter expt interval n_required survey_code (1 for the
+       TNO survey) # comment, as load_sequence() reads them */
+
     for(i=0;i<n_points;i++){
-      fprintf(stdout,"%10.6f %10.5f Y 60.0 %7.3f 3 %d\n",
+      fprintf(stdout,"%10.6f %10.5f Y 60.0 %7.3f 3 1 # f%d\n",
 	grid[i].ra,grid[i].dec,interval,i);
     }
 
@@ -0,0 +1,384 @@
+/* obs_log.c
+
+   2026 Oct 14
+
+   The binary observation log.
+
+   The scheduler writes each exposure to LOG_OBS_FILE as a line of text,
+   and the analysis tools (get_time_history, get_time_gaps, ...) parse
+   the lines again with sscanf for every run. With append_obs_log() the
+   scheduler also writes each exposure to OBS_LOG_FILE, a file the tools
+   can map and scan as arrays.
+
+   The file is an Obs_Log_Header followed by chunks of OBS_LOG_CHUNK
+   records. Each chunk holds its records as columns, one after the other:
+
+      double jd[], ra[], dec[]; float am[], expt[]; int field_number[];
+      signed char survey_code[], shutter[];
+
+   so a scan of one column reads only that column, and obs_log_columns()
+   gives a pointer to each column of a chunk. The header counts the
+   records and indexes the nights (see Obs_Log_Night), so the records
+   of a night are found with obs_log_night() without a scan.
+
+   A record is written to its chunk before the count in the header is
+   raised, so a tool mapping the log while the scheduler runs sees only
+   whole records. The file is in the byte order of the machine that
+   wrote it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "obs_log.h"
+
+#define OBS_LOG_CHUNK_BYTES (OBS_LOG_CHUNK*(3*sizeof(double)+2*sizeof(float)+ \
+       sizeof(int)+2*sizeof(signed char)))
+#define OBS_LOG_HEAD_BYTES offsetof(Obs_Log_Header,night) /* all but the index */
+
+int open_obs_log(char *file_name, double lat, Obs_Log *log);
+int append_obs_log(Obs_Log *log, Obs_Log_Entry *e);
+void close_obs_log(Obs_Log *log);
+int is_obs_log(char *file_name);
+int map_obs_log(char *file_name, Obs_Log_Map *m);
+void unmap_obs_log(Obs_Log_Map *m);
+int obs_log_columns(Obs_Log_Map *m, int chunk, Obs_Log_Columns *c);
+int obs_log_night(Obs_Log_Map *m, int night, int *first);
+
+/************************************************************/
+
+/* set the columns of chunk, starting at base */
+
+static void set_obs_log_columns(char *base, Obs_Log_Columns *c)
+{
+    c->jd=(double *)base;
+    c->ra=c->jd+OBS_LOG_CHUNK;
+    c->dec=c->ra+OBS_LOG_CHUNK;
+    c->am=(float *)(c->dec+OBS_LOG_CHUNK);
+    c->expt=c->am+OBS_LOG_CHUNK;
+    c->field_number=(int *)(c->expt+OBS_LOG_CHUNK);
+    c->survey_code=(signed char *)(c->field_number+OBS_LOG_CHUNK);
+    c->shutter=c->survey_code+OBS_LOG_CHUNK;
+}
+
+/************************************************************/
+
+/* return 0 if h is the header of a log this code can read */
+
+static int check_obs_log_header(Obs_Log_Header *h, char *file_name)
+{
+    if(strncmp(h->magic,OBS_LOG_MAGIC,8)!=0){
+       fprintf(stderr,"obs_log: %s is not an observation log\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+    if(h->version!=OBS_LOG_VERSION||h->chunk_size!=OBS_LOG_CHUNK){
+       fprintf(stderr,"obs_log: %s is version %d with chunks of %d; expected version %d with chunks of %d\n",
+          file_name,h->version,h->chunk_size,OBS_LOG_VERSION,OBS_LOG_CHUNK);
+       fflush(stderr);
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Open file_name for appending, creating it for a site at latitude lat
+   (deg) if it doesn't exist. Return 0, or -1 on error */
+
+int open_obs_log(char *file_name, double lat, Obs_Log *log)
+{
+    Obs_Log_Header *h;
+    ssize_t n;
+
+    log->fd=open(file_name,O_RDWR|O_CREAT,0644);
+    if(log->fd<0){
+       fprintf(stderr,"open_obs_log: can't open file %s\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    h=&(log->header);
+    n=pread(log->fd,(void *)h,sizeof(Obs_Log_Header),0);
+
+    if(n==0){
+       memset((void *)h,0,sizeof(Obs_Log_Header));
+       memcpy(h->magic,OBS_LOG_MAGIC,8);
+       h->version=OBS_LOG_VERSION;
+       h->chunk_size=OBS_LOG_CHUNK;
+       h->lat=lat;
+       if(pwrite(log->fd,(void *)h,sizeof(Obs_Log_Header),0)!=sizeof(Obs_Log_Header)){
+          fprintf(stderr,"open_obs_log: can't write header of %s\n",file_name);
+          fflush(stderr);
+          close(log->fd);
+          log->fd=-1;
+          return(-1);
+       }
+    }
+    else if(n!=sizeof(Obs_Log_Header)||check_obs_log_header(h,file_name)!=0){
+       fprintf(stderr,"open_obs_log: can't read header of %s\n",file_name);
+       fflush(stderr);
+       close(log->fd);
+       log->fd=-1;
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Append e to the log. Return 0, or -1 on error */
+
+int append_obs_log(Obs_Log *log, Obs_Log_Entry *e)
+{
+    Obs_Log_Header *h;
+    Obs_Log_Night *night;
+    off_t chunk;
+    double sin_alt,am;
+    float am_f,expt_f;
+    signed char survey_code,shutter;
+    int i,n,night_number,nightly;
+
+    if(log->fd<0)return(-1);
+
+    h=&(log->header);
+    i=h->n_records%OBS_LOG_CHUNK;
+    chunk=sizeof(Obs_Log_Header)+(off_t)(h->n_records/OBS_LOG_CHUNK)*OBS_LOG_CHUNK_BYTES;
+
+    sin_alt=sin(e->dec*M_PI/180.0)*sin(h->lat*M_PI/180.0)+
+       cos(e->dec*M_PI/180.0)*cos(h->lat*M_PI/180.0)*cos(e->ha*M_PI/12.0);
+    am=(sin_alt>0.0) ? 1.0/sin_alt : 1000.0;
+    am_f=am;
+    expt_f=e->expt;
+    survey_code=e->survey_code;
+    shutter=e->shutter;
+
+    /* give a new chunk all its space, so a map of the file holds
+       the whole of each chunk */
+
+    if(i==0&&ftruncate(log->fd,chunk+OBS_LOG_CHUNK_BYTES)!=0){
+       fprintf(stderr,"append_obs_log: can't extend the log for record %d\n",h->n_records);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* the columns in the order set_obs_log_columns() puts them */
+
+    n=0;
+    n+=pwrite(log->fd,&(e->jd),sizeof(double),chunk+i*sizeof(double))!=sizeof(double);
+    chunk+=OBS_LOG_CHUNK*sizeof(double);
+    n+=pwrite(log->fd,&(e->ra),sizeof(double),chunk+i*sizeof(double))!=sizeof(double);
+    chunk+=OBS_LOG_CHUNK*sizeof(double);
+    n+=pwrite(log->fd,&(e->dec),sizeof(double),chunk+i*sizeof(double))!=sizeof(double);
+    chunk+=OBS_LOG_CHUNK*sizeof(double);
+    n+=pwrite(log->fd,&am_f,sizeof(float),chunk+i*sizeof(float))!=sizeof(float);
+    chunk+=OBS_LOG_CHUNK*sizeof(float);
+    n+=pwrite(log->fd,&expt_f,sizeof(float),chunk+i*sizeof(float))!=sizeof(float);
+    chunk+=OBS_LOG_CHUNK*sizeof(float);
+    n+=pwrite(log->fd,&(e->field_number),sizeof(int),chunk+i*sizeof(int))!=sizeof(int);
+    chunk+=OBS_LOG_CHUNK*sizeof(int);
+    n+=pwrite(log->fd,&survey_code,1,chunk+i)!=1;
+    chunk+=OBS_LOG_CHUNK;
+    n+=pwrite(log->fd,&shutter,1,chunk+i)!=1;
+    if(n!=0){
+       fprintf(stderr,"append_obs_log: can't write record %d\n",h->n_records);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* index the record with its night */
+
+    night_number=floor(e->jd);
+    nightly=-1;
+    if(h->n_nights>0&&h->night[h->n_nights-1].night==night_number){
+       nightly=h->n_nights-1;
+    }
+    else if(h->n_nights>0&&h->night[h->n_nights-1].night>night_number){
+       h->n_nights=-1; /* out of time order */
+    }
+    else if(h->n_nights>=OBS_LOG_MAX_NIGHTS){
+       h->n_nights=-1; /* too many nights to index */
+    }
+    else if(h->n_nights>=0){
+       nightly=h->n_nights;
+       h->n_nights++;
+       h->night[nightly].night=night_number;
+       h->night[nightly].first=h->n_records;
+       h->night[nightly].n=0;
+    }
+    if(nightly>=0){
+       night=h->night+nightly;
+       night->n++;
+       if(pwrite(log->fd,(void *)night,sizeof(Obs_Log_Night),
+             offsetof(Obs_Log_Header,night)+nightly*sizeof(Obs_Log_Night))!=sizeof(Obs_Log_Night)){
+          fprintf(stderr,"append_obs_log: can't write index of night %d\n",night_number);
+          fflush(stderr);
+          return(-1);
+       }
+    }
+
+    h->n_records++;
+    if(pwrite(log->fd,(void *)h,OBS_LOG_HEAD_BYTES,0)!=OBS_LOG_HEAD_BYTES){
+       fprintf(stderr,"append_obs_log: can't write header\n");
+       fflush(stderr);
+       h->n_records--;
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+void close_obs_log(Obs_Log *log)
+{
+    if(log->fd>=0)close(log->fd);
+    log->fd=-1;
+}
+
+/************************************************************/
+
+/* return 1 if file_name is a binary observation log (and not, say, a
+   text log), 0 if not */
+
+int is_obs_log(char *file_name)
+{
+    FILE *input;
+    char magic[8];
+    int n;
+
+    input=fopen(file_name,"r");
+    if(input==NULL)return(0);
+    n=fread(magic,1,8,input);
+    fclose(input);
+
+    return(n==8&&strncmp(magic,OBS_LOG_MAGIC,8)==0);
+}
+
+/************************************************************/
+
+/* Map file_name for reading. Return the number of records, or -1 on
+   error. Records appended after the map are not seen */
+
+int map_obs_log(char *file_name, Obs_Log_Map *m)
+{
+    struct stat st;
+    Obs_Log_Header *h;
+
+    memset((void *)m,0,sizeof(Obs_Log_Map));
+
+    m->fd=open(file_name,O_RDONLY);
+    if(m->fd<0){
+       fprintf(stderr,"map_obs_log: can't open file %s\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+    if(fstat(m->fd,&st)!=0||st.st_size<sizeof(Obs_Log_Header)){
+       fprintf(stderr,"map_obs_log: %s is too short for an observation log\n",file_name);
+       fflush(stderr);
+       close(m->fd);
+       return(-1);
+    }
+
+    m->size=st.st_size;
+    m->base=mmap(NULL,m->size,PROT_READ,MAP_SHARED,m->fd,0);
+    if(m->base==MAP_FAILED){
+       fprintf(stderr,"map_obs_log: can't map file %s\n",file_name);
+       fflush(stderr);
+       close(m->fd);
+       return(-1);
+    }
+
+    h=(Obs_Log_Header *)m->base;
+    m->header=h;
+    if(check_obs_log_header(h,file_name)!=0){
+       unmap_obs_log(m);
+       return(-1);
+    }
+
+    m->n_records=h->n_records;
+    m->n_chunks=(m->n_records+OBS_LOG_CHUNK-1)/OBS_LOG_CHUNK;
+    if(sizeof(Obs_Log_Header)+(size_t)m->n_chunks*OBS_LOG_CHUNK_BYTES>m->size){
+       fprintf(stderr,"map_obs_log: %s is shorter than its %d records\n",
+          file_name,m->n_records);
+       fflush(stderr);
+       unmap_obs_log(m);
+       return(-1);
+    }
+
+    madvise(m->base,m->size,MADV_SEQUENTIAL);
+
+    return(m->n_records);
+}
+
+/************************************************************/
+
+void unmap_obs_log(Obs_Log_Map *m)
+{
+    if(m->base!=NULL&&m->base!=MAP_FAILED)munmap(m->base,m->size);
+    if(m->fd>=0)close(m->fd);
+    m->base=NULL;
+    m->header=NULL;
+    m->fd=-1;
+}
+
+/************************************************************/
+
+/* Set c to the columns of chunk of m. Return the number of records in
+   the chunk, or -1 if there is no such chunk */
+
+int obs_log_columns(Obs_Log_Map *m, int chunk, Obs_Log_Columns *c)
+{
+    if(chunk<0||chunk>=m->n_chunks)return(-1);
+
+    set_obs_log_columns(m->base+sizeof(Obs_Log_Header)+(size_t)chunk*OBS_LOG_CHUNK_BYTES,c);
+    c->first=chunk*OBS_LOG_CHUNK;
+    c->n=m->n_records-c->first;
+    if(c->n>OBS_LOG_CHUNK)c->n=OBS_LOG_CHUNK;
+
+    return(c->n);
+}
+
+/************************************************************/
+
+/* Set *first to the first record of night (the integer part of its jd).
+   Return the number of records of the night (0 if none), or -1 if the
+   log has no index of its nights */
+
+int obs_log_night(Obs_Log_Map *m, int night, int *first)
+{
+    Obs_Log_Night *nights;
+    int lo,hi,mid,n_nights;
+
+    n_nights=m->header->n_nights;
+    if(n_nights<0)return(-1);
+
+    nights=m->header->night;
+    lo=0;
+    hi=n_nights-1;
+    while(lo<=hi){
+       mid=(lo+hi)/2;
+       if(nights[mid].night==night){
+          *first=nights[mid].first;
+          /* records appended after the map are not seen */
+          if(*first>=m->n_records)return(0);
+          if(*first+nights[mid].n>m->n_records)return(m->n_records-*first);
+          return(nights[mid].n);
+       }
+       if(nights[mid].night<night)lo=mid+1;
+       else hi=mid-1;
+    }
+
+    *first=m->n_records;
+    return(0);
+}
+
+/************************************************************/
@@ -0,0 +1,108 @@
+#ifndef __obs_log_h
+#define __obs_log_h
+
+/* obs_log.h
+
+   The binary observation log: the exposures of LOG_OBS_FILE in fixed
+   width columns, with an index of the nights, that the analysis tools
+   can map into memory and scan in place of parsing the text log
+   (see obs_log.c).
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+
+#define OBS_LOG_FILE "log.obs.bin" /* binary twin of LOG_OBS_FILE */
+#define OBS_LOG_MAGIC "LS4OBSLG" /* first 8 bytes of the file */
+#define OBS_LOG_VERSION 1
+#define OBS_LOG_CHUNK 4096 /* records in each chunk of columns */
+#define OBS_LOG_MAX_NIGHTS 8192 /* nights indexed (over 20 years) */
+#define OBS_LOG_NO_SURVEY -1 /* survey code of a record converted from text */
+
+/* the records of one night, numbered by the integer part of the jd
+   (which changes at noon UT, in the day at the sites in Chile) */
+
+typedef struct {
+    int night; /* integer part of the jd */
+    int first; /* first record of the night */
+    int n; /* records of the night */
+} Obs_Log_Night;
+
+/* the start of the file. The index is valid while the records come in
+   time order; if one comes after a later night, n_nights is set to -1 */
+
+typedef struct {
+    char magic[8]; /* OBS_LOG_MAGIC, not terminated */
+    int version; /* OBS_LOG_VERSION */
+    int chunk_size; /* OBS_LOG_CHUNK */
+    int n_records;
+    int n_nights; /* nights in the index, or -1 if not indexed */
+    double lat; /* site latitude (deg), for the airmass */
+    Obs_Log_Night night[OBS_LOG_MAX_NIGHTS];
+} Obs_Log_Header;
+
+/* one exposure, as appended to the log */
+
+typedef struct {
+    double jd; /* start of the exposure */
+    double ra; /* hours */
+    double dec; /* deg */
+    double ha; /* hours, for the airmass */
+    double expt; /* requested exposure (sec) */
+    int field_number;
+    int survey_code; /* or OBS_LOG_NO_SURVEY */
+    int shutter; /* shutter code (SKY_CODE, FOCUS_CODE, ...) */
+} Obs_Log_Entry;
+
+/* the log open for appending */
+
+typedef struct {
+    int fd;
+    Obs_Log_Header header; /* as last written */
+} Obs_Log;
+
+/* the log mapped for reading */
+
+typedef struct {
+    int fd;
+    size_t size;
+    char *base;
+    Obs_Log_Header *header;
+    int n_records; /* when mapped */
+    int n_chunks;
+} Obs_Log_Map;
+
+/* the columns of one chunk of a mapped log. Record i of the chunk is
+   record first+i of the log */
+
+typedef struct {
+    int first;
+    int n;
+    double *jd;
+    double *ra;
+    double *dec;
+    float *am; /* airmass (1000 below the horizon) */
+    float *expt;
+    int *field_number;
+    signed char *survey_code;
+    signed char *shutter;
+} Obs_Log_Columns;
+
+int open_obs_log(char *file_name, double lat, Obs_Log *log);
+
+int append_obs_log(Obs_Log *log, Obs_Log_Entry *e);
+
+void close_obs_log(Obs_Log *log);
+
+int is_obs_log(char *file_name);
+
+int map_obs_log(char *file_name, Obs_Log_Map *m);
+
+void unmap_obs_log(Obs_Log_Map *m);
+
+int obs_log_columns(Obs_Log_Map *m, int chunk, Obs_Log_Columns *c);
+
+int obs_log_night(Obs_Log_Map *m, int night, int *first);
+
+#endif
@@ -0,0 +1,108 @@
+/* obs_log_convert.c
+
+   2026 Oct 14
+
+   Append the exposures of a text log (LOG_OBS_FILE, or the log printed
+   by sched_sim) to a binary observation log (see obs_log.c), so the logs
+   written before the scheduler wrote OBS_LOG_FILE can be read by the
+   same tools. The text log has no survey codes: a record gets
+   TNO_SURVEY_CODE if the comment of its line names a TNO field
+   ("track" or "TNO", as get_time_history reads text logs), and
+   OBS_LOG_NO_SURVEY otherwise. Lines that are not exposures are
+   skipped.
+
+   For the index of nights, the log should be in time order
+   (sort -n -k 7 first if it is not).
+
+   syntax: obs_log_convert log_file binary_log [latitude]
+
+   where latitude (deg) is the site latitude for the airmass, by default
+   that of ESO La Silla. It is used only if binary_log is new.
+*/
+
+#include "scheduler.h"
+
+#define LA_SILLA_LAT -29.257
+
+/************************************************************/
+
+/* return the shutter code of the log letter s, or BAD_CODE */
+
+static int shutter_code(char *s)
+{
+    if(strcmp(s,DARK_STRING_LC)==0)return(DARK_CODE);
+    if(strcmp(s,SKY_STRING_LC)==0)return(SKY_CODE);
+    if(strcmp(s,FOCUS_STRING_LC)==0)return(FOCUS_CODE);
+    if(strcmp(s,OFFSET_STRING_LC)==0)return(OFFSET_CODE);
+    if(strcmp(s,EVENING_FLAT_STRING_LC)==0)return(EVENING_FLAT_CODE);
+    if(strcmp(s,MORNING_FLAT_STRING_LC)==0)return(MORNING_FLAT_CODE);
+    if(strcmp(s,DOME_FLAT_STRING_LC)==0)return(DOME_FLAT_CODE);
+
+    return(BAD_CODE);
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    FILE *input;
+    Obs_Log log;
+    Obs_Log_Entry e;
+    char string[STR_BUF_LEN],shutter_string[STR_BUF_LEN],s[STR_BUF_LEN],*comment;
+    double lat,actual_expt;
+    int n_done,n_lines,n_records;
+
+    if(argc!=3&&argc!=4){
+       fprintf(stderr,"syntax: obs_log_convert log_file binary_log [latitude]\n");
+       exit(-1);
+    }
+
+    lat=LA_SILLA_LAT;
+    if(argc==4)sscanf(argv[3],"%lf",&lat);
+
+    input=fopen(argv[1],"r");
+    if(input==NULL){
+       fprintf(stderr,"can't open file %s for input\n",argv[1]);
+       exit(-1);
+    }
+
+    if(open_obs_log(argv[2],lat,&log)!=0){
+       fprintf(stderr,"can't open binary log %s\n",argv[2]);
+       exit(-1);
+    }
+
+/*
+ 13.359190  13.626470 s 2   60.0  10.646 2454207.943576  60.250 20070417103845s # sky 15 2 2800
+*/
+    n_lines=0;
+    n_records=0;
+    while(fgets(string,STR_BUF_LEN,input)!=NULL){
+       n_lines++;
+       if(sscanf(string,"%lf %lf %s %d %lf %lf %lf %lf",&e.ra,&e.dec,shutter_string,
+             &n_done,&e.expt,&e.ha,&e.jd,&actual_expt)!=8)continue;
+       comment=strstr(string,"#");
+       if(comment==NULL||sscanf(comment+1,"%s %d",s,&e.field_number)!=2)continue;
+       e.shutter=shutter_code(shutter_string);
+       if(strstr(comment,"track")!=NULL||strstr(comment,"TNO")!=NULL){
+          e.survey_code=TNO_SURVEY_CODE;
+       }
+       else{
+          e.survey_code=OBS_LOG_NO_SURVEY;
+       }
+
+       if(append_obs_log(&log,&e)!=0){
+          fprintf(stderr,"error converting line %d of %s\n",n_lines,argv[1]);
+          exit(-1);
+       }
+       n_records++;
+    }
+
+    fclose(input);
+
+    fprintf(stderr,"# %d of %d lines converted, %d nights indexed\n",n_records,n_lines,
+       log.header.n_nights);
+
+    close_obs_log(&log);
+
+    exit(0);
+}
@@ -0,0 +1,518 @@
+/* sched_bench.c
+
+   2026 Oct 14
+
+   Time the CPU-bound paths of the scheduler: load_sequence(),
+   init_fields(), get_next_field() and select_next_field(),
+   save_obs_record() and load_obs_record(), print_tonight() and
+   compute_night_times(), and parse_status().
+
+   Each sequence file is timed in turn against the same fixtures: the
+   Fake site, the night of BENCH_YEAR BENCH_MONTH BENCH_DAY, and a
+   fixed camera status reply. Field selection is timed over a night
+   observed on the virtual clock and hardware (scheduler_backend.c).
+   For each function and sequence a line
+
+      bench name n_fields n_calls mean_usec p50_usec p90_usec p99_usec max_usec
+
+   is printed to stdout, and for each sequence a line
+
+      memory n_fields field_bytes max_rss_kb
+
+   If a baseline (the saved output of an earlier run) is given, the
+   median of each function is compared with the one in the baseline,
+   and the functions more than BENCH_SLOWER_RATIO times slower are
+   flagged. The exit status is then the number flagged.
+
+   syntax: sched_bench [-b baseline_file] sequence_file [sequence_file ...]
+
+   "make bench" makes sequences of several sizes with make_sequence
+   and runs this on them (see the Makefile).
+*/
+
+#include "scheduler.h"
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define BENCH_YEAR 2026
+#define BENCH_MONTH 3
+#define BENCH_DAY 1
+#define BENCH_REPEATS 20 /* calls of load_sequence, init_fields, and the obs record */
+#define BENCH_NIGHT_REPEATS 50 /* calls of print_tonight, compute_night_times */
+#define BENCH_SELECT_CALLS 1000 /* most selections timed in a night */
+#define BENCH_SAVE_CALLS 200 /* most save_obs_record calls timed */
+#define BENCH_STATUS_CALLS 10000 /* calls of parse_status */
+#define BENCH_SLOWER_RATIO 1.25 /* median this much slower than baseline is flagged */
+#define BENCH_MAX_BASELINE 256 /* lines kept from the baseline */
+#define BENCH_RECORD_FILE "/tmp/sched_bench.bin" /* obs record written and read */
+
+extern int verbose;
+extern int verbose1;
+
+/* a camera status reply as ls4_ccp sends it */
+
+static char bench_status_reply[]=
+  "[DONE {'ready': True, 'state': 'started', 'error': False, 'comment': 'started', "
+  "'date': '2025-06-24T20:15:56.00', 'NOSTATUS': '0000', 'UNKNOWN': '0000', "
+  "'IDLE': '1111', 'EXPOSING': '0000', 'READOUT_PENDING': '0000', 'READING': '0000', "
+  "'FETCHING': '0000', 'FLUSHING': '0000', 'ERASING': '0000', 'PURGING': '0000', "
+  "'AUTOCLEAR': '0000', 'AUTOFLUSH': '0000', 'POWERON': '1111', 'POWEROFF': '0000', "
+  "'POWERBAD': '0000', 'FETCH_PENDING': '0000', 'ERROR': '0000', 'ACTIVE': '1111', "
+  "'ERRORED': '0000'}]";
+
+typedef struct {
+    char name[STR_BUF_LEN];
+    int n_fields;
+    double p50;
+} Bench_Baseline;
+
+static Bench_Baseline baseline[BENCH_MAX_BASELINE];
+static int num_baseline=0;
+static int num_slower=0;
+
+/************************************************************/
+
+static double bench_usec()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC,&t);
+
+    return(t.tv_sec*1.0e6+t.tv_nsec*1.0e-3);
+}
+
+/************************************************************/
+
+static int compare_double(const void *a, const void *b)
+{
+    double x=*(double *)a,y=*(double *)b;
+
+    return(x<y ? -1 : (x>y ? 1 : 0));
+}
+
+/************************************************************/
+
+/* read the bench lines of an earlier run. Return the number read,
+   or -1 if the file can't be read */
+
+static int load_baseline(char *file_name)
+{
+    FILE *input;
+    char string[STR_BUF_LEN],name[STR_BUF_LEN];
+    int n_fields,n_calls;
+    double mean,p50;
+
+    input=fopen(file_name,"r");
+    if(input==NULL){
+       fprintf(stderr,"sched_bench: can't open baseline %s\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    while(fgets(string,STR_BUF_LEN,input)!=NULL&&num_baseline<BENCH_MAX_BASELINE){
+       if(sscanf(string,"bench %s %d %d %lf %lf",name,&n_fields,&n_calls,&mean,&p50)!=5)continue;
+       strcpy(baseline[num_baseline].name,name);
+       baseline[num_baseline].n_fields=n_fields;
+       baseline[num_baseline].p50=p50;
+       num_baseline++;
+    }
+
+    fclose(input);
+
+    return(num_baseline);
+}
+
+/************************************************************/
+
+/* print the distribution of the n call times in usec (sorted here),
+   and compare its median with the baseline */
+
+static void report(char *name, int n_fields, double *usec, int n)
+{
+    double mean;
+    int i;
+
+    if(n<1)return;
+
+    qsort((void *)usec,n,sizeof(double),compare_double);
+    mean=0.0;
+    for(i=0;i<n;i++)mean=mean+usec[i];
+    mean=mean/n;
+
+    printf("bench %-20s %6d %6d %12.3f %12.3f %12.3f %12.3f %12.3f",
+       name,n_fields,n,mean,usec[n/2],usec[(9*n)/10],usec[(99*n)/100],usec[n-1]);
+
+    for(i=0;i<num_baseline;i++){
+       if(baseline[i].n_fields==n_fields&&strcmp(baseline[i].name,name)==0)break;
+    }
+    if(i<num_baseline&&baseline[i].p50>0.0){
+       printf("   %6.2f x baseline",usec[n/2]/baseline[i].p50);
+       if(usec[n/2]>BENCH_SLOWER_RATIO*baseline[i].p50){
+          printf("  SLOWER");
+          num_slower++;
+       }
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/************************************************************/
+
+/* send stdout and stderr to /dev/null (quiet=1) or back (quiet=0), for
+   the functions that print as they go */
+
+static void bench_quiet(int quiet)
+{
+    static int saved_stdout=-1,saved_stderr=-1;
+    int fd;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    if(quiet&&saved_stdout<0){
+       fd=open("/dev/null",O_WRONLY);
+       if(fd<0)return;
+       saved_stdout=dup(1);
+       saved_stderr=dup(2);
+       dup2(fd,1);
+       dup2(fd,2);
+       close(fd);
+    }
+    else if(!quiet&&saved_stdout>=0){
+       dup2(saved_stdout,1);
+       dup2(saved_stderr,2);
+       close(saved_stdout);
+       close(saved_stderr);
+       saved_stdout=-1;
+       saved_stderr=-1;
+    }
+}
+
+/************************************************************/
+
+static void free_store(Field_Store *store)
+{
+    truncate_field_store(store,0);
+    if(store->fields!=NULL)free(store->fields);
+    init_field_store(store);
+}
+
+/************************************************************/
+
+/* time a night of selections with get_next_field() (event_driven=0)
+   or select_next_field() (event_driven=1), observing each field chosen
+   on the virtual hardware */
+
+static int bench_selection(Field_Store *store, Field *saved, int num_fields,
+       Night_Times *nt, Night_Times *nt_5day, Night_Times *nt_10day,
+       Night_Times *nt_15day, Site_Params *site, struct date_time date,
+       int event_driven, double *usec)
+{
+    Sched_Clock clock;
+    Sched_Hardware hw;
+    Field_Selector selector;
+    Telescope_Status tel_status;
+    double jd,dt,t0;
+    int i,i_prev,n;
+
+    memset((void *)&tel_status,0,sizeof(Telescope_Status));
+    restore_fields(store,saved,num_fields);
+    init_fields(store->fields,num_fields,nt,nt_5day,nt_10day,nt_15day,site,
+         nt->jd_sunset,&tel_status);
+    init_virtual_clock(&clock,nt->jd_sunset);
+    init_virtual_hardware(&hw,&clock,NULL,NULL,date);
+    if(init_field_selector(&selector)!=0)return(0);
+
+    n=0;
+    i_prev=-1;
+    jd=clock.now(&clock);
+    while(jd<nt->jd_sunrise&&n<BENCH_SELECT_CALLS){
+       t0=bench_usec();
+       if(event_driven){
+          i=select_next_field(&selector,store->fields,num_fields,i_prev,jd,0);
+       }
+       else{
+          i=get_next_field(store->fields,num_fields,i_prev,jd,0);
+       }
+       usec[n++]=bench_usec()-t0;
+
+       if(i>=0){
+          hw.observe(&hw,store->fields,i,i_prev,jd,&dt,nt);
+          touch_field(&selector,i);
+          if(i_prev>=0)touch_field(&selector,i_prev);
+          if(clock.now(&clock)<=jd)clock.wait(&clock,LOOP_WAIT_SEC);
+          i_prev=i;
+       }
+       else{
+          clock.wait(&clock,LOOP_WAIT_SEC);
+       }
+       jd=clock.now(&clock);
+    }
+
+    free_field_selector(&selector);
+
+    return(n);
+}
+
+/************************************************************/
+
+/* time the obs record: the first save (every field), then a save
+   after each of a night of observations, then reading it back */
+
+static void bench_obs_record(Field_Store *store, Field *saved, int num_fields,
+       Night_Times *nt, Night_Times *nt_5day, Night_Times *nt_10day,
+       Night_Times *nt_15day, Site_Params *site, double *usec)
+{
+    Field_Store loaded;
+    Telescope_Status tel_status;
+    FILE *obs_record;
+    struct tm tm;
+    double t0,jd;
+    int i,n,k;
+
+    memset((void *)&tel_status,0,sizeof(Telescope_Status));
+    memset((void *)&tm,0,sizeof(struct tm));
+    restore_fields(store,saved,num_fields);
+    init_fields(store->fields,num_fields,nt,nt_5day,nt_10day,nt_15day,site,
+         nt->jd_sunset,&tel_status);
+    /* the first save of a new record, BENCH_REPEATS times. The last
+       record is left open for the saves after each observation.
+       load_obs_record() reports what it has read */
+
+    for(n=0;n<BENCH_REPEATS;n++){
+       for(i=0;i<num_fields;i++){
+          store->fields[i].n_saved=-1;
+          store->fields[i].jd_saved=0.0;
+       }
+
+       bench_quiet(1);
+       unlink(BENCH_RECORD_FILE);
+       init_field_store(&loaded);
+       k=load_obs_record(BENCH_RECORD_FILE,&loaded,&obs_record);
+       free_store(&loaded);
+       bench_quiet(0);
+       if(k<0)return;
+
+       t0=bench_usec();
+       save_obs_record(store->fields,obs_record,num_fields,&tm);
+       usec[n]=bench_usec()-t0;
+       if(n<BENCH_REPEATS-1)fclose(obs_record);
+    }
+    report("save_obs_record_all",num_fields,usec,n);
+
+    /* one more observation of a different field before each save */
+
+    n=0;
+    jd=nt->jd_start;
+    for(k=0;k<num_fields&&n<BENCH_SAVE_CALLS;k++){
+       i=(k*7919)%num_fields;
+       if(store->fields[i].n_done>=store->fields[i].n_required)continue;
+       store->fields[i].history->jd[store->fields[i].n_done]=jd;
+       store->fields[i].n_done++;
+       jd=jd+(store->fields[i].expt+exposure_overhead(store->fields[i].shutter))/24.0;
+
+       t0=bench_usec();
+       save_obs_record(store->fields,obs_record,num_fields,&tm);
+       usec[n++]=bench_usec()-t0;
+    }
+    report("save_obs_record",num_fields,usec,n);
+    fclose(obs_record);
+
+    bench_quiet(1);
+    for(n=0;n<BENCH_REPEATS;n++){
+       init_field_store(&loaded);
+       t0=bench_usec();
+       load_obs_record(BENCH_RECORD_FILE,&loaded,&obs_record);
+       usec[n]=bench_usec()-t0;
+       if(obs_record!=NULL)fclose(obs_record);
+       free_store(&loaded);
+    }
+    bench_quiet(0);
+    report("load_obs_record",num_fields,usec,n);
+
+    unlink(BENCH_RECORD_FILE);
+}
+
+/************************************************************/
+
+static int bench_sequence(char *file_name, Site_Params *site, struct date_time date,
+       Night_Times *nt, Night_Times *nt_5day, Night_Times *nt_10day,
+       Night_Times *nt_15day)
+{
+    Field_Store store;
+    Field *saved;
+    Telescope_Status tel_status;
+    struct rusage usage;
+    double *usec,t0;
+    int n,num_fields,n_calls;
+
+    n_calls=BENCH_SELECT_CALLS;
+    if(n_calls<BENCH_SAVE_CALLS)n_calls=BENCH_SAVE_CALLS;
+    if(n_calls<BENCH_REPEATS)n_calls=BENCH_REPEATS;
+    usec=(double *)malloc(n_calls*sizeof(double));
+    if(usec==NULL){
+       fprintf(stderr,"sched_bench: can't allocate %d times\n",n_calls);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* load_sequence */
+
+    num_fields=0;
+    for(n=0;n<BENCH_REPEATS;n++){
+       init_field_store(&store);
+       t0=bench_usec();
+       num_fields=load_sequence(file_name,&store,0);
+       usec[n]=bench_usec()-t0;
+       if(num_fields<1){
+          fprintf(stderr,"sched_bench: can't load sequence %s\n",file_name);
+          fflush(stderr);
+          free(usec);
+          return(-1);
+       }
+       if(n<BENCH_REPEATS-1)free_store(&store);
+    }
+    report("load_sequence",num_fields,usec,n);
+
+    saved=(Field *)malloc(num_fields*sizeof(Field));
+    if(saved==NULL){
+       fprintf(stderr,"sched_bench: can't allocate %d fields\n",num_fields);
+       fflush(stderr);
+       free(usec);
+       return(-1);
+    }
+    memcpy((void *)saved,(void *)store.fields,num_fields*sizeof(Field));
+
+    /* init_fields */
+
+    memset((void *)&tel_status,0,sizeof(Telescope_Status));
+    for(n=0;n<BENCH_REPEATS;n++){
+       restore_fields(&store,saved,num_fields);
+       t0=bench_usec();
+       init_fields(store.fields,num_fields,nt,nt_5day,nt_10day,nt_15day,site,
+          nt->jd_sunset,&tel_status);
+       usec[n]=bench_usec()-t0;
+    }
+    report("init_fields",num_fields,usec,n);
+
+    /* field selection through a night */
+
+    n=bench_selection(&store,saved,num_fields,nt,nt_5day,nt_10day,nt_15day,
+          site,date,0,usec);
+    report("get_next_field",num_fields,usec,n);
+
+    n=bench_selection(&store,saved,num_fields,nt,nt_5day,nt_10day,nt_15day,
+          site,date,1,usec);
+    report("select_next_field",num_fields,usec,n);
+
+    bench_obs_record(&store,saved,num_fields,nt,nt_5day,nt_10day,nt_15day,
+          site,usec);
+
+    getrusage(RUSAGE_SELF,&usage);
+    printf("memory %6d %12ld %12ld\n",num_fields,
+        (long)(store.max_fields*sizeof(Field)),(long)usage.ru_maxrss);
+    fflush(stdout);
+
+    free(saved);
+    free_store(&store);
+    free(usec);
+
+    return(0);
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    struct date_time date,date_n;
+    Night_Times nt,nt_5day,nt_10day,nt_15day,nt_test;
+    Site_Params site;
+    Camera_Status cam_status;
+    double usec[BENCH_STATUS_CALLS],t0;
+    int i,n;
+
+    verbose=0;
+    verbose1=0;
+
+    i=1;
+    if(argc>2&&strcmp(argv[1],"-b")==0){
+       if(load_baseline(argv[2])<0)exit(-1);
+       i=3;
+    }
+    if(i>=argc){
+       fprintf(stderr,
+         "syntax: sched_bench [-b baseline_file] sequence_file [sequence_file ...]\n");
+       exit(-1);
+    }
+
+    date.y=BENCH_YEAR;
+    date.mo=BENCH_MONTH;
+    date.d=BENCH_DAY;
+    date.h=0;
+    date.mn=0;
+    date.s=0;
+
+    init_overhead_model(&overhead_model);
+
+    memset((void *)&site,0,sizeof(Site_Params));
+    strcpy(site.site_name,"Fake");
+    bench_quiet(1);
+    load_site(&site.longit,&site.lat,&site.stdz,&site.use_dst,site.zone_name,&site.zabr,
+            &site.elevsea,&site.elev,&site.horiz,site.site_name);
+    bench_quiet(0);
+
+    date_n=date;
+    adjust_date(&date_n,5);
+    init_night(date_n,&nt_5day,&site,0);
+    date_n=date;
+    adjust_date(&date_n,10);
+    init_night(date_n,&nt_10day,&site,0);
+    date_n=date;
+    adjust_date(&date_n,15);
+    init_night(date_n,&nt_15day,&site,0);
+    init_night(date,&nt,&site,0);
+
+    printf("# bench name n_fields n_calls mean_usec p50_usec p90_usec p99_usec max_usec\n");
+    printf("# memory n_fields field_bytes max_rss_kb\n");
+
+    /* the fixtures that do not depend on the sequence */
+
+    bench_quiet(1);
+    for(n=0;n<BENCH_NIGHT_REPEATS;n++){
+       nt_test=nt;
+       t0=bench_usec();
+       print_tonight(date,site.lat,site.longit,site.elevsea,site.elev,site.horiz,
+              site.site_name,site.stdz,site.zone_name,site.zabr,site.use_dst,
+              &(site.jdb),&(site.jde),2,&nt_test,1);
+       usec[n]=bench_usec()-t0;
+    }
+    bench_quiet(0);
+    report("print_tonight",0,usec,n);
+
+    for(n=0;n<BENCH_NIGHT_REPEATS;n++){
+       nt_test=nt;
+       t0=bench_usec();
+       compute_night_times(date,site.lat,site.longit,site.elevsea,site.horiz,
+              site.stdz,site.use_dst,&(site.jdb),&(site.jde),&nt_test);
+       usec[n]=bench_usec()-t0;
+    }
+    report("compute_night_times",0,usec,n);
+
+    init_status_names();
+    for(n=0;n<BENCH_STATUS_CALLS;n++){
+       t0=bench_usec();
+       parse_status(bench_status_reply,&cam_status);
+       usec[n]=bench_usec()-t0;
+    }
+    report("parse_status",0,usec,n);
+
+    for(;i<argc;i++){
+       if(bench_sequence(argv[i],&site,date,&nt,&nt_5day,&nt_10day,&nt_15day)!=0){
+          exit(-1);
+       }
+    }
+
+    exit(num_slower);
+}
@@ -0,0 +1,163 @@
+/* sched_sim.c
+
+   2026 Oct 14
+
+   Simulate the scheduler over a run of nights.
+
+   The sequence is read once. For each night the fields are set up with
+   init_fields() and observed with run_night() (scheduler_backend.c) on
+   the virtual hardware and a virtual clock, so the fields are chosen by
+   the same code the scheduler runs (libls4sched.a), with no waiting and
+   no rebuild. A semester of nights takes seconds.
+
+   The exposure log (in the format of LOG_OBS_FILE) is printed to
+   stdout, and a summary of each night to stderr. The overheads are
+   read from OVERHEAD_MODEL_FILE if it is in the current directory,
+   as by the scheduler.
+
+   syntax: sched_sim sequence_file yyyy mm dd n_nights verbose_flag [weather_file]
+
+   where yyyy mm dd is the local date of the first night. The weather
+   file lists when the dome is open (see check_weather()).
+*/
+
+#include "scheduler.h"
+#include <sys/time.h>
+
+extern int verbose;
+extern int verbose1;
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    struct date_time date,date_5day,date_10day,date_15day;
+    Night_Times nt,nt_5day,nt_10day,nt_15day;
+    Site_Params site;
+    Telescope_Status tel_status;
+    Field_Store store;
+    Field *saved;
+    Sched_Clock clock;
+    Sched_Hardware hw;
+    Night_Summary summary;
+    FILE *weather_input;
+    Weather_Timeline weather,*weather_ptr;
+    struct timeval t0,t1;
+    int n,n_nights,num_fields,num_observable_fields;
+    int total_exposures;
+
+    if(argc!=7&&argc!=8){
+       fprintf(stderr,
+         "syntax: sched_sim sequence_file yyyy mm dd n_nights verbose_flag [weather_file]\n");
+       exit(-1);
+    }
+
+    sscanf(argv[2],"%hd",&(date.y));
+    sscanf(argv[3],"%hd",&(date.mo));
+    sscanf(argv[4],"%hd",&(date.d));
+    sscanf(argv[5],"%d",&n_nights);
+    sscanf(argv[6],"%d",&verbose);
+    if (verbose > 1)verbose1=1;
+    date.h=0;
+    date.mn=0;
+    date.s=0;
+
+    weather_ptr=NULL;
+    if(argc==8){
+       weather_input=fopen(argv[7],"r");
+       if(weather_input==NULL){
+          fprintf(stderr,"can't open weather file %s\n",argv[7]);
+          exit(-1);
+       }
+       if(load_weather_timeline(weather_input,&weather)<0){
+          fprintf(stderr,"can't read weather file %s\n",argv[7]);
+          exit(-1);
+       }
+       fclose(weather_input);
+       weather_ptr=&weather;
+    }
+
+    init_field_store(&store);
+    num_fields=load_sequence(argv[1],&store,0);
+    if(num_fields<1){
+       fprintf(stderr,"Error loading script %s\n",argv[1]);
+       exit(-1);
+    }
+
+    /* the overheads the scheduler would use (see scheduler_overhead.c) */
+
+    init_overhead_model(&overhead_model);
+    if(load_overhead_model(OVERHEAD_MODEL_FILE,&overhead_model)>=0){
+       fprintf(stderr,"# overheads from %s, fitted from %d observations\n",
+          OVERHEAD_MODEL_FILE,overhead_model.n_fit);
+    }
+
+    /* start each night from the sequence as read */
+
+    saved=(Field *)malloc(num_fields*sizeof(Field));
+    if(saved==NULL){
+       fprintf(stderr,"sched_sim: can't allocate %d fields\n",num_fields);
+       exit(-1);
+    }
+    memcpy((void *)saved,(void *)store.fields,num_fields*sizeof(Field));
+
+    /* same site as the scheduler */
+
+    strcpy(site.site_name,"Fake");
+    load_site(&site.longit,&site.lat,&site.stdz,&site.use_dst,site.zone_name,&site.zabr,
+            &site.elevsea,&site.elev,&site.horiz,site.site_name);
+
+    memset((void *)&tel_status,0,sizeof(Telescope_Status));
+
+    gettimeofday(&t0,NULL);
+    total_exposures=0;
+
+    for(n=0;n<n_nights;n++){
+
+       date_5day=date;
+       adjust_date(&date_5day,5);
+       init_night(date_5day,&nt_5day,&site,0);
+       date_10day=date;
+       adjust_date(&date_10day,10);
+       init_night(date_10day,&nt_10day,&site,0);
+       date_15day=date;
+       adjust_date(&date_15day,15);
+       init_night(date_15day,&nt_15day,&site,0);
+       init_night(date,&nt,&site,verbose);
+
+       /* start at sunset, as "scheduler -s" does */
+
+       restore_fields(&store,saved,num_fields);
+       num_observable_fields=init_fields(store.fields,num_fields,
+               &nt,&nt_5day,&nt_10day,&nt_15day,&site,nt.jd_sunset,&tel_status);
+
+       init_virtual_clock(&clock,nt.jd_sunset);
+       init_virtual_hardware(&hw,&clock,stdout,weather_ptr,date);
+
+       if(run_night(&store,&nt,&clock,&hw,NULL,&summary)<0){
+          fprintf(stderr,"sched_sim: error simulating night %04d %02d %02d\n",
+             date.y,date.mo,date.d);
+          exit(-1);
+       }
+       total_exposures=total_exposures+summary.n_exposures;
+
+       fprintf(stderr,
+         "# %04d %02d %02d : %d fields observable  %d exposures  %d fields completed  %d errors  observing %7.3f h  idle %7.3f h\n",
+         date.y,date.mo,date.d,num_observable_fields,summary.n_exposures,
+         summary.n_completed,summary.n_errors,summary.t_observing,summary.t_idle);
+       fflush(stderr);
+
+       adjust_date(&date,1);
+    }
+
+    gettimeofday(&t1,NULL);
+
+    fprintf(stderr,"# %d nights  %d exposures  simulated in %7.3f sec\n",
+       n_nights,total_exposures,
+       (t1.tv_sec-t0.tv_sec)+(t1.tv_usec-t0.tv_usec)*1.0e-6);
+    fflush(stderr);
+
+    if(weather_ptr!=NULL)free_weather_timeline(weather_ptr);
+
+    exit(0);
+}
@@ -15,15 +15,25 @@
 #include <time.h>
 #include <signal.h>
 #include <unistd.h>
+#include <sys/types.h>
 #include "sky_utils.h"
+#include "sky_window.h"
+#include "weather_timeline.h"
+#include "scheduler_log.h"
+#include "scheduler_metrics.h"
+#include "scheduler_overhead.h"
+#include "scheduler_focus.h"
+#include "obs_log.h"
+#include "scheduler_history.h"
 #include "socket.h"
+#include "socket_trace.h"
 #include "scheduler_camera.h"
+#include "scheduler_control.h"
 
 #define False false
 #define True true
 
 #define SNE_SHIFT 0 /* set to 1 to shift paired fields by 1.0 deg, 0 for 0.5 deg */
-#define FAKE_RUN 0 /* set to 1 for simulated obs */
 #define UT_OFFSET 0.00 /* ut offset for debugging */
 #define DEEP_DITHER_ON 0 /* turn on dithering for deep coadds */
 #
@@ -33,12 +43,25 @@
 /*#define POINTING_TEST*/ /* define to break up all exposures longer than LONG_EXPOSURE,
                          both west and east of the meridian */
 
+#define EVENT_DRIVEN_SELECTION 1 /* set to 0 to choose fields with the linear scan in
+                                  get_next_field() instead of select_next_field() */
+
+#define LOOKAHEAD_PLANNING 0 /* set to 1 to check each free choice of field with a
+                                lookahead beam search (see scheduler_plan.c) */
+
+#define ADAPTIVE_FOCUS 0 /* set to 1 to fit each exposure of a focus sequence and stop
+                            early, instead of stepping through all n_required
+                            settings (see scheduler_focus.c). Needs FWHM_SCRIPT */
+
 #define POINTING_CORRECTIONS_ON 0 /* set to 1 to apply empirical pointing corrections*/
 #define TRACKING_CORRECTIONS_ON 0 /* set to 1 to apply empirical tracking corrections*/
 
 #define DEG_TO_RAD (3.14159/180.0)
 #define SIDEREAL_DAY_IN_HOURS 23.93446972
 
+#define LOOP_WAIT_SEC 10 /* seconds to wait between loops if no
+               field selected */
+
 #define SKYFLAT_WAIT_TIME (0.5/24) /* wait half hour after sunset or stop
                                       half hour before sunset for skyflats */
 
@@ -50,16 +73,15 @@
 #define SELECTED_FIELDS_FILE "fields.completed"
 #define LOG_OBS_FILE "log.obs"
 #define OBS_RECORD_FILE "scheduler.bin"  /* binary record of fields */
+#define SIM_FILE_PREFIX "sim_" /* put in front of the file names above by scheduler -s */
 
 #define DEGTORAD 57.29577951 /* 180/pi */
 //#define LST_SEARCH_INCREMENT 0.0166 /* 1 minute in hours */
 #define LST_SEARCH_INCREMENT 0.00166 /* 1 minute in hours */
-#define FAKE_RUN_TIME_STEP  0.0167 /* 1 minute in hours */
 
 #define MAX_AIRMASS 2.0
 #define MAX_HOURANGLE 4.3
-#define MAX_OBS_PER_FIELD 100 /* maximum number of observations per field */
-#define MAX_FIELDS 500  /* maximum number of fields per script */
+#define FIELD_STORE_CHUNK 256 /* fields added each time the field store grows */
 #define OBSERVATORY_SITE "La Silla"
 #define MAX_EXPT 1000.0
 #define MAX_INTERVAL (43200.0/3600.0)
@@ -100,6 +122,33 @@
 #define MIN_EXECUTION_TIME 0.029 /* minimum time (hours) to make an observation */
 #define FOCUS_OVERHEAD 0.00555 /* time to change focus (hours) = 20 sec */
 
+/* slew-time model (see scheduler_slew.c) */
+#define SLEW_RATE_RA 1.0 /* RA axis slew rate (deg/sec) */
+#define SLEW_RATE_DEC 1.0 /* Dec axis slew rate (deg/sec) */
+#define SLEW_SETTLE_SEC 5.0 /* time for the mount to settle after a slew (sec) */
+#define SLEW_TIE_TIME 0.05 /* fields whose time_left is within this (hours) of the
+                              least are taken to tie, and the nearest is chosen */
+#define SLEW_SCAN_MAX 64 /* tied fields looked at one by one. With more, the
+                            nearest is found with the sky grid */
+
+/* lookahead planning (see scheduler_plan.c) */
+#define LOOKAHEAD_DEPTH 4 /* observations played forward */
+#define LOOKAHEAD_BEAM 4 /* branches kept at each step */
+#define LOOKAHEAD_BRANCH 3 /* fields tried from each branch at each step */
+#define LOOKAHEAD_THREADS 4 /* threads extending the branches */
+#define LOOKAHEAD_BUDGET_SEC 10.0 /* wall-clock limit on one decision (sec) */
+#define LOOKAHEAD_WAIT_TIME 0.0167 /* step (hours) of a branch with nothing to observe */
+#define LOOKAHEAD_PAIR_BONUS 0.1 /* score (hours) of a completed pair */
+#define LOOKAHEAD_STRAND_PENALTY 0.2 /* score (hours) of a pair that can't be completed */
+
+/* chaining repeats at one pointing into bursts (see scheduler_burst.c) */
+#define BURST_MAX_FRAMES 32 /* frames taken in one burst */
+#define BURST_MAX_TIME 0.25 /* hours of one burst, between checks of the weather */
+
+#define SKY_GRID_DEG 5.0 /* width (deg) of the Dec bands and RA cells of the sky grid */
+#define SKY_GRID_BANDS 36 /* 180/SKY_GRID_DEG */
+#define SKY_GRID_CHUNK 16 /* fields added to a grid cell at a time */
+
 #define FLAT_DITHER_STEP 0.002778 /* 10 arcsec in deg */
 #define DEEPSEARCH_DITHER_STEP 0.001389 /* 5 arcsec in deg */
 
@@ -141,6 +190,25 @@ enum Selection_Code {NOT_SELECTED,FIRST_DO_NOW_FLAT, FIRST_DO_NOW_DARK, FIRST_DO
 enum Filter_Index { RGIZ_INDEX, NONE_INDEX, FAKE_INDEX, CLEAR_INDEX, NUM_FILTERS };
 
 
+/* per-field script text and history of completed observations. This
+   is kept apart from the Field scheduling record so that the selection
+   loop in get_next_field() walks only the few hundred bytes per field it
+   needs. One Field_History per field, allocated by add_field() with
+   room for max_obs observations (see scheduler_store.c), and reached
+   from the Field through its history pointer */
+
+typedef struct {
+    char *script_line;    
+    int max_obs; /* number of observations there is room for */
+    double *ut; /* ut (hours) of completed obs (start time) */
+    double *jd; /* lst (hours) of completed obs */
+    double *lst; /* lst (hours) of completed obs */
+    double *ha; /* hour angle (hours) of completed obs  */
+    double *am; /* airmass of completed obs  */
+    double *actual_expt; /* actual exposure time (hours) of obs*/
+    char *filename; /* filename prefix, FILENAME_LENGTH per obs */
+} Field_History;
+
 typedef struct {
     int status; /* 0 if not doable, 2 if must observe pronto, 1 if ready to observe,
                    -1 if not enough time to observe remaining fields */
@@ -148,9 +216,10 @@ typedef struct {
     enum Selection_Code selection_code;
     int field_number;
     int line_number;
-    char script_line[STR_BUF_LEN];    
     double ra; /* hours */
     double dec; /*deg */
+    double sin_dec; /* sin and cos of dec, set when the field is read */
+    double cos_dec;
     double gal_long; /*deg*/
     double gal_lat; /* deg */
     double ecl_long; /* deg */
@@ -173,15 +242,163 @@ typedef struct {
                              remaining observations */
     double time_left; /* time remaining (hours) before time_required 
                          exceeds time_up -- i.e. time_up-time_required */
-    double ut[MAX_OBS_PER_FIELD]; /* ut (hours) of completed obs (start time) */
-    double jd[MAX_OBS_PER_FIELD]; /* lst (hours) of completed obs */
-    double lst[MAX_OBS_PER_FIELD]; /* lst (hours) of completed obs */
-    double ha[MAX_OBS_PER_FIELD]; /* hour angle (hours) of completed obs  */
-    double am[MAX_OBS_PER_FIELD]; /* airmass of completed obs  */
-    double actual_expt[MAX_OBS_PER_FIELD]; /* actual exposure time (hours) of obs*/
-    char filename[FILENAME_LENGTH*MAX_OBS_PER_FIELD]; /* filename prefix */
+    Field_History *history; /* script line and completed obs */
+    int n_saved; /* observations written to obs record, -1 if field is not
+                    yet in the record */
+    double jd_saved; /* jd of last observation written to obs record */
 } Field;
 
+/* growable array of fields (see scheduler_store.c) */
+
+typedef struct {
+    Field *fields;
+    int num_fields; /* fields in use */
+    int max_fields; /* fields allocated */
+} Field_Store;
+
+/* read position in a script that is appended to while the scheduler
+   runs (see scheduler_ingest.c) */
+
+typedef struct {
+    char file_name[STR_BUF_LEN];
+    dev_t dev;                 /* device and inode of the file ingested */
+    ino_t ino;
+    off_t offset;              /* bytes ingested so far */
+    off_t last_size;           /* file size when a partial last line was seen */
+    unsigned int checksum;     /* checksum of the first offset bytes */
+    unsigned int line_checksum; /* checksum of the last line ingested */
+    int line_length;           /* and its length in bytes */
+    int line;                  /* lines ingested so far */
+    int num_fields;            /* fields read so far */
+    int num_skip;              /* fields already in the store when re-read */
+    int changed;               /* file may have changed since last ingest */
+    int notify_fd;             /* inotify descriptor, or -1 if polling */
+    int watch;
+    int wake_fd;               /* also ends wait_script_tail() when readable, or -1 */
+} Script_Tail;
+
+/* field positions binned in Dec bands and RA cells of about equal area
+   (see scheduler_slew.c) */
+
+typedef struct {
+    int band_start[SKY_GRID_BANDS]; /* first cell of each Dec band */
+    int band_cells[SKY_GRID_BANDS]; /* RA cells in each band */
+    int n_cells;
+    int **cell; /* field indices in each cell */
+    int *cell_n; /* number in each cell */
+    int *cell_max; /* number allocated */
+} Sky_Grid;
+
+/* binary min-heap of fields, ordered by key and then by field index */
+
+typedef struct {
+    int *elem; /* SELECTOR_SLOTS*field index + slot */
+    double *key;
+    int n; /* number in heap */
+    int max; /* number allocated */
+} Field_Heap;
+
+#define SELECTOR_SLOTS 3 /* heaps a field can be in at once */
+#define SELECTOR_BUCKET_CHUNK 8 /* n_left heaps added at a time */
+
+/* state kept between calls by select_next_field() (see scheduler_select.c) */
+
+typedef struct {
+    int num_fields; /* fields seen so far */
+    int max_fields; /* size of per-field arrays */
+    int bad_weather; /* bad_weather at last call */
+    int call_id; /* incremented each call */
+    Field_Heap events; /* next time each field's status may change */
+    Field_Heap **ready; /* READY fields, a heap for each n_left */
+    Field_Heap **ready_must_do; /* READY must-do, a heap for each n_left */
+    int n_buckets; /* n_left values there are heaps for */
+    Field_Heap ready_must_do_6; /* READY must-do with n_required==6 */
+    Field_Heap late; /* TOO_LATE fields, most time_left first */
+    Field_Heap late_must_do; /* TOO_LATE must-do, least time_left first */
+    Field_Heap do_now; /* DO_NOW fields, by index */
+    Field_Heap do_now_dark; /* DO_NOW darks, by index */
+    Field_Heap do_now_flat; /* DO_NOW flats, by index */
+    Field_Heap **member[SELECTOR_SLOTS]; /* heap holding each field, or NULL */
+    int *pos[SELECTOR_SLOTS]; /* position of each field in that heap */
+    int *status; /* status at last evaluation */
+    int *stamp; /* call_id when last collected, -1 if touched */
+    int *dirty; /* fields touched since last call */
+    int n_dirty;
+    int *weather; /* flat, focus and offset fields */
+    int n_weather;
+    int *work; /* fields to evaluate this call */
+    int *stack; /* scratch for heap scans */
+    Sky_Grid grid; /* field positions, for the nearest of tied fields */
+} Field_Selector;
+
+/* clock the scheduling core runs against (see scheduler_clock.c) */
+
+typedef struct Sched_Clock Sched_Clock;
+
+struct Sched_Clock {
+    double (*now)(Sched_Clock *clock); /* current jd */
+    int (*wait)(Sched_Clock *clock, double sec); /* let sec seconds pass */
+    double jd; /* jd at last call (the time itself for a virtual clock) */
+    void *arg; /* other state of the clock, or NULL */
+};
+
+/* telescope and camera as seen by run_night() (see scheduler_backend.c) */
+
+typedef struct Sched_Hardware Sched_Hardware;
+
+struct Sched_Hardware {
+    /* observe field index of sequence (index_prev the last observed)
+       starting at jd. Set *dt to the hours taken. Return 0, or -1 on error */
+    int (*observe)(Sched_Hardware *hw, Field *sequence, int index, int index_prev,
+            double jd, double *dt, Night_Times *nt);
+    /* return 1 if the dome can't be opened at jd */
+    int (*bad_weather)(Sched_Hardware *hw, double jd, Night_Times *nt);
+    /* return the jd the dome can next be opened, at or after jd, or -1
+       if not tonight or not known. May be NULL */
+    double (*weather_clears)(Sched_Hardware *hw, double jd, Night_Times *nt);
+
+    /* the scheduler's work around the observations. Any of these may be
+       NULL, as they are for the virtual hardware */
+
+    /* add the fields that have arrived since the last call to store, set
+       up for jd. Return the number of fields in store */
+    int (*add_fields)(Sched_Hardware *hw, Field_Store *store, double jd, Night_Times *nt);
+    /* publish the state of the fields at jd, index the field last observed,
+       or the field about to be observed */
+    void (*publish)(Sched_Hardware *hw, Field *sequence, int num_fields, int index,
+            double jd, int bad_weather);
+    /* return 1 if observing is paused at jd. bad_weather is as found at
+       the last check */
+    int (*paused)(Sched_Hardware *hw, double jd, int bad_weather);
+    /* finish the focus or offset sequence that field index_prev ended, if
+       it did. Return 1 if there was one to finish (field index_prev may
+       have changed), else 0 */
+    int (*calibrate)(Sched_Hardware *hw, Field *sequence, int num_fields, int index_prev,
+            double jd);
+    /* there is nothing to observe at jd: index is -1 if no field is
+       ready, else the field chosen, which the weather keeps closed */
+    void (*idle)(Sched_Hardware *hw, int index, int bad_weather, double jd);
+    /* field index has been observed, and observe() returned result */
+    void (*observed)(Sched_Hardware *hw, Field *sequence, int num_fields, int index,
+            int result, double jd, int bad_weather);
+
+    Sched_Clock *clock; /* clock the hardware runs on */
+    FILE *output; /* exposure log, or NULL */
+    Weather_Timeline *weather; /* times the dome is open (see check_weather()), or NULL */
+    struct date_time date; /* local date of the night, for check_weather() */
+    void *arg; /* other state of the backend */
+};
+
+/* what happened in a night run by run_night() */
+
+typedef struct {
+    int n_exposures; /* exposures taken */
+    int n_errors; /* observations that failed */
+    int n_completed; /* fields with all their observations done */
+    double t_observing; /* hours spent observing */
+    double t_idle; /* hours with nothing to observe, or the dome closed */
+} Night_Summary;
+
 /*  site-specific parameters  */
 
 typedef struct {
@@ -221,9 +438,12 @@ typedef struct {
     double ra_offset; /* Correction to RA pointing in degrees */
     double dec_offset; /* Correction to Dec  pointing in degrees */
     Weather_Info weather;
-    double update_time;
+    double update_time; /* wall clock time (sec) when read from the controller */
 } Telescope_Status;
 
+#define TEL_STATUS_POLL_SEC 2.0 /* period of the background telescope status poller */
+#define TEL_STATUS_MAX_AGE_SEC 5.0 /* oldest status snapshot used by the main loop */
+
 typedef struct {
     unsigned char nostatus;
     unsigned char unknown;
@@ -268,15 +488,19 @@ typedef struct {
 } Camera_Status;
 
 #define MAX_FITS_WORDS 100
+#define FITS_HASH_SIZE 256 /* power of 2, > MAX_FITS_WORDS */
 
 typedef struct{
      char keyword[256];
      char value[256];
+     int dirty; /* value changed since last sent to the camera controller */
 } Fits_Word;
 
 typedef struct {
   int num_words;
+  int num_dirty;
   Fits_Word fits_word[MAX_FITS_WORDS];
+  short hash[FITS_HASH_SIZE]; /* index+1 of the word for each keyword hash, 0 if empty */
 } Fits_Header;
 
 #define FILTERNAME_KEYWORD "filterna"
@@ -347,24 +571,7 @@ typedef struct {
 #define MORNING_FLAT_TYPE "amskyflat"
 #define DOME_FLAT_TYPE "domeskyflat"
 
-int add_new_fields(Field *sequence, int num_fields,
-		Field *new_sequence, int num_new_fields);
-
-int load_obs_record(char *file_name, Field *sequence, FILE **obs_record);
-int save_obs_record(Field *sequence, FILE *obs_record, int num_fields,
-         struct tm *tm);
-
-int adjust_date(struct date_time *date, int n_days);
-
-int init_night(struct date_time date, Night_Times *nt, 
-                      Site_Params *site, int print_flag);
-
-int load_sequence(char *script_name, Field *sequence);
-
-int check_weather(FILE *input, double jd, 
-			struct date_time *date, Night_Times *nt);
-
-int get_day_of_year(struct date_time *date);
+/* from scheduler.c */
 
 int observe_next_field(Field *sequence, int index, int index_prev, 
                 double jd, double *time_taken, 
@@ -378,6 +585,31 @@ int do_stow(double ut,Telescope_Status *status);
 
 int get_dither(int iteration, double *ra_dither, double *dec_dither, double step_size);
 
+double get_lst();
+
+int close_files();
+
+int do_exit(int code);
+
+/* from scheduler_core.c */
+
+int adjust_date(struct date_time *date, int n_days);
+
+int init_night(struct date_time date, Night_Times *nt, 
+                      Site_Params *site, int print_flag);
+
+int load_sequence(char *script_name, Field_Store *store, int num_skip);
+
+int parse_sequence_line(char *string, int line, Field *f);
+
+int check_weather(Weather_Timeline *w, double jd, 
+			struct date_time *date, Night_Times *nt);
+
+double get_weather_clear_jd(Weather_Timeline *w, double jd,
+			struct date_time *date, Night_Times *nt);
+
+int get_day_of_year(struct date_time *date);
+
 int init_fields(Field *sequence, int num_fields, 
                 Night_Times *nt, Night_Times *nt_5day,
 		Night_Times *nt_10day, Night_Times *nt_15day,
@@ -391,6 +623,12 @@ double get_jd_rise_time(double ra,double dec, double max_am, double max_ha,
 double get_jd_set_time(double ra,double dec, double max_am, double max_ha,
        Night_Times *nt, Site_Params *site, double *am, double *ha);
 
+double get_jd_rise_in_window(double ra, double ha_limit, Night_Times *nt,
+       double *lst);
+
+double get_jd_set_in_window(double ra, double ha_limit, Night_Times *nt,
+       double *lst);
+
 double get_airmass(double ha, double dec, Site_Params *site);
 
 double get_ha(double ra, double lst);
@@ -412,21 +650,42 @@ int print_field_status (Field *f, FILE *output);
 
 int print_history(double lst,Field *sequence, int num_fields,FILE *output);
 
-double get_lst();
+int get_shutter_string(char *string, int shutter, char *description);
 
-int close_files();
+int get_shutter_code(char *string);
 
-int do_exit(int code);
+int get_filename(char *filename,struct tm *tm,int shutter);
 
-int get_shutter_string(char *string, int shutter, char *description);
+int check_filter_name(char *name);
 
-int get_shutter_code(char *string);
+/* from scheduler_clock.c */
 
+double get_tm(struct tm *tm_out);
+double get_ut();
+double get_jd();
+double get_wall_time();
+double get_unix_time();
+double get_clock_speed();
+void set_clock_scale(double t_origin, double speed);
+void set_clock_stepped(double t_origin);
+void set_clock_settle(void (*settle)());
+int clock_is_stepped();
+void clock_sleep(double sec);
+void clock_sync(double t);
 int advance_tm_day(struct tm *tm);
-
 int leap_year_check(int year);
+int init_wall_clock(Sched_Clock *clock);
+int init_virtual_clock(Sched_Clock *clock, double jd);
 
-int check_filter_name(char *name);
+/* from scheduler_backend.c */
+
+int init_virtual_hardware(Sched_Hardware *hw, Sched_Clock *clock, FILE *output,
+        Weather_Timeline *weather, struct date_time date);
+int run_night(Field_Store *store, Night_Times *nt, Sched_Clock *clock,
+        Sched_Hardware *hw, FILE *hist_out, Night_Summary *summary);
+void night_ut_lst(Night_Times *nt, double jd, double *ut, double *lst);
+int record_exposure(Field *f, double jd, double ut, double lst,
+        double actual_expt, char *filename);
 
 /* from scheduler_telescope.c */
 int init_telescope_offsets(Telescope_Status *status);
@@ -436,34 +695,29 @@ int update_telescope_status(Telescope_Status *status);
 int do_telescope_command(char *command, char *reply,int timeout, char *host);
 int do_daytime_telescope_command(char *command, char *reply,int timeout, char *host);
 int print_telescope_status(Telescope_Status *status, FILE *output);
-double get_tm(struct tm *tm_out);
-double get_ut();
-double get_jd();
 int focus_telescope(Field *f, Telescope_Status *status, double focus_default);
-int get_filename(char *filename,struct tm *tm,int shutter);
+int set_best_focus(double focus, Telescope_Status *status);
+double measure_focus_fwhm(char *filename, double focus);
 double get_median_focus(char *file);
 int set_telescope_focus(double focus);
 int get_telescope_focus (double *focus);
 
 
 /* from scheduler_camera.c */
-int init_semaphores();
 int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
 		    char *name, double *ut, double *jd,
 		    bool wait_flag, int *exp_error_code, char *exp_mode);
-int get_filename(char *filename,struct tm *tm,int shutter);
 int imprint_fits_header(Fits_Header *header);
 double wait_exp_done(int expt);
 int init_camera();
 int clear_camera();
 int update_camera_status(Camera_Status *cam_status);
-void *do_camera_command_thread(void *args);
 int do_status_command(char *command, char *reply, int timeout_sec,int id, char *host);
 int do_camera_command(char *command, char *reply, int timeout_sec, int id, char *host);
 int do_command(char *command, char *reply, int timeout_sec, int port, int id, char *host);
 int bad_readout();
-int get_filename(char *filename,struct tm *tm,int shutter);
 int wait_camera_readout(Camera_Status *status);
+int fetch_last_exposure(Camera_Status *status);
 int print_camera_status(Camera_Status *status, FILE *output);
 double expose_timeout (char *exp_mode, double exp_time, bool wait_flag);
 
@@ -477,6 +731,43 @@ int get_string_status(char *keyword, char *reply, char *status);
 int parse_status(char *reply,Camera_Status *status);
 int print_camera_status(Camera_Status *status,FILE *output);
 
+/* from scheduler_monitor.c */
+
+int start_camera_monitor();
+int stop_camera_monitor();
+int wait_camera_state(int state, int value, int timeout_sec, Camera_Status *status);
+int get_monitored_camera_status(Camera_Status *status);
+
+/* from scheduler_slew.c */
+
+double slew_time(double ra1, double dec1, double ra2, double dec2);
+double slew_overhead(double ra1, double dec1, double ra2, double dec2);
+int init_sky_grid(Sky_Grid *grid);
+int free_sky_grid(Sky_Grid *grid);
+int add_sky_grid_field(Sky_Grid *grid, int index, double ra, double dec);
+int nearest_sky_grid_field(Sky_Grid *grid, Field *sequence, double ra, double dec,
+        int (*accept)(int index, void *arg), void *arg);
+
+/* from scheduler_plan.c */
+
+int plan_next_field(Field *sequence, int num_fields, int i_prev, double jd,
+        int bad_weather, int i_greedy, double jd_end);
+
+/* from scheduler_burst.c */
+
+int burst_field(Field *f);
+double burst_frame_time(Field *f);
+int burst_length(Field *f, double jd);
+double burst_expt(Field *f, int n_frames);
+
+/* from scheduler_worker.c */
+
+int start_camera_workers();
+int queue_camera_command(int type, char *command, int timeout_sec, bool detach);
+int wait_camera_command(int ticket, int timeout_sec, char *reply);
+int release_camera_command(int ticket);
+int run_camera_command(int type, char *command, char *reply, int timeout_sec);
+
 /* from scheduler_corrections.c */
 
 double get_ra_correction(double ha0, double ha);
@@ -491,22 +782,77 @@ void sigterm_handler();
 void sigusr1_handler();
 void sigusr2_handler();
 
+/* from scheduler_journal.c */
+
+int load_obs_record(char *file_name, Field_Store *store, FILE **obs_record);
+int save_obs_record(Field *sequence, FILE *obs_record, int num_fields,
+         struct tm *tm);
+
+/* from scheduler_store.c */
+
+int init_field_store(Field_Store *store);
+int add_field(Field_Store *store, Field *field, char *script_line);
+int grow_field_history(Field *f, int max_obs);
+int truncate_field_store(Field_Store *store, int num_fields);
+int restore_fields(Field_Store *store, Field *saved, int num_fields);
+
+/* from scheduler_history.c */
+
+int open_history_log(char *file_name, History_Log *h);
+int write_history(History_Log *h, double jd, Field *sequence, int num_fields);
+void close_history_log(History_Log *h);
+
+/* from scheduler_control.c */
+
+int start_control_server(char *key_file, char *address, int port);
+void stop_control_server();
+int control_wake_fd();
+int drain_control_fields(Field_Store *store);
+void note_control_fields(int n_added, int n_observable);
+int control_abort_requested();
+void post_control_state(Field *sequence, int num_fields, int index, double jd);
+
+/* from scheduler_ingest.c */
+
+int init_script_tail(Script_Tail *tail, char *file_name);
+int ingest_sequence(Script_Tail *tail, Field_Store *store);
+int wait_script_tail(Script_Tail *tail, double seconds);
+
+/* from scheduler_select.c */
+
+int init_field_selector(Field_Selector *sel);
+int free_field_selector(Field_Selector *sel);
+int touch_field(Field_Selector *sel, int index);
+int select_next_field(Field_Selector *sel, Field *sequence, int num_fields,
+        int i_prev, double jd, int bad_weather);
+
 /* from scheduler_fits.c */
 
 int init_fits_header(Fits_Header *header);
 int update_fits_header(Fits_Header *header, char *keyword, char *value);
 int add_fits_word(Fits_Header *header, char *keyword, char *value);
+int clear_fits_word(Fits_Header *header, int i);
 
 /* from scheduler_socket.c */
 int send_command(char *command, char *reply, char *machine, 
 			int port, int timeout_sec);
+int add_socket_endpoint(char *machine, int port);
+void close_socket_pool();
+int establish(u_short portnum);
+int get_connection(int s);
 
 /* from scheduler_telescope.c*/
 
 
+int open_telescope_connections(char *host);
+int get_telescope_status(Telescope_Status *status, double max_age_sec);
+int start_telescope_status_poller(double period_sec);
+int stop_telescope_status_poller();
 int init_telescope_offsets(Telescope_Status *status);
 int get_telescope_offsets(Field *f, Telescope_Status *status);
 int focus_telescope(Field *f, Telescope_Status *status, double focus_default);
+int set_best_focus(double focus, Telescope_Status *status);
+double measure_focus_fwhm(char *filename, double focus);
 int stow_telescope();
 int set_telescope_focus(double focus);
 int get_telescope_focus(double *focus);
@@ -516,8 +862,6 @@ int update_telescope_status(Telescope_Status *status);
 int print_telescope_status(Telescope_Status *status,FILE *output);
 int do_telescope_command(char *command, char *reply, int timeout, char *host);
 int do_daytime_telescope_command(char *command, char *reply, int timeout, char *host);
-int advance_tm_day(struct tm *tm);
-int leap_year_check(int year);
 
 extern double sin(),fabs();
 
@@ -43,9 +43,16 @@ from scheduler_telescope import (
 from scheduler_astropy import (
     julian_date, lst, galactic_coordinates, ecliptic_coordinates,
     rise_set_times, moon_position, moon_separation, twilight_times,
-    altitude_azimuth, airmass
+    altitude_azimuth, airmass,
+    batch_galactic_coordinates, batch_ecliptic_coordinates, batch_visibility
 )
 
+# The C scheduling core, if libls4sched.so has been built ("make shared")
+try:
+    import ls4sched
+except ImportError:
+    ls4sched = None
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -73,6 +80,9 @@ class Config:
     DEEP_DITHER_ON = False
     USE_12DEG_START = True
     
+    # Selection
+    USE_C_ENGINE = True  # select fields with the C core (ls4sched) when it can be loaded
+    
     # Time constants
     SIDEREAL_DAY_IN_HOURS = 23.93446972
     LST_SEARCH_INCREMENT = 0.00166  # 1 minute in hours
@@ -122,6 +132,8 @@ class Config:
     SELECTED_FIELDS_FILE = "fields.completed"
     LOG_OBS_FILE = "log.obs"
     OBS_RECORD_FILE = "scheduler.bin"
+    BATCH_VISIBILITY = False  # rise/set of all the fields from one batch_visibility() grid
+    VISIBILITY_CACHE_DIR = None  # directory to cache field visibility in, None for no cache
     FILENAME_LENGTH = 16
     STR_BUF_LEN = 1024
     
@@ -321,6 +333,9 @@ class Scheduler:
         self.camera_status = CameraStatus()
         self.fits_header = CameraFitsHeader()
         
+        # The C scheduling core holding the same fields, or None
+        self.engine = None
+        
         # Control flags
         self.pause_flag = False
         self.stop_flag = True
@@ -396,6 +411,9 @@ class Scheduler:
                 logger.error("No valid fields to observe")
                 return
         
+        # Select with the C core if it can hold the same fields
+        self._open_engine(sequence_file, date, num_fields)
+        
         # Open output files
         self._open_output_files()
         
@@ -528,6 +546,7 @@ class Scheduler:
         
         # End of observations
         logger.info(f"UT {ut:9.6f}: Ending observations")
+        self._sync_fields()
         
         # Stow telescope if needed
         if not self.config.FAKE_RUN and jd > self.night_times.jd_sunrise:
@@ -594,8 +613,7 @@ class Scheduler:
             if wait_camera_readout(self.camera_status) != 0:
                 logger.warning("Bad readout of previous exposure")
                 if self.i_prev >= 0 and self.fields[self.i_prev].n_done > 0:
-                    self.fields[self.i_prev].n_done -= 1
-                    self.fields[self.i_prev].jd_next = jd
+                    self._reject_exposure(self.i_prev, jd)
         
         # Clear camera if needed
         if not self.config.FAKE_RUN:
@@ -646,8 +664,14 @@ class Scheduler:
             field_obj.filenames[field_obj.n_done] = f"sim_{field_obj.field_number}_{field_obj.n_done}"
         
         # Update field status
-        field_obj.n_done += 1
-        field_obj.jd_next = jd + field_obj.interval
+        if self.engine is not None:
+            n = field_obj.n_done
+            self.engine.record_exposure(index, jd, field_obj.actual_expt[n],
+                                        field_obj.filenames[n])
+            self._sync_fields([index])
+        else:
+            field_obj.n_done += 1
+            field_obj.jd_next = jd + field_obj.interval
         
         # Log observation
         if self.log_file:
@@ -668,6 +692,12 @@ class Scheduler:
         Returns:
             Index of selected field, or -1 if none available
         """
+        if self.engine is not None:
+            i = self.engine.next_field(self.i_prev, jd, self.bad_weather)
+            if i >= 0:
+                self._sync_fields([i])
+            return i
+        
         # Update all field statuses
         for field_obj in self.fields:
             self._update_field_status(field_obj, jd)
@@ -788,7 +818,7 @@ class Scheduler:
                 # Wait for readout
                 if wait_camera_readout(self.camera_status) != 0:
                     logger.warning("Bad readout of last focus exposure")
-                    self.fields[self.i_prev].n_done -= 1
+                    self._reject_exposure(self.i_prev)
                     return True
                 
                 # Get and set best focus
@@ -826,7 +856,7 @@ class Scheduler:
                 # Wait for readout
                 if wait_camera_readout(self.camera_status) != 0:
                     logger.warning("Bad readout of last offset exposure")
-                    self.fields[self.i_prev].n_done -= 1
+                    self._reject_exposure(self.i_prev)
                     return True
                 
                 # Get and set telescope offsets
@@ -853,22 +883,34 @@ class Scheduler:
     def _init_fields(self, jd: float) -> int:
         """Initialize field rise/set times and observability"""
         num_observable = 0
+        if not self.fields:
+            return 0
         
-        for field_obj in self.fields:
+        if self.engine is not None:
+            num_observable = self.engine.init_fields(jd)
+            self._sync_fields()
+            logger.info(f"Initialized {self.num_fields} fields, {num_observable} are observable")
+            return num_observable
+        
+        # Transform all the fields at once: set up per field, the astropy
+        # frames cost far more than the transforms themselves
+        ra = np.array([field_obj.ra for field_obj in self.fields])
+        dec = np.array([field_obj.dec for field_obj in self.fields])
+        gal_long, gal_lat = batch_galactic_coordinates(ra, dec)
+        epoch, ecl_long, ecl_lat = batch_ecliptic_coordinates(ra, dec, jd)
+        rise_set = self._get_rise_set_windows(ra, dec)
+        moon = None
+        
+        for i, field_obj in enumerate(self.fields):
             # Initialize observation tracking
             field_obj.n_done = 0
             field_obj.status = FieldStatus.NOT_DOABLE
             field_obj.selection_code = SelectionCode.NOT_SELECTED
             
-            # Calculate galactic coordinates
-            field_obj.gal_long, field_obj.gal_lat = galactic_coordinates(
-                field_obj.ra, field_obj.dec
-            )
-            
-            # Calculate ecliptic coordinates
-            field_obj.epoch, field_obj.ecl_long, field_obj.ecl_lat = ecliptic_coordinates(
-                field_obj.ra, field_obj.dec, jd
-            )
+            # Galactic and ecliptic coordinates
+            field_obj.gal_long, field_obj.gal_lat = float(gal_long[i]), float(gal_lat[i])
+            field_obj.epoch = epoch
+            field_obj.ecl_long, field_obj.ecl_lat = float(ecl_long[i]), float(ecl_lat[i])
             
             # Special handling for darks and flats
             if field_obj.shutter == ShutterCode.DARK:
@@ -887,8 +929,8 @@ class Scheduler:
                 num_observable += 1
                 continue
             
-            # Calculate rise/set times for sky fields
-            rise_jd, set_jd = self._get_field_rise_set(field_obj)
+            # Rise/set times for sky fields
+            rise_jd, set_jd = rise_set[i]
             
             if rise_jd is None or set_jd is None:
                 field_obj.doable = False
@@ -907,7 +949,9 @@ class Scheduler:
             
             # Check moon interference for SNe fields
             if field_obj.survey_code == SurveyCode.SNE:
-                moon_ra, moon_dec, illumination = moon_position(jd)
+                if moon is None:
+                    moon = moon_position(jd)
+                moon_ra, moon_dec, illumination = moon
                 if illumination > 0.5:
                     separation = moon_separation(field_obj.ra, field_obj.dec, moon_ra, moon_dec)
                     if separation < Config.MIN_MOON_SEPARATION:
@@ -927,15 +971,95 @@ class Scheduler:
         logger.info(f"Initialized {self.num_fields} fields, {num_observable} are observable")
         return num_observable
     
+    def _open_engine(self, sequence_file: str, date: datetime, num_fields: int):
+        """Load the sequence into the C scheduling core, to select fields with"""
+        self.engine = None
+        if not self.config.USE_C_ENGINE or ls4sched is None or not ls4sched.available():
+            return
+        
+        # The core sets up its fields from the sequence, so it can't take
+        # over the fields of a resumed observation record
+        if any(field_obj.n_done > 0 for field_obj in self.fields):
+            logger.info("Resuming observations, selecting fields in Python")
+            return
+        
+        # load_site() in C knows La Silla as DEFAULT; the Python Fake site is La Silla too
+        site_name = self.site.site_name if self.site.site_name != "Fake" else "DEFAULT"
+        try:
+            engine = ls4sched.Engine(site_name, 1 if self.config.DEBUG else 0)
+        except RuntimeError as e:
+            logger.warning(f"{e}, selecting fields in Python")
+            return
+        
+        engine.set_night(date.year, date.month, date.day)
+        n = engine.load_sequence(sequence_file)
+        if n != num_fields:
+            logger.warning(f"C core read {n} fields of {sequence_file}, not {num_fields}, "
+                           "selecting fields in Python")
+            engine.close()
+            return
+        
+        # Run the night on the core's times, so it and the loop agree
+        night = engine.get_night()
+        for name, _ in ls4sched.Night._fields_:
+            setattr(self.night_times, name, getattr(night, name))
+        
+        self.engine = engine
+        logger.info(f"Selecting fields with the C scheduling core ({n} fields)")
+    
+    def _sync_fields(self, indices: Optional[List[int]] = None):
+        """Copy the state of fields (all by default) from the C core"""
+        if self.engine is None:
+            return
+        
+        if indices is None:
+            states = enumerate(self.engine.get_fields())
+        else:
+            states = ((i, self.engine.get_field(i)) for i in indices)
+        
+        for i, state in states:
+            field_obj = self.fields[i]
+            field_obj.status = FieldStatus(state.status)
+            field_obj.doable = bool(state.doable)
+            field_obj.selection_code = SelectionCode(state.selection_code)
+            field_obj.n_done = state.n_done
+            field_obj.n_required = state.n_required
+            field_obj.interval = state.interval
+            field_obj.jd_rise = state.jd_rise
+            field_obj.jd_set = state.jd_set
+            field_obj.jd_next = state.jd_next
+            field_obj.time_up = state.time_up
+            field_obj.time_required = state.time_required
+            field_obj.time_left = state.time_left
+            field_obj.gal_long, field_obj.gal_lat = state.gal_long, state.gal_lat
+            field_obj.ecl_long, field_obj.ecl_lat = state.ecl_long, state.ecl_lat
+    
+    def _reject_exposure(self, index: int, jd: Optional[float] = None):
+        """Take back the last exposure of a field after a bad readout"""
+        field_obj = self.fields[index]
+        if jd is None:
+            jd = field_obj.jd_next
+        
+        if self.engine is not None:
+            self.engine.reject_exposure(index, jd)
+            self._sync_fields([index])
+        else:
+            field_obj.n_done -= 1
+            field_obj.jd_next = jd
+    
     def _get_field_rise_set(self, field_obj: Field) -> Tuple[Optional[float], Optional[float]]:
         """Calculate rise and set times for a field considering airmass constraints"""
+        return self._get_rise_set(field_obj.ra, field_obj.dec)
+    
+    def _get_rise_set(self, ra: float, dec: float) -> Tuple[Optional[float], Optional[float]]:
+        """Rise and set times within the night of one position, above the airmass limit"""
         # Use airmass constraint to determine altitude threshold
         max_airmass = Config.MAX_AIRMASS
         min_altitude = math.degrees(math.asin(1.0 / max_airmass))
         
         # Get rise/set times
         rise_jd, set_jd = rise_set_times(
-            field_obj.ra, field_obj.dec, 
+            ra, dec, 
             self.night_times.jd_start,
             self.site.longitude, self.site.latitude,
             min_altitude
@@ -953,6 +1077,36 @@ class Scheduler:
         
         return None, None
     
+    def _get_rise_set_windows(self, ra: np.ndarray,
+                              dec: np.ndarray) -> List[Tuple[Optional[float], Optional[float]]]:
+        """Rise and set times within the night of many fields, above the airmass limit"""
+        if not self.config.BATCH_VISIBILITY:
+            return [self._get_rise_set(float(r), float(d)) for r, d in zip(ra, dec)]
+        
+        # Use airmass constraint to determine altitude threshold
+        max_airmass = Config.MAX_AIRMASS
+        min_altitude = math.degrees(math.asin(1.0 / max_airmass))
+        
+        # One altitude grid for all the fields over the observing window
+        visibility = batch_visibility(
+            ra, dec,
+            self.night_times.jd_start, self.night_times.jd_end,
+            self.site.longitude, self.site.latitude,
+            min_altitude,
+            elevation=self.site.elevation_sea,
+            cache_dir=self.config.VISIBILITY_CACHE_DIR
+        )
+        
+        # Check if each field is observable during the night, in its longest window
+        windows = []
+        for rise_jd, set_jd in zip(visibility['rise_jd'], visibility['set_jd']):
+            if np.isfinite(rise_jd) and np.isfinite(set_jd) and rise_jd < set_jd:
+                windows.append((float(rise_jd), float(set_jd)))
+            else:
+                windows.append((None, None))
+        
+        return windows
+    
     def _init_night_times(self, date: datetime):
         """Initialize night timing information"""
         # Calculate JD for local noon
@@ -1318,8 +1472,13 @@ class Scheduler:
                 file_handle.close()
         
         # Save final observation record
+        self._sync_fields()
         self.save_obs_record()
         
+        if self.engine is not None:
+            self.engine.close()
+            self.engine = None
+        
         logger.info("Scheduler cleanup completed")
 
 
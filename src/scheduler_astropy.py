@@ -6,6 +6,7 @@ This module provides astronomical calculations including:
 - Time conversions (UT, LST, JD)
 - Coordinate transformations
 - Rise/set time calculations
+- Batched visibility windows for many fields over a night
 - Moon position and interference checks
 - Airmass calculations
 
@@ -13,6 +14,8 @@ All functions maintain the same interface as scheduler_astro.py for compatibilit
 """
 
 import math
+import os
+import hashlib
 import numpy as np
 from datetime import datetime, timedelta
 from typing import Tuple, Optional
@@ -366,6 +369,274 @@ def rise_set_times(ra: float, dec: float, jd: float,
     return (jd_rise, jd_set)
 
 
+# ============================================================================
+# Batched Visibility
+# ============================================================================
+
+VISIBILITY_GRID_MINUTES = 5.0  # spacing of the time grid over the night
+VISIBILITY_CHUNK_FIELDS = 2000  # fields transformed together in one AltAz call
+VISIBILITY_CACHE_VERSION = 2  # bump when the cached arrays change meaning
+
+
+def night_time_grid(jd_start: float, jd_end: float,
+                    step_minutes: float = VISIBILITY_GRID_MINUTES) -> np.ndarray:
+    """
+    Evenly spaced Julian Dates covering a night.
+    
+    Args:
+        jd_start: Start of the night (JD)
+        jd_end: End of the night (JD)
+        step_minutes: Largest spacing of the grid in minutes
+    
+    Returns:
+        Array of JDs from jd_start to jd_end inclusive
+    """
+    n = max(2, int(math.ceil((jd_end - jd_start) * 1440.0 / step_minutes)) + 1)
+    return np.linspace(jd_start, jd_end, n)
+
+
+def batch_galactic_coordinates(ra, dec) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Galactic coordinates of many J2000 positions in one transform.
+    
+    Args:
+        ra: Right ascensions in hours (array)
+        dec: Declinations in degrees (array)
+    
+    Returns:
+        Tuple of (l, b) arrays in degrees
+    """
+    ra = np.atleast_1d(np.asarray(ra, dtype=float))
+    dec = np.atleast_1d(np.asarray(dec, dtype=float))
+    coord_gal = SkyCoord(ra=ra*u.hour, dec=dec*u.deg, frame='icrs').galactic
+    
+    return coord_gal.l.deg, coord_gal.b.deg
+
+
+def batch_ecliptic_coordinates(ra, dec, jd: float) -> Tuple[float, np.ndarray, np.ndarray]:
+    """
+    Ecliptic coordinates of many positions in one transform.
+    
+    Args:
+        ra: Right ascensions in hours (array)
+        dec: Declinations in degrees (array)
+        jd: Julian Date for obliquity calculation
+    
+    Returns:
+        Tuple of (epoch, longitudes, latitudes), as ecliptic_coordinates()
+    """
+    ra = np.atleast_1d(np.asarray(ra, dtype=float))
+    dec = np.atleast_1d(np.asarray(dec, dtype=float))
+    coord_ecl = SkyCoord(ra=ra*u.hour, dec=dec*u.deg, frame='icrs').transform_to(
+        BarycentricMeanEcliptic(equinox=Time(jd, format='jd')))
+    epoch = 2000.0 + (jd - JD_EPOCH_2000) / 365.25
+    
+    return epoch, coord_ecl.lon.deg, coord_ecl.lat.deg
+
+
+def batch_altitudes(ra, dec, jd_grid, longitude: float, latitude: float,
+                    elevation: float = 0.0) -> np.ndarray:
+    """
+    Altitudes of many fields over a shared time grid using astropy.
+    
+    All the fields are broadcast against all the times, so the frame for
+    the grid is set up once per VISIBILITY_CHUNK_FIELDS fields rather
+    than once per field and time.
+    
+    Args:
+        ra: Right ascensions in hours (array)
+        dec: Declinations in degrees (array)
+        jd_grid: Julian Dates (array), e.g. from night_time_grid()
+        longitude: Observer longitude in hours (west positive)
+        latitude: Observer latitude in degrees
+        elevation: Observer height above sea level in meters
+    
+    Returns:
+        Array of altitudes in degrees, one row per field, one column per time
+    """
+    ra = np.atleast_1d(np.asarray(ra, dtype=float))
+    dec = np.atleast_1d(np.asarray(dec, dtype=float))
+    jd_grid = np.atleast_1d(np.asarray(jd_grid, dtype=float))
+    
+    lon_deg = -longitude * 15.0  # Convert to degrees, east positive
+    location = EarthLocation(lon=lon_deg * u.deg, lat=latitude * u.deg,
+                             height=elevation * u.m)
+    frame = AltAz(obstime=Time(jd_grid, format='jd')[np.newaxis, :], location=location)
+    
+    alt = np.empty((len(ra), len(jd_grid)))
+    for i in range(0, len(ra), VISIBILITY_CHUNK_FIELDS):
+        j = min(i + VISIBILITY_CHUNK_FIELDS, len(ra))
+        targets = SkyCoord(ra=ra[i:j, np.newaxis]*u.hour, dec=dec[i:j, np.newaxis]*u.deg,
+                           frame='icrs')
+        alt[i:j] = targets.transform_to(frame).alt.deg
+    
+    return alt
+
+
+def batch_windows(alt: np.ndarray, jd_grid, altitude: float = 0.0) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Every window above an altitude for each row of batch_altitudes().
+    
+    The crossings are interpolated linearly between grid points. A field
+    already above the altitude at the first time rises then, and one
+    still above it at the last time sets then, so a field that sets
+    early in the night and rises again before the end has two windows.
+    
+    Args:
+        alt: Altitudes in degrees, one row per field
+        jd_grid: Julian Dates of the columns of alt
+        altitude: Altitude threshold in degrees
+    
+    Returns:
+        Tuple of (rise_jd, set_jd) arrays, one row per field and one
+        column per window in time order, NaN past the last window of a field
+    """
+    jd_grid = np.asarray(jd_grid, dtype=float)
+    n_fields, n_times = alt.shape
+    
+    above = alt >= altitude
+    no_field = np.zeros((n_fields, 1), dtype=bool)
+    starts = above & ~np.hstack((no_field, above[:, :-1]))
+    ends = above & ~np.hstack((above[:, 1:], no_field))
+    
+    n_windows = int(starts.sum(axis=1).max()) if n_fields > 0 and n_times > 0 else 0
+    rise_jd = np.full((n_fields, n_windows), np.nan)
+    set_jd = np.full((n_fields, n_windows), np.nan)
+    
+    # Column of each window in its row: the windows of a row, counted in time order
+    rows, i_rise = np.nonzero(starts)
+    k = np.cumsum(starts, axis=1)[rows, i_rise] - 1
+    t = jd_grid[i_rise].copy()
+    r = i_rise > 0
+    a0 = alt[rows[r], i_rise[r] - 1]
+    a1 = alt[rows[r], i_rise[r]]
+    t0 = jd_grid[i_rise[r] - 1]
+    t[r] = t0 + (altitude - a0) / (a1 - a0) * (jd_grid[i_rise[r]] - t0)
+    rise_jd[rows, k] = t
+    
+    rows, i_set = np.nonzero(ends)
+    k = np.cumsum(ends, axis=1)[rows, i_set] - 1
+    t = jd_grid[i_set].copy()
+    s = i_set < n_times - 1
+    a0 = alt[rows[s], i_set[s]]
+    a1 = alt[rows[s], i_set[s] + 1]
+    t0 = jd_grid[i_set[s]]
+    t[s] = t0 + (a0 - altitude) / (a0 - a1) * (jd_grid[i_set[s] + 1] - t0)
+    set_jd[rows, k] = t
+    
+    return rise_jd, set_jd
+
+
+def longest_windows(rise_jd: np.ndarray, set_jd: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Longest of the windows from batch_windows() for each field.
+    
+    Args:
+        rise_jd: Rise times, one row per field, from batch_windows()
+        set_jd: Set times, one row per field, from batch_windows()
+    
+    Returns:
+        Tuple of (rise_jd, set_jd) arrays, NaN for fields never above altitude
+    """
+    n_fields = rise_jd.shape[0]
+    if rise_jd.shape[1] == 0:
+        return np.full(n_fields, np.nan), np.full(n_fields, np.nan)
+    
+    length = np.where(np.isfinite(rise_jd), set_jd - rise_jd, -1.0)
+    i = np.argmax(length, axis=1)
+    rows = np.arange(n_fields)
+    
+    return rise_jd[rows, i], set_jd[rows, i]
+
+
+def _visibility_cache_file(cache_dir: str, ra: np.ndarray, dec: np.ndarray,
+                           jd_start: float, jd_end: float, longitude: float,
+                           latitude: float, altitude: float, elevation: float,
+                           step_minutes: float) -> str:
+    """Name of the cache file for a site, night and field list"""
+    key = hashlib.sha1()
+    key.update(repr((VISIBILITY_CACHE_VERSION, round(jd_start, 6), round(jd_end, 6),
+                     longitude, latitude, altitude, elevation, step_minutes)).encode())
+    key.update(ra.tobytes())
+    key.update(dec.tobytes())
+    
+    return os.path.join(cache_dir, f"visibility_{key.hexdigest()}.npz")
+
+
+def batch_visibility(ra, dec, jd_start: float, jd_end: float,
+                     longitude: float, latitude: float, altitude: float = 0.0,
+                     elevation: float = 0.0,
+                     step_minutes: float = VISIBILITY_GRID_MINUTES,
+                     cache_dir: Optional[str] = None) -> dict:
+    """
+    Observing windows and best airmass of many fields for one night.
+    
+    Replaces a loop over rise_set_times() with one batch_altitudes()
+    call over a grid of the night. With cache_dir, the result is kept
+    in a file named for the site, night, threshold and field list, and
+    read back from it by later calls with the same arguments.
+    
+    Args:
+        ra: Right ascensions in hours (array)
+        dec: Declinations in degrees (array)
+        jd_start: Start of the night (JD)
+        jd_end: End of the night (JD)
+        longitude: Observer longitude in hours (west positive)
+        latitude: Observer latitude in degrees
+        altitude: Altitude threshold in degrees (default horizon)
+        elevation: Observer height above sea level in meters
+        step_minutes: Spacing of the time grid in minutes
+        cache_dir: Directory for cached results, or None for no cache
+    
+    Returns:
+        Dictionary of arrays, one entry per field:
+        'rise_jd', 'set_jd' of the longest window (NaN if never above
+        altitude in the night), 'window_rise_jd', 'window_set_jd' of every
+        window (one row per field, as batch_windows()), 'max_altitude'
+        (degrees) and 'min_airmass' (999.9 if never up)
+    """
+    ra = np.atleast_1d(np.asarray(ra, dtype=float))
+    dec = np.atleast_1d(np.asarray(dec, dtype=float))
+    
+    cache_file = None
+    if cache_dir is not None:
+        cache_file = _visibility_cache_file(cache_dir, ra, dec, jd_start, jd_end,
+                                            longitude, latitude, altitude,
+                                            elevation, step_minutes)
+        if os.path.exists(cache_file):
+            try:
+                with np.load(cache_file) as cached:
+                    return {name: cached[name] for name in cached.files}
+            except (OSError, ValueError, KeyError) as e:
+                logger.warning(f"Ignoring visibility cache {cache_file}: {e}")
+    
+    jd_grid = night_time_grid(jd_start, jd_end, step_minutes)
+    alt = batch_altitudes(ra, dec, jd_grid, longitude, latitude, elevation)
+    window_rise_jd, window_set_jd = batch_windows(alt, jd_grid, altitude)
+    rise_jd, set_jd = longest_windows(window_rise_jd, window_set_jd)
+    max_alt = alt.max(axis=1) if alt.shape[1] > 0 else np.full(len(ra), -90.0)
+    
+    min_airmass = np.full(len(ra), 999.9)
+    up = max_alt > 0
+    min_airmass[up] = 1.0 / np.cos(np.radians(90.0 - max_alt[up]))
+    
+    result = {'rise_jd': rise_jd, 'set_jd': set_jd,
+              'window_rise_jd': window_rise_jd, 'window_set_jd': window_set_jd,
+              'max_altitude': max_alt, 'min_airmass': min_airmass}
+    
+    if cache_file is not None:
+        try:
+            os.makedirs(cache_dir, exist_ok=True)
+            tmp_file = cache_file + f".{os.getpid()}.tmp"
+            with open(tmp_file, 'wb') as output:
+                np.savez(output, **result)
+            os.replace(tmp_file, cache_file)
+        except OSError as e:
+            logger.warning(f"Could not write visibility cache {cache_file}: {e}")
+    
+    return result
+
+
 # ============================================================================
 # Sun and Moon Calculations using Astropy
 # ============================================================================
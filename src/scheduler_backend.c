@@ -0,0 +1,367 @@
+/* scheduler_backend.c
+
+   2026 Oct 14
+
+   The observing loop of the scheduler, and the virtual hardware it can
+   run on.
+
+   run_night() chooses fields with select_next_field() (or
+   get_next_field(), and plan_next_field() if LOOKAHEAD_PLANNING is
+   set) and observes them through a Sched_Hardware, waiting on a
+   Sched_Clock (see scheduler_clock.c) when there is nothing to
+   observe. Neither the loop nor the selection code reads the time or
+   sleeps itself. The scheduler runs it on the telescope and camera and
+   the wall clock (see scheduler.c), and sched_sim, season_sim and
+   "scheduler -s" on the virtual hardware and a virtual clock, so a
+   simulated night is chosen by the code that runs at the telescope.
+
+   The virtual hardware takes each exposure in the time charged for it
+   (exposure time, the overhead of an exposure, the slew beyond the
+   readout, and the focus time for focus fields, see
+   scheduler_overhead.c), by letting that
+   time pass on its clock, and chains repeats at one pointing into
+   bursts as it does (see scheduler_burst.c). The dome is open as given
+   by an optional weather file (see check_weather()), and in bad
+   weather the loop waits for it to clear in one step. With a virtual
+   clock a whole night runs as fast as the fields can be chosen (see
+   sched_sim.c).
+*/
+
+#include "scheduler.h"
+
+extern int verbose;
+extern char *selection_string[];
+
+int init_virtual_hardware(Sched_Hardware *hw, Sched_Clock *clock, FILE *output,
+        Weather_Timeline *weather, struct date_time date);
+int run_night(Field_Store *store, Night_Times *nt, Sched_Clock *clock,
+        Sched_Hardware *hw, FILE *hist_out, Night_Summary *summary);
+void night_ut_lst(Night_Times *nt, double jd, double *ut, double *lst);
+int record_exposure(Field *f, double jd, double ut, double lst,
+        double actual_expt, char *filename);
+
+/************************************************************/
+
+/* the ut and lst (hours) at jd in the night nt */
+
+void night_ut_lst(Night_Times *nt, double jd, double *ut, double *lst)
+{
+    *ut=nt->ut_start+(jd-nt->jd_start)*24.0;
+    if(*ut>24.0)*ut=*ut-24.0;
+    if(*ut<0.0)*ut=*ut+24.0;
+    *lst=nt->lst_start+(jd-nt->jd_start)*SIDEREAL_DAY_IN_HOURS;
+    if(*lst>24.0)*lst=*lst-24.0;
+    if(*lst<0.0)*lst=*lst+24.0;
+}
+
+/************************************************************/
+
+/* Add an exposure of f taken at jd (ut and lst in hours), of
+   actual_expt hours, to its history, and set when it is next due.
+   Return 0, or -1 if f is already complete */
+
+int record_exposure(Field *f, double jd, double ut, double lst,
+        double actual_expt, char *filename)
+{
+    if(f->n_done>=f->n_required){
+       fprintf(stderr,"record_exposure: field %d is already complete\n",f->field_number);
+       fflush(stderr);
+       return(-1);
+    }
+
+    f->history->ut[f->n_done]=ut;
+    f->history->jd[f->n_done]=jd;
+    f->history->ha[f->n_done]=get_ha(f->ra,lst);
+    f->history->lst[f->n_done]=lst;
+    f->history->actual_expt[f->n_done]=actual_expt;
+    strncpy(f->history->filename+(f->n_done)*FILENAME_LENGTH,filename,FILENAME_LENGTH);
+    f->n_done=f->n_done+1;
+    f->jd_next=jd+(f->interval/24.0);
+
+    return(0);
+}
+
+/************************************************************/
+
+static int virtual_observe(Sched_Hardware *hw, Field *sequence, int index,
+        int index_prev, double jd, double *dt, Night_Times *nt)
+{
+    Field *f,*f_prev;
+    struct tm tm;
+    double ut,lst,ha,jd_frame,dt_frame;
+    char shutter_string[3],filename[STR_BUF_LEN],field_description[STR_BUF_LEN];
+    int n,n_burst;
+
+    f=sequence+index;
+    f_prev=(index_prev>=0) ? sequence+index_prev : NULL;
+
+    if(f->n_done>=f->n_required){
+       fprintf(stderr,"virtual_observe: field %d is already complete\n",f->field_number);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* as in observe_next_field(), the repeats of a field at one pointing
+       may be taken in one burst (see scheduler_burst.c) */
+
+    n_burst=burst_length(f,jd);
+
+    *dt=0.0;
+    for(n=1;n<=n_burst;n++){
+       jd_frame=jd+(*dt/24.0);
+       night_ut_lst(nt,jd_frame,&ut,&lst);
+       ha=get_ha(f->ra,lst);
+
+       if(n==1){
+          dt_frame=f->expt+exposure_overhead(f->shutter);
+          if(f_prev!=NULL)dt_frame=dt_frame+slew_overhead(f_prev->ra,f_prev->dec,f->ra,f->dec);
+          if(f->shutter==FOCUS_CODE)dt_frame=dt_frame+focus_overhead();
+       }
+       else{
+          dt_frame=burst_frame_time(f);
+       }
+       *dt=*dt+dt_frame;
+
+       tm.tm_year=hw->date.y;
+       tm.tm_mon=hw->date.mo;
+       tm.tm_mday=hw->date.d;
+       tm.tm_hour=ut;
+       tm.tm_min=(ut-tm.tm_hour)*60.0;
+       tm.tm_sec=(ut-tm.tm_hour-(tm.tm_min/60.0))*3600.0;
+       get_filename(filename,&tm,f->shutter);
+       get_shutter_string(shutter_string,f->shutter,field_description);
+
+       record_exposure(f,jd_frame,ut,lst,f->expt,filename);
+
+       if(verbose){
+          fprintf(stderr,
+             "UT: %10.6f JD: %12.6f Exposed field : %d  RA: %9.6f  Dec: %9.5f n_done: %d n_wanted: %d time_left : %10.6f jd_next : %10.6f  description: %s\n",
+             ut, jd_frame-2450000,f->field_number, f->ra, f->dec, f->n_done,
+             f->n_required, f->time_left, f->jd_next, field_description);
+       }
+
+       if(hw->output!=NULL){
+          fprintf(hw->output,"%10.6f %10.6f %s %d %6.1f %10.6f %11.6f %10.6f %s # %s %d",
+             f->ra,f->dec,shutter_string,f->n_done,3600.0*f->expt,
+             ha,jd_frame,3600.0*f->expt,filename,field_description,f->field_number);
+          if(strstr(f->history->script_line,"#")!=NULL){
+             fprintf(hw->output,"%s",strstr(f->history->script_line,"#")+1);
+          }
+          else{
+             fprintf(hw->output,"\n");
+          }
+       }
+    }
+
+    return(hw->clock->wait(hw->clock,*dt*3600.0));
+}
+
+/************************************************************/
+
+static int virtual_bad_weather(Sched_Hardware *hw, double jd, Night_Times *nt)
+{
+    if(hw->weather==NULL)return(0);
+
+    return(check_weather(hw->weather,jd,&(hw->date),nt)!=0);
+}
+
+/************************************************************/
+
+static double virtual_weather_clears(Sched_Hardware *hw, double jd, Night_Times *nt)
+{
+    if(hw->weather==NULL)return(jd);
+
+    return(get_weather_clear_jd(hw->weather,jd,&(hw->date),nt));
+}
+
+/************************************************************/
+
+/* Set up hw as virtual hardware running on clock, logging exposures
+   to output (if not NULL), with the dome open as given by the weather
+   file read into weather for the night of local date (always open if
+   weather is NULL) */
+
+int init_virtual_hardware(Sched_Hardware *hw, Sched_Clock *clock, FILE *output,
+        Weather_Timeline *weather, struct date_time date)
+{
+    memset((void *)hw,0,sizeof(Sched_Hardware));
+    hw->observe=virtual_observe;
+    hw->bad_weather=virtual_bad_weather;
+    hw->weather_clears=virtual_weather_clears;
+    hw->clock=clock;
+    hw->output=output;
+    hw->weather=weather;
+    hw->date=date;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* earliest jd_next of the darks and dome flats still to be taken,
+   which are taken whatever the weather, or -1 if there are none */
+
+static double next_calibration_jd(Field *sequence, int num_fields)
+{
+    double jd_next;
+    int i;
+
+    jd_next=-1.0;
+    for(i=0;i<num_fields;i++){
+       if((sequence[i].shutter==DARK_CODE||sequence[i].shutter==DOME_FLAT_CODE)&&
+             sequence[i].doable&&sequence[i].n_done<sequence[i].n_required&&
+             (jd_next<0.0||sequence[i].jd_next<jd_next)){
+          jd_next=sequence[i].jd_next;
+       }
+    }
+
+    return(jd_next);
+}
+
+/************************************************************/
+
+/* Observe the fields of store (set up for the night nt by
+   init_fields()) from the time on clock until sunrise, choosing each
+   field as the scheduler does. Print the history (see print_history())
+   after every observation to hist_out, if not NULL. Fill in summary.
+   Return the number of exposures taken, or -1 on error.
+
+   Fields the hardware adds (see add_fields()) are appended to store,
+   which may then move. While observing is paused the clock is let run
+   LOOP_WAIT_SEC at a time. In bad weather, if the hardware says when it
+   will clear, the clock is let run to then (or to the next dark or dome
+   flat, if sooner) rather than LOOP_WAIT_SEC at a time */
+
+int run_night(Field_Store *store, Night_Times *nt, Sched_Clock *clock,
+        Sched_Hardware *hw, FILE *hist_out, Night_Summary *summary)
+{
+    Field_Selector selector;
+    Field *sequence;
+    double jd,dt,jd_wait,jd_cal;
+    int i,i_prev,num_fields,bad_weather,n_done_prev,result;
+
+    memset((void *)summary,0,sizeof(Night_Summary));
+
+    if(init_field_selector(&selector)!=0){
+       fprintf(stderr,"run_night: can't initialize field selector\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    i_prev=-1;
+    bad_weather=0;
+    jd=clock->now(clock);
+
+    while(jd<nt->jd_sunrise){
+
+       if(hw->add_fields!=NULL)hw->add_fields(hw,store,jd,nt);
+       sequence=store->fields;
+       num_fields=store->num_fields;
+
+       if(hw->publish!=NULL)hw->publish(hw,sequence,num_fields,i_prev,jd,bad_weather);
+
+       if(hw->paused!=NULL&&hw->paused(hw,jd,bad_weather)!=0){
+          clock->wait(clock,LOOP_WAIT_SEC);
+          summary->t_idle=summary->t_idle+(clock->now(clock)-jd)*24.0;
+          jd=clock->now(clock);
+          continue;
+       }
+
+       bad_weather=0;
+       if(hw->bad_weather!=NULL&&hw->bad_weather(hw,jd,nt)!=0)bad_weather=1;
+
+       /* a focus or offset sequence just ended is finished before the
+          next field is chosen */
+
+       if(hw->calibrate!=NULL&&i_prev>=0&&
+             hw->calibrate(hw,sequence,num_fields,i_prev,jd)!=0){
+          touch_field(&selector,i_prev);
+          jd=clock->now(clock);
+          continue;
+       }
+
+       begin_obs_metrics(PHASE_SELECT);
+#if EVENT_DRIVEN_SELECTION
+       i=select_next_field(&selector,sequence,num_fields,i_prev,jd,bad_weather);
+#else
+       i=get_next_field(sequence,num_fields,i_prev,jd,bad_weather);
+#endif
+#if LOOKAHEAD_PLANNING
+       i=plan_next_field(sequence,num_fields,i_prev,jd,bad_weather,i,nt->jd_end);
+#endif
+
+       /* as in the scheduler, darks and dome flats are taken whatever
+          the weather */
+
+       if(i>=0&&(sequence[i].shutter==DARK_CODE||sequence[i].shutter==DOME_FLAT_CODE||
+             !bad_weather)){
+          if(verbose){
+             fprintf(stderr,"# JD : %12.6f Selected field %d: %s\n",
+                jd-2450000,i,selection_string[sequence[i].selection_code]);
+          }
+
+          if(hw->publish!=NULL)hw->publish(hw,sequence,num_fields,i,jd,bad_weather);
+
+          dt=0.0;
+          n_done_prev=sequence[i].n_done;
+          result=hw->observe(hw,sequence,i,i_prev,jd,&dt,nt);
+          if(result!=0){
+             fprintf(stderr,"run_night: ERROR observing field %d\n",i);
+             fflush(stderr);
+             summary->n_errors++;
+          }
+          else{
+
+             /* a burst takes several exposures at once */
+
+             summary->n_exposures+=sequence[i].n_done-n_done_prev;
+          }
+          summary->t_observing=summary->t_observing+dt;
+
+          /* observing changes field i, and a bad readout may roll back
+             the last exposure of field i_prev */
+
+          touch_field(&selector,i);
+          if(i_prev>=0)touch_field(&selector,i_prev);
+
+          if(hw->observed!=NULL)hw->observed(hw,sequence,num_fields,i,result,jd,bad_weather);
+          if(hist_out!=NULL)print_history(jd,sequence,num_fields,hist_out);
+
+          end_obs_metrics(sequence[i].field_number,sequence[i].shutter,
+             sequence[i].n_done-n_done_prev,jd,
+             result==0 ? 3600.0*burst_expt(sequence+i,sequence[i].n_done-n_done_prev) : 0.0);
+
+          /* don't get stuck if the hardware took no time */
+
+          if(clock->now(clock)<=jd)clock->wait(clock,LOOP_WAIT_SEC);
+          i_prev=i;
+       }
+       else{
+          if(hw->idle!=NULL)hw->idle(hw,i,bad_weather,jd);
+
+          dt=LOOP_WAIT_SEC;
+          if(bad_weather&&hw->weather_clears!=NULL){
+             jd_wait=hw->weather_clears(hw,jd,nt);
+             if(jd_wait<0.0||jd_wait>nt->jd_sunrise)jd_wait=nt->jd_sunrise;
+             jd_cal=next_calibration_jd(sequence,num_fields);
+             if(jd_cal>=0.0&&jd_cal<jd_wait)jd_wait=jd_cal;
+             if((jd_wait-jd)*86400.0>dt)dt=(jd_wait-jd)*86400.0;
+          }
+          clock->wait(clock,dt);
+          summary->t_idle=summary->t_idle+(clock->now(clock)-jd)*24.0;
+       }
+
+       jd=clock->now(clock);
+    }
+
+    sequence=store->fields;
+    for(i=0;i<store->num_fields;i++){
+       if(sequence[i].n_done==sequence[i].n_required)summary->n_completed++;
+    }
+
+    free_field_selector(&selector);
+
+    return(summary->n_exposures);
+}
+
+/************************************************************/
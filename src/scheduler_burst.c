@@ -0,0 +1,111 @@
+/* scheduler_burst.c
+
+   2026 Oct 14
+
+   Chaining the repeats of a field at one pointing into a burst.
+
+   The camera controller can expose the next image while it fetches the
+   last one (EXP_MODE_NEXT, see take_exposure()), so the fastest cadence
+   at one pointing is one frame per exposure and readout. A field whose
+   remaining repeats are due again as soon as one is taken (darks, dome
+   flats, and sky fields whose interval is no longer than a frame) used
+   to go back through the main loop for each one: selection, a record
+   save, and in observe_next_field() a telescope status, a pointing, a
+   clear check and a round of FITS keywords. burst_length() says how
+   many of those repeats observe_next_field() should take as one pass,
+   as it does for the pieces of a long exposure split in the west. Only
+   the first frame of a burst pays for the slew and setup; the others
+   cost BURST_FRAME_OVERHEAD each.
+
+   Fields that change pointing or focus between frames (focus and
+   offset sequences, dithered flats and deep coadds) are never chained.
+   A burst is cut at BURST_MAX_FRAMES frames or BURST_MAX_TIME hours,
+   so the weather and new fields are still checked between bursts, and
+   a sky field's burst ends before the field sets.
+*/
+
+#include "scheduler.h"
+
+int burst_field(Field *f);
+double burst_frame_time(Field *f);
+int burst_length(Field *f, double jd);
+double burst_expt(Field *f, int n_frames);
+
+/************************************************************/
+
+/* 1 if the repeats of f may be taken in a burst, 0 if not */
+
+int burst_field(Field *f)
+{
+    if(f->shutter==DARK_CODE||f->shutter==DOME_FLAT_CODE)return(1);
+
+    if(f->shutter!=SKY_CODE)return(0);
+
+    /* deep coadds are dithered frame by frame, and long exposures are
+       split instead */
+
+    if(f->n_required==6&&DEEP_DITHER_ON)return(0);
+    if(f->expt>LONG_EXPTIME)return(0);
+
+    return(1);
+}
+
+/************************************************************/
+
+/* time (hours) of each frame of a burst of f after the first */
+
+double burst_frame_time(Field *f)
+{
+    return(f->expt+BURST_FRAME_OVERHEAD);
+}
+
+/************************************************************/
+
+/* Return the number of the remaining observations of f to take at jd
+   in one burst: 1 unless f may be chained, its interval is no longer
+   than a frame of the burst (so each repeat is due by the time the
+   frame before it has read out), and more than one observation is
+   left */
+
+int burst_length(Field *f, double jd)
+{
+    double t_frame,t;
+    int n,n_left;
+
+    n_left=f->n_required-f->n_done;
+    if(n_left<2||!burst_field(f))return(1);
+
+    t_frame=burst_frame_time(f);
+    if(f->interval>t_frame)return(1);
+
+    n=1;
+    t=execution_time(f->shutter,f->expt);
+    while(n<n_left&&n<BURST_MAX_FRAMES&&t+t_frame<=BURST_MAX_TIME){
+       if(f->shutter==SKY_CODE&&jd+(t+t_frame)/24.0>f->jd_set)break;
+       t=t+t_frame;
+       n++;
+    }
+
+    if(n>1&&verbose1){
+       fprintf(stderr,"burst_length: field %d : %d frames in %7.1f sec\n",
+          f->field_number,n,t*3600.0);
+       fflush(stderr);
+    }
+
+    return(n);
+}
+
+/************************************************************/
+
+/* exposure time (hours) of n_frames observations of f taken in one
+   pass of observe_next_field(): the frames of a burst each expose
+   f->expt, while the pieces of a split exposure share it */
+
+double burst_expt(Field *f, int n_frames)
+{
+    if(n_frames<1||f->expt>LONG_EXPTIME)return(f->expt);
+
+    return(n_frames*f->expt);
+}
+
+/************************************************************/
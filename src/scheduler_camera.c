@@ -9,24 +9,19 @@
 #include "scheduler.h"
 #include <errno.h>
 #include <pthread.h>
-#include <semaphore.h>
 
 #define BAD_ERROR_CODE 2
 #define BAD_READOUT_TIME 60.0
 
-typedef struct{
-   char *command;
-   char *reply;
-   int timeout;
-   sem_t *start_semaphore;
-   sem_t *done_semaphore;
-   int command_id;
-} Do_Command_Args;
+/* ticket of the exposure command left running on the camera worker
+   (scheduler_worker.c) by take_exposure() with wait_flag False */
 
-// semaphores used to synchronize do_camera_command_thread
-// with parent thread
-sem_t command_done_semaphore; 
-sem_t command_start_semaphore; 
+static int exposure_ticket = -1;
+
+/* file name of the last exposure, for the EXP_MODE_LAST fetch that ends a
+   FIRST, NEXT, ..., NEXT sequence (see fetch_last_exposure()) */
+
+static char last_exposure_name[STR_BUF_LEN] = "";
 
 /* set status_channel_active to True if ls4_ccp has been configured
  * to reply to status queries on a dedicated socket */
@@ -120,20 +115,6 @@ Return value:
 
 */
 
-int init_semaphores()
-{
-    if(verbose1){
-        fprintf(stderr,"init_semaphores: initializing start_semaphore\n");
-    }
-    sem_init(&command_start_semaphore,0,0);
-
-    if(verbose1){
-        fprintf(stderr,"init_semaphores: initializing done_semaphore\n");
-    }
-    sem_init(&command_done_semaphore,0,0);
-
-}
-
 int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
 		    char *name, double *ut, double *jd,
 		    bool wait_flag, int *exp_error_code, char *exp_mode)
@@ -147,7 +128,6 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
     double expt;
     int shutter;
     int timeout = 0;
-    pthread_t command_thread;
     double t;
 
     int result = 0;
@@ -208,9 +188,9 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
 
     /* update comment line in FITS header with comments from script record */
 
-    if(strstr(f->script_line,"#")!=NULL){
+    if(strstr(f->history->script_line,"#")!=NULL){
         sprintf(comment_line,"                      ");
-        sprintf(comment_line,"'%s",strstr(f->script_line,"#")+1);
+        sprintf(comment_line,"'%s",strstr(f->history->script_line,"#")+1);
         strcpy(comment_line+strlen(comment_line)-1,"'");
     }
     else{
@@ -236,6 +216,7 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
       fprintf(stderr,"take_exposure: could not imprint fits header\n");
       return(-1);
     }
+    obs_phase(PHASE_EXPOSE);
 
     char shutter_state[12];
     if(shutter)
@@ -244,37 +225,24 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
       strcpy(shutter_state,"False");
 
 
-    /* initialize command semaphores to 0. 
-     *
-     * If do_camera_command thread executes the expose command (wait = False),
-     * that thread will pause until the start semaphore is posted (changed to 1).
-     * The thread will post the done semaphore when the expose command returns.
-     *
-     * If the thread is  not used, neither will be posted.
-     *
-    */
     if(verbose1){
         fprintf(stderr,"take_exposure: set readout_pending to True\n");
     }
     readout_pending = True;
 
-    /* If wait_flag is False, then launch a new thread (command_thread) to execute 
-     * the call to do_camera_command (which sends an EXPOSE_COMMAND to the camera
-     * control program (ls4_ccp). 
+    /* If wait_flag is False, then queue the EXPOSE_COMMAND to the camera
+     * worker (scheduler_worker.c), which sends it to the camera
+     * control program (ls4_ccp) and waits for the reply. 
      *
      * Meanwhile, monitor the status of the camera. When the camera status show that  
      * the exposure time has elapsed (but the controller has not year read out the image),
      * return from the program.
      *
-     * The command_thread will continue executing the exposure, and read out the
-     * image when the exposure time has elapsed. It will post do the command_done_semaphore
-     * just before it exists.
+     * The worker carries on waiting for the reply, which comes once the image
+     * is read out. wait_camera_readout() waits for that reply (exposure_ticket).
      *
-     * If wait flag is True, do not launch a new thread. Just execute the call to 
-     * to do_camera_command and wait for it to complete before returning. Set
-     * exp_error_code appropriately if do_camera_command returns with an error.
-     *
-     * Note that the action taken by 
+     * If wait flag is True, queue the command and wait for its reply before
+     * returning. Set exp_error_code appropriately if the command returns with an error.
     */
 
 
@@ -311,42 +279,29 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
 
     if (! wait_flag){
        if(verbose1){
-         fprintf(stderr,"take_exposure: using a thread to execute the exposure command");
+         fprintf(stderr,"take_exposure: queueing the exposure command to the camera worker\n");
          fflush(stderr);
        }
 
-       pthread_t thread_id;
-       Do_Command_Args *command_args;
-
-       command_args = (Do_Command_Args *)malloc(sizeof(Do_Command_Args));
-       command_args->command = command;
-       command_args->reply = reply;
-       command_args->timeout = timeout;
-       command_args->start_semaphore = &command_start_semaphore;
-       command_args->done_semaphore = &command_done_semaphore;
-       command_args->command_id = command_id++;
+       /* a ticket not collected by wait_camera_readout() (readout timed out) */
+       if (exposure_ticket >= 0){
+         release_camera_command(exposure_ticket);
+         exposure_ticket = -1;
+       }
 
-       if(pthread_create(&thread_id,NULL,do_camera_command_thread,\
-		       (void *)command_args)!=0){
-         fprintf(stderr,"take_exposure: ERROR creating do_camera_command_thread\n");
+       t = get_ut();
+       exposure_ticket = queue_camera_command(CAMERA_CMD_EXPOSE,command,timeout,False);
+       if (exposure_ticket < 0){
+         fprintf(stderr,"take_exposure: ERROR queueing exposure command\n");
          fflush(stderr);
 	 readout_pending = False;
 	 return -1;
        }
 
        if(verbose1){
-           fprintf(stderr,"take_exposure: do_camera_command_thread running\n");
-           fflush(stderr);
-       }
-
-       // post to command_start_semaphore. This tells the do_camera_command_thread to start
-       // executing the exposre command
-       if(verbose1){
-	   t = get_ut();
-           fprintf(stderr,"take_exposure: time %12.6f : posting to start_semaphore\n",t);
+           fprintf(stderr,"take_exposure: time %12.6f : exposure command queued\n",t);
            fflush(stderr);
        }
-       sem_post(&command_start_semaphore);
 
        // record time at start of exposure
        gettimeofday(&t_exp_start, NULL);
@@ -378,8 +333,7 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
        // record time at start of exposure
        gettimeofday(&t_exp_start, NULL);
 
-       command_id++;
-       if(do_camera_command(command,reply,timeout,command_id,host_name)!=0){
+       if(run_camera_command(CAMERA_CMD_EXPOSE,command,reply,timeout)!=0){
          fprintf(stderr,"take_exposure: error sending exposure command : %s\n",command);
          fprintf(stderr,"take_exposure: reply was : %s\n",reply);
          *actual_expt=0.0;
@@ -401,6 +355,7 @@ int take_exposure(Field *f, Fits_Header *header, double *actual_expt,
     }
 
     strncpy(name,filename,FILENAME_LENGTH);
+    strncpy(last_exposure_name,filename,STR_BUF_LEN-1);
     
     return(0);
 }
@@ -466,57 +421,60 @@ double expose_timeout (char *exp_mode, double exp_time, bool wait_flag)
 
 /*****************************************************/
 
-int get_filename(char *filename,struct tm *tm,int shutter)
-{
-    char shutter_string[3];
-    int result;
-    char field_description[STR_BUF_LEN];
-
-    result=get_shutter_string(shutter_string,shutter,field_description);
-    if(result!=0){
-        fprintf(stderr,"get_filename: bad shutter code: %d\n",shutter);
-        fflush(stderr);
-    }
-
-    sprintf(filename,"%04d%02d%02d%02d%02d%02d%s",
-            tm->tm_year,tm->tm_mon,tm->tm_mday,
-	    tm->tm_hour,tm->tm_min,tm->tm_sec,shutter_string);
-
-    return(result);
-}
-
-/*****************************************************/
-
 /* The camera controller updates the image fits header with info specific to the camera status. 
  * This command to add info the header maintained by the controller. This additional
  * info will be save to the fits header when the image is read out and saved by the controller
+ *
+ * The controller keeps the values it has been sent from one image to the next, so only
+ * the keywords whose values have changed since the last imprint (marked dirty by
+ * update_fits_header) are sent. A keyword that fails to send stays dirty and is sent
+ * again next time.
 */
 
 int imprint_fits_header(Fits_Header *header)
 {
     char command[MAXBUFSIZE];
-    char reply[MAXBUFSIZE];
-    int i;
+    int ticket[MAX_FITS_WORDS];
+    int i,result;
+
+    if(verbose1){
+      fprintf(stderr,"imprint_fits_header: sending %d of %d keywords\n",
+		header->num_dirty,header->num_words);
+      fflush(stderr);
+    }
+
+    /* queue all the keywords to the camera worker, then collect the replies */
 
-    command_id++;
     for(i=0;i<header->num_words;i++){
+      ticket[i]=-1;
+      if(!header->fits_word[i].dirty)continue;
       sprintf(command,"%s %s %s",
 		HEADER_COMMAND,header->fits_word[i].keyword,
                 header->fits_word[i].value);
-      if(do_camera_command(command,reply,CAMERA_TIMEOUT_SEC,command_id,host_name)!=0){
+      ticket[i]=queue_camera_command(CAMERA_CMD_HEADER,command,CAMERA_TIMEOUT_SEC,False);
+    }
+
+    result=0;
+    for(i=0;i<header->num_words;i++){
+      if(!header->fits_word[i].dirty)continue;
+      if(ticket[i]<0||wait_camera_command(ticket[i],0,NULL)!=0){
         fprintf(stderr,
-          "imprint_fits_header: error sending command %s\n",command);
-        return(-1);
+          "imprint_fits_header: error sending keyword %s\n",header->fits_word[i].keyword);
+        result=-1;
       }
+      else{
+        clear_fits_word(header,i);
+      }
+      release_camera_command(ticket[i]);
     }
 
-    return(0);
+    return(result);
 }
      
 /*****************************************************/
 
 /* wait for camera exposure to end while the command to take an
- * exposure occurs in a parallel thread (do_camera_command_thread). 
+ * exposure is sent by the camera worker (scheduler_worker.c). 
  * This routine is used by the "take_exposure" command when
  * the wait_flag argument is False. 
  *
@@ -528,14 +486,13 @@ int imprint_fits_header(Fits_Header *header)
  * the main thread continues to perform other functions (such as
  * moving the telescope to the next position).
  *
- * The parallel thread posts to the done_semaphore just before it exits,
- * signifying the exposure command has completed.
+ * The reply to the exposure command, collected by wait_camera_readout(),
+ * signifies the exposure command has completed.
 */
  
 double wait_exp_done(int expt)
 {
-    struct timeval t_val;
-    int t,t_start,t_end,timeout_sec;
+    int t,t_start,timeout_sec;
     double act_expt;
 
     act_expt=0;
@@ -548,50 +505,33 @@ double wait_exp_done(int expt)
          fflush(stderr);
     }
 
-    sleep(expt);
-
-    /* if the status channel is active, query the camera status to determine whenb
-     * the exposure ends. Otherwise, just assume it has ended when the expected 
+    /* if the status channel is active, the camera monitor thread
+     * (scheduler_monitor.c) reports the moment the EXPOSING flag clears.
+     * Sleep until just before the exposure should end, then wait for it.
+     * Otherwise, just assume it has ended when the expected 
      * exposure time has been waited */
 
-    if (status_channel_active){
-
-	gettimeofday(&t_val,NULL);
-	int t_start = t_val.tv_sec;
-	int t_end = t_start + timeout_sec;
-
-	t=t_start;
-	int done = False;
-	while (t < t_end && ! done){
-	  if(update_camera_status(NULL)!=0){
-	    fprintf(stderr,"wait_camera_readout: could not update camera status\n");
-	    done = True;
-	  }
-	  else if (cam_status.state_val[EXPOSING] == ALL_NEGATIVE_VAL){
-	     done = True;
-	  }
-	  else{
-	    fprintf(stderr,"cam_status.state_val[EXPOSING] = %d\n",cam_status.state_val[EXPOSING]);
-	    usleep(100000);
-	    gettimeofday(&t_val,NULL);
-	    t = t_val.tv_sec;
-	  }
-	}
+    if (status_channel_active && start_camera_monitor() == 0){
+
+	if (expt > EXP_DONE_LEAD_SEC) clock_sleep(expt - EXP_DONE_LEAD_SEC);
+
+	t_start = (int)get_unix_time();
+
+	int done = (wait_camera_state(EXPOSING,ALL_NEGATIVE_VAL,
+			timeout_sec - (expt > EXP_DONE_LEAD_SEC ? expt - EXP_DONE_LEAD_SEC : 0),
+			&cam_status) == 0);
+
+	t = (int)get_unix_time();
 
 	if (! done ){
-	   if (t < t_end){
-	     fprintf(stderr,"wait_exp_done: time %12.6f : ERROR waiting for exposure to end\n",get_ut());
-	   }
-	   else{
-	     fprintf(stderr,"wait_exp_done: time %12.6f : timeout waiting for exposure to end\n",get_ut());
-	   }
+	   fprintf(stderr,"wait_exp_done: time %12.6f : ERROR or timeout waiting for exposure to end\n",get_ut());
 	   fflush(stderr);
 	}
 	else{
 
 	   if(verbose1){
 	     fprintf(stderr,
-	       "wait_camera_readout: exposure successfully ended in  %d sec\n",
+	       "wait_exp_done: exposure ended %d sec after the wait started\n",
 		t - t_start);
 	     fflush(stderr);
 	   }
@@ -603,8 +543,12 @@ double wait_exp_done(int expt)
 	    fflush(stderr);
 	    act_expt=-1.0;
 	}
+	else{
+	    act_expt = expt;
+	}
     }
     else{
+        clock_sleep(expt);
         act_expt = expt;
     }
 
@@ -656,8 +600,7 @@ int update_camera_status(Camera_Status *status)
 
      error_flag=0;
 
-     command_id++;
-     if(do_status_command(STATUS_COMMAND,reply,CAMERA_TIMEOUT_SEC,command_id,host_name)!=0){
+     if(run_camera_command(CAMERA_CMD_STATUS,STATUS_COMMAND,reply,CAMERA_TIMEOUT_SEC)!=0){
        return(-1);
      }
      else {
@@ -669,74 +612,6 @@ int update_camera_status(Camera_Status *status)
 
 }
 /*****************************************************/
-// thread wrapper
-//
-void *do_camera_command_thread(void *args){
-
-     int *result = malloc(sizeof(int));
-     Do_Command_Args *command_args;
-     int timeout_sec;
-     char *command;
-     char *reply;
-     sem_t *done_semaphore;
-     sem_t *start_semaphore;
-     double t_start, t_end;
-     int id;
-
-     command_args = (Do_Command_Args *)args;
-     command = command_args->command;
-     reply = command_args->reply;
-     timeout_sec =  command_args->timeout;
-     start_semaphore = command_args->start_semaphore;
-     done_semaphore = command_args->done_semaphore;
-     id = command_args->command_id;
-
-
-     *result = 0;
-
-
-     struct timespec t;
-     t.tv_sec = timeout_sec;
-     t.tv_nsec = 0;
-
-     if(verbose1){
-          fprintf(stderr,"do_camera_command_thread[%d]: time %12.6f : waiting for start_semaphore to post with timeout %ld sec\n",
-			  id,get_ut(),t.tv_sec);
-          fflush(stderr);
-     }
-
-     /* wait for the start_semaphore to post, or else timeout */
-     if ( sem_timedwait(start_semaphore,&t) != 0){
-        fprintf(stderr,"do_camera_command_thread[%d]: time %12.6f : error waiting for start_semaphore to post\n",id,get_ut());
-	perror("timeout waiting for start_semaphore to post in do_camera_command");
-        fflush(stderr);
-        *result = -1;
-     }
-     /* once the start semaphore posts, execute the command and then post to the
-      * done semaphore */
-     else{
-	t_start = get_ut();
-        if(verbose1){
-          fprintf(stderr,"do_camera_command_thread[%d]: start time %12.6f : sending command [%s] with timeout %d sec\n",
-			  id,t_start,command,timeout_sec);
-          fflush(stderr);
-        }
-        *result = do_camera_command(command,reply, timeout_sec,id,host_name);
-	t_end = get_ut();
-        if(verbose1){
-          fprintf(stderr,"do_camera_command_thread[%d]: done time %12.6f : result is [%d] \n",id,t_end,*result);
-	  fflush(stderr);
-	}
-        if(verbose1){
-          fprintf(stderr,"do_camera_command_thread[%d]: time %12.6f : posting to done_semaphore\n", id,t_end);
-	  fflush(stderr);
-	}
-	sem_post(done_semaphore);
-     }
-
-     pthread_exit(result);
-}
-
 int do_status_command(char *command, char *reply, int timeout_sec,int id, char *host){
     return do_command(command, reply, timeout_sec, STATUS_PORT,id, host);
 }
@@ -749,10 +624,9 @@ int do_command(char *command, char *reply, int timeout_sec, int port,int id, cha
 
      int returnval = 0;
 
-     if(verbose1){
-          fprintf(stderr,"do_command[%d]: time %12.6f : sending command %s with timeout %d sec\n",
+     if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+          sched_log(LOG_COMMAND,LOG_DEBUG,"do_command[%d]: time %12.6f : sending command %s with timeout %d sec\n",
 			  id,get_ut(),command,timeout_sec);
-          fflush(stderr);
      }
 
      if(send_command(command,reply,host,port, timeout_sec)!=0){
@@ -762,7 +636,7 @@ int do_command(char *command, char *reply, int timeout_sec, int port,int id, cha
          fflush(stderr);
      }
 
-     usleep(COMMAND_DELAY_USEC);
+     if(COMMAND_DELAY_USEC>0)usleep(COMMAND_DELAY_USEC);
 
      if (returnval == 0){
        //if(strstr(reply,ERROR_REPLY)!=NULL || strlen(reply) == 0 ){
@@ -774,9 +648,8 @@ int do_command(char *command, char *reply, int timeout_sec, int port,int id, cha
 	 returnval = -1;
        }
        else {
-         if(verbose1){
-           fprintf(stderr,"do_command[%d]: time %12.6f : reply was %s\n",id,get_ut(),reply);
-           fflush(stderr);
+         if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+           sched_log(LOG_COMMAND,LOG_DEBUG,"do_command[%d]: time %12.6f : reply was %s\n",id,get_ut(),reply);
          }
        }
      }
@@ -787,81 +660,92 @@ int do_command(char *command, char *reply, int timeout_sec, int port,int id, cha
 }
 /*****************************************************/
 
+/* return True if the camera monitor shows a readout or fetch still in
+   progress */
+
+static bool readout_in_progress()
+{
+    Camera_Status status;
+
+    if (!status_channel_active || get_monitored_camera_status(&status) != 0)
+       return False;
+
+    return (status.state_val[READOUT_PENDING] != ALL_NEGATIVE_VAL ||
+            status.state_val[READING] != ALL_NEGATIVE_VAL ||
+            status.state_val[FETCHING] != ALL_NEGATIVE_VAL);
+}
+
+/*****************************************************/
+
 /* wait for camera readout to end.
  * This routine used by scheduler.c to decide when to begin a new observation.
  * As long as the readout is complete, the telescope may be moved to a new position.
  * A new exposure may also begin, depending on the exposure mode of the previous
  * observatopn.
  *
- * If a readout is not pending, wait the the command_done_semaphore
- * to post. This signifies the exposure and readout have completed.
- * Return with result = 0 if no timeout or other error occurs while
- * waiting for the readout. Otherwise return -1.
+ * If a readout is pending, wait for the camera worker to receive the
+ * reply to the exposure command (exposure_ticket). This signifies the
+ * exposure and readout have completed.
+ * Return with result = 0 if the exposure command succeeded and no timeout
+ * occurs while waiting for the readout. Otherwise return -1.
  *
  * If no readout is pending, just return with result = 0
 */
 
 int wait_camera_readout(Camera_Status *status)
 {
-    struct timeval t1,t2;
-    double t,t_start,t_end,dt;
+    double t_start,t_end,dt;
     int result=0;
     int timeout_sec = READOUT_TIME_SEC;
+    int wait_result;
 
     if (readout_pending){
-      gettimeofday(&t1,NULL);
       if(verbose){
 	fprintf(stderr,"wait_camera_readout: time %12.6f : waiting for readout to complete\n",get_ut());
 	fflush(stderr);
       }
-      /* wait for the done_semphore to post, or else timeout */
 
       t_start = get_ut();
       if(verbose1){
-	fprintf(stderr,"wait_camera_readout: time = %12.6f : waiting for done_semaphore to post with timeout %d\n",t_start,timeout_sec);
+	fprintf(stderr,"wait_camera_readout: time = %12.6f : waiting for exposure reply with timeout %d\n",t_start,timeout_sec);
 	fflush(stderr);
       }
-      //HERE
-      /* If a timeout or error occurs while waiting for ther done_semaphore to
-       * post, return -1.
-      */
-      t = t_start*3600.0;
-      t_end = t + timeout_sec;
-      bool done = False;
-      while (t < t_end  && !done){
-         if ( sem_trywait(&command_done_semaphore) != 0){
-	    if(verbose1){
-	      fprintf(stderr,"wait_camera_readout: time = %12.6f : still waiting for done_semaphore\n",
-			      get_ut());
-	    }
-	    usleep(100000);
-	    t = t + 0.1;
-	 }
-	 else{
-	    done = True;
-	    if(verbose1){
-	      fprintf(stderr,"wait_camera_readout: time = %12.6f : done_semaphore has posted\n",
+
+      /* wait_camera_command returns as soon as the worker has the reply, so the
+         next exposure can start without a polling delay */
+
+      wait_result = wait_camera_command(exposure_ticket,timeout_sec,NULL);
+      if (wait_result == CAMERA_WAIT_TIMEOUT && readout_in_progress()){
+	 /* the camera monitor shows the readout still going. Give it
+	    one more READOUT_TIME_SEC */
+	 fprintf(stderr,"wait_camera_readout: time = %12.6f : readout still in progress, waiting longer\n",
 			      get_ut());
-	    }
-	 }   
+	 fflush(stderr);
+	 wait_result = wait_camera_command(exposure_ticket,timeout_sec,NULL);
       }
+
       t_end = get_ut();
       dt = (t_end - t_start) * 3600.0;
-      if ( ! done ){
-        fprintf(stderr,"wait_camera_readout: time = %12.6f: dt = %12.6f: error waiting for done_semaphore to post\n",t_end,dt);
+
+      /* if the reply is still not in, the worker discards it when it comes */
+
+      release_camera_command(exposure_ticket);
+      exposure_ticket = -1;
+      readout_pending = False;
+
+      if ( wait_result == CAMERA_WAIT_TIMEOUT ){
+        fprintf(stderr,"wait_camera_readout: time = %12.6f: dt = %12.6f: timeout waiting for exposure reply\n",t_end,dt);
         fflush(stderr);
         result = -1;
       }
-      /* Otherwise if done_semaphore posts, the readout is is done.  Set readout_pending to
-       * False and return 0
-      */
-      else{
-	readout_pending = False;
-        if(verbose1){
-     	  fprintf(stderr,"wait_camera_readout: time = %12.6f : done_semaphore has posted\n",t_end);
-     	  fprintf(stderr,"wait_camera_readout: time = %12.6f : waited %7.3f sec for readout to end\n",t_end,dt);
-	  fflush(stderr);
-        }
+      else if ( wait_result != 0 ){
+        fprintf(stderr,"wait_camera_readout: time = %12.6f: dt = %12.6f: exposure command failed\n",t_end,dt);
+        fflush(stderr);
+        result = -1;
+      }
+      else if(verbose1){
+     	fprintf(stderr,"wait_camera_readout: time = %12.6f : waited %7.3f sec for readout to end\n",t_end,dt);
+	fflush(stderr);
       }
     }
     else{
@@ -886,6 +770,48 @@ int wait_camera_readout(Camera_Status *status)
 
 /*****************************************************/
 
+/* End a sequence of exposures taken with EXP_MODE_FIRST and EXP_MODE_NEXT:
+   wait for the readout of the last one and fetch it from controller
+   memory with EXP_MODE_LAST, which takes no new exposure. Without this
+   the last image of the night stays unfetched.
+   Return 0 on success, -1 on failure */
+
+int fetch_last_exposure(Camera_Status *status)
+{
+    char command[MAXBUFSIZE],reply[MAXBUFSIZE];
+    int timeout,result;
+
+    result=0;
+    if(wait_camera_readout(status)!=0){
+       fprintf(stderr,"fetch_last_exposure: bad readout of last exposure\n");
+       fflush(stderr);
+       result=-1;
+    }
+
+    if(strlen(last_exposure_name)==0)return(result);
+
+    timeout = expose_timeout(EXP_MODE_LAST, 0.0, True);
+    sprintf(command,"%s %s %9.3f %s %s",EXPOSE_COMMAND,"False",0.0,
+       last_exposure_name,EXP_MODE_LAST);
+
+    if(verbose){
+       fprintf(stderr,"fetch_last_exposure: sending command %s\n",command);
+       fflush(stderr);
+    }
+
+    if(run_camera_command(CAMERA_CMD_EXPOSE,command,reply,timeout)!=0){
+       fprintf(stderr,"fetch_last_exposure: error sending exposure command : %s\n",command);
+       fprintf(stderr,"fetch_last_exposure: reply was : %s\n",reply);
+       fflush(stderr);
+       result=-1;
+    }
+    last_exposure_name[0]=0;
+
+    return(result);
+}
+
+/*****************************************************/
+
 int clear_camera()
 {
      char reply[MAXBUFSIZE];
@@ -894,8 +820,7 @@ int clear_camera()
      double timeout = CLEAR_TIME +  5;
      sprintf(command_string,"%s %d",CLEAR_COMMAND,CLEAR_TIME);
 
-     command_id++;
-     if(do_camera_command(command_string,reply,timeout,command_id,host_name)!=0){
+     if(run_camera_command(CAMERA_CMD_CLEAR,command_string,reply,timeout)!=0){
        return(-1);
      }
      else {
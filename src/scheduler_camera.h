@@ -13,7 +13,8 @@
 #define STATUS_PORT 5001  
 
 
-#define COMMAND_DELAY_USEC 100000 /* useconds to wait between commands */
+#define COMMAND_DELAY_USEC 0 /* useconds to wait between commands. Not needed
+                               now that send_command() waits for the full reply */
 
 /* first word in reply from camera controller */
 #define ERROR_REPLY "ERROR"
@@ -27,13 +28,45 @@
 //#define NUM_CAMERA_CLEARS 2 /* number of clears per camera clear */
 #define READOUT_TIME_SEC 40
 #define TRANSFER_TIME_SEC 10
-#define EXPOSURE_OVERHEAD ((READOUT_TIME_SEC + 5.0)/3600.0) /* hours */
+#define EXPOSURE_SETUP_SEC 5.0 /* header imprint and start of exposure, after readout */
+
+/* time between exposures (hours). Selecting, pointing and focusing for the next
+   field happen while the previous exposure reads out (see observe_next_field), so
+   an observation takes max(slew, readout) + setup beyond its exposure time. This
+   is the readout and setup part, charged to every exposure; the part of a slew
+   longer than the readout is charged by slew_overhead() where the pointing
+   before is known (the virtual hardware, the lookahead planner). A slew is
+   hidden when it is shorter than the readout, so the charge is the readout and
+   setup alone, as it was before the pipeline, which never charged the slew or
+   the selection, status and header phases it ran in series (it is this time,
+   not the 45 sec, that the pipeline saves). The fit of fit_overhead_model()
+   measures both parts the same way */
+#define EXPOSURE_OVERHEAD ((READOUT_TIME_SEC + EXPOSURE_SETUP_SEC)/3600.0)
+
+/* time between the frames of a burst at one pointing (hours). Each frame is
+   exposed with EXP_MODE_NEXT as soon as the last one is read out, and only
+   the keywords that change (the sequence number and file name) are imprinted */
+#define BURST_FRAME_OVERHEAD (READOUT_TIME_SEC/3600.0)
 
 /* Timeout after 10 seconds if expecting quick response from
    a camera command */
 
 #define CAMERA_TIMEOUT_SEC 5 
 
+/* wait_exp_done sleeps until this many seconds before the expected end of
+   an exposure, then watches the camera state for the actual end */
+#define EXP_DONE_LEAD_SEC 1
+
+/* commands queued to the camera workers (scheduler_worker.c) */
+#define CAMERA_CMD_EXPOSE 0
+#define CAMERA_CMD_CLEAR 1
+#define CAMERA_CMD_HEADER 2
+#define CAMERA_CMD_STATUS 3
+
+#define CAMERA_QUEUE_SIZE 128 /* commands queued per worker. Room for a full
+                                 FITS header (MAX_FITS_WORDS) and an exposure */
+#define CAMERA_WAIT_TIMEOUT -2 /* wait_camera_command(): command not finished */
+
 /* LS4 exposure modes  (see "ls4_control/archon-main/archon/ls4/ls4_exp_modes.py")*/
 #define EXP_MODE_SINGLE "single"
 #define EXP_MODE_FIRST "first"
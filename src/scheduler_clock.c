@@ -0,0 +1,401 @@
+/* scheduler_clock.c
+
+   2026 Oct 14
+
+   Time of day, and the clocks the scheduling core runs against.
+
+   get_ut(), get_tm() and get_jd() read the system clock (they were in
+   scheduler_telescope.c). A Sched_Clock gives run_night() (see
+   scheduler_backend.c) the current jd and lets time pass while it
+   waits for a field to become ready:
+
+     init_wall_clock()    : the system clock. Waiting sleeps.
+     init_virtual_clock() : a jd held in the clock, which waiting (and
+                            the virtual hardware, as it observes) moves
+                            on at once, so a simulated night takes no
+                            longer than the selections in it.
+
+   The scheduler reads the time of day through get_unix_time() and lets
+   time pass with clock_sleep(). Normally these are the system clock and
+   sleep(), but set_clock_scale() can start the clock from another time
+   and run it faster, so a recorded night can be replayed (see
+   socket_trace.c) at its own time of day, and in less than a night.
+
+   set_clock_stepped() instead holds the time, and moves it on only when
+   the thread that set it (the scheduler's main thread) calls
+   clock_sleep() or clock_sync(), by exactly the time asked. Nothing
+   else, such as the time taken to choose a field, moves it, so a
+   replay gives the same times on every run and on any machine. Other
+   threads (the camera workers) keep their own time, which starts from
+   the held time and is moved on by their own sleeps, so a command one
+   of them sends takes its time alongside the main thread's. Before the
+   main thread moves the clock, the settle function (see
+   set_clock_settle()) waits for the other threads to finish what they
+   were given at the time held.
+*/
+
+#include "scheduler.h"
+#include <unistd.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+double get_wall_time();
+double get_unix_time();
+double get_clock_speed();
+void set_clock_scale(double t_origin, double speed);
+void set_clock_stepped(double t_origin);
+void set_clock_settle(void (*settle)());
+int clock_is_stepped();
+void clock_sleep(double sec);
+void clock_sync(double t);
+int init_wall_clock(Sched_Clock *clock);
+int init_virtual_clock(Sched_Clock *clock, double jd);
+
+/* the scaled clock. Only set once, before other threads start */
+
+static int clock_scaled=0;
+static double clock_origin=0.0; /* unix time the scaled clock starts from */
+static double clock_wall_origin=0.0; /* system time it started */
+static double clock_speed=1.0; /* sec of scaled time per sec of system time */
+
+/* the stepped clock */
+
+static int clock_stepped=0;
+static double clock_held=0.0; /* unix time it holds */
+static pthread_t clock_owner; /* the only thread that moves it */
+static void (*clock_settle)()=NULL; /* called before it is moved */
+static pthread_mutex_t clock_mutex=PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local double clock_thread_time=0.0; /* of a thread other than clock_owner */
+
+/*****************************************************/
+
+/* system time in sec since 1970 */
+
+double get_wall_time()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv,NULL);
+
+  return(tv.tv_sec+tv.tv_usec/1.0e6);
+}
+
+/*****************************************************/
+
+/* from now on, run the clock from unix time t_origin at speed times the
+   system clock */
+
+void set_clock_scale(double t_origin, double speed)
+{
+  if(speed<=0.0)speed=1.0;
+
+  clock_wall_origin=get_wall_time();
+  clock_origin=t_origin;
+  clock_speed=speed;
+  clock_scaled=1;
+}
+
+/*****************************************************/
+
+/* from now on, hold the clock at unix time t_origin, and move it on
+   only as the calling thread sleeps (see the top) */
+
+void set_clock_stepped(double t_origin)
+{
+  clock_held=t_origin;
+  clock_owner=pthread_self();
+  clock_stepped=1;
+}
+
+/*****************************************************/
+
+/* call settle() before each move of the stepped clock */
+
+void set_clock_settle(void (*settle)())
+{
+  clock_settle=settle;
+}
+
+/*****************************************************/
+
+int clock_is_stepped()
+{
+  return(clock_stepped);
+}
+
+/*****************************************************/
+
+/* time in sec since 1970, on the scaled or stepped clock if there is one */
+
+double get_unix_time()
+{
+  double t;
+
+  if(clock_stepped){
+     pthread_mutex_lock(&clock_mutex);
+     t=clock_held;
+     pthread_mutex_unlock(&clock_mutex);
+     if(!pthread_equal(pthread_self(),clock_owner)&&clock_thread_time>t)t=clock_thread_time;
+     return(t);
+  }
+
+  if(!clock_scaled)return(get_wall_time());
+
+  return(clock_origin+(get_wall_time()-clock_wall_origin)*clock_speed);
+}
+
+/*****************************************************/
+
+double get_clock_speed()
+{
+  return(clock_speed);
+}
+
+/*****************************************************/
+
+/* let sec seconds pass on the scaled clock, or move the stepped clock
+   on by sec without waiting */
+
+void clock_sleep(double sec)
+{
+  if(sec<=0.0)return;
+
+  if(clock_stepped){
+     clock_sync(get_unix_time()+sec);
+     return;
+  }
+
+  sec=sec/clock_speed;
+  if(sec>=1.0)sleep((unsigned int)sec);
+  usleep((useconds_t)((sec-floor(sec))*1.0e6));
+}
+
+/*****************************************************/
+
+/* move the stepped clock on to unix time t, if it is earlier, as when
+   the main thread has waited for a camera worker that finished at t.
+   In another thread, move that thread's time on instead. Does nothing
+   if the clock is not stepped */
+
+void clock_sync(double t)
+{
+  if(!clock_stepped)return;
+
+  if(!pthread_equal(pthread_self(),clock_owner)){
+     if(t>clock_thread_time)clock_thread_time=t;
+     return;
+  }
+
+  if(clock_settle!=NULL)clock_settle();
+
+  pthread_mutex_lock(&clock_mutex);
+  if(t>clock_held)clock_held=t;
+  pthread_mutex_unlock(&clock_mutex);
+}
+
+/*****************************************************/
+
+double get_ut() {
+
+  time_t t;
+  struct tm *tm;
+  double ut;
+
+  t=(time_t)get_unix_time();
+  tm = gmtime(&t);
+
+  /* get ut time in fractional hour for current day */
+  ut = tm->tm_hour + tm->tm_min/60. + tm->tm_sec/3600.;
+
+/*debug*/
+
+  if(UT_OFFSET!=0.0){
+     ut=ut+UT_OFFSET;
+     if(ut>24.0)ut=ut-24.0;
+  }
+
+  return(ut);
+}
+
+/*****************************************************/
+
+/* return tm structure with year, month, day, hour,
+   minute, second filled out. Also return UT in hours */
+
+double get_tm(struct tm *tm_out) {
+
+  time_t t;
+  struct tm *tm;
+  double ut;
+
+  t=(time_t)get_unix_time();
+  tm = gmtime(&t);
+
+
+  /* use convention Jan is month 1, not 0 */
+  tm->tm_mon=tm->tm_mon+1; 
+
+  /* change from year 0 = 1900 to year 1900 = 1900 */
+  tm->tm_year=tm->tm_year+1900;
+
+  /* get ut time in fractional hour for current day */
+  ut = tm->tm_hour + tm->tm_min/60. + tm->tm_sec/3600.;
+
+/*debug*/
+
+  if(UT_OFFSET!=0.0){
+
+     ut=ut+UT_OFFSET;
+     if(ut>24.0){
+         ut=ut-24.0;
+         advance_tm_day(tm);
+     }   
+     tm->tm_hour=ut;
+     tm->tm_min=(ut-tm->tm_hour)*60.0;
+     tm->tm_sec=(ut - tm->tm_hour - (tm->tm_min/60.0) )*3600.0;
+  }
+
+
+  if(tm_out!=NULL)*tm_out=*tm;
+
+  return(ut);
+}
+
+/*****************************************************/
+
+int advance_tm_day(struct tm *tm)
+{
+    tm->tm_mday=tm->tm_mday+1;
+
+    if(tm->tm_mday==29 && tm->tm_mon==2 && !leap_year_check(tm->tm_year)){ 
+       tm->tm_mon=3;
+       tm->tm_mday=1;
+    }
+    else if(tm->tm_mday==30 && tm->tm_mon==2 ){ 
+       tm->tm_mon=3;
+       tm->tm_mday=1;
+    }
+    else if (tm->tm_mday==31 && (tm->tm_mon == 4 || 
+        tm->tm_mon ==6 || tm->tm_mon == 9 || tm->tm_mon==11 ) ) {
+        tm->tm_mon=tm->tm_mon+1;
+        tm->tm_mday=1;
+    }
+    else if (tm->tm_mday==32) {
+        tm->tm_mon=tm->tm_mon+1;
+        tm->tm_mday=1;
+        if(tm->tm_mon==13){
+          tm->tm_mon=1;
+          tm->tm_year=tm->tm_year+1;
+        }
+    }
+    return(0);
+}
+
+/*****************************************************/
+
+int leap_year_check(int year)
+{
+   int n;
+   
+
+   n=year/4;
+   n=4*n;
+   if ( n != year ) return(0);
+
+   n = year/100;
+   n = n * 100;
+   if ( n != year ) return(1);
+
+   n =  year/400;
+   n = n*400;
+
+   if( n == year) return(1);
+
+   return(0);
+}
+
+/*****************************************************/
+
+double get_jd()
+{
+    struct tm tm;
+    struct date_time date;
+    double jd;
+
+    get_tm(&tm);
+
+    date.y=tm.tm_year;
+    date.mo=tm.tm_mon;
+    date.d=tm.tm_mday;
+    date.h=tm.tm_hour;
+    date.mn=tm.tm_min;
+    date.s=tm.tm_sec;
+
+    jd=date_to_jd(date);
+
+    return(jd);
+}
+/*****************************************************/
+
+static double wall_clock_now(Sched_Clock *clock)
+{
+    clock->jd=get_jd();
+
+    return(clock->jd);
+}
+
+/*****************************************************/
+
+static int wall_clock_wait(Sched_Clock *clock, double sec)
+{
+    if(sec<=0.0)return(0);
+
+    clock_sleep(sec);
+    clock->jd=get_jd();
+
+    return(0);
+}
+
+/*****************************************************/
+
+int init_wall_clock(Sched_Clock *clock)
+{
+    clock->now=wall_clock_now;
+    clock->wait=wall_clock_wait;
+    clock->jd=get_jd();
+    clock->arg=NULL;
+
+    return(0);
+}
+
+/*****************************************************/
+
+static double virtual_clock_now(Sched_Clock *clock)
+{
+    return(clock->jd);
+}
+
+/*****************************************************/
+
+static int virtual_clock_wait(Sched_Clock *clock, double sec)
+{
+    if(sec>0.0)clock->jd=clock->jd+(sec/86400.0);
+
+    return(0);
+}
+
+/*****************************************************/
+
+/* start a virtual clock at jd */
+
+int init_virtual_clock(Sched_Clock *clock, double jd)
+{
+    clock->now=virtual_clock_now;
+    clock->wait=virtual_clock_wait;
+    clock->jd=jd;
+    clock->arg=NULL;
+
+    return(0);
+}
+
+/*****************************************************/
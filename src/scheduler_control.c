@@ -0,0 +1,696 @@
+/* scheduler_control.c
+
+   2026 Oct 14
+
+   The control socket.
+
+   Besides SIGUSR1/SIGUSR2 (pause and resume, see scheduler_signals.c),
+   the only way into a running scheduler was appending to the new-fields
+   script, which the main loop reads only between observations and
+   every LOOP_WAIT_SEC when idle. A target of opportunity (a LIGO
+   alert) needs seconds. start_control_server() listens on a port of
+   one interface (the loopback, CONTROL_ADDRESS, unless configured
+   otherwise) with a thread that serves up to CONTROL_MAX_CLIENTS
+   clients at once, a line per command and a line per reply, "DONE ..."
+   or "ERROR ..." as the camera controller replies:
+
+      auth key             the key in key_file; required before the rest
+      add script_line      inject a field, in the format of the script
+      pause                as SIGUSR1
+      resume               as SIGUSR2
+      abort                stop the burst or split exposure in progress
+      status               the state last posted by the main loop
+      quit                 close the connection
+
+   The key file must hold at least CONTROL_KEY_MIN characters and be
+   readable by its owner only, or the server is not started. A client
+   that sends a wrong key is answered after CONTROL_AUTH_DELAY_SEC and
+   dropped, as is one silent for CONTROL_READ_TIMEOUT_SEC, without
+   holding up the others. stop_control_server() (from do_exit()) stops
+   the thread and closes the socket.
+
+   Injected lines are checked and queued, and a byte written to a pipe
+   (control_wake_fd()) wakes the main loop from wait_script_tail(), so
+   it adds them to the store with drain_control_fields() and evaluates
+   them with init_fields() at once. Must-do fields (MUSTDO_SURVEY_CODE,
+   or LIGO_SURVEY_CODE in the line) are then chosen at the next
+   decision. The exposure in progress runs to its end, since the camera
+   controller has no abort command; abort makes observe_next_field()
+   return after it instead of taking the rest of its frames.
+*/
+
+#include "scheduler.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#include <arpa/inet.h>
+
+extern int verbose;
+extern _Atomic int pause_flag;
+
+static char ctl_key[STR_BUF_LEN];
+static int ctl_key_len=0;
+static int ctl_socket=-1;
+static int ctl_pipe[2]={-1,-1};
+static int ctl_stop_pipe[2]={-1,-1};
+static pthread_t ctl_thread;
+static int ctl_running=0;
+static pthread_mutex_t ctl_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+/* injected script lines waiting for the main loop, and the state it
+   last posted (both under ctl_mutex) */
+
+static char ctl_pending[CONTROL_MAX_PENDING][STR_BUF_LEN];
+static int ctl_num_pending=0;
+static Control_State ctl_state={0,-1,-1,0,0,0.0,0,0,0};
+static _Atomic int ctl_abort=0;
+
+/* a connected client of the control thread */
+
+typedef struct {
+    int s; /* connection, -1 if the slot is free */
+    char buf[MAXBUFSIZE]; /* what it sent after its last complete line */
+    int len;
+    int authenticated;
+    double t_active; /* wall clock time (sec) it last sent something */
+    double t_drop; /* if a wrong key, when to send reply and drop it */
+    char reply[STR_BUF_LEN];
+} Control_Client;
+
+int start_control_server(char *key_file, char *address, int port);
+void stop_control_server();
+int control_wake_fd();
+int drain_control_fields(Field_Store *store);
+void note_control_fields(int n_added, int n_observable);
+int control_abort_requested();
+void post_control_state(Field *sequence, int num_fields, int index, double jd);
+
+/************************************************************/
+
+/* Read the key from file_name into ctl_key. Return 0, or -1 if the
+   file can't be read, is open to others, or the key is too short */
+
+static int read_control_key(char *file_name)
+{
+    FILE *input;
+    struct stat st;
+    int n;
+
+    if(stat(file_name,&st)!=0){
+       fprintf(stderr,"read_control_key: no key file %s\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+    if(st.st_mode&(S_IRWXG|S_IRWXO)){
+       fprintf(stderr,"read_control_key: %s must be readable by its owner only\n",
+          file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    input=fopen(file_name,"r");
+    if(input==NULL||fgets(ctl_key,STR_BUF_LEN,input)==NULL){
+       fprintf(stderr,"read_control_key: can't read key file %s\n",file_name);
+       fflush(stderr);
+       if(input!=NULL)fclose(input);
+       return(-1);
+    }
+    fclose(input);
+
+    n=strlen(ctl_key);
+    while(n>0&&(ctl_key[n-1]=='\n'||ctl_key[n-1]=='\r'||ctl_key[n-1]==' '))ctl_key[--n]=0;
+    if(n<CONTROL_KEY_MIN){
+       fprintf(stderr,"read_control_key: key in %s is shorter than %d characters\n",
+          file_name,CONTROL_KEY_MIN);
+       fflush(stderr);
+       memset(ctl_key,0,sizeof(ctl_key));
+       return(-1);
+    }
+    ctl_key_len=n;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* 1 if key is the control key. Every character is compared, so the
+   time taken does not show how much of the key was right */
+
+static int check_control_key(char *key)
+{
+    unsigned int diff;
+    int i,n;
+
+    n=strlen(key);
+    diff=(n!=ctl_key_len);
+    for(i=0;i<ctl_key_len;i++){
+       diff|=(unsigned char)ctl_key[i]^(unsigned char)(i<n ? key[i] : 0);
+    }
+
+    return(diff==0);
+}
+
+/************************************************************/
+
+/* wake the main loop from wait_script_tail() */
+
+static void wake_main_loop()
+{
+    char c=1;
+
+    if(ctl_pipe[1]>=0&&write(ctl_pipe[1],&c,1)<0&&errno!=EAGAIN){
+       fprintf(stderr,"wake_main_loop: can't write to wake pipe\n");
+       fflush(stderr);
+    }
+}
+
+/************************************************************/
+
+static int send_control_reply(int s, char *reply)
+{
+    int n,len;
+
+    len=strlen(reply);
+    while(len>0){
+       n=send(s,reply,len,MSG_NOSIGNAL);
+       if(n<=0)return(-1);
+       reply+=n;
+       len-=n;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Queue the script line of an add command. Write the reply in reply */
+
+static void queue_control_field(char *line, char *reply)
+{
+    char shutter_flag[STR_BUF_LEN];
+    double ra,dec,expt,interval;
+    int code;
+    int n_required,survey_code;
+
+    if(strlen(line)>=STR_BUF_LEN-2){
+       sprintf(reply,"%s line too long\n",ERROR_REPLY);
+       return;
+    }
+
+    /* parse_sequence_line() sets the focus and filter globals, so it runs
+       only in the main loop (drain_control_fields()). Here the line is
+       only checked for the fields of a script line */
+
+    if(sscanf(line,"%lf %lf %s %lf %lf %d %d",&ra,&dec,shutter_flag,&expt,
+          &interval,&n_required,&survey_code)!=7){
+       sprintf(reply,"%s not a field: %s\n",ERROR_REPLY,line);
+       return;
+    }
+
+    /* parse_sequence_line() reads at most 2 characters of shutter flag,
+       so a longer one would be cut to a different flag */
+
+    code=get_shutter_code(shutter_flag);
+    if(strlen(shutter_flag)>2||code==BAD_CODE){
+       sprintf(reply,"%s bad shutter flag %s\n",ERROR_REPLY,shutter_flag);
+       return;
+    }
+
+    pthread_mutex_lock(&ctl_mutex);
+    if(ctl_num_pending>=CONTROL_MAX_PENDING){
+       pthread_mutex_unlock(&ctl_mutex);
+       sprintf(reply,"%s %d fields already queued\n",ERROR_REPLY,CONTROL_MAX_PENDING);
+       return;
+    }
+    sprintf(ctl_pending[ctl_num_pending],"%s\n",line);
+    ctl_num_pending++;
+    ctl_state.n_queued=ctl_num_pending;
+    pthread_mutex_unlock(&ctl_mutex);
+
+    wake_main_loop();
+
+    if(verbose){
+       fprintf(stderr,"queue_control_field: queued field %s survey_code %d\n",
+          line,survey_code);
+       fflush(stderr);
+    }
+
+    sprintf(reply,"%s queued survey_code %d\n",DONE_REPLY,survey_code);
+}
+
+/************************************************************/
+
+/* Carry out command (one line, without the newline) from a client.
+   Write the reply in reply. Return 1 to close the connection, or -1 to
+   close it after CONTROL_AUTH_DELAY_SEC (a wrong key) */
+
+static int do_control_command(char *command, int *authenticated, char *reply)
+{
+    char word[STR_BUF_LEN],*arg;
+    Control_State s;
+
+    word[0]=0;
+    sscanf(command,"%s",word);
+    arg=command+strspn(command," \t");
+    arg=arg+strlen(word);
+    arg=arg+strspn(arg," \t");
+
+    if(strcmp(word,"auth")==0){
+       if(check_control_key(arg)){
+          *authenticated=1;
+          sprintf(reply,"%s\n",DONE_REPLY);
+          return(0);
+       }
+       fprintf(stderr,"do_control_command: bad key from control client\n");
+       fflush(stderr);
+       sprintf(reply,"%s bad key\n",ERROR_REPLY);
+       return(-1);
+    }
+    else if(strcmp(word,"quit")==0){
+       sprintf(reply,"%s\n",DONE_REPLY);
+       return(1);
+    }
+    else if(!*authenticated){
+       sprintf(reply,"%s not authenticated\n",ERROR_REPLY);
+       return(1);
+    }
+    else if(strcmp(word,"add")==0){
+       queue_control_field(arg,reply);
+    }
+    else if(strcmp(word,"pause")==0){
+       pause_flag=1;
+       sprintf(reply,"%s\n",DONE_REPLY);
+    }
+    else if(strcmp(word,"resume")==0){
+       pause_flag=0;
+       wake_main_loop();
+       sprintf(reply,"%s\n",DONE_REPLY);
+    }
+    else if(strcmp(word,"abort")==0){
+       ctl_abort=1;
+       sprintf(reply,"%s\n",DONE_REPLY);
+    }
+    else if(strcmp(word,"status")==0){
+       pthread_mutex_lock(&ctl_mutex);
+       s=ctl_state;
+       pthread_mutex_unlock(&ctl_mutex);
+       sprintf(reply,
+          "%s jd %13.6f paused %d fields %d field %d field_number %d n_done %d n_required %d queued %d injected %d observable %d\n",
+          DONE_REPLY,s.jd,pause_flag,s.num_fields,s.field,s.field_number,
+          s.n_done,s.n_required,s.n_queued,s.n_injected,s.n_observable);
+    }
+    else{
+       sprintf(reply,"%s unknown command %s\n",ERROR_REPLY,word);
+    }
+
+    if(verbose){
+       fprintf(stderr,"do_control_command: %s : %s",word,reply);
+       fflush(stderr);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* close the wake and stop pipes */
+
+static void close_control_pipes()
+{
+    int i;
+
+    for(i=0;i<2;i++){
+       if(ctl_pipe[i]>=0)close(ctl_pipe[i]);
+       if(ctl_stop_pipe[i]>=0)close(ctl_stop_pipe[i]);
+       ctl_pipe[i]=ctl_stop_pipe[i]=-1;
+    }
+}
+
+/************************************************************/
+
+/* open a socket listening on port of the interface with IPv4 address
+   address (CONTROL_ADDRESS, the loopback, unless a remote client must
+   be served). Return it, or -1 */
+
+static int listen_control_socket(char *address, int port)
+{
+    struct sockaddr_in sa;
+    int s,on;
+
+    bzero(&sa,sizeof(struct sockaddr_in));
+    sa.sin_family=AF_INET;
+    sa.sin_port=htons((u_short)port);
+    if(inet_pton(AF_INET,address,&sa.sin_addr)!=1){
+       fprintf(stderr,"listen_control_socket: bad address %s\n",address);
+       fflush(stderr);
+       return(-1);
+    }
+
+    if((s=socket(AF_INET,SOCK_STREAM,0))<0){
+       fprintf(stderr,"listen_control_socket: can't open socket\n");
+       fflush(stderr);
+       return(-1);
+    }
+    on=1;
+    setsockopt(s,SOL_SOCKET,SO_REUSEADDR,&on,sizeof(on));
+
+    if(bind(s,(const struct sockaddr *)&sa,sizeof(sa))<0||
+          listen(s,CONTROL_MAX_CLIENTS)<0){
+       fprintf(stderr,"listen_control_socket: can't bind %s port %d\n",address,port);
+       fflush(stderr);
+       close(s);
+       return(-1);
+    }
+
+    return(s);
+}
+
+/************************************************************/
+
+static void close_control_client(Control_Client *c)
+{
+    if(c->s>=0)close(c->s);
+    memset((void *)c,0,sizeof(Control_Client));
+    c->s=-1;
+}
+
+/************************************************************/
+
+/* accept a connection on ctl_socket into a free slot of clients, or
+   refuse it if all CONTROL_MAX_CLIENTS are taken */
+
+static void accept_control_client(Control_Client *clients, double t)
+{
+    int s,i,flags;
+
+    s=get_connection(ctl_socket);
+    if(s<0)return;
+
+    for(i=0;i<CONTROL_MAX_CLIENTS&&clients[i].s>=0;i++);
+    if(i==CONTROL_MAX_CLIENTS){
+       send_control_reply(s,ERROR_REPLY " too many clients\n");
+       close(s);
+       return;
+    }
+
+    flags=fcntl(s,F_GETFL,0);
+    fcntl(s,F_SETFL,flags|O_NONBLOCK);
+
+    clients[i].s=s;
+    clients[i].len=0;
+    clients[i].authenticated=0;
+    clients[i].t_active=t;
+    clients[i].t_drop=0.0;
+}
+
+/************************************************************/
+
+/* Read what client c has sent and carry out its complete lines. Close
+   it if it quits, hangs up, or sends a wrong key (then the reply waits
+   until t_drop, without holding up the other clients) */
+
+static void serve_control_client(Control_Client *c, double t)
+{
+    char reply[MAXBUFSIZE+STR_BUF_LEN],*end;
+    int n,done;
+
+    n=recv(c->s,c->buf+c->len,MAXBUFSIZE-1-c->len,0);
+    if(n<0&&(errno==EAGAIN||errno==EWOULDBLOCK||errno==EINTR))return;
+    if(n<=0){
+       close_control_client(c);
+       return;
+    }
+    c->len+=n;
+    c->buf[c->len]=0;
+    c->t_active=t;
+
+    done=0;
+    while(!done&&(end=strchr(c->buf,'\n'))!=NULL){
+       *end=0;
+       if(end>c->buf&&*(end-1)=='\r')*(end-1)=0;
+       done=do_control_command(c->buf,&c->authenticated,reply);
+       if(done<0){
+          /* bad key */
+          strcpy(c->reply,reply);
+          c->t_drop=t+CONTROL_AUTH_DELAY_SEC;
+          return;
+       }
+       if(send_control_reply(c->s,reply)!=0)done=1;
+       c->len-=(end+1-c->buf);
+       memmove(c->buf,end+1,c->len+1);
+    }
+
+    if(!done&&c->len>=MAXBUFSIZE-1){
+       send_control_reply(c->s,ERROR_REPLY " line too long\n");
+       done=1;
+    }
+    if(done)close_control_client(c);
+}
+
+/************************************************************/
+
+/* Serve up to CONTROL_MAX_CLIENTS clients at once, each dropped after
+   CONTROL_READ_TIMEOUT_SEC of silence, until stop_control_server()
+   writes to ctl_stop_pipe */
+
+static void *control_server_thread(void *arg)
+{
+    Control_Client clients[CONTROL_MAX_CLIENTS];
+    struct timeval timeout;
+    fd_set read_fds;
+    double t;
+    int i,n,max_fd;
+
+    for(i=0;i<CONTROL_MAX_CLIENTS;i++){
+       clients[i].s=-1;
+       close_control_client(clients+i);
+    }
+
+    while(1){
+       FD_ZERO(&read_fds);
+       FD_SET(ctl_stop_pipe[0],&read_fds);
+       FD_SET(ctl_socket,&read_fds);
+       max_fd=ctl_stop_pipe[0]>ctl_socket ? ctl_stop_pipe[0] : ctl_socket;
+       for(i=0;i<CONTROL_MAX_CLIENTS;i++){
+          if(clients[i].s<0||clients[i].t_drop>0.0)continue;
+          FD_SET(clients[i].s,&read_fds);
+          if(clients[i].s>max_fd)max_fd=clients[i].s;
+       }
+
+       /* wake at least once a second to drop silent clients and answer
+          bad keys */
+
+       timeout.tv_sec=1;
+       timeout.tv_usec=0;
+       n=select(max_fd+1,&read_fds,NULL,NULL,&timeout);
+       if(n<0&&errno!=EINTR){
+          fprintf(stderr,"control_server_thread: select failed\n");
+          fflush(stderr);
+          sleep(1);
+          continue;
+       }
+       if(n>0&&FD_ISSET(ctl_stop_pipe[0],&read_fds))break;
+
+       t=get_wall_time();
+       if(n>0&&FD_ISSET(ctl_socket,&read_fds))accept_control_client(clients,t);
+
+       for(i=0;i<CONTROL_MAX_CLIENTS;i++){
+          if(clients[i].s<0)continue;
+          if(clients[i].t_drop>0.0){
+             if(t>=clients[i].t_drop){
+                send_control_reply(clients[i].s,clients[i].reply);
+                close_control_client(clients+i);
+             }
+          }
+          else if(n>0&&FD_ISSET(clients[i].s,&read_fds)){
+             serve_control_client(clients+i,t);
+          }
+          else if(t-clients[i].t_active>CONTROL_READ_TIMEOUT_SEC){
+             close_control_client(clients+i);
+          }
+       }
+    }
+
+    for(i=0;i<CONTROL_MAX_CLIENTS;i++){
+       if(clients[i].s>=0)close_control_client(clients+i);
+    }
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* Read the key from key_file and start serving control commands on
+   port of the interface with address (CONTROL_ADDRESS). Return 0, or
+   -1 if the server can't be started (the scheduler then runs without
+   it) */
+
+int start_control_server(char *key_file, char *address, int port)
+{
+    int flags;
+
+    if(read_control_key(key_file)!=0)return(-1);
+
+    if(pipe(ctl_pipe)!=0){
+       fprintf(stderr,"start_control_server: can't open wake pipe\n");
+       fflush(stderr);
+       return(-1);
+    }
+    flags=fcntl(ctl_pipe[0],F_GETFL,0);
+    fcntl(ctl_pipe[0],F_SETFL,flags|O_NONBLOCK);
+    flags=fcntl(ctl_pipe[1],F_GETFL,0);
+    fcntl(ctl_pipe[1],F_SETFL,flags|O_NONBLOCK);
+
+    if(pipe(ctl_stop_pipe)!=0){
+       fprintf(stderr,"start_control_server: can't open stop pipe\n");
+       fflush(stderr);
+       close_control_pipes();
+       return(-1);
+    }
+
+    ctl_socket=listen_control_socket(address,port);
+    if(ctl_socket<0){
+       fprintf(stderr,"start_control_server: can't listen on %s port %d\n",address,port);
+       fflush(stderr);
+       close_control_pipes();
+       return(-1);
+    }
+
+    if(pthread_create(&ctl_thread,NULL,control_server_thread,NULL)!=0){
+       fprintf(stderr,"start_control_server: can't start control thread\n");
+       fflush(stderr);
+       close(ctl_socket);
+       ctl_socket=-1;
+       close_control_pipes();
+       return(-1);
+    }
+    ctl_running=1;
+
+    fprintf(stderr,"start_control_server: listening on %s port %d\n",address,port);
+    fflush(stderr);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* stop the control thread, dropping its clients, and close the control
+   socket. Nothing happens if the server was not started */
+
+void stop_control_server()
+{
+    char c=1;
+
+    if(!ctl_running)return;
+
+    if(write(ctl_stop_pipe[1],&c,1)!=1){
+       fprintf(stderr,"stop_control_server: can't write to stop pipe\n");
+       fflush(stderr);
+       return;
+    }
+    pthread_join(ctl_thread,NULL);
+    ctl_running=0;
+
+    close(ctl_socket);
+    ctl_socket=-1;
+    close_control_pipes();
+}
+
+/************************************************************/
+
+/* descriptor that becomes readable when the main loop should wake up,
+   or -1 if there is no control server */
+
+int control_wake_fd()
+{
+    return(ctl_pipe[0]);
+}
+
+/************************************************************/
+
+/* Append the injected fields to store, as ingest_sequence() appends the
+   fields of the new-fields script. Return the number added */
+
+int drain_control_fields(Field_Store *store)
+{
+    char pending[CONTROL_MAX_PENDING][STR_BUF_LEN+1];
+    char c;
+    Field field;
+    int i,n,n_added,index;
+
+    if(ctl_pipe[0]<0)return(0);
+    while(read(ctl_pipe[0],&c,1)==1);
+
+    pthread_mutex_lock(&ctl_mutex);
+    n=ctl_num_pending;
+    for(i=0;i<n;i++)strcpy(pending[i],ctl_pending[i]);
+    ctl_num_pending=0;
+    ctl_state.n_queued=0;
+    pthread_mutex_unlock(&ctl_mutex);
+
+    n_added=0;
+    for(i=0;i<n;i++){
+       memset((void *)&field,0,sizeof(Field));
+       if(parse_sequence_line(pending[i],0,&field)!=1)continue;
+       index=add_field(store,&field,pending[i]);
+       if(index<0){
+          fprintf(stderr,"drain_control_fields: can't add field %s",pending[i]);
+          fflush(stderr);
+          continue;
+       }
+       store->fields[index].field_number=index;
+       n_added++;
+    }
+
+    if(n_added>0){
+       fprintf(stderr,"drain_control_fields: %d fields injected\n",n_added);
+       fflush(stderr);
+    }
+
+    return(n_added);
+}
+
+/************************************************************/
+
+/* count n_added injected fields, n_observable of them observable */
+
+void note_control_fields(int n_added, int n_observable)
+{
+    pthread_mutex_lock(&ctl_mutex);
+    ctl_state.n_injected+=n_added;
+    ctl_state.n_observable+=n_observable;
+    pthread_mutex_unlock(&ctl_mutex);
+}
+
+/************************************************************/
+
+/* 1 (once) if an abort has been requested since the last call */
+
+int control_abort_requested()
+{
+    return(atomic_exchange(&ctl_abort,0)!=0);
+}
+
+/************************************************************/
+
+/* post the state of the main loop at jd, with field index (or -1) the
+   one being observed, for the status command */
+
+void post_control_state(Field *sequence, int num_fields, int index, double jd)
+{
+    pthread_mutex_lock(&ctl_mutex);
+    ctl_state.num_fields=num_fields;
+    ctl_state.jd=jd;
+    if(index>=0&&index<num_fields){
+       ctl_state.field=index;
+       ctl_state.field_number=sequence[index].field_number;
+       ctl_state.n_done=sequence[index].n_done;
+       ctl_state.n_required=sequence[index].n_required;
+    }
+    pthread_mutex_unlock(&ctl_mutex);
+}
+
+/************************************************************/
@@ -0,0 +1,38 @@
+#ifndef __scheduler_control_h
+#define __scheduler_control_h
+
+/* scheduler_control.h
+
+   The control socket: authenticated commands to inject fields, pause,
+   resume, abort a burst and query the state of the scheduler while it
+   runs (see scheduler_control.c).
+
+   2026 Oct 14
+*/
+
+#define CONTROL_PORT 5100 /* port the control socket listens on */
+#define CONTROL_ADDRESS "127.0.0.1" /* interface it listens on */
+#define CONTROL_MAX_CLIENTS 8 /* clients served at once */
+#define CONTROL_KEY_FILE "scheduler.key" /* shared key, readable by the owner only */
+#define CONTROL_KEY_MIN 16 /* shortest key accepted */
+#define CONTROL_MAX_PENDING 64 /* injected fields waiting for the main loop */
+#define CONTROL_READ_TIMEOUT_SEC 10 /* a client silent this long is dropped */
+#define CONTROL_AUTH_DELAY_SEC 1 /* wait after a bad key, before the reply */
+
+/* what the main loop last posted, returned by the status command */
+
+typedef struct {
+    int num_fields;
+    int field; /* field being observed or last observed, -1 if none */
+    int field_number;
+    int n_done;
+    int n_required;
+    double jd; /* of the last post */
+    int n_queued; /* injected fields waiting for the main loop */
+    int n_injected; /* injected fields the main loop has added */
+    int n_observable; /* of those, the ones init_fields() found observable */
+} Control_State;
+
+/* the functions are declared in scheduler.h, after the Field types */
+
+#endif
@@ -0,0 +1,1934 @@
+/* scheduler_core.c
+
+   2026 Oct 14
+
+   The scheduling core: reading the observing sequence, the night's
+   times, the rise and set of each field, and the choice of the next
+   field to observe. Nothing here talks to the telescope or camera or
+   reads the clock; every function is given the jd it is to work at.
+
+   These functions were in scheduler.c. With scheduler_select.c,
+   scheduler_plan.c, scheduler_slew.c, scheduler_store.c and the sky
+   routines they make up libls4sched.a (see the Makefile), which both
+   the scheduler and the simulator (sched_sim.c, which runs it on the
+   clocks of scheduler_clock.c and the virtual hardware of
+   scheduler_backend.c) are linked with.
+
+   The globals set while reading the sequence (focus settings and
+   filter name) and the verbose flags are defined here, so a program
+   linked with the library need not define them.
+*/
+
+#include "scheduler.h"
+
+int verbose=0;
+int verbose1 = 0; /* set to 1 for very verbose */
+double focus_start=NOMINAL_FOCUS_START;
+double focus_increment=NOMINAL_FOCUS_INCREMENT;
+double focus_default=NOMINAL_FOCUS_DEFAULT;
+char filter_name[STR_BUF_LEN];
+char *filter_name_ptr=0;
+
+// NOTE: each element of selection string must correspond to an element of Selection_Code 
+// defined in scheduler.h
+
+char *selection_string[] = {"not selected", "first do_now flat", "first do_now dark",
+       "first_do_now sky field", "first ready paired field", "first late paired field",
+       "first not-ready late paired field", "first not-ready and not-late paired field",
+       "late must-do field with least time left", "ready must-do field with least time left",
+       "ready field with least time left", "late ready field with most time left"};
+
+/************************************************************/
+
+/* t of the weather timeline (ut day of year + ut/24) at jd on the night
+   of local date */
+
+static double get_weather_time(double jd, struct date_time *date, Night_Times *nt)
+{
+     double ut;
+     int doy;
+
+     /* ut date is 1 + doy since get_day_of_year takes local time */
+     doy=1+get_day_of_year (date); 
+
+     /* ut values don't go past 24 hours at ESO La Silla at night */
+     ut=nt->ut_start+(jd-nt->jd_start)*24.0;
+
+     return(doy+(ut/24.0));
+}
+
+/************************************************************/
+
+/* Return 0 if the weather is good at jd on the night of local date,
+   according to the weather file read into w (see weather_timeline.c).
+   Otherwise return 1 */
+
+int check_weather (Weather_Timeline *w, double jd, struct date_time *date, Night_Times *nt)
+{
+     double t_obs;
+
+     t_obs=get_weather_time(jd,date,nt);
+
+/*
+     if(verbose){
+    fprintf(stderr,"check_weather : doy,ut,t_obs = %03d %10.6f %10.6f\n",doy,ut,t_obs);
+     }
+*/
+
+     return(weather_timeline_bad(w,t_obs));
+}
+
+/************************************************************/
+
+/* Return the jd at which the weather in w is next good, at or after jd
+   on the night of local date, or -1 if it is not good again */
+
+double get_weather_clear_jd(Weather_Timeline *w, double jd, struct date_time *date,
+        Night_Times *nt)
+{
+     double t_obs,t_clear;
+
+     t_obs=get_weather_time(jd,date,nt);
+     t_clear=weather_timeline_clears(w,t_obs);
+     if(t_clear<0.0)return(-1.0);
+
+     return(jd+(t_clear-t_obs));
+}
+       
+/************************************************************/
+
+int get_day_of_year(struct date_time *date)
+{
+    int n,doy;
+
+    doy=date->d;
+
+    if(date->mo>1)doy=doy+31;
+    if(date->mo>2)doy=doy+28;
+    if(date->mo>3)doy=doy+31;
+    if(date->mo>4)doy=doy+30;
+    if(date->mo>5)doy=doy+31;
+    if(date->mo>6)doy=doy+30;
+    if(date->mo>7)doy=doy+31;
+    if(date->mo>8)doy=doy+31;
+    if(date->mo>9)doy=doy+30;
+    if(date->mo>10)doy=doy+31;
+    if(date->mo>11)doy=doy+30;
+
+    n=(date->y)/4;
+    n=n*4;
+    if(date->y==n)doy++;
+
+    return(doy);
+}
+
+/************************************************************/
+
+int init_night(struct date_time date, Night_Times *nt, 
+                     Site_Params *site,int print_flag)
+{
+
+    /* initialize night_time values. Unless they are to be printed,
+       take them from the cache of nights already worked out */
+
+    if (print_flag){
+       print_tonight(date,site->lat,site->longit,site->elevsea,site->elev,site->horiz,
+              site->site_name,site->stdz,site->zone_name,site->zabr,site->use_dst,
+              &(site->jdb),&(site->jde),2,nt,print_flag);
+    }
+    else{
+       get_night_times(date,site->lat,site->longit,site->elevsea,site->horiz,
+              site->stdz,site->use_dst,&(site->jdb),&(site->jde),nt);
+    }
+
+
+
+    if (USE_12DEG_START){
+      if (print_flag ){
+         fprintf(stderr,"using 12 deg twilight + %12.6f h for start time\n",
+            STARTUP_TIME);
+     }
+      nt->ut_start=nt->ut_evening12+STARTUP_TIME;
+      nt->ut_end=nt->ut_morning12-MIN_EXECUTION_TIME;
+      nt->lst_start=nt->lst_evening12+STARTUP_TIME;
+      nt->lst_end=nt->lst_morning12-MIN_EXECUTION_TIME;
+      nt->jd_start=nt->jd_evening12+(STARTUP_TIME/24.0);
+      nt->jd_end=nt->jd_morning12-(MIN_EXECUTION_TIME/24.0);
+       }
+    else {
+      if (print_flag ){
+         fprintf(stderr,"using 18 deg twilight + %12.6f h for start time\n",
+            STARTUP_TIME);
+     }
+      nt->ut_start=nt->ut_evening18+STARTUP_TIME;
+      nt->ut_end=nt->ut_morning18-MIN_EXECUTION_TIME;
+      nt->lst_start=nt->lst_evening18+STARTUP_TIME;
+      nt->lst_end=nt->lst_morning18-MIN_EXECUTION_TIME;
+      nt->jd_start=nt->jd_evening18+(STARTUP_TIME/24.0);
+      nt->jd_end=nt->jd_morning18-(MIN_EXECUTION_TIME/24.0);
+    }
+
+
+    if(nt->ut_start>24.0)nt->ut_start=nt->ut_start-24.0;
+    if(nt->lst_start>24.0)nt->lst_start=nt->lst_start-24.0;
+
+    if(nt->ut_end<0.0)nt->ut_end=nt->ut_end+24.0;
+    if(nt->lst_end<0.0)nt->lst_end=nt->lst_end+24.0;
+
+
+
+    return(0);
+}
+
+/************************************************************/
+
+int adjust_date(struct date_time *date, int n_days)
+{
+    double jd;
+    short dow;
+
+    jd=date_to_jd(*date);
+    jd=jd+n_days;
+    caldat(jd,date,&dow);
+
+    return(0);
+}
+/************************************************************/
+int get_shutter_code(char *shutter_flag)
+{
+      int code;
+
+      if(strcmp(shutter_flag,SKY_STRING)==0){
+        code=SKY_CODE;
+      }
+      else if(strcmp(shutter_flag,SKY_STRING_LC)==0){
+        code=SKY_CODE;
+      }
+      else if (strcmp(shutter_flag,DARK_STRING)==0){
+        code=DARK_CODE;
+      }
+      else if (strcmp(shutter_flag,DARK_STRING_LC)==0){
+        code=DARK_CODE;
+      }
+      else if (strcmp(shutter_flag,FOCUS_STRING)==0){
+        code=FOCUS_CODE;
+      }
+      else if (strcmp(shutter_flag,FOCUS_STRING_LC)==0){
+        code=FOCUS_CODE;
+      }
+      else if (strcmp(shutter_flag,OFFSET_STRING)==0){
+        code=OFFSET_CODE;
+      }
+      else if (strcmp(shutter_flag,OFFSET_STRING_LC)==0){
+        code=OFFSET_CODE;
+      }
+      else if (strcmp(shutter_flag,EVENING_FLAT_STRING)==0){
+        code=EVENING_FLAT_CODE;
+      }
+      else if (strcmp(shutter_flag,EVENING_FLAT_STRING_LC)==0){
+        code=EVENING_FLAT_CODE;
+      }
+      else if (strcmp(shutter_flag,MORNING_FLAT_STRING)==0){
+        code=MORNING_FLAT_CODE;
+      }
+      else if (strcmp(shutter_flag,MORNING_FLAT_STRING_LC)==0){
+        code=MORNING_FLAT_CODE;
+      }
+      else if (strcmp(shutter_flag,DOME_FLAT_STRING)==0){
+        code=DOME_FLAT_CODE;
+      }
+      else if (strcmp(shutter_flag,DOME_FLAT_STRING_LC)==0){
+        code=DOME_FLAT_CODE;
+      }
+      else{
+        code=BAD_CODE;
+      }
+
+      return(code);
+}
+
+/************************************************************/
+
+int get_shutter_string(char *string, int shutter, char *description)
+{
+    switch (shutter){
+
+    case BAD_CODE:
+      strcpy(string,BAD_STRING_LC);
+      sprintf(description,BAD_FIELD_TYPE);
+      break;
+
+    case DARK_CODE:
+      strcpy(string,DARK_STRING_LC);
+      sprintf(description,DARK_FIELD_TYPE);
+      break;
+
+    case SKY_CODE:
+      strcpy(string,SKY_STRING_LC);
+      sprintf(description,SKY_FIELD_TYPE);
+      break;
+
+    case FOCUS_CODE:
+      strcpy(string,FOCUS_STRING_LC);
+      sprintf(description,FOCUS_FIELD_TYPE);
+      break;
+
+    case OFFSET_CODE:
+      strcpy(string,OFFSET_STRING_LC);
+      sprintf(description,OFFSET_FIELD_TYPE);
+      break;
+
+    case EVENING_FLAT_CODE:
+      strcpy(string,EVENING_FLAT_STRING_LC);
+      sprintf(description,EVENING_FLAT_TYPE);
+      break;
+
+    case MORNING_FLAT_CODE:
+      strcpy(string,MORNING_FLAT_STRING_LC);
+      sprintf(description,MORNING_FLAT_TYPE);
+      break;
+
+    case DOME_FLAT_CODE:
+      strcpy(string,DOME_FLAT_STRING_LC);
+      sprintf(description,DOME_FLAT_TYPE);
+      break;
+
+    default:
+      fprintf(stderr,"get_shutter_string: unrecognized shutter code: %d\n",shutter);
+      sprintf(description,BAD_FIELD_TYPE);
+      strcpy(string,BAD_STRING_LC);
+      return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+int get_filename(char *filename,struct tm *tm,int shutter)
+{
+    char shutter_string[3];
+    int result;
+    char field_description[STR_BUF_LEN];
+
+    result=get_shutter_string(shutter_string,shutter,field_description);
+    if(result!=0){
+        fprintf(stderr,"get_filename: bad shutter code: %d\n",shutter);
+        fflush(stderr);
+    }
+
+    sprintf(filename,"%04d%02d%02d%02d%02d%02d%s",
+            tm->tm_year,tm->tm_mon,tm->tm_mday,
+	    tm->tm_hour,tm->tm_min,tm->tm_sec,shutter_string);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* Choose the next field to observe.
+
+   This is a two pass selection loop. In the first pass, consider 
+   every field. Call update_field_status to determine if the
+   field is observable, ready to be observed, and how much time 
+   is left to observe it. If there is a field with DO_NOW_STATUS 
+   (e.g. a dark) , choose that field and return with its field index. 
+   Otherwise, keep track of how many fields have READY_STATUS
+   and TOO_LATE_STATUS. For those with READY_STATUS,
+   update the minimum value of n_left (number of fields remaining 
+   for completion).
+
+   Before starting the second pass, check if the previously
+   observed field was the first in a pair and if the
+   second in the pair is ready to be observed. If so, choose
+   the second in the pair as the next field.
+
+   In the second pass, find all the fields that are ready to observe
+   (READY_STATUS) and have n_left matching the minimum value
+   determined in the first pass. Of these, select the field
+   that has the least time remaining (time_left) to complete the
+   required observations.
+
+   If there are no fields ready to observe, choose among the "late"
+   fields (TOO_LATE_STATUS) which are observable, but for which
+   there is not enough time to
+   observe all the remaining observations. Choose the late field with
+   the most amount of time left (least negative value) and shorten
+   the time interval between fields so that there is time left. Choose
+   this field.
+
+   If there are not late fields that can be shortened (while still
+   keeping interval > MIN_INTERVAL), return -1 (no field selected).
+
+*/
+
+int get_next_field(Field *sequence,int num_fields, int i_prev,
+                double jd, int bad_weather)
+{
+     Field *f,*f_prev,*f_next,*f_pos;
+     double time_left_min,time_left,time_left_max,t,t_min;
+     int i,n_left,n_left_min,n_left_min_must_do;
+     int i_min,i_max,status,n_ready,n_late;
+     int n_do_now,i_min_dark, i_min_flat,i_min_do_now;
+     int n_ready_must_do,n_late_must_do;
+     char field_status[256];
+
+     if(i_prev>=0&&i_prev<num_fields-1){
+       f_prev=sequence+i_prev;
+       f_next=sequence+i_prev+1;
+     }
+     else{
+       f_prev=NULL;
+       f_next=NULL;
+     }
+
+     /* the telescope is at the previous field. Of fields tied on
+        time_left (within SLEW_TIE_TIME), choose the nearest to it */
+
+     if(i_prev>=0&&i_prev<num_fields){
+       f_pos=sequence+i_prev;
+     }
+     else{
+       f_pos=NULL;
+     }
+
+     n_left_min=100000;
+     n_left_min_must_do=100000;
+     n_ready=0;
+     n_late=0;
+     n_do_now=0;
+     i_min_dark=-1;
+     i_min_flat=-1;
+     i_min_do_now=-1;
+     n_ready_must_do=0;
+     n_late_must_do=0;
+
+     if(LOG_ON(LOG_SELECT,LOG_VERBOSE)){  
+    sched_log(LOG_SELECT,LOG_VERBOSE,"get_next_field: updating field status\n");
+     }
+
+     for(i=0;i<num_fields;i++){
+     f=sequence+i;
+
+     update_field_status(f,jd,bad_weather);
+     if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       get_field_status_string(f,field_status);
+       sched_log(LOG_SELECT,LOG_DEBUG,"field %d status %s\n",i,field_status);
+     }
+
+#if 1
+     /* for any MUST-DO field with READY_STATUS, increment the count and update minimum
+        value of n_left */
+
+     if (f->status==READY_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE){
+        n_ready_must_do++;
+
+        n_left=f->n_required-f->n_done;
+        
+        if(n_left<n_left_min_must_do){
+         n_left_min_must_do=n_left;
+        }
+
+     }
+
+     /* status of DO_NOW_STATUS  means must do now (i.e. darks or 2nd offset
+        field).  Return field index */
+
+     else if(f->status==DO_NOW_STATUS){
+        n_do_now++;
+        if(i_min_do_now==-1)i_min_do_now=i;
+        if(f->shutter==DARK_CODE&&i_min_dark==-1)i_min_dark=i;
+        if((f->shutter==DOME_FLAT_CODE||f->shutter==EVENING_FLAT_CODE||
+          f->shutter==MORNING_FLAT_CODE)&&i_min_flat==-1)i_min_flat=i;
+        /*return(i);*/
+     }
+
+#else
+     /* status of DO_NOW_STATUS  means must do now (i.e. darks or 2nd offset
+        field).  Return field index */
+
+     if(f->status==DO_NOW_STATUS){
+        n_do_now++;
+        if(i_min_do_now==-1)i_min_do_now=i;
+        if(f->shutter==DARK_CODE&&i_min_dark==-1)i_min_dark=i;
+        if((f->shutter==DOME_FLAT_CODE||f->shutter==EVENING_FLAT_CODE||
+          f->shutter==MORNING_FLAT_CODE)&&i_min_flat==-1)i_min_flat=i;
+        /*return(i);*/
+     }
+
+     /* for any MUST-DO field with READY_STATUS, increment the count and update minimum
+        value of n_left */
+
+     else if (f->status==READY_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE){
+        n_ready_must_do++;
+
+        n_left=f->n_required-f->n_done;
+        
+        if(n_left<n_left_min_must_do){
+         n_left_min_must_do=n_left;
+        }
+
+     }
+#endif
+
+     /* for any other field with READY_STATUS, increment the count and update minimum
+        value of n_left */
+
+     else if (f->status==READY_STATUS){
+        n_ready++;
+
+        n_left=f->n_required-f->n_done;
+        
+        if(n_left<n_left_min){
+         n_left_min=n_left;
+        }
+
+     }
+
+     /* Also count fields with TOO_LATE_STATUS */
+
+     else if (f->status==TOO_LATE_STATUS){
+        n_late++;
+        if(f->survey_code==MUSTDO_SURVEY_CODE)n_late_must_do++;
+     }
+
+     } //for(i=0;i<num_fields;i++){
+
+     /* If there are MUST_DO fields with READY_STATUS, 
+    choose the one that has least time left to complete the 
+    required observations */       
+
+     if(n_ready_must_do>0){
+       if(LOG_ON(LOG_SELECT,LOG_VERBOSE)){
+       sched_log(LOG_SELECT,LOG_VERBOSE,"get_next_field: checking %d ready must-do fields \n",n_ready_must_do);
+       }
+      
+       if(LOG_ON(LOG_SELECT,LOG_VERBOSE)) {
+      sched_log(LOG_SELECT,LOG_VERBOSE,"get_next_field: %d must-do fields ready\n",n_ready_must_do);
+       }
+
+       time_left_min=10000.0;
+       i_min=-1;
+
+       for(i=0;i<num_fields;i++){
+     f=sequence+i;
+     if(f->status==READY_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE){
+        n_left=f->n_required-f->n_done;
+        if((f->n_required==6||n_left==n_left_min_must_do)&&f->time_left<time_left_min){
+         i_min=i;
+         time_left_min=f->time_left;
+        }
+     }
+       }
+
+       if(f_pos!=NULL){
+     t_min=HUGE_VAL;
+     for(i=0;i<num_fields;i++){
+        f=sequence+i;
+        if(f->status==READY_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE){
+           n_left=f->n_required-f->n_done;
+           if((f->n_required==6||n_left==n_left_min_must_do)&&
+              f->time_left<=time_left_min+SLEW_TIE_TIME){
+             t=slew_time(f_pos->ra,f_pos->dec,f->ra,f->dec);
+             if(t<t_min){
+               i_min=i;
+               t_min=t;
+             }
+           }
+        }
+     }
+       }
+
+       if(LOG_ON(LOG_SELECT,LOG_VERBOSE)){
+      sched_log(LOG_SELECT,LOG_VERBOSE,"get_next_field: returning ready must-do field : %d\n",i_min);
+       }
+       (sequence+i_min)->selection_code = LEAST_TIME_READY_MUST_DO;
+       return(i_min);
+
+     }
+
+      /* If there are MUST-DO fields with TOO_LATE_STATUS, choose the one
+    that has the least time left.  Shorten the interval so 
+    that time_left=0.  If still doable, choose this field*/
+
+     if (n_late_must_do>0){
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: checking %d too-late must-do fields \n",n_late_must_do);
+    }
+
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)) {
+      sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: %d must-do late fields\n",n_late_must_do);
+    }
+
+    i_min=-1;
+    time_left_min=10000.0;
+    for(i=0;i<num_fields;i++){
+      f=sequence+i;
+      if(f->status==TOO_LATE_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE&&f->time_left<time_left_min){
+          time_left_min=f->time_left;
+          i_min=i;
+      }
+    }
+
+    // This shouldn't happen
+    if(i_min<0){
+       fprintf(stderr,
+          "ERROR: get_next_field: n_late_must_do [%d] > 0 but non appear in the field list\n",
+          n_late_must_do);
+       fflush(stdout);
+       fflush(stderr);
+       //return(-1);
+    }
+       
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       sched_log(LOG_SELECT,LOG_DEBUG,
+        "get_next_field: choosing field %d to shorten intervals\n",
+         i_min);
+    }
+       
+    f=sequence+i_min;
+    shorten_interval(f);
+    update_field_status(f,jd,bad_weather);
+
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       sched_log(LOG_SELECT,LOG_DEBUG,
+          "get_next_field: interval shortened to %10.6f\n",
+          f->interval*3600.0);
+    }
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+      sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning late must-do field : %d\n",i_min);
+    }
+    (sequence+i_min)->selection_code = LEAST_TIME_LATE_MUST_DO;
+    return(i_min);
+     }
+
+ 
+     /* If there were fields with DO_NOW_STATUS, choose the first flat,
+    or else the first dark, or else the first field */
+
+     if(n_do_now>0){
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: checking %d do_now fields\n",n_do_now);
+    }
+
+    if(i_min_flat>=0){
+          if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+          sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning i_min_flat: %d\n",i_min_flat);
+          }
+          (sequence+i_min_flat)->selection_code = FIRST_DO_NOW_FLAT;
+          return(i_min_flat);
+    }
+    else if(i_min_dark>=0){
+          if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+          sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning i_min_dark: %d\n",i_min_dark);
+          }
+          (sequence+i_min_dark)->selection_code = FIRST_DO_NOW_DARK;
+          return(i_min_dark);
+    }
+    else{
+          if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+          sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning i_min_do_now: %d\n",i_min_do_now);
+          }
+          (sequence+i_min_do_now)->selection_code = FIRST_DO_NOW;
+          return(i_min_do_now);
+    }
+     }
+  
+     /* if the pair to the previous fields is doable, choose the paired field */
+
+     if(f_prev!=NULL&&paired_fields(f_next,f_prev)&&f_next->doable){
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: checking for doable pair to previous field %d\n",i_prev);
+    }
+
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: field %d is paired with field %d \n",
+            i_prev+1,i_prev);
+    }
+    if(f_next->status==READY_STATUS){
+        if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning paired field %d \n", i_prev+1);
+        }
+        (sequence+i_prev+1)->selection_code = FIRST_READY_PAIR;
+        return(i_prev+1);
+    }
+    else if(f_next->status==TOO_LATE_STATUS){
+      shorten_interval(f_next);
+      update_field_status(f_next,jd,bad_weather);
+      if(f_next->status==READY_STATUS){
+         if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning late paired field %d \n", i_prev+1);
+         }
+         (sequence+i_prev+1)->selection_code = FIRST_LATE_PAIR;
+         return(i_prev+1);
+      }
+      else{
+         if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+           sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning  not-ready paired field %d \n", i_prev+1);
+         }
+         (sequence+i_prev+1)->selection_code = FIRST_NOT_READY_LATE_PAIR;
+         return(i_prev+1);
+      }
+    }
+    else{
+         if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+           sched_log(LOG_SELECT,LOG_DEBUG,
+          "get_next_field: returning paired field %d that is neither ready nor too late\n",
+          i_prev+1);
+         }
+         (sequence+i_prev+1)->selection_code = FIRST_NOT_READY_NOT_LATE_PAIR;
+         return(i_prev+1);
+    }
+     }
+
+     /* If there are fields with READY_STATUS, choose the one 
+    that has least time left to complete the required observations */
+
+     if(n_ready>0){
+     if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: checking %d ready fields \n",n_ready);
+     }
+    
+     time_left_min=10000.0;
+     i_min=-1;
+
+     for(i=0;i<num_fields;i++){
+       f=sequence+i;
+       if(f->status==READY_STATUS){
+          n_left=f->n_required-f->n_done;
+          if(n_left==n_left_min&&f->time_left<time_left_min){
+           i_min=i;
+           time_left_min=f->time_left;
+          }
+       }
+     }
+
+     if(f_pos!=NULL){
+       t_min=HUGE_VAL;
+       for(i=0;i<num_fields;i++){
+         f=sequence+i;
+         if(f->status==READY_STATUS&&f->n_required-f->n_done==n_left_min&&
+            f->time_left<=time_left_min+SLEW_TIE_TIME){
+           t=slew_time(f_pos->ra,f_pos->dec,f->ra,f->dec);
+           if(t<t_min){
+             i_min=i;
+             t_min=t;
+           }
+         }
+       }
+     }
+     if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: returning ready field : %d\n",i_min);
+     }
+
+     (sequence+i_min)->selection_code = LEAST_TIME_READY;
+     return(i_min);
+
+     }
+
+     /* If there are no observable fields ready to observe,  but there are
+    fields with TOO_LATE_STATUS, choose the first one with MUSTDO_SURVEY_CODE, or
+    else the field that has the most time left. Shorten the interval so 
+    that time_left=0.  If still doable, choose this field. Otherwise return -1 */
+
+     if (n_late>0){
+
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: checking %d late fields \n",n_late);
+    }
+
+    i_max=-1;
+    time_left_max=-1000;
+    for(i=0;i<num_fields;i++){
+      f=sequence+i;
+      if(f->status==TOO_LATE_STATUS&&f->time_left>time_left_max){
+          time_left_max=f->time_left;
+          i_max=i;
+      }
+    }
+
+
+    if(i_max<0){
+       if(LOG_ON(LOG_SELECT,LOG_DEBUG))sched_log(LOG_SELECT,LOG_DEBUG,"get_next_field: No fields to shorten\n");
+       //return(-1);
+    } 
+    else{
+       
+      if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+         sched_log(LOG_SELECT,LOG_DEBUG,
+          "get_next_field: choosing field %d to shorten intervals\n",
+           i_max);
+      }
+         
+      f=sequence+i_max;
+      shorten_interval(f);
+      update_field_status(f,jd,bad_weather);
+      if(f->status==READY_STATUS){
+
+         if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,
+           "get_next_field: interval shortened to %10.6f\n",
+           f->interval*3600.0);
+         }
+         (sequence+i_max)->selection_code = MOST_TIME_READY_LATE;
+         return(i_max);
+      }
+      else{
+         if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+        sched_log(LOG_SELECT,LOG_DEBUG,
+           "get_next_field: could not shorten interval of field %d\n",
+           i_max);
+         }
+      }  // if (f->status==READY_STATUS
+    } //if(i_max<0){
+ 
+     }  // if(n_late>0)
+
+     if(LOG_ON(LOG_SELECT,LOG_VERBOSE)) {
+    sched_log(LOG_SELECT,LOG_VERBOSE,"get_next_field: No fields to observe\n");
+     }
+     return(-1);
+
+}
+/*******************************************************/
+
+int paired_fields(Field *f1, Field *f2)
+{
+    double dra;
+
+    if(f1->shutter!=SKY_CODE||f2->shutter!=SKY_CODE)return(0);
+
+    /*dra=1.1*RA_STEP0/cos(f1->dec*DEG_TO_RAD);*/
+    dra=RA_STEP0/cos(f1->dec*DEG_TO_RAD);
+
+    if(f2->dec==f1->dec&&
+       fabs(clock_difference(f1->ra,f2->ra))<dra){
+    return(1);
+    }
+    else{
+    return(0);
+    }
+}
+
+/*******************************************************/
+
+/* shorten interval between exposures so that time_left=0. If new 
+   interval is less than MIN_INTERVAL, set doable to 0 */
+
+int shorten_interval(Field *f)
+{
+    double new_interval,new_time_required;
+
+
+    new_time_required=f->time_up;
+    new_interval = new_time_required/(f->n_required-f->n_done);
+    /*new_interval = f->interval/2.0;*/
+
+    if(new_interval>MIN_INTERVAL){
+       f->time_required=new_time_required;
+       f->interval=new_interval;
+       f->time_left=0;
+    }
+    else{
+       f->doable=0.0;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* If not doable, already completed, or already set,  set doable flag to 0,
+   set status to NO_DOABLE_STATUS and return NOT_DOABLE_STATUS. 
+
+   If not yet risen or not yet ready to observe, don't change doable flag,
+   but still set status to NO_DOABLE_STATUS and return NOT_DOABLE_STATUS. 
+
+   For any dark, status to DO_NOW_STATUS and return status.
+
+   For focus, or flat ready to observe, set status to DO_NOW_STATUS if
+   the bad_weather flag is 0 and return status.
+
+   For any other field,  update time_required, time_up , and time left.
+   If time_left<0, keep doable = 1 but return TOO_LATE_STATUS.
+   Otherwise, this is field is observable. Return READY_STATUS 
+
+*/
+
+int  get_field_status_string(Field *f, char *string)
+{
+    switch (f->status){
+
+    case TOO_LATE_STATUS -1:
+      sprintf(string,"Too late");
+      break;
+    case NOT_DOABLE_STATUS -1:
+      sprintf(string,"Not doable");
+      break;
+    case READY_STATUS -1:
+      sprintf(string,"Ready");
+      break;
+    case DO_NOW_STATUS -1:
+      sprintf(string,"Do now");
+      break;
+    default:
+      sprintf(string,"Unknown status");
+      break;
+    }
+
+    return (0);
+}
+
+int update_field_status(Field *f, double jd, int bad_weather)
+{
+
+      /* Isn't doable */
+      if(f->doable==0){
+      f->status=NOT_DOABLE_STATUS;
+      return(NOT_DOABLE_STATUS);
+      }
+
+      /* Has been completed. */
+
+      else if(f->n_done==f->n_required){
+     f->doable=0; 
+     f->status=NOT_DOABLE_STATUS;
+     return(NOT_DOABLE_STATUS);
+      }
+    
+      /* hasn't risen yet */
+
+      else if(jd<f->jd_rise){
+     f->status=NOT_DOABLE_STATUS;
+     return(NOT_DOABLE_STATUS);
+      }
+
+      /* has already set 0 */
+
+      else if(jd>f->jd_set){
+     f->doable=0;
+     f->status=NOT_DOABLE_STATUS;
+     return(NOT_DOABLE_STATUS);
+      }
+
+      /* not yet time to reobserve */
+
+#if 1
+      else if (f->jd_next-jd>(MIN_EXECUTION_TIME/24.0)){
+#else
+      else if (f->jd_next-jd>f->interval/(2.0*24.0)){
+#endif
+     f->status=NOT_DOABLE_STATUS;
+     return(NOT_DOABLE_STATUS);
+      }
+
+
+      /* darks  and domes that  are ready to
+     observe get highest priority (DO_NOW_STATUS) */
+
+      else if (f->shutter==DARK_CODE||f->shutter==DOME_FLAT_CODE){
+    f->status=DO_NOW_STATUS;
+    return(DO_NOW_STATUS);
+      }
+
+
+      /* sky flats, focus and pointing_offsets fields  that are ready to
+     observe get highest priority (DO_NOW_STATUS)  as long as bad_weather flag is 0*/
+
+      else if (f->shutter==EVENING_FLAT_CODE||
+        f->shutter==MORNING_FLAT_CODE||f->shutter==FOCUS_CODE||
+        f->shutter==OFFSET_CODE){
+    if( !bad_weather){
+       f->status=DO_NOW_STATUS;
+       return(DO_NOW_STATUS);
+    }
+    else {
+       f->status=NOT_DOABLE_STATUS;
+       return(NOT_DOABLE_STATUS);
+    }
+      }      
+
+
+      /* Any other field is either ready to observe (READY_STATUS) or
+     too late to observe (TOO_LATE_STATUS ) */
+
+      else{
+
+      /* Update time_required, time_up , time left. Time required is
+         the intervals before the last observation, and the time to
+         make it (see scheduler_overhead.c) */
+
+    f->time_required=(f->n_required-f->n_done-1)*f->interval+
+          execution_time(f->shutter,f->expt);
+
+    /* time up is now to when the field sets */
+
+    f->time_up=(f->jd_set-jd)*24.0;
+
+    /* time left is time up - time required to finish the
+       observations.  */
+
+    f->time_left=f->time_up-f->time_required; 
+      
+    if(f->time_left<0){
+          f->status=TOO_LATE_STATUS;
+#if DEBUG
+  if ( f->field_number > 37 && f->field_number < 47 ){
+    fprintf(stderr,"update_field_status: field: %d jd: %12.6f time_required: %10.6f  jd_set: %12.6f time_up: %10.6f  time_left: %10.6f  status: %s\n",
+    f->field_number, jd, f->time_required, f->jd_set, f->time_up, f->time_left, "TOO_LATE");
+  }
+#endif
+          return(TOO_LATE_STATUS);
+    }
+    else{
+        f->status=READY_STATUS;
+#if DEBUG
+  if ( f->field_number > 37 && f->field_number < 47 ){
+    fprintf(stderr,"update_field_status: field: %d jd: %12.6f time_required: %10.6f  jd_set: %12.6f time_up: %10.6f  time_left: %10.6f  status: %s\n",
+    f->field_number, jd, f->time_required, f->jd_set, f->time_up, f->time_left, "READY_STATUS");
+  }
+#endif
+        return(READY_STATUS);
+    }
+      }
+}
+
+/************************************************************/
+
+/* initialize rise and set times for each field. Set 0 values for time,
+hour angle, and airmass of each oservation for each field. Set number
+done to 0. Determine which observations are doable, and initialize
+time_up, time_required, time_left, and jd_next */
+
+int init_fields(Field *sequence, int num_fields, 
+        Night_Times *nt, Night_Times *nt_5day,
+        Night_Times *nt_10day, Night_Times *nt_15day,
+        Site_Params *site, double jd,
+        Telescope_Status *tel_status)
+{
+    int i,j,n_observable,n_up_too_short,n_moon_too_close,n_never_rise;
+    int n_moon_too_close_later;
+    int n_same_ra;
+    Field *f;
+    double *ha_limit,*sin_dec,*cos_dec,limit,lst;
+    double dark_night_duration, whole_night_duration;
+    double ra_prev,current_epoch;
+    double max_airmass;
+    double max_hourangle;
+    double new_jd_start=0.0;
+    double new_lst_start=0.0;
+    double jd_last;
+
+    n_up_too_short=0;
+    n_moon_too_close=0;
+    n_moon_too_close_later=0;
+    n_never_rise=0;
+    n_same_ra=1;
+    ra_prev=0.0;
+    
+    /* if initializing fields after jd_start, set jd_start to
+       current jd */
+
+    if (jd > nt->jd_start){
+    new_jd_start = jd;
+    new_lst_start = nt->lst_start+(new_jd_start-nt->jd_start)*SIDEREAL_DAY_IN_HOURS;
+    if(new_lst_start > 24.0) new_lst_start = new_lst_start - 24.0;
+    if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+        sched_log(LOG_FIELDS,LOG_VERBOSE,
+            "adjusting jd_start from %10.6f to %10.6f\n",
+            nt->jd_start-2450000,new_jd_start-2450000);
+        sched_log(LOG_FIELDS,LOG_VERBOSE,
+            "adjusting lst_start from %10.6f to %10.6f\n",
+            nt->lst_start,new_lst_start);
+    }
+    nt->lst_start=new_lst_start;
+    nt->jd_start=new_jd_start;
+    }
+
+    /* calculate length of dark night remaining, and length of
+       whole night remaining (time until sunrise) */
+
+    dark_night_duration=(nt->jd_end-nt->jd_start)*24.0;
+    whole_night_duration=(nt->jd_sunrise-jd)*24.0;
+
+    if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"current lst: %10.6f\n",tel_status->lst);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"current jd: %10.6f\n",jd-2450000);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"ut_start: %10.6f",nt->ut_start);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"ut_end: %10.6f\n",nt->ut_end);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"jd_start: %10.6f\n",nt->jd_start-2450000);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"jd_end: %10.6f\n",nt->jd_end-2450000);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"lst_start: %10.6f\n",nt->lst_start);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"lst_end: %10.6f\n",nt->lst_end);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"dark night duration : %10.6f\n",dark_night_duration);
+     sched_log(LOG_FIELDS,LOG_VERBOSE,"whole night duration : %10.6f\n",whole_night_duration);
+    }
+
+    /* the hour angle limits (see sky_window.c) of all the fields in
+       one batch, from the sin and cos of their declinations. These
+       are irrelevant for darks, flats, focus fields, and offset
+       pointing. If there is no room for the batch, work them out
+       one at a time below */
+
+    max_airmass=MAX_AIRMASS;
+    max_hourangle=MAX_HOURANGLE;
+    ha_limit=(double *)malloc(3*num_fields*sizeof(double)+1);
+    if(ha_limit!=NULL){
+       sin_dec=ha_limit+num_fields;
+       cos_dec=sin_dec+num_fields;
+       for(i=0;i<num_fields;i++){
+          sin_dec[i]=sequence[i].sin_dec;
+          cos_dec[i]=sequence[i].cos_dec;
+       }
+       get_ha_limits(num_fields,sin_dec,cos_dec,site->lat,max_airmass,
+             max_hourangle,ha_limit);
+    }
+
+    n_observable=0;
+    for (i=0;i<num_fields;i++){
+
+    f=sequence+i;
+    f->status=0;
+    f->selection_code = NOT_SELECTED;
+
+    /* fields replayed from the obs record keep their completed
+       observations */
+
+    if(f->n_saved<=0){
+      f->n_done=0;
+      for(j=0;j<f->n_required;j++){
+         f->history->ut[j]=0.0;
+         f->history->jd[j]=0.0;
+         f->history->lst[j]=0.0;
+         f->history->ha[j]=0.0;
+         f->history->am[j]=0.0;
+      }
+    }
+
+    if(LOG_ON(LOG_FIELDS,LOG_DEBUG)){
+       sched_log(LOG_FIELDS,LOG_DEBUG,"checking field %d at ra %12.6f dec %12.6f\n",
+             i,f->ra,f->dec);
+    }
+
+    /* get rise and set times of given position (the jd when the
+       airmass crosses below and above the maximum airmass, MAX_AIRMASS). 
+       If the object is already up at the start of the observing window
+       (nt.jd_start), set jd_rise to nt.jd_start. If it is up at the 
+       end of the observing window (nt.jd_end), set the jd_set to 
+       nt.jd_end. If the object is not up at all during the observing 
+       window, set jd_rise and jd_set to -1.  These are irrelevant
+       for darks, flats, focus fields, and offset pointing */
+
+    if(ha_limit!=NULL){
+       limit=ha_limit[i];
+    }
+    else{
+       limit=get_ha_limit(f->dec,site->lat,max_airmass,max_hourangle);
+    }
+    f->jd_rise=get_jd_rise_in_window(f->ra,limit,nt,&lst);
+    f->jd_set=get_jd_set_in_window(f->ra,limit,nt,&lst);
+    f->ut_rise = nt->ut_start + (f->jd_rise - nt->jd_start)*24.0;
+    f->ut_set = nt->ut_start + (f->jd_set - nt->jd_start)*24.0;
+    
+    galact(f->ra,f->dec,2000.0,&(f->gal_long),&(f->gal_lat));
+    eclipt(f->ra,f->dec,2000.0,nt->jd_start,&(f->epoch),&(f->ecl_long),&(f->ecl_lat));
+
+    /* calculate total time object will be observable (jd_set-jd_rise)
+       and the total time required to make all the observations (the
+       intervals between them, and the time to make the last). Again,
+       these are irrelevant for darks, flats, focus fields, and offset fields */
+
+    f->time_up=(f->jd_set-f->jd_rise)*24.0;
+    f->time_required=(f->n_required-1)*f->interval+execution_time(f->shutter,f->expt);
+    f->time_left=f->time_up-f->time_required; 
+
+    /* Determine if the observation is doable (i.e. it rises during the
+       night and there is enough time to do all the observations while
+       it is up). If so, set doable=1 and initialize the jd_next to the
+       earliest possible time to observe the position (either jd_start or
+       jd_rise).  If not, set doable=0 and  jd_next = -1. */
+
+
+    /* darks with 0 declination are  dark time only */
+
+    if(f->shutter==DARK_CODE&&f->dec==0.0){
+       if(jd<nt->jd_end){
+           n_observable++;
+           f->doable=1;
+           f->jd_rise=nt->jd_start;
+           if(jd>f->jd_rise){
+          f->jd_next=jd;
+          f->jd_rise=jd;
+           }
+           else{
+          f->jd_next=f->jd_rise;
+           }
+           f->jd_set=nt->jd_end;
+           f->time_up=(f->jd_set-f->jd_next)*24.0;
+           f->time_left=(f->jd_set-jd)*24.0;
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d  night-time dark\n",
+          f->field_number);
+           }
+       }
+       else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, night-time has ended\n",
+          f->field_number);
+           }
+       }
+    }
+
+    /* darks with declinration -1.0  are evening twilight only */
+
+    else if(f->shutter==DARK_CODE&&f->dec==-1.0){
+       if(jd<nt->jd_start){
+           n_observable++;
+           f->doable=1;
+           f->jd_rise=nt->jd_sunset+DARK_WAIT_TIME;
+           if(jd>f->jd_rise){
+          f->jd_next=jd;
+          f->jd_rise=jd;
+           }
+           else{
+          f->jd_next=f->jd_rise;
+           }
+           f->jd_set=nt->jd_start;
+           f->time_up=(f->jd_set-f->jd_next)*24.0;
+           f->time_left=(f->jd_set-jd)*24.0;
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d  evening dark\n",
+          f->field_number);
+           }
+       }
+       else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, evening twilight has ended\n",
+          f->field_number);
+           }
+       }
+      }
+
+    /* darks with declination +1.0  are morning twilight only */
+
+    else if(f->shutter==DARK_CODE&&f->dec==1.0){
+       if(jd<nt->jd_sunrise){
+           n_observable++;
+           f->doable=1;
+           f->jd_set = nt->jd_sunrise-DARK_WAIT_TIME;
+           if(jd>nt->jd_end){
+           f->jd_next=jd;
+           f->jd_rise=jd;
+           f->time_up=(f->jd_set-jd)*24.0;
+           f->time_left=f->time_up;
+           }
+           else{
+           f->time_up=(f->jd_set-nt->jd_end)*24.0;
+           f->jd_next=nt->jd_end;
+           f->jd_rise=nt->jd_end;
+           f->time_left=(f->jd_set-jd)*24.0;
+           }
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d  morning dark\n",
+          f->field_number);
+           }
+        }
+        else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, morning twilight has ended\n",
+          f->field_number);
+           }
+        }
+      }
+
+    /* darks with dec != -1,0,+1 and dome flats are always doable.  Set time left to whole 
+       night's duration, jd_next and jd_rise to sunset, and jd_set to
+       sunrise .*/
+
+    else if(f->shutter==DARK_CODE||f->shutter==DOME_FLAT_CODE){
+        n_observable++;
+        f->doable=1;
+
+        f->time_left=whole_night_duration;
+        f->time_up=whole_night_duration;
+        f->jd_next=jd;
+        f->jd_rise=jd;
+        f->jd_set=nt->jd_sunrise;
+
+        if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+           if(f->shutter==DARK_CODE){
+           sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f darks\n",
+            f->field_number,f->ra,f->dec);
+           }
+           else if(f->shutter==DOME_FLAT_CODE){
+           sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f dome flat\n",
+            f->field_number,f->ra,f->dec);
+           }
+        }
+    }
+
+     /* offset pointing and focus can be done anytime it is dark */
+    else if(f->shutter==FOCUS_CODE||f->shutter==OFFSET_CODE){
+       if(jd<nt->jd_end){
+           n_observable++;
+           f->doable=1;
+
+           f->time_left=dark_night_duration;
+           f->time_up=dark_night_duration;
+           f->jd_next=nt->jd_start;
+           f->jd_rise=nt->jd_start;
+           f->jd_set=nt->jd_end;
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          if(f->shutter==FOCUS_CODE){
+              sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f focus\n",
+              f->field_number,f->ra,f->dec);
+          }
+          else if(f->shutter==OFFSET_CODE){
+              sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f offset\n",
+              f->field_number,f->ra,f->dec);
+          }
+           }
+       }
+       else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, morning twilight has started\n",
+          f->field_number);
+           }
+       }
+      }
+
+    /* evening flats can only be done after sunset (sunset + SKYFLAT_WAIT_TIME) and i
+       before jd_start */
+ 
+    else if (f->shutter==EVENING_FLAT_CODE){
+       if(jd<nt->jd_start){
+           n_observable++;
+           f->doable=1;
+           f->jd_rise=nt->jd_sunset+SKYFLAT_WAIT_TIME;
+           if(jd>f->jd_rise){
+          f->jd_next=jd;
+          f->jd_rise=jd;
+           }
+           else{
+          f->jd_next=f->jd_rise;
+           }
+           f->jd_set=nt->jd_start;
+           f->time_up=(f->jd_set-f->jd_next)*24.0;
+           f->time_left=(f->jd_set-jd)*24.0;
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f evening flat\n",
+          f->field_number,f->ra,f->dec);
+           }
+       }
+       else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, evening twilight has ended\n",
+          f->field_number);
+           }
+       }
+    }
+
+    /* morning flats can only be done after jd_end and before sunrise - SKYFLAT_WAIT_TIME  */
+ 
+    else if (f->shutter==MORNING_FLAT_CODE){
+       if(jd<nt->jd_sunrise-SKYFLAT_WAIT_TIME){
+           n_observable++;
+           f->doable=1;
+           f->jd_set = nt->jd_sunrise-SKYFLAT_WAIT_TIME;
+           if(jd>nt->jd_end){
+           f->jd_next=jd;
+           f->jd_rise=jd;
+           f->time_up=(f->jd_set-jd)*24.0;
+           f->time_left=f->time_up;
+           }
+           else{
+           f->time_up=(f->jd_set-nt->jd_end)*24.0;
+           f->jd_next=nt->jd_end;
+           f->jd_rise=nt->jd_end;
+           f->time_left=(f->jd_set-jd)*24.0;
+           }
+
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f morning flat\n",
+          f->field_number,f->ra,f->dec);
+           }
+        }
+        else{
+           if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+          sched_log(LOG_FIELDS,LOG_VERBOSE,"skipping field %d, morning twilight has ended\n",
+          f->field_number);
+           }
+        }
+    }
+
+    /* never rises. Not doable */
+
+    else if(f->jd_rise<0){ 
+       n_never_rise++;
+       f->doable=0;
+       f->jd_next=-1;
+       f->time_left=-1;
+
+       if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f never rises\n",
+            f->field_number,f->ra,f->dec);
+
+    }
+
+       /* Field too close to tonight's moon. Not doable */
+    else if (moon_interference(f,nt,MIN_MOON_SEPARATION)){
+        n_moon_too_close++;
+        f->doable=0;
+        f->jd_next=-1;
+
+        if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,
+        "field: %d %10.6f %10.6f moon too close\n",
+        f->field_number,f->ra,f->dec);
+ 
+    }
+
+    else if (f->dec>MAX_DEC){
+       f->doable=0;
+       if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f dec too high\n",
+        f->field_number,f->ra,f->dec);
+    }
+
+    else if (f->dec<MIN_DEC){
+       f->doable=0;
+       if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f dec too high\n",
+        f->field_number,f->ra,f->dec);
+    }
+
+    /* not enough time for required obs. Not doable (unless it is a must do field) */
+    else if(f->survey_code!=MUSTDO_SURVEY_CODE&&f->time_left<0){ 
+       n_up_too_short++;
+       f->doable=0;
+       f->jd_next=-1;
+
+       if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f up too short\n",
+        f->field_number,f->ra,f->dec);
+
+    }
+
+
+    /* below 30 deg galactic latitude, too much extinction for supernove */
+    else if (f->survey_code==SNE_SURVEY_CODE&&fabs(f->gal_lat)<15.0){
+       f->doable=0;
+       if(LOG_ON(LOG_FIELDS,LOG_VERBOSE))sched_log(LOG_FIELDS,LOG_VERBOSE,"field: %d %10.6f %10.6f galactic lat too low: %10.6f\n",
+        f->field_number,f->ra,f->dec,f->gal_lat);
+    }
+
+    /* Doable */
+    else{ 
+       n_observable++;
+       f->doable=1;
+
+       /* if position has already risen, set jd_next to jd_start.
+          Otherwise set jd_next to jd_rise */
+
+       if(jd>f->jd_rise){
+           f->jd_next=nt->jd_start;
+       }
+       else{
+           f->jd_next=f->jd_rise;
+       }
+
+       if(fabs(clock_difference(f->ra,ra_prev))<
+            1.1*RA_STEP0/cos(f->dec*DEG_TO_RAD)){
+         n_same_ra++;
+       }
+       else{
+         ra_prev=f->ra;
+         n_same_ra=1;
+       }
+
+
+    }
+
+    /* a partly observed field is not due again until one interval
+       after its last observation */
+
+    if(f->doable&&f->n_done>0){
+       jd_last=f->history->jd[f->n_done-1]+(f->interval/24.0);
+       if(jd_last>f->jd_next)f->jd_next=jd_last;
+    }
+
+    if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+      sched_log(LOG_FIELDS,LOG_VERBOSE,
+          "%d field: %d %10.6f %10.6f %10.6f %d jd_rise: %9.6f  jd_set: %9.6f next: %9.6f  time_up : %10.6f time_required: %10.6f time_left: %10.6f survey_code: %d ut_rise: %10.6f  ut_set: %10.6f\n",
+          f->doable,f->field_number,f->ra,f->dec,
+          f->expt,f->shutter,f->jd_rise-2450000,f->jd_set-2450000,
+          f->jd_next-2450000,f->time_up, f->time_required, f->time_left,
+          f->survey_code,f->ut_rise,f->ut_set);
+    }
+    }
+
+    if(LOG_ON(LOG_FIELDS,LOG_VERBOSE)){
+      sched_log(LOG_FIELDS,LOG_VERBOSE,
+    "init_fields: %d never rise  %d up to short  %d moon to close %d too close later %d observable\n",
+    n_never_rise,n_up_too_short, n_moon_too_close, n_moon_too_close_later, n_observable);
+    }
+
+    if(ha_limit!=NULL)free(ha_limit);
+
+    return(n_observable);
+}
+/************************************************************/
+
+int moon_interference(Field *f, Night_Times *nt, double min_separation)
+{
+    double dra,ddec,dmoon;
+
+
+    if(nt->percent_moon>0.5){
+        dra=clock_difference(nt->ra_moon,f->ra)*15.0;
+        ddec=nt->dec_moon-f->dec;
+        dmoon=sqrt(dra*dra+ddec*ddec);
+#if 0
+fprintf(stderr,"field: %10.6f %10.6f moon: %10.6f %10.6f  dra, ddec, dmoon: %10.6f %10.6f %10.6f\n",
+f->ra,f->dec,nt->ra_moon,nt->dec_moon, dra,ddec,dmoon);
+#endif
+
+    if(dmoon<min_separation)return(1);
+     }
+ 
+     return(0);
+}
+
+/************************************************************/
+
+/* If object is already up at the start of the observing window, return
+   nt->jd_start. If it rises before the end of the window, return with
+   the rise time. If it never rises, return -1.
+
+   The rise time is found in closed form (see sky_window.c) from the hour
+   angle limit set by max_am and max_ha. The LST advances from
+   nt->lst_start at SIDEREAL_DAY_IN_HOURS per day of jd.
+*/
+
+double get_jd_rise_time(double ra,double dec, double max_am, double max_ha,
+       Night_Times *nt, Site_Params *site, double *am, double *ha)
+{
+    double lst,jd,ha_limit;
+
+    ha_limit=get_ha_limit(dec,site->lat,max_am,max_ha);
+
+    if(LOG_ON(LOG_FIELDS,LOG_DEBUG)){
+       sched_log(LOG_FIELDS,LOG_DEBUG,"jd_start: %12.6f  lst_start: %10.6f\n",nt->jd_start,nt->lst_start);
+       sched_log(LOG_FIELDS,LOG_DEBUG,"ra: %12.6f  dec: %12.6f  ha_limit: %10.6f\n",ra,dec,ha_limit);
+    }
+
+    jd=get_jd_rise_in_window(ra,ha_limit,nt,&lst);
+    *ha=get_ha(ra,lst);
+    *am=get_airmass(*ha,dec,site);
+
+    if(LOG_ON(LOG_FIELDS,LOG_DEBUG)){
+       if(jd<0.0){
+          sched_log(LOG_FIELDS,LOG_DEBUG,"field never rises below am %10.6f within ha %10.6f\n",max_am,max_ha);
+       }
+       else{
+          sched_log(LOG_FIELDS,LOG_DEBUG,"field rises at jd  %10.6f (%10.6f h after jd_start)\n",
+             jd,(jd-nt->jd_start)*SIDEREAL_DAY_IN_HOURS);
+       }
+    }
+
+    return(jd);
+}
+
+/************************************************************/
+
+/* As get_jd_rise_time(), for an object at ra with the hour angle
+   limit ha_limit (see get_ha_limit()). Set lst to the LST at the
+   rise time (or at nt->lst_start if it never rises) */
+
+double get_jd_rise_in_window(double ra, double ha_limit, Night_Times *nt,
+       double *lst)
+{
+    double lst_span,dt;
+
+    lst_span=(nt->jd_end-nt->jd_start)*SIDEREAL_DAY_IN_HOURS;
+    dt=get_lst_rise_offset(ra,ha_limit,nt->lst_start,lst_span);
+
+    if(dt<0.0){
+       *lst=nt->lst_start;
+       return(-1.0);
+    }
+
+    *lst=nt->lst_start+dt;
+    if(*lst>24.0)*lst=*lst-24.0;
+
+    return(nt->jd_start+(dt/SIDEREAL_DAY_IN_HOURS));
+}
+
+/************************************************************/
+
+/* If object is still up at the end of the observing window, return
+   nt->jd_end. If it sets after the start of the window, return with
+   the set time. If it is not up during the window, return -1.
+
+   As for get_jd_rise_time(), the set time is found in closed form,
+   counting back from nt->lst_end at SIDEREAL_DAY_IN_HOURS per day of jd.
+*/
+
+double get_jd_set_time(double ra,double dec, double max_am, double max_ha,
+       Night_Times *nt, Site_Params *site, double *am, double *ha)
+{
+    double lst,jd,ha_limit;
+
+    ha_limit=get_ha_limit(dec,site->lat,max_am,max_ha);
+    jd=get_jd_set_in_window(ra,ha_limit,nt,&lst);
+    *ha=get_ha(ra,lst);
+    *am=get_airmass(*ha,dec,site);
+
+    return(jd);
+}
+
+/************************************************************/
+
+/* As get_jd_set_time(), for an object at ra with the hour angle
+   limit ha_limit. Set lst to the LST at the set time (or at
+   nt->lst_end if it is not up) */
+
+double get_jd_set_in_window(double ra, double ha_limit, Night_Times *nt,
+       double *lst)
+{
+    double lst_span,dt;
+
+    lst_span=(nt->jd_end-nt->jd_start)*SIDEREAL_DAY_IN_HOURS;
+    dt=get_lst_set_offset(ra,ha_limit,nt->lst_end,lst_span);
+
+    if(dt<0.0){
+       *lst=nt->lst_end;
+       return(-1.0);
+    }
+
+    *lst=nt->lst_end-dt;
+    if(*lst<0.0)*lst=*lst+24.0;
+
+    return(nt->jd_end-(dt/SIDEREAL_DAY_IN_HOURS));
+}
+/************************************************************/
+
+/* Given two clock values (interval 0 to 24), return
+   their difference, h2 - h1, assuming there difference can not
+   be greater than 12 or less than -12 */
+
+double clock_difference(double h1,double h2)
+{
+   double dt;
+
+   dt = h2 - h1;
+   if(dt>12.0)dt=dt-24.0;
+   if(dt<-12.0)dt=dt+24.0;
+   
+   return (dt);
+}
+/************************************************************/
+
+double get_airmass(double ha, double dec, Site_Params *site) {
+ 
+  double alt, az, am;
+
+  alt = altit(dec,ha,site->lat,&az);
+  if (alt <= 0) {
+     am=1000.0; /* below horizon */
+  }
+  else{
+     am = 1.0/sin(alt/DEGTORAD);
+  }
+  return(am);
+}
+                                                   
+
+/************************************************************/
+
+double get_ha(double ra, double lst) {
+  double ha;
+ 
+  ha = lst - ra;
+  if (ha <= -12.0) {
+    ha += 24.0;
+  } else if (ha >= 12.0) {
+    ha -= 24.0;
+  }
+  return(ha);
+}
+
+/************************************************************/
+
+/* Read the fields in script_name, appending them to store. The first
+   num_skip fields in the script are assumed to be in the store already,
+   and are skipped. Return the total number of fields in the script, or
+   -1 if it can't be read. */
+
+int load_sequence(char *script_name, Field_Store *store, int num_skip)
+{
+
+    FILE *input;
+    int n_fields,line,index;
+    char string[STR_BUF_LEN+1];
+    Field field;
+
+    /* if file can not be opened for reading, return error. Otherwise
+     * load any new sequences
+    */
+
+    input=fopen(script_name,"r");
+    if (input==NULL){
+       fprintf(stderr,"load_sequence: can't open file %s\n",script_name);
+       return(-1);
+    }
+
+    n_fields=0;
+    line=0;
+    string[STR_BUF_LEN-1]=0;
+    while(fgets(string,STR_BUF_LEN,input)!=NULL){
+
+      line++;
+      // make sure last element if string is still 0. If not, the line read from the input is
+      // longer than buffer length (STR_BUF_LEN)
+      if(string[STR_BUF_LEN-1]!=0){
+      fprintf(stderr,"load_sequence: WARNING: sequence line [%d] is too long. Ignoring \n",line);
+      fflush(stderr);
+      string[STR_BUF_LEN-1]=0;
+      }
+
+      /* Accept the field */
+
+      else if(parse_sequence_line(string,line,&field)==1){
+         if(n_fields>=num_skip){
+            index=add_field(store,&field,string);
+            if(index<0){
+               fprintf(stderr,"load_sequence: can't add field at line %d\n",line);
+               fclose(input);
+               return(-1);
+            }
+            store->fields[index].field_number=index;
+         }
+         n_fields++;
+      }
+    } //while(fgets(string,STR_BUF_LEN,input)!=NULL){
+
+    fclose(input);
+
+    return(n_fields);
+
+}
+
+/************************************************************/
+
+/* Parse line number line of a sequence script, held in string (which
+   must have room for one more character). Comment and FILTER lines are
+   handled here. If the line describes a valid field, fill in f and
+   return 1. Otherwise return 0. A space is appended to string, which
+   is saved as the field's script line */
+
+int parse_sequence_line(char *string, int line, Field *f)
+{
+    int n,n1;
+    char *s_ptr,shutter_flag[3],s[256];
+    int string_length=0;
+
+    /* get rid of leading spaces */
+    s_ptr=string;
+    while(strncmp(s_ptr," ",1)==0&&*s_ptr!=0)s_ptr++;
+
+    /* get length of string, starting at s_ptr */
+    string_length = strlen(s_ptr);
+
+    /* add a space to the end of s_ptr to make sure it is processed
+     * correctly by camera server
+    */
+
+    sprintf(s_ptr+string_length," ");
+    string_length++;
+
+    /* if there are more characters left in the string, and if the
+       current character is not "#", then read in the next line */
+
+     if (string_length<=1){
+       /* line too short, pass */
+       if(verbose){
+         fprintf(stderr,"WARNING: line [%d] is too short [%s]\n",line,s_ptr);
+       }
+     }
+     else if (strncmp(s_ptr,"#",1)==0){
+       /* comment line. pass */
+       if(verbose){
+         fprintf(stderr,"line [%d] is a commented out [%s]\n",line,s_ptr);
+       }
+     }
+     else if(strncmp(s_ptr,"FILTER",6) == 0 || strncmp(s_ptr,"filter",6)==0 ){
+       sscanf(s_ptr,"%s %s",s,filter_name);
+       filter_name_ptr=filter_name;
+       if(check_filter_name(filter_name)!=0){
+         fprintf(stderr,"WARNING: unexpeced filter name: %s",filter_name);
+       }
+     }
+     else{
+
+        memset((void *)f,0,sizeof(Field));
+        f->line_number=line;
+
+        n=sscanf(s_ptr,"%lf %lf %2s %lf %lf %d %d",
+          &(f->ra),&(f->dec),shutter_flag,&(f->expt),&(f->interval),
+          &(f->n_required),&(f->survey_code));
+
+        if (f->survey_code == LIGO_SURVEY_CODE)f->survey_code = MUSTDO_SURVEY_CODE;
+        f->interval=f->interval/3600.0;
+        f->expt=f->expt/3600.0;
+
+        f->shutter=get_shutter_code(shutter_flag);
+
+        /* if this is a focus field, read the focus start, increment, and
+           default setting from the script line */
+
+        if(f->shutter==FOCUS_CODE){
+           sscanf(s_ptr,"%s %s %s %s %s %s %s %lf %lf",
+          s,s,s,s,s,s,s,&focus_increment,&focus_default);
+           n1 = f->n_required/2;
+           focus_start=focus_default-n1*focus_increment;
+           if(verbose){
+          fprintf(stderr,
+              "load_sequence: focus start, incr, default: %8.5f %8.5f %8.5f\n",
+              focus_start,focus_increment,focus_default);
+         fflush(stderr);
+           }
+          
+        }
+
+        /* if the focus parameters are out of range for a focus field
+           skip the field */
+
+        if(f->shutter==FOCUS_CODE&&
+           (focus_start<MIN_FOCUS||focus_increment<MIN_FOCUS_INCREMENT||
+          focus_start>MAX_FOCUS||focus_increment>MAX_FOCUS_INCREMENT||
+          focus_start+(f->n_required*focus_increment)>MAX_FOCUS)){
+           fprintf(stderr,"focus parameters out of range: %s",s_ptr);
+        }
+
+         /* Also make sure 6 parameters are read from the line, and that
+           the parameters are within range. If not, skip this field. */
+
+        else if(n!=7||f->ra<0.0||f->ra>24.0||f->dec<-90.0||f->dec>90.0||
+          f->expt>MAX_EXPT||f->expt<0||
+          f->interval>MAX_INTERVAL||f->interval<MIN_INTERVAL||f->n_required<1||
+          f->shutter==BAD_CODE||
+          f->survey_code<MIN_SURVEY_CODE||f->survey_code>MAX_SURVEY_CODE){
+           fprintf(stderr,"load_sequence: bad field line %d: %s\n",
+          line,string);
+        }
+
+        /* Accept the field */
+
+        else{
+           f->sin_dec=sin(f->dec/DEG_IN_RADIAN);
+           f->cos_dec=cos(f->dec/DEG_IN_RADIAN);
+           return(1);
+        }
+     }
+
+    return(0);
+}
+/************************************************************/
+
+/* if name is an expected filter name (see  FILTER_NAME in scheduler.h)
+ * return 0. Otherwise return -1
+*/
+
+int check_filter_name(char *name)
+{
+    for (enum Filter_Index i =1; i<= NUM_FILTERS; i++){
+      if(strcmp(name, FILTER_NAME[i-1]) == 0) return(0);
+    }
+    return(-1);
+}
+/************************************************************/
+
+int print_field_status (Field *f, FILE *output)
+{
+    int i;
+    double dt;
+
+    if(f->n_done==f->n_required){
+       fprintf(output,"Field : %d %s",
+          f->field_number," Completed ");
+    }
+    else{
+       fprintf(output,"Field : %d %s",
+          f->field_number,"Unfinished ");
+    }
+
+    fprintf(output,"Required : %d  Done: %d Interval : %10.6f LSTs : ",
+        f->n_required,f->n_done,f->interval);
+    for(i=0;i<f->n_done;i++){
+    fprintf(output,"%10.6f ",f->history->lst[i]);
+    }
+#if 0
+    fprintf(output," dLSTs: ");
+    for(i=1;i<f->n_done;i++){
+    dt=f->history->lst[i]-f->history->lst[i-1];
+    if(dt<0.0)dt=dt+24.0;
+    fprintf(output,"%10.6f ",dt);
+    }
+#endif
+    fprintf(output," HAs: ");
+    for(i=0;i<f->n_done;i++){
+    fprintf(output,"%10.6f ",f->history->ha[i]);
+    }
+
+
+    fprintf(output," gal. lat: %10.6f ",f->gal_lat);
+    fprintf(output," ecl. lat: %10.6f ",f->ecl_lat);
+
+    fprintf(output,"\n");
+
+    return(0);
+}
+
+/************************************************************/
+
+/* print one line with character for each field in the sequence as follows:
+
+   "." : not observable
+   "n" : where is n number of fields completed
+   "#" : completed
+
+   The scheduler writes only the changes instead (see write_history());
+   expand_history prints them back in this format.
+*/
+   
+int print_history(double jd, Field *sequence, int num_fields,FILE *output)
+{
+    int i;
+    Field *f;
+   
+    /* the line has one character per field, so with a large field store
+       it can be longer than STR_BUF_LEN. Write it directly to output */
+
+    fprintf(output,"%12.6f ",jd-2450000);
+    for(i=0;i<num_fields;i++){
+       f=sequence+i;
+       if (f->n_done==f->n_required){
+     fputc('.',output);
+       }
+       else if (f->n_done<10){
+     fputc('0'+f->n_done,output);
+       }
+       else{
+     fprintf(output,"%d",f->n_done);
+       }
+    }
+
+    fprintf(output,"\n");
+    fflush(output);
+
+    return(0);
+}
+
+/*************************************************************************/
+
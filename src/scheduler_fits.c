@@ -16,41 +16,87 @@ extern int verbose1;
 int init_fits_header(Fits_Header *header);
 int update_fits_header(Fits_Header *header, char *keyword, char *value);
 int add_fits_word(Fits_Header *header, char *keyword, char *value);
+int clear_fits_word(Fits_Header *header, int i);
 
 
 /************************************************************/
 
+/* return the hash table slot for keyword in header: either the slot
+   holding keyword, or the empty slot where it would go */
+
+static int fits_hash_slot(Fits_Header *header, char *keyword)
+{
+    unsigned int h;
+    char *c;
+    int i;
+
+    h=2166136261u;
+    for(c=keyword;*c!=0;c++)h=(h^(unsigned char)*c)*16777619u;
+
+    i=h&(FITS_HASH_SIZE-1);
+    while(header->hash[i]!=0&&
+          strcmp(header->fits_word[header->hash[i]-1].keyword,keyword)!=0){
+       i=(i+1)&(FITS_HASH_SIZE-1);
+    }
+
+    return(i);
+}
+
+/************************************************************/
+
+/* Set keyword to value. The word is marked dirty, to be sent with the
+   next imprint_fits_header(), only if the value has changed */
+
 int update_fits_header(Fits_Header *header, char *keyword, char *value)
 {
     int i;
+    Fits_Word *w;
 
     if(strlen(value)==0||strcmp(value," ")==0)strcpy(value,BLANK_VALUE);
 
-    if(verbose){
-       fprintf(stderr,"update_fits_header: setting %s to %s\n",
+    if(LOG_ON(LOG_FITS,LOG_VERBOSE)){
+       sched_log(LOG_FITS,LOG_VERBOSE,"update_fits_header: setting %s to %s\n",
          keyword,value);
     }
 
-    i=0;
-    while(strncmp(header->fits_word[i].keyword,keyword,strlen(keyword))!=0&&
-         i<header->num_words){
-        i++;
-     }
+    i=header->hash[fits_hash_slot(header,keyword)]-1;
 
-    if(i>=header->num_words){
+    if(i<0){
       fprintf(stderr,"update_fits_header: keyword %s not recognized\n",
 		keyword);
       return(-1);
     }
 
-    strcpy(header->fits_word[i].value,value);
+    w=header->fits_word+i;
+    if(strcmp(w->value,value)!=0){
+       strcpy(w->value,value);
+       if(!w->dirty){
+          w->dirty=1;
+          header->num_dirty++;
+       }
+    }
+
+    if(LOG_ON(LOG_FITS,LOG_VERBOSE)){
+       sched_log(LOG_FITS,LOG_VERBOSE,"update_fits_header: %d %s %s\n",
+         i,w->keyword,w->value);
+    }
+    return(0);
+}
+
+/************************************************************/
+
+/* mark word i of header as sent to the camera controller */
 
-    if(verbose){
-       fprintf(stderr,"update_fits_header: %d %s %s\n",
-         i,header->fits_word[i].keyword,header->fits_word[i].value);
+int clear_fits_word(Fits_Header *header, int i)
+{
+    if(header->fits_word[i].dirty){
+       header->fits_word[i].dirty=0;
+       header->num_dirty--;
     }
+
     return(0);
 }
+
 /************************************************************/
 
 int init_fits_header(Fits_Header *header)
@@ -58,6 +104,8 @@ int init_fits_header(Fits_Header *header)
 	int n;
 
         header->num_words=0;
+        header->num_dirty=0;
+        memset((void *)header->hash,0,sizeof(header->hash));
         if(add_fits_word(header,FILTERNAME_KEYWORD,BLANK_VALUE)<0)return(-1);
         else if(add_fits_word(header,FILTERID_KEYWORD,"0")<0)return(-1);
         else if(add_fits_word(header,LST_KEYWORD,"0.0")<0)return(-1);
@@ -86,12 +134,23 @@ int add_fits_word(Fits_Header *header,char *keyword, char *value)
 {
     int n;
 
+    int slot;
+
     n=header->num_words;
     
     if(n>=MAX_FITS_WORDS)return(-1);
 
+    slot=fits_hash_slot(header,keyword);
+    if(header->hash[slot]!=0){
+       fprintf(stderr,"add_fits_word: keyword %s already in header\n",keyword);
+       return(-1);
+    }
+
     strcpy(header->fits_word[n].keyword,keyword);
     strcpy(header->fits_word[n].value,value);
+    header->fits_word[n].dirty=1;
+    header->num_dirty++;
+    header->hash[slot]=n+1;
 
     n++;
     header->num_words=n;
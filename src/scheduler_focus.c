@@ -0,0 +1,410 @@
+/* scheduler_focus.c
+
+   2026 Oct 14
+
+   The adaptive focus sweep.
+
+   A focus field steps through n_required exposures from focus_start in
+   focus_increment steps and then hands them all to FOCUS_SCRIPT
+   (see focus_telescope()), so the focus block always costs n_required
+   exposures, each with FOCUS_OVERHEAD and a readout. With
+   ADAPTIVE_FOCUS the image quality of each exposure is measured as it
+   is read out (measure_focus_fwhm()) and added to a Focus_Sweep:
+
+      - the first setting is the focus predicted for the temperature
+        (predict_focus()), and the next two are a step either side of it
+      - the square of the fwhm is fitted with a parabola in the focus
+        setting (the seeing and the defocus add in quadrature, so this
+        is the shape of the curve, not just an approximation to it)
+      - while the smallest fwhm is at an end of the settings tried, the
+        sweep steps outward; once the minimum is bracketed the next
+        setting is the fitted best focus
+      - the sweep stops once there are FOCUS_SWEEP_MIN_POINTS exposures,
+        the minimum is bracketed and the fitted best focus is known to
+        FOCUS_SWEEP_TOLERANCE
+
+   The best focus and the temperature of each good sweep are appended to
+   FOCUS_MODEL_FILE, and the prediction is a linear fit of the recent
+   sweeps in temperature (or the last one, with too few or too narrow a
+   spread of temperatures to fit).
+*/
+
+#include "scheduler.h"
+
+extern int verbose;
+
+void init_focus_sweep(Focus_Sweep *s, double center, double increment,
+        double focus_default, int max_points);
+double next_focus_setting(Focus_Sweep *s);
+int add_focus_point(Focus_Sweep *s, double focus, double fwhm);
+int focus_sweep_done(Focus_Sweep *s);
+int focus_sweep_best(Focus_Sweep *s, double *best);
+double predict_focus(char *file_name, double temperature, double focus_default);
+int save_focus_model(char *file_name, double jd, double temperature, double focus);
+
+/************************************************************/
+
+void init_focus_sweep(Focus_Sweep *s, double center, double increment,
+        double focus_default, int max_points)
+{
+    memset((void *)s,0,sizeof(Focus_Sweep));
+
+    s->center=center;
+    s->increment=increment;
+    s->focus_default=focus_default;
+    s->max_points=max_points;
+    if(s->max_points>FOCUS_SWEEP_MAX_POINTS)s->max_points=FOCUS_SWEEP_MAX_POINTS;
+    s->pending=center;
+}
+
+/************************************************************/
+
+/* the range of settings tried so far, and the index of the one with the
+   smallest fwhm */
+
+static int sweep_range(Focus_Sweep *s, double *lo, double *hi)
+{
+    int i,i_min;
+
+    i_min=0;
+    *lo=s->focus[0];
+    *hi=s->focus[0];
+    for(i=1;i<s->n_points;i++){
+       if(s->fwhm[i]<s->fwhm[i_min])i_min=i;
+       if(s->focus[i]<*lo)*lo=s->focus[i];
+       if(s->focus[i]>*hi)*hi=s->focus[i];
+    }
+
+    return(i_min);
+}
+
+/************************************************************/
+
+/* Return the focus setting for the next exposure of the sweep, and keep
+   it as s->pending for add_focus_point() */
+
+double next_focus_setting(Focus_Sweep *s)
+{
+    double focus,lo,hi,d,d_min,limit;
+    int i,i_min,n_below,n_above;
+
+    if(s->n_points==0){
+       focus=s->center;
+    }
+    else if(s->n_points==1){
+       focus=s->center-s->increment;
+    }
+    else if(s->n_points==2){
+       focus=s->center+s->increment;
+    }
+    else{
+       i_min=sweep_range(s,&lo,&hi);
+
+       /* not bracketed yet: step outward past the smallest fwhm */
+
+       if(s->focus[i_min]<=lo){
+          focus=lo-s->increment;
+       }
+       else if(s->focus[i_min]>=hi){
+          focus=hi+s->increment;
+       }
+
+       /* bracketed: try the fitted best focus, or half a step from it
+          on the less sampled side if a setting there was already tried */
+
+       else{
+          focus=s->fit_ok ? s->best : s->focus[i_min];
+          d_min=s->increment;
+          n_below=0;
+          n_above=0;
+          for(i=0;i<s->n_points;i++){
+             d=fabs(s->focus[i]-focus);
+             if(d<d_min)d_min=d;
+             if(s->focus[i]<focus)n_below++;
+             else n_above++;
+          }
+          if(d_min<s->increment/4.0){
+             if(n_below<=n_above)focus=focus-s->increment/2.0;
+             else focus=focus+s->increment/2.0;
+          }
+       }
+    }
+
+    /* nothing further than MAX_FOCUS_CHANGE from the default would be
+       used, so don't look further than a step beyond that */
+
+    limit=MAX_FOCUS_CHANGE+s->increment;
+    if(focus<s->focus_default-limit)focus=s->focus_default-limit;
+    if(focus>s->focus_default+limit)focus=s->focus_default+limit;
+    if(focus<MIN_FOCUS)focus=MIN_FOCUS;
+    if(focus>MAX_FOCUS)focus=MAX_FOCUS;
+
+    s->pending=focus;
+
+    return(focus);
+}
+
+/************************************************************/
+
+/* invert the symmetric 3x3 matrix a into b. Return 0, or -1 if it is
+   singular */
+
+static int invert_3x3(double a[3][3], double b[3][3])
+{
+    double det;
+    int i,j;
+
+    b[0][0]=a[1][1]*a[2][2]-a[1][2]*a[2][1];
+    b[0][1]=a[0][2]*a[2][1]-a[0][1]*a[2][2];
+    b[0][2]=a[0][1]*a[1][2]-a[0][2]*a[1][1];
+    b[1][0]=a[1][2]*a[2][0]-a[1][0]*a[2][2];
+    b[1][1]=a[0][0]*a[2][2]-a[0][2]*a[2][0];
+    b[1][2]=a[0][2]*a[1][0]-a[0][0]*a[1][2];
+    b[2][0]=a[1][0]*a[2][1]-a[1][1]*a[2][0];
+    b[2][1]=a[0][1]*a[2][0]-a[0][0]*a[2][1];
+    b[2][2]=a[0][0]*a[1][1]-a[0][1]*a[1][0];
+
+    det=a[0][0]*b[0][0]+a[0][1]*b[1][0]+a[0][2]*b[2][0];
+    if(fabs(det)<1.0e-30)return(-1);
+
+    for(i=0;i<3;i++){
+       for(j=0;j<3;j++)b[i][j]=b[i][j]/det;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* fit fwhm^2 = p0 + p1*x + p2*x^2, x the setting less s->center, and
+   set s->fit_ok, s->best and s->sigma */
+
+static void fit_focus_sweep(Focus_Sweep *s)
+{
+    double a[3][3],cov[3][3],t[3],p[3],x,y,r,chi2,var_b,var_c,cov_bc,q;
+    int i,j,k,n;
+
+    s->fit_ok=0;
+    n=s->n_points;
+    if(n<4)return; /* no freedom left to judge the fit by */
+
+    memset((void *)a,0,sizeof(a));
+    memset((void *)t,0,sizeof(t));
+    for(i=0;i<n;i++){
+       x=s->focus[i]-s->center;
+       y=s->fwhm[i]*s->fwhm[i];
+       a[0][0]+=1.0;
+       a[0][1]+=x;
+       a[0][2]+=x*x;
+       a[1][2]+=x*x*x;
+       a[2][2]+=x*x*x*x;
+       t[0]+=y;
+       t[1]+=x*y;
+       t[2]+=x*x*y;
+    }
+    a[1][0]=a[0][1];
+    a[1][1]=a[0][2];
+    a[2][0]=a[0][2];
+    a[2][1]=a[1][2];
+
+    if(invert_3x3(a,cov)!=0)return;
+
+    for(j=0;j<3;j++){
+       p[j]=0.0;
+       for(k=0;k<3;k++)p[j]+=cov[j][k]*t[k];
+    }
+    if(p[2]<=0.0)return; /* no minimum */
+
+    chi2=0.0;
+    for(i=0;i<n;i++){
+       x=s->focus[i]-s->center;
+       r=s->fwhm[i]*s->fwhm[i]-(p[0]+p[1]*x+p[2]*x*x);
+       chi2+=r*r;
+    }
+    chi2=chi2/(n-3);
+
+    /* best = -p1/(2 p2), with the errors of p1 and p2 propagated */
+
+    var_b=chi2*cov[1][1];
+    var_c=chi2*cov[2][2];
+    cov_bc=chi2*cov[1][2];
+    q=p[1]/p[2];
+
+    s->best=s->center-p[1]/(2.0*p[2]);
+    s->sigma=sqrt(fabs(var_b-2.0*q*cov_bc+q*q*var_c))/(2.0*p[2]);
+    s->fit_ok=1;
+}
+
+/************************************************************/
+
+/* Add the measured fwhm of an exposure at focus to the sweep and refit.
+   A fwhm <= 0 (not measured) fails the sweep, which then leaves the
+   settings and the best focus to the fixed sequence, taken again from
+   focus_start, and FOCUS_SCRIPT.
+   Return 0, or -1 if the sweep has failed */
+
+int add_focus_point(Focus_Sweep *s, double focus, double fwhm)
+{
+    if(s->failed)return(-1);
+
+    if(fwhm<=0.0||s->n_points>=FOCUS_SWEEP_MAX_POINTS){
+       fprintf(stderr,"add_focus_point: no image quality for focus %8.5f. Using fixed focus steps\n",
+          focus);
+       fflush(stderr);
+       s->failed=1;
+       return(-1);
+    }
+
+    s->focus[s->n_points]=focus;
+    s->fwhm[s->n_points]=fwhm;
+    s->n_points++;
+
+    fit_focus_sweep(s);
+
+    if(verbose){
+       if(s->fit_ok){
+          fprintf(stderr,"add_focus_point: %d: focus %8.5f fwhm %7.3f. Best focus %8.5f +/- %7.5f\n",
+             s->n_points,focus,fwhm,s->best,s->sigma);
+       }
+       else{
+          fprintf(stderr,"add_focus_point: %d: focus %8.5f fwhm %7.3f\n",
+             s->n_points,focus,fwhm);
+       }
+       fflush(stderr);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return 1 if the sweep needs no more exposures, 0 if it does */
+
+int focus_sweep_done(Focus_Sweep *s)
+{
+    double lo,hi;
+
+    if(s->failed)return(0);
+    if(s->n_points>=s->max_points)return(1);
+    if(s->n_points<FOCUS_SWEEP_MIN_POINTS||!s->fit_ok)return(0);
+
+    sweep_range(s,&lo,&hi);
+
+    return(s->best>lo&&s->best<hi&&s->sigma<=FOCUS_SWEEP_TOLERANCE);
+}
+
+/************************************************************/
+
+/* Set best to the fitted best focus. Return 0, or -1 if the sweep has
+   no fit good enough to use (in which case FOCUS_SCRIPT should decide) */
+
+int focus_sweep_best(Focus_Sweep *s, double *best)
+{
+    double lo,hi;
+
+    if(s->failed||!s->fit_ok||s->n_points<FOCUS_SWEEP_MIN_POINTS)return(-1);
+
+    sweep_range(s,&lo,&hi);
+    if(s->best<=lo||s->best>=hi||s->sigma>FOCUS_SWEEP_TOLERANCE)return(-1);
+    if(s->best<MIN_FOCUS||s->best>MAX_FOCUS)return(-1);
+    if(fabs(s->best-s->focus_default)>MAX_FOCUS_CHANGE)return(-1);
+
+    *best=s->best;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return the best focus predicted at temperature (deg C) from the
+   sweeps in file_name, or focus_default if there are none or the
+   prediction is further than MAX_FOCUS_CHANGE from it */
+
+double predict_focus(char *file_name, double temperature, double focus_default)
+{
+    FILE *input;
+    char string[STR_BUF_LEN];
+    double jd,temp[FOCUS_MODEL_ENTRIES],focus[FOCUS_MODEL_ENTRIES];
+    double t,f,t_min,t_max,st,sf,stt,stf,d,prediction;
+    int i,n,n_read;
+
+    input=fopen(file_name,"r");
+    if(input==NULL)return(focus_default);
+
+    /* keep the last FOCUS_MODEL_ENTRIES, oldest first */
+
+    n_read=0;
+    while(fgets(string,STR_BUF_LEN,input)!=NULL){
+       if(string[0]=='#')continue;
+       if(sscanf(string,"%lf %lf %lf",&jd,&t,&f)!=3)continue;
+       temp[n_read%FOCUS_MODEL_ENTRIES]=t;
+       focus[n_read%FOCUS_MODEL_ENTRIES]=f;
+       n_read++;
+    }
+    fclose(input);
+
+    if(n_read==0)return(focus_default);
+    n=n_read<FOCUS_MODEL_ENTRIES ? n_read : FOCUS_MODEL_ENTRIES;
+
+    prediction=focus[(n_read-1)%FOCUS_MODEL_ENTRIES];
+
+    if(n>=FOCUS_MODEL_MIN_FIT){
+       t_min=temp[0];
+       t_max=temp[0];
+       st=0.0;
+       sf=0.0;
+       for(i=0;i<n;i++){
+          if(temp[i]<t_min)t_min=temp[i];
+          if(temp[i]>t_max)t_max=temp[i];
+          st+=temp[i];
+          sf+=focus[i];
+       }
+       st=st/n;
+       sf=sf/n;
+       if(t_max-t_min>=FOCUS_MODEL_MIN_TEMP_RANGE){
+          stt=0.0;
+          stf=0.0;
+          for(i=0;i<n;i++){
+             d=temp[i]-st;
+             stt+=d*d;
+             stf+=d*(focus[i]-sf);
+          }
+          prediction=sf+(stf/stt)*(temperature-st);
+       }
+    }
+
+    if(verbose){
+       fprintf(stderr,"predict_focus: %8.5f mm at %5.1f C from %d sweeps\n",
+          prediction,temperature,n);
+       fflush(stderr);
+    }
+
+    if(fabs(prediction-focus_default)>MAX_FOCUS_CHANGE)return(focus_default);
+
+    return(prediction);
+}
+
+/************************************************************/
+
+/* append the best focus of a sweep to file_name. Return 0, or -1 on
+   error */
+
+int save_focus_model(char *file_name, double jd, double temperature, double focus)
+{
+    FILE *output;
+
+    output=fopen(file_name,"a");
+    if(output==NULL){
+       fprintf(stderr,"save_focus_model: can't open file %s for output\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    fprintf(output,"%14.6f %7.2f %8.5f\n",jd,temperature,focus);
+    fclose(output);
+
+    return(0);
+}
+
+/************************************************************/
+
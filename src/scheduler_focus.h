@@ -0,0 +1,54 @@
+#ifndef __scheduler_focus_h
+#define __scheduler_focus_h
+
+/* scheduler_focus.h
+
+   The adaptive focus sweep: the image quality of each focus exposure is
+   fitted as it comes in, the next focus setting is chosen from the fit
+   to bracket the best focus, and the sweep stops as soon as the fit is
+   good enough (see scheduler_focus.c).
+
+   2026 Oct 14
+*/
+
+#define FOCUS_SWEEP_MAX_POINTS 32 /* most exposures in one sweep */
+#define FOCUS_SWEEP_MIN_POINTS 5 /* fewest exposures before the sweep can stop */
+#define FOCUS_SWEEP_TOLERANCE 0.015 /* stop when the best focus is known to this (mm, 1 sigma) */
+
+#define FOCUS_MODEL_FILE "focus.model" /* best focus and temperature of past sweeps */
+#define FOCUS_MODEL_ENTRIES 20 /* most recent sweeps used for the prediction */
+#define FOCUS_MODEL_MIN_FIT 5 /* fewest sweeps to fit the temperature slope from */
+#define FOCUS_MODEL_MIN_TEMP_RANGE 2.0 /* deg C spread of temperatures needed for the fit */
+
+typedef struct {
+    double center; /* first setting, the predicted best focus (mm) */
+    double increment; /* step between settings (mm) */
+    double focus_default; /* the fit is used only within MAX_FOCUS_CHANGE of this */
+    int max_points; /* exposures allowed, at most FOCUS_SWEEP_MAX_POINTS */
+    int n_points; /* exposures measured */
+    double focus[FOCUS_SWEEP_MAX_POINTS]; /* setting of each (mm) */
+    double fwhm[FOCUS_SWEEP_MAX_POINTS]; /* image quality of each */
+    double pending; /* setting of the exposure not yet measured */
+    int failed; /* an exposure could not be measured, so the sweep is fixed */
+    int fit_ok; /* the fit has a minimum */
+    double best; /* fitted best focus (mm) */
+    double sigma; /* its uncertainty (mm) */
+} Focus_Sweep;
+
+void init_focus_sweep(Focus_Sweep *s, double center, double increment,
+        double focus_default, int max_points);
+
+double next_focus_setting(Focus_Sweep *s);
+
+int add_focus_point(Focus_Sweep *s, double focus, double fwhm);
+
+int focus_sweep_done(Focus_Sweep *s);
+
+int focus_sweep_best(Focus_Sweep *s, double *best);
+
+double predict_focus(char *file_name, double temperature, double focus_default);
+
+int save_focus_model(char *file_name, double jd, double temperature, double focus);
+
+
+#endif
@@ -0,0 +1,162 @@
+/* scheduler_history.c
+
+   2026 Oct 14
+
+   The survey history as deltas.
+
+   print_history() writes a line to HISTORY_FILE after each observation
+   with a character for every field, so the file grows by the number of
+   fields for each exposure, however few of them changed (usually one).
+   write_history() writes only the fields whose n_done or n_required
+   changed since the last record:
+
+      D jd num_fields index:n_done[/n_required] ...
+
+   where jd is less HISTORY_JD_OFFSET, and n_required is given only if
+   it changed or the field is new. num_fields follows the field store,
+   so fields added during the night are new indices past the last
+   record's num_fields, and a store truncated after a failed ingest
+   just has fewer. The first record after opening, and every
+   HISTORY_SNAPSHOT_RECORDS-th after that, is a snapshot of all the
+   fields:
+
+      S jd num_fields n_done/n_required ...
+
+   so the history can be read from any snapshot onward, and a file
+   appended to by several runs of the scheduler has a snapshot at the
+   start of each run. Each record is one line, flushed when written.
+   Lines of the old format (a jd and a character per field) are left
+   alone by the readers, so old and new histories can share the file.
+   expand_history prints the records back in the old format.
+
+   Finding the changes is a comparison of two ints for each field, with
+   no formatting of the ones that did not change.
+*/
+
+#include "scheduler.h"
+
+int open_history_log(char *file_name, History_Log *h);
+int write_history(History_Log *h, double jd, Field *sequence, int num_fields);
+void close_history_log(History_Log *h);
+
+/************************************************************/
+
+/* Open file_name for appending the history to. Return 0, or -1 on
+   error */
+
+int open_history_log(char *file_name, History_Log *h)
+{
+    memset((void *)h,0,sizeof(History_Log));
+
+    h->output=fopen(file_name,"a");
+    if(h->output==NULL){
+       fprintf(stderr,"open_history_log: can't open file %s for output\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* make room in h for num_fields fields. Return 0, or -1 on error */
+
+static int grow_history_log(History_Log *h, int num_fields)
+{
+    int max_fields;
+    int *n_done,*n_required;
+
+    if(num_fields<=h->max_fields)return(0);
+
+    max_fields=h->max_fields>0 ? h->max_fields : 1024;
+    while(max_fields<num_fields)max_fields=2*max_fields;
+
+    n_done=(int *)realloc(h->n_done,max_fields*sizeof(int));
+    if(n_done==NULL){
+       fprintf(stderr,"grow_history_log: can't allocate %d fields\n",max_fields);
+       fflush(stderr);
+       return(-1);
+    }
+    h->n_done=n_done;
+
+    n_required=(int *)realloc(h->n_required,max_fields*sizeof(int));
+    if(n_required==NULL){
+       fprintf(stderr,"grow_history_log: can't allocate %d fields\n",max_fields);
+       fflush(stderr);
+       return(-1);
+    }
+    h->n_required=n_required;
+    h->max_fields=max_fields;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Append a record of the num_fields fields of sequence at jd to h: a
+   snapshot if one is due, or else the changes since the last record.
+   Return 0, or -1 on error */
+
+int write_history(History_Log *h, double jd, Field *sequence, int num_fields)
+{
+    int i,snapshot;
+    Field *f;
+
+    if(h->output==NULL)return(-1);
+
+    if(grow_history_log(h,num_fields)!=0)return(-1);
+
+    snapshot=(h->n_records==0||h->n_since_snapshot>=HISTORY_SNAPSHOT_RECORDS);
+
+    if(snapshot){
+       fprintf(h->output,"%c %12.6f %d",HISTORY_SNAPSHOT_CODE,
+          jd-HISTORY_JD_OFFSET,num_fields);
+       for(i=0;i<num_fields;i++){
+          f=sequence+i;
+          fprintf(h->output," %d/%d",f->n_done,f->n_required);
+          h->n_done[i]=f->n_done;
+          h->n_required[i]=f->n_required;
+       }
+       h->n_since_snapshot=0;
+    }
+    else{
+       fprintf(h->output,"%c %12.6f %d",HISTORY_DELTA_CODE,
+          jd-HISTORY_JD_OFFSET,num_fields);
+       for(i=0;i<num_fields;i++){
+          f=sequence+i;
+          if(i>=h->num_fields||f->n_required!=h->n_required[i]){
+             fprintf(h->output," %d:%d/%d",i,f->n_done,f->n_required);
+          }
+          else if(f->n_done!=h->n_done[i]){
+             fprintf(h->output," %d:%d",i,f->n_done);
+          }
+          else{
+             continue;
+          }
+          h->n_done[i]=f->n_done;
+          h->n_required[i]=f->n_required;
+       }
+       h->n_since_snapshot++;
+    }
+
+    fprintf(h->output,"\n");
+    fflush(h->output);
+
+    h->num_fields=num_fields;
+    h->n_records++;
+
+    return(0);
+}
+
+/************************************************************/
+
+void close_history_log(History_Log *h)
+{
+    if(h->output!=NULL)fclose(h->output);
+    if(h->n_done!=NULL)free(h->n_done);
+    if(h->n_required!=NULL)free(h->n_required);
+    memset((void *)h,0,sizeof(History_Log));
+}
+
+/************************************************************/
@@ -0,0 +1,37 @@
+#ifndef __scheduler_history_h
+#define __scheduler_history_h
+
+/* scheduler_history.h
+
+   The survey history (HISTORY_FILE) written as the changes in n_done
+   of the fields after each observation, with a full snapshot every
+   HISTORY_SNAPSHOT_RECORDS records (see scheduler_history.c, and
+   expand_history.c for the tool that turns it back into one line per
+   observation).
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+
+#define HISTORY_SNAPSHOT_RECORDS 256 /* records between full snapshots */
+#define HISTORY_SNAPSHOT_CODE 'S' /* first character of a snapshot record */
+#define HISTORY_DELTA_CODE 'D' /* first character of a delta record */
+#define HISTORY_JD_OFFSET 2450000 /* subtracted from the jd of each record */
+
+/* the history open for appending, with the counts last written so the
+   next record holds only what changed */
+
+typedef struct {
+    FILE *output;
+    int num_fields; /* fields in the last record */
+    int max_fields; /* room in n_done and n_required */
+    int *n_done;
+    int *n_required;
+    int n_records; /* written since opened */
+    int n_since_snapshot; /* written since the last snapshot */
+} History_Log;
+
+/* the functions are declared in scheduler.h, after the Field types */
+
+#endif
@@ -0,0 +1,409 @@
+/* scheduler_ingest.c
+
+   2026 Oct 14
+
+   Incremental reading of the new-fields script (script_name.add), which
+   may be appended to while the scheduler runs.
+
+   Rather than re-parsing the whole script every loop, ingest_sequence()
+   remembers the byte offset, line count and inode of the part already
+   read, and parses only complete lines appended since. A last line
+   without a newline is read only once the file size has stayed the same
+   between two calls, so a line caught half-written is not split.
+
+   If the file is replaced (new inode), truncated, or rewritten in place
+   (the last line read is no longer where it was), the bytes already
+   read are compared with the start of the new file by checksum. If they
+   match, reading continues from the same offset. Otherwise the file is
+   read again from the start, and as before the first num_fields fields
+   are assumed to be in the store already and are skipped.
+
+   On Linux the script's directory is watched with inotify, so the file
+   is only looked at after it has changed, and wait_script_tail() can
+   return as soon as new lines are written. Elsewhere the file is
+   stat'ed every call and wait_script_tail() just sleeps.
+*/
+
+#include "scheduler.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <limits.h>
+#endif
+
+extern int verbose;
+
+#define CHECKSUM_INIT 2166136261u
+
+/************************************************************/
+
+/* FNV-1a checksum of length bytes of data, continuing from sum */
+
+static unsigned int update_checksum(unsigned int sum, char *data, int length)
+{
+    int i;
+
+    for(i=0;i<length;i++){
+       sum=(sum^(unsigned char)data[i])*16777619u;
+    }
+
+    return(sum);
+}
+
+/************************************************************/
+
+/* return a pointer to the last component of file name */
+
+static char *base_name(char *name)
+{
+    char *s;
+
+    s=strrchr(name,'/');
+    if(s==NULL)return(name);
+
+    return(s+1);
+}
+
+/************************************************************/
+
+/* read any pending inotify events without blocking, and flag the tail
+   as changed if any of them are for the script. Return the number of
+   events for the script */
+
+static int drain_notify(Script_Tail *tail)
+{
+#if defined(__linux__)
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event *event;
+    char *name,*p;
+    int n,n_events;
+
+    if(tail->notify_fd<0)return(0);
+
+    name=base_name(tail->file_name);
+    n_events=0;
+
+    while((n=read(tail->notify_fd,buf,sizeof(buf)))>0){
+       for(p=buf;p<buf+n;p+=sizeof(struct inotify_event)+event->len){
+          event=(struct inotify_event *)p;
+          if((event->mask&IN_Q_OVERFLOW)||
+             (event->len>0&&strcmp(event->name,name)==0)){
+             n_events++;
+          }
+       }
+    }
+
+    if(n_events>0)tail->changed=1;
+
+    return(n_events);
+#else
+    return(0);
+#endif
+}
+
+/************************************************************/
+
+/* Start reading file_name from the beginning. The file need not exist
+   yet */
+
+int init_script_tail(Script_Tail *tail, char *file_name)
+{
+#if defined(__linux__)
+    char dir_name[STR_BUF_LEN];
+    char *s;
+#endif
+
+    memset((void *)tail,0,sizeof(Script_Tail));
+    strncpy(tail->file_name,file_name,STR_BUF_LEN-1);
+    tail->checksum=CHECKSUM_INIT;
+    tail->last_size=-1;
+    tail->changed=1;
+    tail->notify_fd=-1;
+    tail->watch=-1;
+    tail->wake_fd=-1;
+
+#if defined(__linux__)
+    strcpy(dir_name,tail->file_name);
+    s=strrchr(dir_name,'/');
+    if(s==NULL){
+       strcpy(dir_name,".");
+    }
+    else if(s==dir_name){
+       dir_name[1]=0;
+    }
+    else{
+       *s=0;
+    }
+
+    tail->notify_fd=inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if(tail->notify_fd>=0){
+       tail->watch=inotify_add_watch(tail->notify_fd,dir_name,
+          IN_MODIFY|IN_CLOSE_WRITE|IN_CREATE|IN_MOVED_TO|IN_DELETE|IN_MOVED_FROM);
+       if(tail->watch<0){
+          close(tail->notify_fd);
+          tail->notify_fd=-1;
+       }
+    }
+
+    if(tail->notify_fd<0){
+       fprintf(stderr,"init_script_tail: can't watch %s, polling %s instead\n",
+          dir_name,tail->file_name);
+       fflush(stderr);
+    }
+#endif
+
+    return(0);
+}
+
+/************************************************************/
+
+/* return 1 if the first tail->offset bytes of input match the part of
+   the script already ingested, 0 if not */
+
+static int check_prefix(Script_Tail *tail, FILE *input)
+{
+    char buf[4096];
+    unsigned int sum;
+    off_t n_left;
+    size_t n;
+
+    sum=CHECKSUM_INIT;
+    n_left=tail->offset;
+
+    rewind(input);
+    while(n_left>0){
+       n=n_left<(off_t)sizeof(buf) ? (size_t)n_left : sizeof(buf);
+       if(fread(buf,1,n,input)!=n)return(0);
+       sum=update_checksum(sum,buf,n);
+       n_left=n_left-n;
+    }
+
+    return(sum==tail->checksum);
+}
+
+/************************************************************/
+
+/* return 1 if the last line ingested is still in place just before
+   tail->offset in input, 0 if not. This catches a script rewritten in
+   place (same inode) without reading it all */
+
+static int check_last_line(Script_Tail *tail, FILE *input)
+{
+    char buf[STR_BUF_LEN];
+
+    if(tail->line_length<=0||tail->line_length>STR_BUF_LEN)return(1);
+
+    if(fseeko(input,tail->offset-tail->line_length,SEEK_SET)!=0)return(0);
+    if(fread(buf,1,tail->line_length,input)!=(size_t)tail->line_length)return(0);
+
+    return(update_checksum(CHECKSUM_INIT,buf,tail->line_length)==tail->line_checksum);
+}
+
+/************************************************************/
+
+/* Append to store the fields in the lines of the script added since the
+   last call. Return the total number of fields read from the script so
+   far (as returned by load_sequence()), or -1 on error, in which case
+   the lines are read again on the next call */
+
+int ingest_sequence(Script_Tail *tail, Field_Store *store)
+{
+    Script_Tail saved;
+    struct stat st;
+    FILE *input;
+    char string[STR_BUF_LEN+1];
+    char *buf;
+    size_t buf_size;
+    ssize_t len;
+    Field field;
+    int index,result,partial;
+
+    drain_notify(tail);
+
+    /* with inotify, only look at the file after it has changed or while
+       waiting for a partial last line to be finished */
+
+    if(tail->notify_fd>=0&&!tail->changed&&tail->last_size<0){
+       return(tail->num_fields);
+    }
+
+    if(stat(tail->file_name,&st)!=0){
+       /* no new fields until the script is (re)created */
+       tail->changed=0;
+       return(tail->num_fields);
+    }
+
+    if(st.st_size==tail->offset&&st.st_ino==tail->ino&&st.st_dev==tail->dev){
+       tail->changed=0;
+       tail->last_size=-1;
+       return(tail->num_fields);
+    }
+
+    input=fopen(tail->file_name,"r");
+    if(input==NULL){
+       fprintf(stderr,"ingest_sequence: can't open file %s\n",tail->file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    saved=*tail;
+
+    /* the script has been replaced, truncated or rewritten. Unless it starts with
+       the part already read, read it again from the start */
+
+    if(st.st_ino!=tail->ino||st.st_dev!=tail->dev||st.st_size<tail->offset||
+         !check_last_line(tail,input)){
+       if(st.st_size<tail->offset||!check_prefix(tail,input)){
+          if(tail->offset>0){
+             fprintf(stderr,
+                "ingest_sequence: %s has been replaced, reading it again and skipping the first %d fields\n",
+                tail->file_name,tail->num_fields);
+             fflush(stderr);
+          }
+          if(tail->num_fields>tail->num_skip)tail->num_skip=tail->num_fields;
+          tail->offset=0;
+          tail->line=0;
+          tail->num_fields=0;
+          tail->checksum=CHECKSUM_INIT;
+          tail->line_length=0;
+       }
+       tail->dev=st.st_dev;
+       tail->ino=st.st_ino;
+    }
+
+    if(fseeko(input,tail->offset,SEEK_SET)!=0){
+       fprintf(stderr,"ingest_sequence: can't seek to byte %ld of %s\n",
+          (long)tail->offset,tail->file_name);
+       fflush(stderr);
+       fclose(input);
+       *tail=saved;
+       return(-1);
+    }
+
+    buf=NULL;
+    buf_size=0;
+    tail->changed=0;
+    tail->last_size=-1;
+
+    while((len=getline(&buf,&buf_size,input))>0){
+
+      /* leave a partial last line until the file stops growing. Even
+         then, read it only if it is a complete field, since the rest of
+         the line may still be on its way */
+
+      partial=(buf[len-1]!='\n');
+      if(partial&&saved.last_size!=st.st_size){
+         tail->last_size=st.st_size;
+         break;
+      }
+
+      if(len>=STR_BUF_LEN-1){
+         fprintf(stderr,"ingest_sequence: WARNING: sequence line [%d] is too long. Ignoring \n",
+            tail->line+1);
+         fflush(stderr);
+      }
+      else{
+         memcpy(string,buf,len+1);
+         result=parse_sequence_line(string,tail->line+1,&field);
+         if(partial&&result!=1){
+            tail->last_size=st.st_size;
+            break;
+         }
+         if(result==1){
+            if(tail->num_fields>=tail->num_skip){
+               index=add_field(store,&field,string);
+               if(index<0){
+                  fprintf(stderr,"ingest_sequence: can't add field at line %d\n",
+                     tail->line+1);
+                  fflush(stderr);
+                  free(buf);
+                  fclose(input);
+                  *tail=saved;
+                  tail->changed=1;
+                  return(-1);
+               }
+               store->fields[index].field_number=index;
+            }
+            tail->num_fields++;
+         }
+      }
+
+      tail->line++;
+      tail->checksum=update_checksum(tail->checksum,buf,len);
+      tail->line_checksum=update_checksum(CHECKSUM_INIT,buf,len);
+      tail->line_length=len;
+      tail->offset=tail->offset+len;
+    }
+
+    free(buf);
+    fclose(input);
+
+    if(verbose){
+       fprintf(stderr,"ingest_sequence: %s read to byte %ld, line %d, %d fields\n",
+          tail->file_name,(long)tail->offset,tail->line,tail->num_fields);
+       fflush(stderr);
+    }
+
+    return(tail->num_fields);
+}
+
+/************************************************************/
+
+/* Wait up to seconds seconds on the scheduler's clock (see
+   clock_sleep()), returning early with 1 if the script changes or
+   tail->wake_fd (the control socket, see scheduler_control.c) becomes
+   readable. Return 0 if neither happened (or the script can't be
+   watched and there is no wake_fd).
+
+   select() waits in system time, so its timeout is scaled by the speed
+   of the clock. A stepped clock does not move while select() waits, so
+   then the descriptors are looked at once and the time let pass */
+
+int wait_script_tail(Script_Tail *tail, double seconds)
+{
+    fd_set fds;
+    struct timeval timeout;
+    double t_end,t,wait_sec;
+    int n,max_fd;
+
+    if(tail->notify_fd<0&&tail->wake_fd<0){
+       clock_sleep(seconds);
+       return(0);
+    }
+
+    t_end=get_unix_time()+seconds;
+
+    while((t=get_unix_time())<t_end){
+       FD_ZERO(&fds);
+       max_fd=-1;
+       if(tail->notify_fd>=0){
+          FD_SET(tail->notify_fd,&fds);
+          max_fd=tail->notify_fd;
+       }
+       if(tail->wake_fd>=0){
+          FD_SET(tail->wake_fd,&fds);
+          if(tail->wake_fd>max_fd)max_fd=tail->wake_fd;
+       }
+       wait_sec=clock_is_stepped() ? 0.0 : (t_end-t)/get_clock_speed();
+       timeout.tv_sec=(long)wait_sec;
+       timeout.tv_usec=(long)((wait_sec-timeout.tv_sec)*1.0e6);
+       n=select(max_fd+1,&fds,NULL,NULL,&timeout);
+       if((n<0&&errno!=EINTR)||(n==0&&clock_is_stepped())){
+          clock_sleep(t_end-t);
+          return(0);
+       }
+       if(n<=0)continue;
+
+       /* the wake byte is read by drain_control_fields() */
+
+       if(tail->wake_fd>=0&&FD_ISSET(tail->wake_fd,&fds))return(1);
+       if(tail->notify_fd>=0&&FD_ISSET(tail->notify_fd,&fds)&&
+             drain_notify(tail)>0)return(1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
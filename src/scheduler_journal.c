@@ -0,0 +1,543 @@
+/* scheduler_journal.c
+
+   2026 Oct 14
+
+   Append-only record of the observations made by the scheduler
+   (OBS_RECORD_FILE), used to pick up where the scheduler left off after
+   a crash or restart.
+
+   The record starts with a header, followed by a series of entries.
+   Each entry is a frame (type, payload length, payload checksum)
+   followed by its payload:
+
+     JOURNAL_FIELD : a field added to the sequence. Written once per field,
+                     with the field parameters and its script line
+     JOURNAL_OBS   : one completed observation of a field
+     JOURNAL_UNDO  : a field's n_done rolled back (bad readout, focus or
+                     offset sequence to be repeated)
+
+   save_obs_record() appends only what has changed since the last call,
+   normally one JOURNAL_OBS entry per exposure, and fsyncs the file.
+   load_obs_record() maps the file and replays the entries. Replay stops
+   at the first incomplete or corrupt entry, which is truncated away, so
+   a crash in the middle of a write loses at most that entry.
+
+   The payloads hold the members of a field one by one, in types of
+   fixed size, so a record stays readable when Field changes. A record
+   of another version (or one that is not a record) is renamed
+   file_name.JOURNAL_OLD_SUFFIX and a new one started, so the scheduler
+   reads the sequence file instead of stopping.
+*/
+
+#include "scheduler.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+#define JOURNAL_MAGIC "LS4OBSJ"
+#define JOURNAL_VERSION 2
+#define JOURNAL_OLD_SUFFIX ".old" /* appended to a record that can't be read */
+
+#define JOURNAL_FIELD 1
+#define JOURNAL_OBS 2
+#define JOURNAL_UNDO 3
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t reserved; /* 0 */
+    int32_t year,month,day,hour,minute,second; /* time record was started */
+} Journal_Header;
+
+typedef struct {
+    int32_t type; /* JOURNAL_FIELD, JOURNAL_OBS, or JOURNAL_UNDO */
+    int32_t length; /* bytes of payload following the frame */
+    uint32_t checksum; /* checksum of the payload */
+} Journal_Frame;
+
+/* payload of JOURNAL_FIELD entries: the members of the Field read from
+   its script line (the rest are computed again by init_fields()) */
+
+typedef struct {
+    int32_t index; /* position of field in sequence */
+    int32_t field_number;
+    int32_t line_number;
+    int32_t shutter;
+    int32_t n_required;
+    int32_t survey_code;
+    double ra,dec,expt,interval; /* hours, deg, hours, hours */
+    char script_line[STR_BUF_LEN];
+} Journal_Field;
+
+/* payload of JOURNAL_OBS and JOURNAL_UNDO entries. For JOURNAL_UNDO
+   only index and n_done are used */
+
+typedef struct {
+    int32_t index; /* position of field in sequence */
+    int32_t n_done; /* n_done after this entry */
+    int32_t n_required; /* n_required after this entry (long exposures split) */
+    int32_t reserved; /* 0 */
+    double ut,jd,lst,ha,am,actual_expt;
+    char filename[FILENAME_LENGTH];
+} Journal_Obs;
+
+extern int verbose;
+extern double focus_start;
+extern double focus_increment;
+extern double focus_default;
+
+int load_obs_record(char *file_name, Field_Store *store, FILE **obs_record);
+int save_obs_record(Field *sequence, FILE *obs_record, int num_fields,
+         struct tm *tm);
+
+/************************************************************/
+
+/* FNV-1a hash of a journal payload */
+
+static unsigned int journal_checksum(void *data, int length)
+{
+    unsigned char *c;
+    unsigned int h;
+    int i;
+
+    c=(unsigned char *)data;
+    h=2166136261u;
+    for(i=0;i<length;i++){
+       h=(h^c[i])*16777619u;
+    }
+
+    return(h);
+}
+
+/************************************************************/
+
+static int append_journal_entry(FILE *obs_record, int type, void *data, int length)
+{
+    Journal_Frame frame;
+
+    frame.type=type;
+    frame.length=length;
+    frame.checksum=journal_checksum(data,length);
+
+    if(fwrite((void *)&frame,sizeof(frame),1,obs_record)!=1||
+       fwrite(data,length,1,obs_record)!=1){
+      fprintf(stderr,"append_journal_entry: ERROR writing entry of type %d\n",
+           type);
+      fflush(stderr);
+      return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+static int append_journal_obs(FILE *obs_record, int type, Field *f,
+           int index, int n)
+{
+    Journal_Obs obs;
+
+    memset((void *)&obs,0,sizeof(obs));
+    obs.index=index;
+    obs.n_required=f->n_required;
+
+    if(type==JOURNAL_UNDO){
+       obs.n_done=n;
+    }
+    else{
+       obs.n_done=n+1;
+       obs.ut=f->history->ut[n];
+       obs.jd=f->history->jd[n];
+       obs.lst=f->history->lst[n];
+       obs.ha=f->history->ha[n];
+       obs.am=f->history->am[n];
+       obs.actual_expt=f->history->actual_expt[n];
+       strncpy(obs.filename,f->history->filename+n*FILENAME_LENGTH,
+            FILENAME_LENGTH);
+    }
+
+    return(append_journal_entry(obs_record,type,(void *)&obs,sizeof(obs)));
+}
+
+/************************************************************/
+
+/* Append to the obs record whatever has changed in the sequence since
+   the last call: the parameters of fields not yet recorded, and the
+   observations completed or rolled back since then. The file is synced
+   to disk before returning. */
+
+int save_obs_record(Field *sequence, FILE *obs_record, int num_fields,
+     struct tm *tm)
+{
+     int i,j,n,num_entries;
+     Field *f;
+     Journal_Header header;
+     Journal_Field *entry;
+
+     if(fseek(obs_record,0,SEEK_END)!=0){
+        fprintf(stderr,"save_obs_record: can't seek to end of obs_record\n");
+        fflush(stderr);
+        return(-1);
+     }
+
+     /* a new record starts with the header */
+
+     if(ftell(obs_record)==0){
+        memset((void *)&header,0,sizeof(header));
+        strcpy(header.magic,JOURNAL_MAGIC);
+        header.version=JOURNAL_VERSION;
+        header.year=tm->tm_year;
+        header.month=tm->tm_mon;
+        header.day=tm->tm_mday;
+        header.hour=tm->tm_hour;
+        header.minute=tm->tm_min;
+        header.second=tm->tm_sec;
+
+        if(fwrite((void *)&header,sizeof(header),1,obs_record)!=1){
+          fprintf(stderr,"save_obs_record: ERROR writing header\n");
+          fflush(stderr);
+          return(-1);
+        }
+     }
+
+     entry=NULL;
+     num_entries=0;
+
+     for(i=0;i<num_fields;i++){
+        f=sequence+i;
+
+        /* field not yet in the record */
+
+        if(f->n_saved<0){
+           if(entry==NULL){
+              entry=(Journal_Field *)malloc(sizeof(Journal_Field));
+              if(entry==NULL){
+                 fprintf(stderr,"save_obs_record: can't allocate field entry\n");
+                 fflush(stderr);
+                 return(-1);
+              }
+           }
+           memset((void *)entry,0,sizeof(Journal_Field));
+           entry->index=i;
+           entry->field_number=f->field_number;
+           entry->line_number=f->line_number;
+           entry->shutter=f->shutter;
+           entry->n_required=f->n_required;
+           entry->survey_code=f->survey_code;
+           entry->ra=f->ra;
+           entry->dec=f->dec;
+           entry->expt=f->expt;
+           entry->interval=f->interval;
+           strncpy(entry->script_line,f->history->script_line,STR_BUF_LEN-1);
+           if(append_journal_entry(obs_record,JOURNAL_FIELD,(void *)entry,
+                    sizeof(Journal_Field))!=0){
+              free(entry);
+              return(-1);
+           }
+           f->n_saved=0;
+           f->jd_saved=0.0;
+           num_entries++;
+        }
+
+        /* n is the number of recorded observations that are still valid.
+           If the last one was rolled back and then redone, its jd
+           will have changed */
+
+        n=f->n_saved;
+        if(n>f->n_done){
+           n=f->n_done;
+        }
+        else if(n>0&&f->history->jd[n-1]!=f->jd_saved){
+           n--;
+        }
+
+        if(n<f->n_saved){
+           if(append_journal_obs(obs_record,JOURNAL_UNDO,f,i,n)!=0){
+              if(entry!=NULL)free(entry);
+              return(-1);
+           }
+           num_entries++;
+        }
+
+        for(j=n;j<f->n_done;j++){
+           if(append_journal_obs(obs_record,JOURNAL_OBS,f,i,j)!=0){
+              if(entry!=NULL)free(entry);
+              return(-1);
+           }
+           num_entries++;
+        }
+
+        f->n_saved=f->n_done;
+        if(f->n_done>0){
+           f->jd_saved=f->history->jd[f->n_done-1];
+        }
+        else{
+           f->jd_saved=0.0;
+        }
+     }
+
+     if(entry!=NULL)free(entry);
+
+     if(fflush(obs_record)!=0){
+        fprintf(stderr,"save_obs_record: ERROR flushing obs_record\n");
+        fflush(stderr);
+        return(-1);
+     }
+
+     if(num_entries>0&&fsync(fileno(obs_record))!=0){
+        fprintf(stderr,"save_obs_record: ERROR syncing obs_record\n");
+        fflush(stderr);
+        return(-1);
+     }
+
+     return(0);
+}
+
+/************************************************************/
+
+/* replay one journal entry into the sequence. Return 0 if the entry
+   is consistent with what has been replayed so far, -1 otherwise. */
+
+static int replay_journal_entry(Journal_Frame *frame, char *data,
+       Field_Store *store)
+{
+    Journal_Field *entry;
+    Journal_Obs *obs;
+    Field field,*f;
+    int n;
+
+    if(frame->type==JOURNAL_FIELD){
+       if(frame->length!=sizeof(Journal_Field))return(-1);
+       entry=(Journal_Field *)data;
+       if(entry->index!=store->num_fields)return(-1);
+
+       if(memchr(entry->script_line,0,STR_BUF_LEN)==NULL)return(-1);
+
+       memset((void *)&field,0,sizeof(Field));
+       field.field_number=entry->field_number;
+       field.line_number=entry->line_number;
+       field.shutter=entry->shutter;
+       field.n_required=entry->n_required;
+       field.survey_code=entry->survey_code;
+       field.ra=entry->ra;
+       field.dec=entry->dec;
+       field.sin_dec=sin(field.dec/DEG_IN_RADIAN);
+       field.cos_dec=cos(field.dec/DEG_IN_RADIAN);
+       field.expt=entry->expt;
+       field.interval=entry->interval;
+       if(add_field(store,&field,entry->script_line)!=entry->index){
+          return(-1);
+       }
+       return(0);
+    }
+
+    if(frame->type!=JOURNAL_OBS&&frame->type!=JOURNAL_UNDO)return(-1);
+    if(frame->length!=sizeof(Journal_Obs))return(-1);
+
+    obs=(Journal_Obs *)data;
+    if(obs->index<0||obs->index>=store->num_fields)return(-1);
+    if(obs->n_done<0||obs->n_required<0)return(-1);
+
+    f=store->fields+obs->index;
+    if(grow_field_history(f,obs->n_required)!=0||
+       grow_field_history(f,obs->n_done)!=0)return(-1);
+    f->n_required=obs->n_required;
+
+    if(frame->type==JOURNAL_UNDO){
+       if(obs->n_done>f->n_done)return(-1);
+       f->n_done=obs->n_done;
+       return(0);
+    }
+
+    n=obs->n_done-1;
+    if(n!=f->n_done)return(-1);
+
+    f->history->ut[n]=obs->ut;
+    f->history->jd[n]=obs->jd;
+    f->history->lst[n]=obs->lst;
+    f->history->ha[n]=obs->ha;
+    f->history->am[n]=obs->am;
+    f->history->actual_expt[n]=obs->actual_expt;
+    strncpy(f->history->filename+n*FILENAME_LENGTH,obs->filename,
+          FILENAME_LENGTH);
+    f->n_done=obs->n_done;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Rename the obs record file_name, which can't be read, to
+   file_name.JOURNAL_OLD_SUFFIX and open a new empty record in its place.
+   Return 0, or -1 on error */
+
+static int restart_obs_record(char *file_name, FILE **obs_record)
+{
+     char old_name[STR_BUF_LEN+8];
+
+     fclose(*obs_record);
+     *obs_record=NULL;
+
+     sprintf(old_name,"%s%s",file_name,JOURNAL_OLD_SUFFIX);
+     if(rename(file_name,old_name)!=0){
+        fprintf(stderr,"load_obs_record: can't rename %s to %s\n",file_name,old_name);
+        fflush(stderr);
+        return(-1);
+     }
+     fprintf(stderr,"load_obs_record: moved %s to %s, starting a new record\n",
+        file_name,old_name);
+     fflush(stderr);
+
+     *obs_record=fopen(file_name,"w+");
+     if(*obs_record==NULL){
+        fprintf(stderr,"load_obs_record: can't create new obs record\n");
+        fflush(stderr);
+        return(-1);
+     }
+
+     return(0);
+}
+
+/************************************************************/
+
+/* Open the obs record file_name, creating it if necessary, and replay
+   it into store. Return the number of fields recovered,
+   0 if there is no previous record (or none that can be read), or -1
+   on error. obs_record is left
+   open for appending by save_obs_record() */
+
+int load_obs_record(char *file_name, Field_Store *store, FILE **obs_record)
+{
+     int i,n;
+     int fd;
+     int num_fields;
+     int n_completed;
+     int n_started;
+     int n_fresh;
+     int n_entries;
+     size_t offset,length;
+     struct stat st;
+     char *map;
+     Journal_Header *header;
+     Journal_Frame frame;
+     Field *f;
+
+     *obs_record=fopen(file_name,"r+");
+     if(*obs_record==NULL){
+    fprintf(stderr,"load_obs_record: can't open file %s for reading\n",
+        file_name);
+    fprintf(stderr,"load_obs_record: creating new empty record\n");
+    fflush(stderr);
+    *obs_record=fopen(file_name,"w+");
+    if(*obs_record==NULL){
+      fprintf(stderr,"load_obs_record: can't create new obs record\n");
+      return(-1);
+    }
+    else{
+      return(0);
+    }
+     }
+
+     fd=fileno(*obs_record);
+     if(fstat(fd,&st)!=0){
+     fprintf(stderr,"load_obs_record: can't stat %s\n",file_name);
+     return(-1);
+     }
+
+     length=st.st_size;
+     if(length==0){
+     fprintf(stderr,"load_obs_record: record is empty\n");
+     fprintf(stderr,"load_obs_record: assuming no previous observations\n");
+     return(0);
+     }
+
+     if(length<sizeof(Journal_Header)){
+     fprintf(stderr,"load_obs_record: record too short for header\n");
+     return(restart_obs_record(file_name,obs_record));
+     }
+
+     map=(char *)mmap(NULL,length,PROT_READ,MAP_PRIVATE,fd,0);
+     if(map==MAP_FAILED){
+     fprintf(stderr,"load_obs_record: can't map %s\n",file_name);
+     return(-1);
+     }
+
+     header=(Journal_Header *)map;
+     if(strncmp(header->magic,JOURNAL_MAGIC,sizeof(header->magic))!=0||
+        header->version!=JOURNAL_VERSION){
+     fprintf(stderr,"load_obs_record: %s is not an obs record of version %d\n",
+          file_name,JOURNAL_VERSION);
+     munmap(map,length);
+     return(restart_obs_record(file_name,obs_record));
+     }
+
+     fprintf(stderr,"load_obs_record: record started %d %d %d %d %d %d\n",
+        header->year,header->month,header->day,
+        header->hour,header->minute,header->second);
+
+     /* replay the entries up to the first one that is incomplete
+        or fails its checksum */
+
+     n_entries=0;
+     offset=sizeof(Journal_Header);
+     while(offset+sizeof(Journal_Frame)<=length){
+        memcpy((void *)&frame,map+offset,sizeof(frame));
+        if(frame.length<=0||offset+sizeof(frame)+frame.length>length)break;
+        if(journal_checksum(map+offset+sizeof(frame),frame.length)!=
+             frame.checksum)break;
+        if(replay_journal_entry(&frame,map+offset+sizeof(frame),store)!=0)break;
+        offset=offset+sizeof(frame)+frame.length;
+        n_entries++;
+     }
+
+     munmap(map,length);
+     num_fields=store->num_fields;
+
+     if(offset<length){
+     fprintf(stderr,
+       "load_obs_record: discarding %ld bytes after entry %d\n",
+        (long)(length-offset),n_entries);
+     fflush(stderr);
+     if(ftruncate(fd,offset)!=0){
+        fprintf(stderr,"load_obs_record: can't truncate obs record\n");
+        return(-1);
+     }
+     }
+
+     n_fresh=0;
+     n_started=0;
+     n_completed=0;
+
+     for(i=0;i<num_fields;i++){
+      f=store->fields+i;
+      f->n_saved=f->n_done;
+      if(f->n_done>0){
+         f->jd_saved=f->history->jd[f->n_done-1];
+      }
+      else{
+         f->jd_saved=0.0;
+      }
+      if(f->n_done==0){
+          n_fresh++;
+      }
+      else if (f->n_done < f->n_required){
+           n_started++;
+      }
+      else {
+           n_completed++;
+      }
+      if(f->shutter==FOCUS_CODE){
+         n=f->n_required/2;
+         focus_start=focus_default-n*focus_increment;
+      }
+     }
+
+     fprintf(stderr,
+       "load_obs_record: %d entries, %d total, %d fresh, %d started, %d completed\n",
+       n_entries, num_fields, n_fresh,n_started,n_completed);
+
+     return(num_fields);
+}
+
+/************************************************************/
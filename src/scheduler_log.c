@@ -0,0 +1,443 @@
+/* scheduler_log.c
+
+   2026 Oct 14
+
+   Leveled logging for the scheduler hot paths.
+
+   Each record belongs to a subsystem (enum Log_Subsystem) and has a
+   level (enum Log_Level). A subsystem keeps records up to its level in
+   log_level[], or, if that is LOG_LEVEL_FOLLOW, up to the level given
+   by the verbose and verbose1 flags. Callers test LOG_ON() before
+   building a record, so a record that is not kept costs one test. A
+   thread that sets log_quiet (the lookahead planner, playing copies of
+   the sequence) keeps none, without changing what the others keep.
+
+   Until start_log_writer() is called, sched_log() writes to stderr and
+   flushes, as the scheduler always has. After it, sched_log() puts
+   the record, with the time it was made, into a ring buffer and
+   returns. A writer thread takes the records out in order and writes
+   them to the log a batch at a time, with one flush per batch. The
+   ring is lock-free: each slot carries a sequence number saying
+   whether it is free or holds a record, and a thread making a record
+   claims a slot by advancing the head with compare-and-swap. If the
+   ring is full the record is dropped, and the count of dropped records
+   is written out with the next batch; the observing thread never waits
+   on the log. The writer puts the time, the subsystem and the level
+   of the record before its text:
+
+      02:13:45.123456 select debug: ...
+
+   While the writer runs, stderr is a stream whose lines also go into
+   the ring, a record a line, written with the time alone. The messages
+   the scheduler writes straight to stderr (errors, mostly) then come
+   out in order with the records before them, not ahead of them. Such a
+   line waits for a free slot rather than being dropped.
+
+   The levels can be changed while running with set_log_level(), and
+   the writer rereads LOG_LEVEL_FILE whenever it changes. Each line of
+   the file is a subsystem name (or "all") and a level name or number
+   ("follow" or 0 to follow the verbose flags again). The levels are
+   atomic, read and written relaxed, since the writer sets them while
+   other threads test them:
+
+      select debug
+      command 2
+*/
+
+#define _GNU_SOURCE /* for fopencookie */
+#include "scheduler.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#if (LOG_RING_SIZE & (LOG_RING_SIZE-1)) != 0
+#error LOG_RING_SIZE must be a power of 2
+#endif
+
+atomic_int log_level[NUM_LOG_SUBSYSTEMS]; /* all LOG_LEVEL_FOLLOW to start */
+_Thread_local int log_quiet=0; /* this thread keeps no records */
+
+static char *log_subsystem_name[NUM_LOG_SUBSYSTEMS]={"main","select","fields",
+       "command","fits"};
+static char *log_level_name[]={"follow","error","info","verbose","debug"};
+
+#define LOG_STDERR_SUBSYSTEM -1 /* record is a line written to stderr */
+
+typedef struct {
+    atomic_uint seq; /* slot is free for the record claimed as seq, and
+                        holds a record to write when seq is one more */
+    struct timeval tv;
+    int subsystem;
+    int level;
+    char text[LOG_RECORD_LEN];
+} Log_Record;
+
+static Log_Record log_ring[LOG_RING_SIZE];
+static atomic_uint log_head; /* next record to claim */
+static unsigned int log_tail; /* next record to write (writer only) */
+static atomic_uint log_dropped;
+static atomic_int log_async=0; /* records go to the ring */
+static atomic_int log_running=0;
+static FILE *log_output=NULL;
+static time_t log_level_mtime=0;
+static pthread_t log_thread;
+static FILE *log_stderr=NULL; /* stderr before start_log_writer() */
+static FILE *log_stderr_stream=NULL; /* stderr while the writer runs */
+
+void sched_log(int subsystem, int level, char *format, ...);
+int start_log_writer(FILE *output);
+void stop_log_writer();
+int set_log_level(char *subsystem, char *level);
+int read_log_levels(char *file_name);
+
+/************************************************************/
+
+/* claim the next slot in the ring. Return it, or NULL if the ring is
+   full. The caller fills the slot and stores pos+1 in its seq */
+
+static Log_Record *claim_log_record(unsigned int *pos)
+{
+    Log_Record *r;
+    unsigned int seq;
+    int diff;
+
+    *pos=atomic_load_explicit(&log_head,memory_order_relaxed);
+    for(;;){
+       r=log_ring+(*pos&(LOG_RING_SIZE-1));
+       seq=atomic_load_explicit(&(r->seq),memory_order_acquire);
+       diff=(int)(seq-*pos);
+       if(diff==0){
+          if(atomic_compare_exchange_weak_explicit(&log_head,pos,*pos+1,
+                memory_order_relaxed,memory_order_relaxed))return(r);
+       }
+       else if(diff<0){
+          /* the writer has not freed this slot yet: the ring is full */
+          return(NULL);
+       }
+       else{
+          *pos=atomic_load_explicit(&log_head,memory_order_relaxed);
+       }
+    }
+}
+
+/************************************************************/
+
+/* Format a record for subsystem. The record is written as it would
+   be by fprintf, so format should end with a newline */
+
+void sched_log(int subsystem, int level, char *format, ...)
+{
+    va_list args;
+    Log_Record *r;
+    unsigned int pos;
+
+    if(level<LOG_ERROR)level=LOG_ERROR;
+    if(level>LOG_DEBUG)level=LOG_DEBUG;
+
+    va_start(args,format);
+
+    if(!atomic_load_explicit(&log_async,memory_order_acquire)){
+       vfprintf(stderr,format,args);
+       fflush(stderr);
+       va_end(args);
+       return;
+    }
+
+    r=claim_log_record(&pos);
+    if(r==NULL){
+       atomic_fetch_add_explicit(&log_dropped,1,memory_order_relaxed);
+       va_end(args);
+       return;
+    }
+
+    gettimeofday(&(r->tv),NULL);
+    r->subsystem=subsystem;
+    r->level=level;
+    vsnprintf(r->text,LOG_RECORD_LEN,format,args);
+    va_end(args);
+
+    atomic_store_explicit(&(r->seq),pos+1,memory_order_release);
+}
+
+/************************************************************/
+
+/* write function of the stream standing in for stderr: put each line
+   of buf into the ring, waiting for a slot if the ring is full. Once
+   the writer is stopped, write to stderr as before */
+
+static ssize_t write_stderr_lines(void *cookie, const char *buf, size_t size)
+{
+    Log_Record *r;
+    unsigned int pos;
+    size_t i,len;
+
+    (void)cookie;
+
+    i=0;
+    while(i<size){
+       len=0;
+       while(i+len<size&&len<LOG_RECORD_LEN-1&&buf[i+len]!='\n')len++;
+       if(i+len<size&&buf[i+len]=='\n'&&len<LOG_RECORD_LEN-1)len++;
+
+       r=NULL;
+       while(atomic_load_explicit(&log_async,memory_order_acquire)&&
+             (r=claim_log_record(&pos))==NULL)usleep(1000);
+
+       if(r==NULL){
+          fwrite(buf+i,1,len,log_stderr);
+          fflush(log_stderr);
+       }
+       else{
+          gettimeofday(&(r->tv),NULL);
+          r->subsystem=LOG_STDERR_SUBSYSTEM;
+          r->level=LOG_ERROR;
+          memcpy(r->text,buf+i,len);
+          r->text[len]=0;
+          atomic_store_explicit(&(r->seq),pos+1,memory_order_release);
+       }
+
+       i+=len;
+    }
+
+    return(size);
+}
+
+/************************************************************/
+
+/* write out the records in the ring, in order. Return the number
+   written */
+
+static int write_log_records()
+{
+    Log_Record *r;
+    struct tm tm;
+    unsigned int dropped;
+    int n,len;
+
+    n=0;
+    for(;;){
+       r=log_ring+(log_tail&(LOG_RING_SIZE-1));
+       if(atomic_load_explicit(&(r->seq),memory_order_acquire)!=log_tail+1)break;
+
+       gmtime_r(&(r->tv.tv_sec),&tm);
+       len=strlen(r->text);
+       if(r->subsystem==LOG_STDERR_SUBSYSTEM){
+          fprintf(log_output,"%02d:%02d:%02d.%06ld %s%s",tm.tm_hour,tm.tm_min,
+             tm.tm_sec,(long)r->tv.tv_usec,r->text,
+             (len>0&&r->text[len-1]=='\n') ? "" : "\n");
+       }
+       else{
+          fprintf(log_output,"%02d:%02d:%02d.%06ld %s %s: %s%s",tm.tm_hour,tm.tm_min,
+             tm.tm_sec,(long)r->tv.tv_usec,log_subsystem_name[r->subsystem],
+             log_level_name[r->level],r->text,
+             (len>0&&r->text[len-1]=='\n') ? "" : "\n");
+       }
+
+       atomic_store_explicit(&(r->seq),log_tail+LOG_RING_SIZE,memory_order_release);
+       log_tail++;
+       n++;
+    }
+
+    dropped=atomic_exchange_explicit(&log_dropped,0,memory_order_relaxed);
+    if(dropped>0){
+       fprintf(log_output,"sched_log: %u records dropped, log ring full\n",dropped);
+       n++;
+    }
+
+    if(n>0)fflush(log_output);
+
+    return(n);
+}
+
+/************************************************************/
+
+/* reread the levels in LOG_LEVEL_FILE if it has changed */
+
+static void check_log_level_file()
+{
+    struct stat st;
+
+    if(stat(LOG_LEVEL_FILE,&st)!=0||st.st_mtime==log_level_mtime)return;
+
+    log_level_mtime=st.st_mtime;
+    read_log_levels(LOG_LEVEL_FILE);
+}
+
+/************************************************************/
+
+static void *log_writer_thread(void *args)
+{
+    struct timeval t_check,t;
+
+    (void)args;
+
+    gettimeofday(&t_check,NULL);
+
+    while(log_running){
+       if(write_log_records()==0)usleep(LOG_WRITER_USEC);
+
+       gettimeofday(&t,NULL);
+       if(t.tv_sec-t_check.tv_sec>=LOG_LEVEL_CHECK_SEC){
+          check_log_level_file();
+          t_check=t;
+       }
+    }
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* Start writing log records to output from a writer thread, and
+   reading levels from LOG_LEVEL_FILE, with the lines written to stderr
+   going through the ring too. Return 0, or -1 if the thread can't be
+   started (records are then still written as they are made) */
+
+int start_log_writer(FILE *output)
+{
+    cookie_io_functions_t stderr_functions={NULL,write_stderr_lines,NULL,NULL};
+    unsigned int i;
+
+    if(log_running)return(0);
+
+    for(i=0;i<LOG_RING_SIZE;i++){
+       atomic_store_explicit(&(log_ring[i].seq),i,memory_order_relaxed);
+    }
+    atomic_store_explicit(&log_head,0,memory_order_relaxed);
+    atomic_store_explicit(&log_dropped,0,memory_order_relaxed);
+    log_tail=0;
+    log_output=output;
+
+    check_log_level_file();
+
+    log_running=1;
+    if(pthread_create(&log_thread,NULL,log_writer_thread,NULL)!=0){
+       fprintf(stderr,"start_log_writer: can't start log writer thread\n");
+       fflush(stderr);
+       log_running=0;
+       return(-1);
+    }
+
+    atomic_store_explicit(&log_async,1,memory_order_release);
+
+    /* the stream is kept after stop_log_writer(), in case a thread
+       still holds it; it then writes to stderr directly */
+
+    if(log_stderr_stream==NULL){
+       log_stderr_stream=fopencookie(NULL,"w",stderr_functions);
+       if(log_stderr_stream!=NULL)setvbuf(log_stderr_stream,NULL,_IOLBF,0);
+    }
+    if(log_stderr_stream!=NULL){
+       fflush(stderr);
+       log_stderr=stderr;
+       stderr=log_stderr_stream;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Write out the records still in the ring and stop the writer. Later
+   records are written as they are made */
+
+void stop_log_writer()
+{
+    if(!log_running)return;
+
+    if(log_stderr_stream!=NULL&&stderr==log_stderr_stream){
+       fflush(stderr);
+       stderr=log_stderr;
+    }
+
+    atomic_store_explicit(&log_async,0,memory_order_release);
+    log_running=0;
+    pthread_join(log_thread,NULL);
+
+    /* a record started just before log_async was cleared may still be
+       going into the ring; give it time, and wait for any slot claimed */
+
+    usleep(LOG_WRITER_USEC);
+
+    while(log_tail!=atomic_load_explicit(&log_head,memory_order_acquire)){
+       if(write_log_records()==0)usleep(1000);
+    }
+}
+
+/************************************************************/
+
+/* Set the level of subsystem (a name from log_subsystem_name, or "all")
+   to level (a name from log_level_name, or its number).
+   Return 0, or -1 if either is not recognized */
+
+int set_log_level(char *subsystem, char *level)
+{
+    int i,l;
+
+    if(sscanf(level,"%d",&l)==1){
+       if(l<LOG_LEVEL_FOLLOW)l=LOG_LEVEL_FOLLOW;
+       if(l>LOG_DEBUG)l=LOG_DEBUG;
+    }
+    else{
+       for(l=LOG_LEVEL_FOLLOW;l<=LOG_DEBUG&&strcmp(level,log_level_name[l])!=0;l++);
+       if(l>LOG_DEBUG){
+          fprintf(stderr,"set_log_level: unknown level %s\n",level);
+          fflush(stderr);
+          return(-1);
+       }
+    }
+
+    if(strcmp(subsystem,"all")==0){
+       for(i=0;i<NUM_LOG_SUBSYSTEMS;i++){
+          atomic_store_explicit(log_level+i,l,memory_order_relaxed);
+       }
+       return(0);
+    }
+
+    for(i=0;i<NUM_LOG_SUBSYSTEMS;i++){
+       if(strcmp(subsystem,log_subsystem_name[i])==0){
+          atomic_store_explicit(log_level+i,l,memory_order_relaxed);
+          return(0);
+       }
+    }
+
+    fprintf(stderr,"set_log_level: unknown subsystem %s\n",subsystem);
+    fflush(stderr);
+
+    return(-1);
+}
+
+/************************************************************/
+
+/* Set the levels listed in file_name (see above). Return the number
+   of levels set, or -1 if the file can't be read */
+
+int read_log_levels(char *file_name)
+{
+    FILE *input;
+    char string[STR_BUF_LEN],subsystem[STR_BUF_LEN],level[STR_BUF_LEN];
+    int n;
+
+    input=fopen(file_name,"r");
+    if(input==NULL)return(-1);
+
+    n=0;
+    while(fgets(string,STR_BUF_LEN,input)!=NULL){
+       if(string[0]=='#')continue;
+       if(sscanf(string,"%s %s",subsystem,level)!=2)continue;
+       if(set_log_level(subsystem,level)==0)n++;
+    }
+
+    fclose(input);
+
+    if(verbose){
+       fprintf(stderr,"read_log_levels: %d levels set from %s\n",n,file_name);
+       fflush(stderr);
+    }
+
+    return(n);
+}
+
+/************************************************************/
@@ -0,0 +1,51 @@
+#ifndef __scheduler_log_h
+#define __scheduler_log_h
+
+/* scheduler_log.h
+
+   Leveled logging for the scheduler hot paths (see scheduler_log.c).
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+enum Log_Subsystem {LOG_MAIN, LOG_SELECT, LOG_FIELDS, LOG_COMMAND, LOG_FITS,
+       NUM_LOG_SUBSYSTEMS};
+
+enum Log_Level {LOG_ERROR=1, LOG_INFO, LOG_VERBOSE, LOG_DEBUG};
+
+#define LOG_LEVEL_FOLLOW 0 /* subsystem level follows verbose and verbose1 */
+#define LOG_RING_SIZE 4096 /* records in the log ring buffer (a power of 2) */
+#define LOG_RECORD_LEN 512 /* longest record kept, including the newline */
+#define LOG_WRITER_USEC 20000 /* writer sleep with nothing to write */
+#define LOG_LEVEL_CHECK_SEC 1 /* how often the writer checks LOG_LEVEL_FILE */
+#define LOG_LEVEL_FILE "scheduler.loglevel" /* lines of "subsystem level" */
+
+extern int verbose;
+extern int verbose1;
+extern atomic_int log_level[NUM_LOG_SUBSYSTEMS];
+
+extern _Thread_local int log_quiet;
+
+#define LOG_LEVEL_OF(subsystem) atomic_load_explicit(log_level+(subsystem),memory_order_relaxed)
+
+/* true if records of level for subsystem are being kept by this thread
+   (none are while it sets log_quiet). Only this test happens when they
+   are not */
+
+#define LOG_ON(subsystem,level) (!log_quiet&&(level)<=(LOG_LEVEL_OF(subsystem)!=LOG_LEVEL_FOLLOW ? \
+       LOG_LEVEL_OF(subsystem) : (verbose1 ? LOG_DEBUG : (verbose ? LOG_VERBOSE : LOG_INFO))))
+
+void sched_log(int subsystem, int level, char *format, ...);
+
+int start_log_writer(FILE *output);
+
+void stop_log_writer();
+
+int set_log_level(char *subsystem, char *level);
+
+int read_log_levels(char *file_name);
+
+#endif
@@ -0,0 +1,222 @@
+/* scheduler_metrics.c
+
+   2026 Oct 14
+
+   Where the time of each observation goes.
+
+   An observation is timed from the start of the selection of its field
+   to the end of saving its record. begin_obs_metrics() starts the
+   clock in a phase, obs_phase() charges the time since the last call
+   to the phase then being timed and moves on to the next, and
+   end_obs_metrics() charges the last phase and writes a line for the
+   observation to METRICS_FILE:
+
+      field shutter n_exp jd expt select status slew focus header readout clear expose save other total
+
+   with expt the requested exposure time and the phases in seconds.
+   The same times are added to totals and to a histogram of each phase,
+   written by write_night_metrics() at the end of each night (and by
+   close_obs_metrics() for a night cut short) as lines starting with
+   "#", so the file can be read by any program that skips comments.
+   Until open_obs_metrics() is called (e.g. in the simulators), these
+   calls do nothing. Times are from get_unix_time(), so they follow the
+   clock the scheduler runs on.
+
+   The time between observations (waiting for a field to become ready,
+   or for the weather) is not part of any observation; the summary
+   gives it as the time since the file was opened (or the last summary)
+   less the time spent observing.
+*/
+
+#include "scheduler.h"
+
+static char *obs_phase_name[NUM_OBS_PHASES]={"select","status","slew","focus",
+       "header","readout","clear","expose","save","other"};
+
+static FILE *metrics_out=NULL;
+static Obs_Metrics obs_metrics; /* phase set to -1 by open_obs_metrics() */
+static Night_Metrics night_metrics;
+
+int open_obs_metrics(char *file_name);
+void write_night_metrics();
+void close_obs_metrics();
+void begin_obs_metrics(int phase);
+void obs_phase(int phase);
+void end_obs_metrics(int field_number, int shutter, int n_exposures,
+       double jd, double expt);
+
+/************************************************************/
+
+static double metrics_time()
+{
+    return(get_unix_time());
+}
+
+/************************************************************/
+
+/* Open file_name for the metrics of each observation to come.
+   Return 0, or -1 if it can't be opened */
+
+int open_obs_metrics(char *file_name)
+{
+    int i;
+
+    metrics_out=fopen(file_name,"a");
+    if(metrics_out==NULL){
+       fprintf(stderr,"open_obs_metrics: can't open file %s for output\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    memset((void *)&night_metrics,0,sizeof(Night_Metrics));
+    night_metrics.t_open=metrics_time();
+    obs_metrics.phase=-1;
+
+    fprintf(metrics_out,"# field shutter n_exp jd expt");
+    for(i=0;i<NUM_OBS_PHASES;i++)fprintf(metrics_out," %s",obs_phase_name[i]);
+    fprintf(metrics_out," total\n");
+    fflush(metrics_out);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Write the totals and histograms of the observations since
+   open_obs_metrics() or the last call, and start new ones */
+
+void write_night_metrics()
+{
+    Night_Metrics *n;
+    double t_night,bin;
+    int i,k;
+
+    if(metrics_out==NULL)return;
+
+    n=&night_metrics;
+    t_night=metrics_time()-n->t_open;
+
+    fprintf(metrics_out,
+      "# night: %d observations  %d exposures  %10.1f sec  observing %10.1f sec  between observations %10.1f sec\n",
+      n->n_obs,n->n_exposures,t_night,n->t_obs,t_night-n->t_obs);
+    if(n->t_obs>0.0){
+       fprintf(metrics_out,
+         "# night: exposing %10.1f sec  %6.2f %% of the time observing\n",
+         n->t_expose,100.0*n->t_expose/n->t_obs);
+    }
+
+    fprintf(metrics_out,"# phase  total_sec  mean_sec  max_sec\n");
+    for(i=0;i<NUM_OBS_PHASES;i++){
+       fprintf(metrics_out,"# %-8s %10.1f %9.3f %9.3f\n",obs_phase_name[i],
+         n->t_total[i],n->n_obs>0 ? n->t_total[i]/n->n_obs : 0.0,n->t_max[i]);
+    }
+
+    /* bin k counts phases up to METRICS_HIST_MIN_SEC*2^k sec. The
+       last bin counts all longer phases. Phases an observation did not
+       have are not counted */
+
+    fprintf(metrics_out,"# histogram bins (sec, upper edge):");
+    for(k=0,bin=METRICS_HIST_MIN_SEC;k<METRICS_HIST_BINS-1;k++,bin=bin*2.0){
+       fprintf(metrics_out," %.1f",bin);
+    }
+    fprintf(metrics_out," more\n");
+    for(i=0;i<NUM_OBS_PHASES;i++){
+       fprintf(metrics_out,"# hist %-8s",obs_phase_name[i]);
+       for(k=0;k<METRICS_HIST_BINS;k++)fprintf(metrics_out," %d",n->hist[i][k]);
+       fprintf(metrics_out,"\n");
+    }
+    fflush(metrics_out);
+
+    memset((void *)n,0,sizeof(Night_Metrics));
+    n->t_open=metrics_time();
+}
+
+/************************************************************/
+
+/* Write the totals of any observations not yet summed up by
+   write_night_metrics(), and close the file */
+
+void close_obs_metrics()
+{
+    if(metrics_out==NULL)return;
+
+    if(night_metrics.n_obs>0)write_night_metrics();
+
+    fclose(metrics_out);
+    metrics_out=NULL;
+}
+
+/************************************************************/
+
+/* start timing an observation in phase */
+
+void begin_obs_metrics(int phase)
+{
+    if(metrics_out==NULL)return;
+
+    memset((void *)&obs_metrics,0,sizeof(Obs_Metrics));
+    obs_metrics.t_start=metrics_time();
+    obs_metrics.t_phase=obs_metrics.t_start;
+    obs_metrics.phase=phase;
+}
+
+/************************************************************/
+
+/* charge the time since the last call to the phase being timed, and
+   time phase from now */
+
+void obs_phase(int phase)
+{
+    double t;
+
+    if(metrics_out==NULL||obs_metrics.phase<0)return;
+
+    t=metrics_time();
+    obs_metrics.t[obs_metrics.phase]+=t-obs_metrics.t_phase;
+    obs_metrics.t_phase=t;
+    obs_metrics.phase=phase;
+}
+
+/************************************************************/
+
+/* End the observation being timed, of n_exposures of field_number
+   with shutter code shutter, beginning at jd, with expt the total
+   requested exposure time (sec). Write its line and add it to
+   the totals */
+
+void end_obs_metrics(int field_number, int shutter, int n_exposures,
+       double jd, double expt)
+{
+    Night_Metrics *n;
+    double t_total,bin;
+    int i,k;
+
+    if(metrics_out==NULL||obs_metrics.phase<0)return;
+
+    obs_phase(PHASE_OTHER);
+    obs_metrics.phase=-1;
+
+    n=&night_metrics;
+    t_total=0.0;
+    for(i=0;i<NUM_OBS_PHASES;i++){
+       t_total+=obs_metrics.t[i];
+       n->t_total[i]+=obs_metrics.t[i];
+       if(obs_metrics.t[i]>n->t_max[i])n->t_max[i]=obs_metrics.t[i];
+
+       if(obs_metrics.t[i]<=0.0)continue;
+       for(k=0,bin=METRICS_HIST_MIN_SEC;k<METRICS_HIST_BINS-1&&obs_metrics.t[i]>bin;
+           k++,bin=bin*2.0);
+       n->hist[i][k]++;
+    }
+    n->n_obs++;
+    n->n_exposures+=n_exposures;
+    n->t_obs+=t_total;
+    n->t_expose+=expt;
+
+    fprintf(metrics_out,"%d %d %d %13.6f %7.1f",field_number,shutter,n_exposures,jd,expt);
+    for(i=0;i<NUM_OBS_PHASES;i++)fprintf(metrics_out," %8.3f",obs_metrics.t[i]);
+    fprintf(metrics_out," %8.3f\n",t_total);
+    fflush(metrics_out);
+}
+
+/************************************************************/
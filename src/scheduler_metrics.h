@@ -0,0 +1,61 @@
+#ifndef __scheduler_metrics_h
+#define __scheduler_metrics_h
+
+/* scheduler_metrics.h
+
+   Time spent in each phase of each observation (see scheduler_metrics.c).
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+
+/* the phases of an observation, in the order they usually happen.
+   Time in none of the others (e.g. bookkeeping between steps) is
+   charged to PHASE_OTHER, so the phases add up to the whole observation */
+
+enum Obs_Phase {PHASE_SELECT, PHASE_STATUS, PHASE_SLEW, PHASE_FOCUS,
+       PHASE_HEADER, PHASE_READOUT, PHASE_CLEAR, PHASE_EXPOSE, PHASE_SAVE,
+       PHASE_OTHER, NUM_OBS_PHASES};
+
+#define METRICS_FILE "scheduler.metrics" /* a line for each observation */
+#define METRICS_HIST_BINS 16 /* bins of each phase histogram */
+#define METRICS_HIST_MIN_SEC 0.1 /* top of the first bin. Each later bin is twice as wide */
+
+/* the observation being timed */
+
+typedef struct {
+    int phase; /* phase being timed, or -1 if not timing */
+    double t_phase; /* when it began (sec) */
+    double t_start; /* when the observation began (sec) */
+    double t[NUM_OBS_PHASES]; /* sec spent in each phase */
+} Obs_Metrics;
+
+/* all the observations since open_obs_metrics() or the last
+   write_night_metrics() */
+
+typedef struct {
+    int n_obs;
+    int n_exposures;
+    double t_open; /* when the metrics file was opened, or the last summary written (sec) */
+    double t_obs; /* sec spent observing */
+    double t_expose; /* requested exposure sec */
+    double t_total[NUM_OBS_PHASES];
+    double t_max[NUM_OBS_PHASES];
+    int hist[NUM_OBS_PHASES][METRICS_HIST_BINS];
+} Night_Metrics;
+
+int open_obs_metrics(char *file_name);
+
+void write_night_metrics();
+
+void close_obs_metrics();
+
+void begin_obs_metrics(int phase);
+
+void obs_phase(int phase);
+
+void end_obs_metrics(int field_number, int shutter, int n_exposures,
+       double jd, double expt);
+
+#endif
@@ -0,0 +1,247 @@
+/* scheduler_monitor.c
+
+   2026 Oct 14
+
+   Camera state monitor.
+
+   A dedicated thread keeps one connection to the camera controller's
+   STATUS_PORT (through the connection pool in socket.c) and queries the
+   controller status over it. Each reply is parsed as it arrives and
+   compared with the last one. Threads waiting for one of the
+   Controller_State flags (EXPOSING, READING, ...) to reach a value wait
+   on that flag's condition variable, which is signalled when the flag
+   changes, so an exposure end is seen within one query of it happening
+   rather than after a fixed sleep.
+
+   While nobody is waiting the monitor queries only every
+   MONITOR_IDLE_USEC. When a waiter arrives it wakes the monitor and the
+   queries run every MONITOR_BUSY_USEC until the wait is over, which is
+   no more often than the old polling loop queried.
+
+   stop_camera_monitor() ends the thread, before the connections are
+   closed at exit.
+*/
+
+#include "scheduler.h"
+#include <pthread.h>
+#include <sys/time.h>
+
+#define MONITOR_IDLE_USEC 1000000 /* query interval with no waiters */
+#define MONITOR_BUSY_USEC 100000  /* minimum query interval with waiters */
+
+extern int verbose;
+extern int verbose1;
+extern char *host_name;
+extern int command_id;
+
+static Camera_Status mon_status;
+static int mon_valid=0;      /* mon_status holds the latest good reply */
+static int mon_seq=0;        /* incremented after each query */
+static int mon_waiters=0;
+static int mon_in_query=0;   /* a query is in progress */
+static int mon_running=0;
+static pthread_t mon_thread;
+static pthread_mutex_t mon_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mon_wake=PTHREAD_COND_INITIALIZER;
+static pthread_cond_t mon_reply=PTHREAD_COND_INITIALIZER; /* after every query */
+static pthread_cond_t state_cond[NUM_STATES];
+
+int start_camera_monitor();
+int stop_camera_monitor();
+int wait_camera_state(int state, int value, int timeout_sec, Camera_Status *status);
+int get_monitored_camera_status(Camera_Status *status);
+
+/************************************************************/
+
+/* absolute system time usec microseconds from now on the scheduler's
+   clock (see clock_sleep()) */
+
+static void get_deadline(struct timespec *ts, long usec)
+{
+    struct timeval tv;
+
+    usec=(long)(usec/get_clock_speed());
+    gettimeofday(&tv,NULL);
+    usec=usec+tv.tv_usec;
+    ts->tv_sec=tv.tv_sec+usec/1000000;
+    ts->tv_nsec=(usec%1000000)*1000;
+}
+
+/************************************************************/
+
+static void *camera_monitor_thread(void *args)
+{
+    char reply[MAXBUFSIZE];
+    Camera_Status status;
+    struct timespec ts;
+    int i,result,id;
+
+    pthread_mutex_lock(&mon_mutex);
+    while(mon_running){
+       id=command_id++;
+       mon_in_query=1;
+       pthread_mutex_unlock(&mon_mutex);
+
+       result=do_status_command(STATUS_COMMAND,reply,CAMERA_TIMEOUT_SEC,id,host_name);
+       if(result==0)parse_status(reply,&status);
+
+       pthread_mutex_lock(&mon_mutex);
+
+       /* signal the waiters on every flag that changed. If the query
+          failed, wake them all so they can give up */
+
+       for(i=0;i<NUM_STATES;i++){
+          if(result!=0||!mon_valid||status.state_val[i]!=mon_status.state_val[i]){
+             pthread_cond_broadcast(state_cond+i);
+          }
+       }
+       if(result==0){
+          if(verbose1&&mon_valid&&
+             status.state_val[EXPOSING]!=mon_status.state_val[EXPOSING]){
+             fprintf(stderr,"camera_monitor_thread: time %12.6f : EXPOSING now %d\n",
+                get_ut(),status.state_val[EXPOSING]);
+             fflush(stderr);
+          }
+          mon_status=status;
+       }
+       mon_valid=(result==0);
+       mon_in_query=0;
+       mon_seq++;
+       pthread_cond_broadcast(&mon_reply);
+
+       get_deadline(&ts,mon_waiters>0 ? MONITOR_BUSY_USEC : MONITOR_IDLE_USEC);
+       while(mon_running&&pthread_cond_timedwait(&mon_wake,&mon_mutex,&ts)==0){
+          if(mon_waiters>0)get_deadline(&ts,MONITOR_BUSY_USEC);
+       }
+    }
+    pthread_mutex_unlock(&mon_mutex);
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* start the monitor thread, if it is not already running */
+
+int start_camera_monitor()
+{
+    int i;
+
+    pthread_mutex_lock(&mon_mutex);
+    if(mon_running){
+       pthread_mutex_unlock(&mon_mutex);
+       return(0);
+    }
+
+    for(i=0;i<NUM_STATES;i++)pthread_cond_init(state_cond+i,NULL);
+    mon_running=1;
+    if(pthread_create(&mon_thread,NULL,camera_monitor_thread,NULL)!=0){
+       fprintf(stderr,"start_camera_monitor: can't start monitor thread\n");
+       fflush(stderr);
+       mon_running=0;
+       pthread_mutex_unlock(&mon_mutex);
+       return(-1);
+    }
+    pthread_mutex_unlock(&mon_mutex);
+
+    if(verbose){
+       fprintf(stderr,"start_camera_monitor: monitoring camera status on port %d\n",
+          STATUS_PORT);
+       fflush(stderr);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* stop the monitor thread, if it is running, and wait for it to end.
+   Waiters are woken, and give up since the status is no longer valid */
+
+int stop_camera_monitor()
+{
+    int i;
+
+    pthread_mutex_lock(&mon_mutex);
+    if(!mon_running){
+       pthread_mutex_unlock(&mon_mutex);
+       return(0);
+    }
+    mon_running=0;
+    pthread_cond_signal(&mon_wake);
+    pthread_mutex_unlock(&mon_mutex);
+
+    pthread_join(mon_thread,NULL);
+
+    pthread_mutex_lock(&mon_mutex);
+    mon_valid=0;
+    mon_seq++;
+    pthread_cond_broadcast(&mon_reply);
+    for(i=0;i<NUM_STATES;i++)pthread_cond_broadcast(state_cond+i);
+    pthread_mutex_unlock(&mon_mutex);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Wait up to timeout_sec for state_val[state] to equal value in a
+   status reply received after this call. Fill in status (if not NULL)
+   with that reply. Return 0 on success, -1 on timeout or if the status
+   can't be read */
+
+int wait_camera_state(int state, int value, int timeout_sec, Camera_Status *status)
+{
+    struct timespec ts;
+    int seq_needed,result;
+
+    if(state<0||state>=NUM_STATES||!mon_running)return(-1);
+
+    get_deadline(&ts,timeout_sec*1000000L);
+    result=-1;
+
+    pthread_mutex_lock(&mon_mutex);
+    mon_waiters++;
+    pthread_cond_signal(&mon_wake);
+
+    /* don't trust a reply that may predate the call */
+
+    seq_needed=mon_seq+(mon_in_query ? 2 : 1);
+    while(mon_seq<seq_needed){
+       if(pthread_cond_timedwait(&mon_reply,&mon_mutex,&ts)!=0)break;
+    }
+
+    while(mon_seq>=seq_needed){
+       if(!mon_valid)break;
+       if(mon_status.state_val[state]==value){
+          result=0;
+          break;
+       }
+       if(pthread_cond_timedwait(state_cond+state,&mon_mutex,&ts)!=0)break;
+    }
+
+    if(status!=NULL)*status=mon_status;
+    mon_waiters--;
+    pthread_mutex_unlock(&mon_mutex);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* copy the latest status seen by the monitor into status. Return -1 if
+   the monitor is not running or the last query failed */
+
+int get_monitored_camera_status(Camera_Status *status)
+{
+    int valid;
+
+    pthread_mutex_lock(&mon_mutex);
+    valid=mon_running&&mon_valid;
+    if(valid)*status=mon_status;
+    pthread_mutex_unlock(&mon_mutex);
+
+    return(valid ? 0 : -1);
+}
+
+/************************************************************/
@@ -0,0 +1,318 @@
+/* scheduler_overhead.c
+
+   2026 Oct 14
+
+   The time an observation takes beyond its exposure time.
+
+   The time charged for an observation (the virtual hardware, the
+   lookahead planner) and the time a field needs to finish its observations (init_fields()
+   and update_field_status()) were fixed: EXPOSURE_OVERHEAD for each
+   exposure and FOCUS_OVERHEAD for a focus field. Here they come from
+   overhead_model, which init_overhead_model() sets to those constants
+   (each program does at startup), and which can be fitted
+   from the METRICS_FILE of past nights (see scheduler_metrics.c) with
+   fit_overhead_model(), written with write_overhead_model(), and read
+   at startup from OVERHEAD_MODEL_FILE with load_overhead_model().
+
+   For each line of a metrics file, the time beyond the exposure time,
+   the focus phase and the part of the slew phase not hidden by the
+   readout of the last exposure (what slew_overhead() predicts from the
+   slew distance), divided by the number of exposures, is an estimate
+   of the overhead of one exposure for that shutter code. The model
+   keeps the median for each shutter code, and the median focus phase
+   of focus fields, wherever there are OVERHEAD_MIN_FIT observations to
+   fit; any other term keeps its default. The model file has a line
+   for each term:
+
+      exposure shutter_code sec n_fit
+      focus sec n_fit
+
+   with "#" lines for comments.
+*/
+
+#include "scheduler.h"
+
+#define OVERHEAD_DEFAULT_SEC (EXPOSURE_OVERHEAD*3600.0)
+
+Overhead_Model overhead_model;
+
+/* the estimates of one term, for its median */
+
+typedef struct {
+    int n;
+    int max;
+    double *t;
+} Overhead_Samples;
+
+void init_overhead_model(Overhead_Model *m);
+int load_overhead_model(char *file_name, Overhead_Model *m);
+int write_overhead_model(FILE *output, Overhead_Model *m);
+int fit_overhead_model(int n_files, char **file_names, Overhead_Model *m);
+double exposure_overhead(int shutter);
+double focus_overhead();
+int count_exposures(double expt);
+double execution_time(int shutter, double expt);
+
+/************************************************************/
+
+/* set m to the fixed overheads */
+
+void init_overhead_model(Overhead_Model *m)
+{
+    int i;
+
+    memset((void *)m,0,sizeof(Overhead_Model));
+    for(i=0;i<NUM_OVERHEAD_SHUTTERS;i++)m->exposure_sec[i]=OVERHEAD_DEFAULT_SEC;
+    m->focus_sec=FOCUS_OVERHEAD*3600.0;
+}
+
+/************************************************************/
+
+/* Read m from file_name (see above), starting from the defaults.
+   Return the number of terms read, or -1 if the file can't be read */
+
+int load_overhead_model(char *file_name, Overhead_Model *m)
+{
+    FILE *input;
+    char string[STR_BUF_LEN],term[STR_BUF_LEN];
+    double t;
+    int shutter,n_fit,n;
+
+    input=fopen(file_name,"r");
+    if(input==NULL)return(-1);
+
+    init_overhead_model(m);
+
+    n=0;
+    while(fgets(string,STR_BUF_LEN,input)!=NULL){
+       if(string[0]=='#'||sscanf(string,"%s",term)!=1)continue;
+       if(strcmp(term,"exposure")==0&&
+             sscanf(string,"%s %d %lf %d",term,&shutter,&t,&n_fit)==4&&
+             shutter>=0&&shutter<NUM_OVERHEAD_SHUTTERS&&t>=0.0){
+          m->exposure_sec[shutter]=t;
+          m->n_exposure[shutter]=n_fit;
+          m->n_fit+=n_fit;
+          n++;
+       }
+       else if(strcmp(term,"focus")==0&&
+             sscanf(string,"%s %lf %d",term,&t,&n_fit)==3&&t>=0.0){
+          m->focus_sec=t;
+          m->n_focus=n_fit;
+          n++;
+       }
+       else{
+          fprintf(stderr,"load_overhead_model: skipping line of %s: %s",file_name,string);
+          fflush(stderr);
+       }
+    }
+
+    fclose(input);
+
+    if(verbose){
+       fprintf(stderr,"load_overhead_model: %d terms read from %s\n",n,file_name);
+       fflush(stderr);
+    }
+
+    return(n);
+}
+
+/************************************************************/
+
+/* write m to output in the form load_overhead_model() reads */
+
+int write_overhead_model(FILE *output, Overhead_Model *m)
+{
+    int i;
+
+    fprintf(output,"# overhead model fitted from %d observations\n",m->n_fit);
+    fprintf(output,"# exposure shutter_code sec n_fit\n");
+    for(i=0;i<NUM_OVERHEAD_SHUTTERS;i++){
+       fprintf(output,"exposure %d %8.3f %d\n",i,m->exposure_sec[i],m->n_exposure[i]);
+    }
+    fprintf(output,"# focus sec n_fit\n");
+    fprintf(output,"focus %8.3f %d\n",m->focus_sec,m->n_focus);
+    fflush(output);
+
+    return(0);
+}
+
+/************************************************************/
+
+static int add_overhead_sample(Overhead_Samples *s, double t)
+{
+    double *p;
+
+    if(s->n==s->max){
+       s->max=(s->max==0) ? 256 : 2*s->max;
+       p=(double *)realloc(s->t,s->max*sizeof(double));
+       if(p==NULL){
+          fprintf(stderr,"add_overhead_sample: can't allocate %d samples\n",s->max);
+          fflush(stderr);
+          return(-1);
+       }
+       s->t=p;
+    }
+    s->t[s->n++]=t;
+
+    return(0);
+}
+
+/************************************************************/
+
+static int compare_overhead_samples(const void *a, const void *b)
+{
+    double d;
+
+    d=*(double *)a-*(double *)b;
+
+    return(d<0.0 ? -1 : (d>0.0 ? 1 : 0));
+}
+
+/************************************************************/
+
+/* set *t to the median of s if there are enough samples to fit.
+   Return the number of samples */
+
+static int overhead_median(Overhead_Samples *s, double *t)
+{
+    if(s->n<OVERHEAD_MIN_FIT)return(s->n);
+
+    qsort((void *)s->t,s->n,sizeof(double),compare_overhead_samples);
+    *t=(s->n%2==1) ? s->t[s->n/2] : 0.5*(s->t[s->n/2-1]+s->t[s->n/2]);
+
+    return(s->n);
+}
+
+/************************************************************/
+
+/* Fit m to the observations in the n_files metrics files file_names
+   (see above). Return the number of observations fitted, or -1 on error */
+
+int fit_overhead_model(int n_files, char **file_names, Overhead_Model *m)
+{
+    FILE *input;
+    Overhead_Samples exposure[NUM_OVERHEAD_SHUTTERS],focus;
+    char string[STR_BUF_LEN];
+    double jd,expt,t[NUM_OBS_PHASES],total,t_exp,t_slew;
+    int i,k,field_number,shutter,n_exp,n,error;
+
+    init_overhead_model(m);
+    memset((void *)exposure,0,sizeof(exposure));
+    memset((void *)&focus,0,sizeof(focus));
+
+    n=0;
+    error=0;
+    for(k=0;k<n_files&&!error;k++){
+       input=fopen(file_names[k],"r");
+       if(input==NULL){
+          fprintf(stderr,"fit_overhead_model: can't open file %s\n",file_names[k]);
+          fflush(stderr);
+          error=1;
+          break;
+       }
+
+       /* field shutter n_exp jd expt select status slew focus header readout
+          clear expose save other total */
+
+       while(fgets(string,STR_BUF_LEN,input)!=NULL){
+          if(string[0]=='#')continue;
+          if(sscanf(string,"%d %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+                &field_number,&shutter,&n_exp,&jd,&expt,&t[PHASE_SELECT],&t[PHASE_STATUS],
+                &t[PHASE_SLEW],&t[PHASE_FOCUS],&t[PHASE_HEADER],&t[PHASE_READOUT],
+                &t[PHASE_CLEAR],&t[PHASE_EXPOSE],&t[PHASE_SAVE],&t[PHASE_OTHER],&total)!=16)continue;
+          if(shutter<0||shutter>=NUM_OVERHEAD_SHUTTERS||n_exp<1)continue;
+
+          /* the slew overlaps the readout of the exposure before it, as
+             in slew_overhead() */
+
+          t_slew=t[PHASE_SLEW]-READOUT_TIME_SEC;
+          if(t_slew<0.0)t_slew=0.0;
+
+          t_exp=(total-expt-t_slew-t[PHASE_FOCUS])/n_exp;
+          if(t_exp<0.0)continue;
+
+          if(add_overhead_sample(exposure+shutter,t_exp)!=0){
+             error=1;
+             break;
+          }
+          if(shutter==FOCUS_CODE&&add_overhead_sample(&focus,t[PHASE_FOCUS])!=0){
+             error=1;
+             break;
+          }
+          n++;
+       }
+
+       fclose(input);
+    }
+
+    if(!error){
+       for(i=0;i<NUM_OVERHEAD_SHUTTERS;i++){
+          m->n_exposure[i]=overhead_median(exposure+i,m->exposure_sec+i);
+          if(m->n_exposure[i]<OVERHEAD_MIN_FIT)m->n_exposure[i]=0;
+       }
+       m->n_focus=overhead_median(&focus,&(m->focus_sec));
+       if(m->n_focus<OVERHEAD_MIN_FIT)m->n_focus=0;
+       m->n_fit=n;
+    }
+
+    for(i=0;i<NUM_OVERHEAD_SHUTTERS;i++){
+       if(exposure[i].t!=NULL)free(exposure[i].t);
+    }
+    if(focus.t!=NULL)free(focus.t);
+
+    return(error ? -1 : n);
+}
+
+/************************************************************/
+
+/* time (hours) an exposure with shutter code shutter takes beyond its
+   exposure time */
+
+double exposure_overhead(int shutter)
+{
+    if(shutter<0||shutter>=NUM_OVERHEAD_SHUTTERS)return(EXPOSURE_OVERHEAD);
+
+    return(overhead_model.exposure_sec[shutter]/3600.0);
+}
+
+/************************************************************/
+
+/* time (hours) to focus for a focus field */
+
+double focus_overhead()
+{
+    return(overhead_model.focus_sec/3600.0);
+}
+
+/************************************************************/
+
+/* the number of exposures an exposure of expt (hours) may have to be
+   split into (in the west, see observe_next_field()) */
+
+int count_exposures(double expt)
+{
+    int n;
+
+    if(expt<=LONG_EXPTIME)return(1);
+
+    n=expt/LONG_EXPTIME;
+
+    return(n+1);
+}
+
+/************************************************************/
+
+/* time (hours) to observe a field with shutter code shutter and
+   exposure time expt (hours) once, not counting the slew to it */
+
+double execution_time(int shutter, double expt)
+{
+    double t;
+
+    t=expt+count_exposures(expt)*exposure_overhead(shutter);
+    if(shutter==FOCUS_CODE)t=t+focus_overhead();
+
+    return(t);
+}
+
+/************************************************************/
@@ -0,0 +1,42 @@
+#ifndef __scheduler_overhead_h
+#define __scheduler_overhead_h
+
+/* scheduler_overhead.h
+
+   The time an observation takes beyond its exposure time, fitted from
+   the phase timings of past observations (see scheduler_overhead.c).
+
+   2026 Oct 14
+*/
+
+#define OVERHEAD_MODEL_FILE "scheduler.overhead" /* model read at startup */
+#define NUM_OVERHEAD_SHUTTERS 8 /* shutter codes DARK_CODE to LIGO_CODE */
+#define OVERHEAD_MIN_FIT 5 /* fewest observations to fit a term from  */
+
+typedef struct {
+    int n_fit; /* observations the model was fitted from, 0 for the defaults */
+    double exposure_sec[NUM_OVERHEAD_SHUTTERS]; /* per exposure, by shutter code */
+    int n_exposure[NUM_OVERHEAD_SHUTTERS]; /* observations each was fitted from */
+    double focus_sec; /* added for a focus field */
+    int n_focus;
+} Overhead_Model;
+
+extern Overhead_Model overhead_model;
+
+void init_overhead_model(Overhead_Model *m);
+
+int load_overhead_model(char *file_name, Overhead_Model *m);
+
+int write_overhead_model(FILE *output, Overhead_Model *m);
+
+int fit_overhead_model(int n_files, char **file_names, Overhead_Model *m);
+
+double exposure_overhead(int shutter);
+
+double focus_overhead();
+
+int count_exposures(double expt);
+
+double execution_time(int shutter, double expt);
+
+#endif
@@ -0,0 +1,444 @@
+/* scheduler_plan.c
+
+   2026 Oct 14
+
+   Lookahead check of the field chosen by get_next_field() or
+   select_next_field() (LOOKAHEAD_PLANNING in scheduler.h).
+
+   The greedy selection looks only at the current jd. It will, for
+   instance, start a pair whose second field can't be observed before
+   morning twilight when another field would have used the time. When
+   the greedy choice is a free one (the ready or late field with the
+   least or most time left, not a must-do, do-now or paired field),
+   plan_next_field() plays the night forward from the greedy choice and
+   from the LOOKAHEAD_BEAM-1 other ready fields with least time left,
+   using the same selection rules (get_next_field()) on copies of the
+   sequence. This is a beam search: at each of LOOKAHEAD_DEPTH steps,
+   every branch kept is extended with the greedy choice and up to
+   LOOKAHEAD_BRANCH-1 alternatives, and the LOOKAHEAD_BEAM best
+   branches are kept. A branch scores the exposure time it observes and
+   LOOKAHEAD_PAIR_BONUS for each pair it completes, less the slew time
+   beyond the readout, the time spent with nothing to observe, and
+   LOOKAHEAD_STRAND_PENALTY for each pair it starts that can no longer
+   be completed. The first field of the best branch is returned.
+
+   The branches of each step are extended by LOOKAHEAD_THREADS threads.
+   If the search takes longer than LOOKAHEAD_BUDGET_SEC, it stops with
+   the branches of the last step completed, so the decision still fits
+   within the readout of the last exposure.
+*/
+
+#include "scheduler.h"
+#include <pthread.h>
+#include <sys/time.h>
+
+/* candidates kept per branch (the first step tries LOOKAHEAD_BEAM) */
+#define MAX_CAND (LOOKAHEAD_BEAM>LOOKAHEAD_BRANCH ? LOOKAHEAD_BEAM : LOOKAHEAD_BRANCH)
+
+extern int verbose;
+extern int verbose1;
+
+typedef struct {
+    Field *fields;  /* copy of the sequence, as played forward */
+    int first;      /* field chosen at the first step */
+    int i_prev;     /* last field observed */
+    double jd;
+    int ended;      /* reached jd_end */
+    int n_obs;
+    int obs[LOOKAHEAD_DEPTH]; /* fields observed */
+    int n_pairs;    /* pairs completed */
+    double expt;    /* exposure time observed (hours) */
+    double slew;    /* slew time beyond the readouts (hours) */
+    double dead;    /* time with nothing to observe (hours) */
+    double score;
+    int n_cand;     /* fields to try next */
+    int cand[MAX_CAND];
+    int valid;
+} Plan_State;
+
+typedef struct {
+    Plan_State *parent;
+    int cand;       /* index into parent->cand */
+    Plan_State *child;
+} Plan_Job;
+
+typedef struct {
+    Plan_Job *jobs;
+    int n_jobs;
+    int next_job;
+    int num_fields;
+    int bad_weather;
+    double jd_end;
+    double t_deadline;
+    pthread_mutex_t mutex;
+} Plan_Work;
+
+int plan_next_field(Field *sequence, int num_fields, int i_prev, double jd,
+        int bad_weather, int i_greedy, double jd_end);
+
+/************************************************************/
+
+static double wall_time()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv,NULL);
+
+    return(tv.tv_sec+tv.tv_usec*1.0e-6);
+}
+
+/************************************************************/
+
+/* selection codes of greedy choices that another field may replace */
+
+static int free_choice(enum Selection_Code code)
+{
+    return(code==LEAST_TIME_READY||code==MOST_TIME_READY_LATE);
+}
+
+/************************************************************/
+
+/* Fill cand[] with choice i_greedy and, if it is a free choice, the
+   other READY fields of fields with the least time_left, up to
+   max_cand in all. The statuses must be up to date. Return the number
+   of candidates */
+
+static int get_candidates(Field *fields, int num_fields, int i_greedy,
+        int *cand, int max_cand)
+{
+    Field *f;
+    int i,j,k,n;
+
+    cand[0]=i_greedy;
+    n=1;
+    if(i_greedy<0||!free_choice(fields[i_greedy].selection_code))return(n);
+
+    /* insertion into cand[1..n-1], by time_left then index */
+
+    for(i=0;i<num_fields;i++){
+       f=fields+i;
+       if(i==i_greedy||f->status!=READY_STATUS)continue;
+       for(k=n;k>1;k--){
+          if(fields[cand[k-1]].time_left<=f->time_left)break;
+       }
+       if(k>=max_cand)continue;
+       if(n<max_cand)n++;
+       for(j=n-1;j>k;j--)cand[j]=cand[j-1];
+       cand[k]=i;
+    }
+
+    return(n);
+}
+
+/************************************************************/
+
+/* score of a branch, counting the pairs it started whose second field
+   can no longer be observed */
+
+static double score_state(Plan_State *s, int num_fields, int bad_weather)
+{
+    Field *f,*f2;
+    int k,i,n_stranded;
+
+    n_stranded=0;
+    for(k=0;k<s->n_obs;k++){
+       i=s->obs[k];
+       if(i+1>=num_fields)continue;
+       f=s->fields+i;
+       f2=s->fields+i+1;
+       if(!paired_fields(f2,f)||f2->n_done>=f->n_done)continue;
+       update_field_status(f2,s->jd,bad_weather);
+       if(f2->doable==0||s->ended)n_stranded++;
+    }
+
+    return(s->expt+LOOKAHEAD_PAIR_BONUS*s->n_pairs-s->slew-s->dead-
+            LOOKAHEAD_STRAND_PENALTY*n_stranded);
+}
+
+/************************************************************/
+
+/* child is parent after observing field i (or waiting if i < 0), with
+   its candidates for the next step */
+
+static void extend_state(Plan_Work *w, Plan_State *parent, int i,
+        Plan_State *child)
+{
+    Field *f,*fields;
+    Field *save;
+    double dt;
+    int g;
+
+    /* keep child's buffer while copying parent's scalars */
+    save=child->fields;
+    *child=*parent;
+    child->fields=save;
+    fields=child->fields;
+    memcpy((void *)fields,(void *)parent->fields,w->num_fields*sizeof(Field));
+
+    if(!child->ended){
+       if(i<0){
+          child->dead=child->dead+LOOKAHEAD_WAIT_TIME;
+          child->jd=child->jd+(LOOKAHEAD_WAIT_TIME/24.0);
+       }
+       else{
+          f=fields+i;
+          dt=f->expt+exposure_overhead(f->shutter);
+          if(child->i_prev>=0){
+             dt=dt+slew_overhead(fields[child->i_prev].ra,fields[child->i_prev].dec,
+                  f->ra,f->dec);
+             child->slew=child->slew+slew_overhead(fields[child->i_prev].ra,
+                  fields[child->i_prev].dec,f->ra,f->dec);
+          }
+          f->n_done=f->n_done+1;
+          f->jd_next=child->jd+(f->interval/24.0);
+          child->expt=child->expt+f->expt;
+          if(i>0&&paired_fields(f,fields+i-1)&&f->n_done==fields[i-1].n_done){
+             child->n_pairs++;
+          }
+          if(child->n_obs<LOOKAHEAD_DEPTH)child->obs[child->n_obs++]=i;
+          child->i_prev=i;
+          child->jd=child->jd+(dt/24.0);
+       }
+       if(child->jd>=w->jd_end)child->ended=1;
+    }
+
+    if(child->ended){
+       child->n_cand=1;
+       child->cand[0]=-1;
+    }
+    else{
+       g=get_next_field(fields,w->num_fields,child->i_prev,child->jd,w->bad_weather);
+       child->n_cand=get_candidates(fields,w->num_fields,g,child->cand,LOOKAHEAD_BRANCH);
+    }
+
+    child->score=score_state(child,w->num_fields,w->bad_weather);
+    child->valid=1;
+}
+
+/************************************************************/
+
+static void *plan_thread(void *args)
+{
+    Plan_Work *w;
+    Plan_Job *job;
+    int n;
+
+    w=(Plan_Work *)args;
+
+    /* the selection rules played on the branches log nothing */
+
+    log_quiet=1;
+
+    while(1){
+       pthread_mutex_lock(&(w->mutex));
+       n=w->next_job++;
+       pthread_mutex_unlock(&(w->mutex));
+       if(n>=w->n_jobs)break;
+
+       job=w->jobs+n;
+       if(wall_time()>w->t_deadline){
+          job->child->valid=0;
+          continue;
+       }
+       extend_state(w,job->parent,job->parent->cand[job->cand],job->child);
+    }
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* run the jobs of one step on LOOKAHEAD_THREADS threads. Return 0 if
+   all were done in time, -1 if not */
+
+static int run_jobs(Plan_Work *w)
+{
+    pthread_t threads[LOOKAHEAD_THREADS];
+    int created[LOOKAHEAD_THREADS];
+    int k,n;
+
+    w->next_job=0;
+    n=LOOKAHEAD_THREADS<w->n_jobs ? LOOKAHEAD_THREADS : w->n_jobs;
+
+    for(k=0;k<n;k++){
+       created[k]=(pthread_create(threads+k,NULL,plan_thread,(void *)w)==0);
+    }
+
+    /* if no thread could be started, do the work here */
+
+    for(k=0;k<n&&!created[k];k++);
+    if(k==n)plan_thread((void *)w);
+
+    for(k=0;k<n;k++){
+       if(created[k])pthread_join(threads[k],NULL);
+    }
+
+    for(k=0;k<w->n_jobs;k++){
+       if(!w->jobs[k].child->valid)return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* order states by decreasing score, then by first field */
+
+static int compare_states(const void *a, const void *b)
+{
+    Plan_State *s1,*s2;
+
+    s1=*(Plan_State **)a;
+    s2=*(Plan_State **)b;
+
+    if(s1->valid!=s2->valid)return(s1->valid ? -1 : 1);
+    if(s1->score>s2->score)return(-1);
+    if(s1->score<s2->score)return(1);
+    if(s1->first!=s2->first)return(s1->first<s2->first ? -1 : 1);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return the field to observe next: i_greedy, chosen at jd by
+   get_next_field() or select_next_field(), or the first field of a
+   better sequence of LOOKAHEAD_DEPTH observations ending by jd_end.
+   sequence is not changed */
+
+int plan_next_field(Field *sequence, int num_fields, int i_prev, double jd,
+        int bad_weather, int i_greedy, double jd_end)
+{
+    Plan_State *states,root,*s;
+    Plan_State *beam[LOOKAHEAD_BEAM],*next[LOOKAHEAD_BEAM*LOOKAHEAD_BRANCH];
+    Plan_Job jobs[LOOKAHEAD_BEAM*LOOKAHEAD_BRANCH];
+    Plan_Work w;
+    Field *buf;
+    int n_states,n_beam,n_next,depth,k,c,i_best,i,timed_out;
+    int save_quiet;
+    double t_start;
+
+    if(i_greedy<0||!free_choice(sequence[i_greedy].selection_code))return(i_greedy);
+
+    t_start=wall_time();
+
+    /* one field buffer for the root, the beam, and the next step */
+
+    n_states=1+LOOKAHEAD_BEAM+LOOKAHEAD_BEAM*LOOKAHEAD_BRANCH;
+    states=(Plan_State *)calloc(n_states,sizeof(Plan_State));
+    buf=(Field *)malloc((size_t)n_states*num_fields*sizeof(Field));
+    if(states==NULL||buf==NULL){
+       fprintf(stderr,"plan_next_field: can't allocate %d copies of %d fields\n",
+          n_states,num_fields);
+       fflush(stderr);
+       if(states!=NULL)free(states);
+       if(buf!=NULL)free(buf);
+       return(i_greedy);
+    }
+    for(k=0;k<n_states;k++)states[k].fields=buf+(size_t)k*num_fields;
+
+    /* the selection rules log their progress. Quiet them in this
+       thread while the branches are played (the planner threads quiet
+       themselves), leaving verbose and verbose1 to the other threads */
+
+    save_quiet=log_quiet;
+    log_quiet=1;
+
+    /* root: the present, with the greedy choice and the alternatives
+       to it */
+
+    memset((void *)&root,0,sizeof(Plan_State));
+    root.fields=states[0].fields;
+    memcpy((void *)root.fields,(void *)sequence,num_fields*sizeof(Field));
+    for(i=0;i<num_fields;i++)update_field_status(root.fields+i,jd,bad_weather);
+    root.i_prev=i_prev;
+    root.jd=jd;
+    root.n_cand=get_candidates(root.fields,num_fields,i_greedy,root.cand,LOOKAHEAD_BEAM);
+
+    w.jobs=jobs;
+    w.num_fields=num_fields;
+    w.bad_weather=bad_weather;
+    w.jd_end=jd_end;
+    w.t_deadline=t_start+LOOKAHEAD_BUDGET_SEC;
+    pthread_mutex_init(&(w.mutex),NULL);
+
+    /* beam[] and next[] use states[1..] */
+
+    for(k=0;k<root.n_cand;k++){
+       jobs[k].parent=&root;
+       jobs[k].cand=k;
+       jobs[k].child=states+1+k;
+       next[k]=states+1+k;
+    }
+    w.n_jobs=root.n_cand;
+    n_next=root.n_cand;
+    timed_out=(run_jobs(&w)!=0);
+    for(k=0;k<n_next;k++)next[k]->first=root.cand[k];
+
+    qsort((void *)next,n_next,sizeof(Plan_State *),compare_states);
+    n_beam=0;
+    for(k=0;k<n_next&&n_beam<LOOKAHEAD_BEAM;k++){
+       if(next[k]->valid)beam[n_beam++]=next[k];
+    }
+
+    for(depth=2;depth<=LOOKAHEAD_DEPTH&&!timed_out&&n_beam>0;depth++){
+
+       /* children go in the buffers not holding the beam */
+
+       n_next=0;
+       for(k=1;k<n_states&&n_next<LOOKAHEAD_BEAM*LOOKAHEAD_BRANCH;k++){
+          s=states+k;
+          for(c=0;c<n_beam&&beam[c]!=s;c++);
+          if(c<n_beam)continue;
+          next[n_next++]=s;
+       }
+
+       w.n_jobs=0;
+       for(k=0;k<n_beam;k++){
+          for(c=0;c<beam[k]->n_cand;c++){
+             jobs[w.n_jobs].parent=beam[k];
+             jobs[w.n_jobs].cand=c;
+             jobs[w.n_jobs].child=next[w.n_jobs];
+             w.n_jobs++;
+          }
+       }
+       if(run_jobs(&w)!=0){
+          /* keep the last complete step */
+          timed_out=1;
+          break;
+       }
+
+       n_next=w.n_jobs;
+       qsort((void *)next,n_next,sizeof(Plan_State *),compare_states);
+       n_beam=0;
+       for(k=0;k<n_next&&n_beam<LOOKAHEAD_BEAM;k++){
+          beam[n_beam++]=next[k];
+       }
+    }
+
+    log_quiet=save_quiet;
+    pthread_mutex_destroy(&(w.mutex));
+
+    i_best=(n_beam>0) ? beam[0]->first : i_greedy;
+
+    if(verbose){
+       fprintf(stderr,
+         "plan_next_field: greedy choice %d, planned choice %d (score %8.5f) after %d steps in %6.3f sec%s\n",
+         i_greedy,i_best,n_beam>0 ? beam[0]->score : 0.0,depth-1,
+         wall_time()-t_start,timed_out ? " (out of time)" : "");
+       fflush(stderr);
+    }
+
+    /* selection_code of the planned field, as it would be chosen now */
+
+    if(i_best!=i_greedy&&i_best>=0){
+       sequence[i_best].selection_code=sequence[i_greedy].selection_code;
+    }
+
+    free(buf);
+    free(states);
+
+    return(i_best);
+}
+
+/************************************************************/
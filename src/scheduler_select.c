@@ -0,0 +1,880 @@
+/* scheduler_select.c
+
+   2026 Oct 14
+
+   Event-driven version of get_next_field().
+
+   get_next_field() calls update_field_status() on every field each time
+   it is called, and then makes several passes over the sequence to find
+   the candidates for each selection rule. The status of a field only
+   changes at a few known times, however: when it rises (jd_rise), when
+   it is next due (jd_next), when it sets (jd_set), and when its
+   time_left crosses zero. Otherwise it changes only when it is
+   observed, or when the bad_weather flag changes for flats, focus and
+   offset fields.
+
+   select_next_field() keeps each field in a min-heap of events keyed on
+   the next of these times, and re-evaluates only the fields whose event
+   has passed, the fields changed by the caller (touch_field()), and
+   the weather-dependent fields when bad_weather changes. Each field is
+   also kept in heaps for its selection bucket:
+
+     READY must-do fields, by n_left (and those with n_required==6)
+     other READY fields, by n_left
+
+   with a heap for each n_left, allocated as larger values are seen.
+     TOO_LATE fields, and TOO_LATE must-do fields
+     DO_NOW fields, and DO_NOW darks and flats
+
+   The READY and TOO_LATE heaps are keyed on the jd at which the field
+   becomes late, jd_set-time_required/24. Since time_left is
+   24*(that jd - current jd), the order by this key does not change with
+   time, and the field with the least time_left is at the top. The heap
+   tops are checked against time_left recomputed at the current jd, so
+   that the selection, tie-breaks included, is the same as
+   get_next_field().
+
+   Among READY fields whose time_left is within SLEW_TIE_TIME of the
+   least, the one nearest the previous field (least slew time) is
+   chosen. These are the fields with keys within SLEW_TIE_TIME/24 of the
+   top. If there are only a few they are compared one by one, otherwise
+   the nearest is found with the sky grid (scheduler_slew.c).
+*/
+
+#include "scheduler.h"
+
+/* re-evaluate fields this long (days) before their status is due to
+   change, to allow for round off in the status tests */
+#define EVENT_MARGIN 1.0e-6
+
+/* heap keys (days) within this of the top are checked against the
+   current time_left */
+#define KEY_TOLERANCE 1.0e-6
+
+/* slots in which a field may be held in a heap. Heap elements are
+   encoded as NUM_SLOTS*index+slot */
+#define NUM_SLOTS SELECTOR_SLOTS
+#define BUCKET_SLOT 0 /* ready[], ready_must_do[], late, or do_now */
+#define SUBSET_SLOT 1 /* ready_must_do_6, late_must_do, do_now_dark or do_now_flat */
+#define EVENT_SLOT 2 /* events */
+
+extern int verbose;
+extern int verbose1;
+
+int init_field_selector(Field_Selector *sel);
+int free_field_selector(Field_Selector *sel);
+int touch_field(Field_Selector *sel, int index);
+int select_next_field(Field_Selector *sel, Field *sequence, int num_fields,
+        int i_prev, double jd, int bad_weather);
+
+/************************************************************/
+
+static int heap_less(Field_Heap *h, int a, int b)
+{
+    if(h->key[a]<h->key[b])return(1);
+    if(h->key[a]>h->key[b])return(0);
+    return(h->elem[a]<h->elem[b]);
+}
+
+/************************************************************/
+
+static void heap_swap(Field_Selector *sel, Field_Heap *h, int a, int b)
+{
+    int e;
+    double k;
+
+    e=h->elem[a];
+    k=h->key[a];
+    h->elem[a]=h->elem[b];
+    h->key[a]=h->key[b];
+    h->elem[b]=e;
+    h->key[b]=k;
+
+    sel->pos[h->elem[a]%NUM_SLOTS][h->elem[a]/NUM_SLOTS]=a;
+    sel->pos[h->elem[b]%NUM_SLOTS][h->elem[b]/NUM_SLOTS]=b;
+}
+
+/************************************************************/
+
+static void heap_sift(Field_Selector *sel, Field_Heap *h, int p)
+{
+    int c;
+
+    while(p>0&&heap_less(h,p,(p-1)/2)){
+       heap_swap(sel,h,p,(p-1)/2);
+       p=(p-1)/2;
+    }
+
+    while(1){
+       c=2*p+1;
+       if(c>=h->n)break;
+       if(c+1<h->n&&heap_less(h,c+1,c))c++;
+       if(!heap_less(h,c,p))break;
+       heap_swap(sel,h,p,c);
+       p=c;
+    }
+}
+
+/************************************************************/
+
+static int heap_insert(Field_Selector *sel, Field_Heap *h, int index, int slot,
+        double key)
+{
+    int n,*elem;
+    double *k;
+
+    if(h->n>=h->max){
+       n=h->max+FIELD_STORE_CHUNK;
+       elem=(int *)realloc(h->elem,n*sizeof(int));
+       if(elem==NULL)return(-1);
+       h->elem=elem;
+       k=(double *)realloc(h->key,n*sizeof(double));
+       if(k==NULL)return(-1);
+       h->key=k;
+       h->max=n;
+    }
+
+    h->elem[h->n]=NUM_SLOTS*index+slot;
+    h->key[h->n]=key;
+    sel->pos[slot][index]=h->n;
+    sel->member[slot][index]=h;
+    h->n++;
+    heap_sift(sel,h,h->n-1);
+
+    return(0);
+}
+
+/************************************************************/
+
+static void heap_remove(Field_Selector *sel, int index, int slot)
+{
+    Field_Heap *h;
+    int p;
+
+    h=sel->member[slot][index];
+    if(h==NULL)return;
+
+    p=sel->pos[slot][index];
+    h->n--;
+    if(p<h->n){
+       heap_swap(sel,h,p,h->n);
+       heap_sift(sel,h,p);
+    }
+
+    sel->member[slot][index]=NULL;
+}
+
+/************************************************************/
+
+static int heap_top(Field_Heap *h)
+{
+    if(h->n==0)return(-1);
+    return(h->elem[0]/NUM_SLOTS);
+}
+
+/************************************************************/
+
+int init_field_selector(Field_Selector *sel)
+{
+    memset((void *)sel,0,sizeof(Field_Selector));
+    sel->bad_weather=-1;
+
+    return(init_sky_grid(&(sel->grid)));
+}
+
+/************************************************************/
+
+static void free_field_heap(Field_Heap *h)
+{
+    free(h->elem);
+    free(h->key);
+}
+
+/************************************************************/
+
+/* free the arrays of a selector set up by init_field_selector(). It
+   must be initialized again before it is used */
+
+int free_field_selector(Field_Selector *sel)
+{
+    int i,slot;
+
+    free_field_heap(&(sel->events));
+    for(i=0;i<sel->n_buckets;i++){
+       free_field_heap(sel->ready[i]);
+       free_field_heap(sel->ready_must_do[i]);
+       free(sel->ready[i]);
+       free(sel->ready_must_do[i]);
+    }
+    free(sel->ready);
+    free(sel->ready_must_do);
+    free_field_heap(&(sel->ready_must_do_6));
+    free_field_heap(&(sel->late));
+    free_field_heap(&(sel->late_must_do));
+    free_field_heap(&(sel->do_now));
+    free_field_heap(&(sel->do_now_dark));
+    free_field_heap(&(sel->do_now_flat));
+
+    for(slot=0;slot<NUM_SLOTS;slot++){
+       free(sel->member[slot]);
+       free(sel->pos[slot]);
+    }
+    free(sel->status);
+    free(sel->stamp);
+    free(sel->dirty);
+    free(sel->weather);
+    free(sel->work);
+    free(sel->stack);
+
+    free_sky_grid(&(sel->grid));
+    memset((void *)sel,0,sizeof(Field_Selector));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* make room for READY fields with n_left observations left. The heaps
+   are allocated one by one, so the member pointers to them stay valid */
+
+static int grow_ready_buckets(Field_Selector *sel, int n_left)
+{
+    Field_Heap **p;
+    int i,n;
+
+    if(n_left<sel->n_buckets)return(0);
+
+    n=sel->n_buckets;
+    while(n<=n_left)n=n+SELECTOR_BUCKET_CHUNK;
+
+    if((p=(Field_Heap **)realloc(sel->ready,n*sizeof(Field_Heap *)))==NULL)return(-1);
+    sel->ready=p;
+    if((p=(Field_Heap **)realloc(sel->ready_must_do,n*sizeof(Field_Heap *)))==NULL)return(-1);
+    sel->ready_must_do=p;
+
+    for(i=sel->n_buckets;i<n;i++){
+       sel->ready[i]=(Field_Heap *)calloc(1,sizeof(Field_Heap));
+       sel->ready_must_do[i]=(Field_Heap *)calloc(1,sizeof(Field_Heap));
+       if(sel->ready[i]==NULL||sel->ready_must_do[i]==NULL){
+          free(sel->ready[i]);
+          free(sel->ready_must_do[i]);
+          sel->n_buckets=i;
+          return(-1);
+       }
+    }
+    sel->n_buckets=n;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* make room for num_fields fields in the per-field arrays */
+
+static int grow_field_selector(Field_Selector *sel, int num_fields)
+{
+    int n,slot;
+    void *p;
+
+    if(num_fields<=sel->max_fields)return(0);
+
+    n=sel->max_fields;
+    while(n<num_fields)n=n+FIELD_STORE_CHUNK;
+
+    for(slot=0;slot<NUM_SLOTS;slot++){
+       p=realloc(sel->member[slot],n*sizeof(Field_Heap *));
+       if(p==NULL)return(-1);
+       sel->member[slot]=(Field_Heap **)p;
+       memset((void *)(sel->member[slot]+sel->max_fields),0,
+            (n-sel->max_fields)*sizeof(Field_Heap *));
+
+       p=realloc(sel->pos[slot],n*sizeof(int));
+       if(p==NULL)return(-1);
+       sel->pos[slot]=(int *)p;
+    }
+
+    if((p=realloc(sel->status,n*sizeof(int)))==NULL)return(-1);
+    sel->status=(int *)p;
+    if((p=realloc(sel->stamp,n*sizeof(int)))==NULL)return(-1);
+    sel->stamp=(int *)p;
+    memset((void *)(sel->stamp+sel->max_fields),0,
+            (n-sel->max_fields)*sizeof(int));
+    if((p=realloc(sel->dirty,n*sizeof(int)))==NULL)return(-1);
+    sel->dirty=(int *)p;
+    if((p=realloc(sel->weather,n*sizeof(int)))==NULL)return(-1);
+    sel->weather=(int *)p;
+    if((p=realloc(sel->work,n*sizeof(int)))==NULL)return(-1);
+    sel->work=(int *)p;
+    if((p=realloc(sel->stack,(2*n+2)*sizeof(int)))==NULL)return(-1);
+    sel->stack=(int *)p;
+
+    sel->max_fields=n;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* mark field index as changed by the caller (observed, or n_done
+   rolled back), so that it is re-evaluated on the next call to
+   select_next_field() */
+
+int touch_field(Field_Selector *sel, int index)
+{
+    if(index<0||index>=sel->num_fields)return(0);
+
+    if(sel->stamp[index]!=-1){
+       sel->stamp[index]=-1;
+       sel->dirty[sel->n_dirty]=index;
+       sel->n_dirty++;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* jd at which the status of field f, just found to be status at jd,
+   may next change. HUGE_VAL if it can't change until the field is
+   touched */
+
+static double next_field_event(Field *f, double jd, int status)
+{
+    double t,event;
+
+    if(f->doable==0)return(HUGE_VAL);
+
+    if(jd<f->jd_rise)return(f->jd_rise-EVENT_MARGIN);
+
+    /* the field becomes undoable once it has set */
+
+    event=f->jd_set;
+
+    if(status==NOT_DOABLE_STATUS){
+
+       /* waiting for jd_next. Otherwise this is a flat, focus or
+          offset field waiting for good weather */
+
+       t=f->jd_next-(MIN_EXECUTION_TIME/24.0);
+       if(t>jd-EVENT_MARGIN&&t<event)event=t;
+    }
+    else if(status==READY_STATUS){
+
+       /* time_left crosses zero */
+
+       t=f->jd_set-(f->time_required/24.0);
+       if(t<event)event=t;
+    }
+
+    return(event-EVENT_MARGIN);
+}
+
+/************************************************************/
+
+/* update the status of field index at jd, and move it to the heaps for
+   its new status and next event */
+
+static int evaluate_field(Field_Selector *sel, Field *sequence, int index,
+          double jd, int bad_weather)
+{
+    Field *f;
+    Field_Heap *h;
+    int slot,status,n_left;
+    double key,event;
+    char field_status[256];
+
+    for(slot=0;slot<NUM_SLOTS;slot++){
+       heap_remove(sel,index,slot);
+    }
+
+    f=sequence+index;
+    status=update_field_status(f,jd,bad_weather);
+    sel->status[index]=status;
+
+    if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+       get_field_status_string(f,field_status);
+       sched_log(LOG_SELECT,LOG_DEBUG,"field %d status %s\n",index,field_status);
+    }
+
+    n_left=f->n_required-f->n_done;
+    if(n_left<0)n_left=0;
+    if((status==READY_STATUS)&&grow_ready_buckets(sel,n_left)!=0){
+       fprintf(stderr,"evaluate_field: can't allocate heaps for %d observations left\n",
+          n_left);
+       return(-1);
+    }
+
+    /* jd at which the field becomes late. The least time_left is the
+       least key */
+
+    key=f->jd_set-(f->time_required/24.0);
+
+    if(status==READY_STATUS&&f->survey_code==MUSTDO_SURVEY_CODE){
+       if(heap_insert(sel,sel->ready_must_do[n_left],index,BUCKET_SLOT,key)!=0)
+            return(-1);
+       if(f->n_required==6&&
+          heap_insert(sel,&(sel->ready_must_do_6),index,SUBSET_SLOT,key)!=0)
+            return(-1);
+    }
+    else if(status==DO_NOW_STATUS){
+       if(heap_insert(sel,&(sel->do_now),index,BUCKET_SLOT,(double)index)!=0)
+            return(-1);
+       h=NULL;
+       if(f->shutter==DARK_CODE){
+          h=&(sel->do_now_dark);
+       }
+       else if(f->shutter==DOME_FLAT_CODE||f->shutter==EVENING_FLAT_CODE||
+           f->shutter==MORNING_FLAT_CODE){
+          h=&(sel->do_now_flat);
+       }
+       if(h!=NULL&&heap_insert(sel,h,index,SUBSET_SLOT,(double)index)!=0)
+            return(-1);
+    }
+    else if(status==READY_STATUS){
+       if(heap_insert(sel,sel->ready[n_left],index,BUCKET_SLOT,key)!=0)
+            return(-1);
+    }
+    else if(status==TOO_LATE_STATUS){
+
+       /* most time_left first */
+
+       if(heap_insert(sel,&(sel->late),index,BUCKET_SLOT,-key)!=0)
+            return(-1);
+       if(f->survey_code==MUSTDO_SURVEY_CODE&&
+          heap_insert(sel,&(sel->late_must_do),index,SUBSET_SLOT,key)!=0)
+            return(-1);
+    }
+
+    event=next_field_event(f,jd,status);
+    if(event<HUGE_VAL&&
+       heap_insert(sel,&(sel->events),index,EVENT_SLOT,event)!=0)return(-1);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Check the fields near the top of heap h against their time_left at
+   jd. Replace *i_best and *time_left_best with any that the linear scan
+   in get_next_field() would take over them: less time_left (or more, if
+   most is set), or the same time_left and a lower index */
+
+static void scan_heap_top(Field_Selector *sel, Field *sequence, Field_Heap *h,
+          double jd, int bad_weather, int most,
+          int *i_best, double *time_left_best)
+{
+    Field *f;
+    int n,p,i;
+    double bound,t;
+
+    if(h->n==0)return;
+
+    bound=h->key[0]+KEY_TOLERANCE;
+
+    n=0;
+    sel->stack[n++]=0;
+    while(n>0){
+       p=sel->stack[--n];
+       if(p>=h->n||h->key[p]>bound)continue;
+       sel->stack[n++]=2*p+1;
+       sel->stack[n++]=2*p+2;
+
+       i=h->elem[p]/NUM_SLOTS;
+       f=sequence+i;
+       update_field_status(f,jd,bad_weather);
+       if(f->status!=sel->status[i]){
+          /* should not happen, but if it does the field is out of date */
+          touch_field(sel,i);
+          continue;
+       }
+       t=f->time_left;
+       if((most&&t>*time_left_best)||(!most&&t<*time_left_best)||
+          (t==*time_left_best&&i<*i_best)){
+          *i_best=i;
+          *time_left_best=t;
+       }
+    }
+}
+
+/************************************************************/
+
+/* the tied fields: those in heap h[k] (in slot[k]) with key <= bound,
+   and time_left at jd (worked out as update_field_status() does) no
+   more than time_left_max */
+
+typedef struct {
+    Field_Selector *sel;
+    Field *sequence;
+    Field_Heap *h[2];
+    int slot[2];
+    double bound;
+    double jd;
+    double time_left_max;
+} Tie_Test;
+
+static int tied_field(int index, void *arg)
+{
+    Tie_Test *tie;
+    Field_Selector *sel;
+    Field *f;
+    int k,slot;
+
+    tie=(Tie_Test *)arg;
+    sel=tie->sel;
+
+    for(k=0;k<2;k++){
+       slot=tie->slot[k];
+       if(tie->h[k]!=NULL&&sel->member[slot][index]==tie->h[k]&&
+          tie->h[k]->key[sel->pos[slot][index]]<=tie->bound){
+          f=tie->sequence+index;
+          return((f->jd_set-tie->jd)*24.0-f->time_required<=tie->time_left_max);
+       }
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return the field nearest field i_pos of those that tie with field
+   i_min, the least time_left in heaps h1 (slot1) and h2 (slot2, may be
+   NULL). */
+
+static int nearest_tied_field(Field_Selector *sel, Field *sequence,
+        Field_Heap *h1, int slot1, Field_Heap *h2, int slot2,
+        int i_min, int i_pos, double jd)
+{
+    Tie_Test tie;
+    Field_Heap *h;
+    Field *f;
+    int k,n,p,i,i_best,n_tied;
+    double t,t_best;
+
+    f=sequence+i_min;
+    tie.sel=sel;
+    tie.sequence=sequence;
+    tie.jd=jd;
+    tie.time_left_max=f->time_left+SLEW_TIE_TIME;
+    tie.h[0]=h1;
+    tie.slot[0]=slot1;
+    tie.h[1]=h2;
+    tie.slot[1]=slot2;
+    tie.bound=f->jd_set-(f->time_required/24.0)+(SLEW_TIE_TIME/24.0)+KEY_TOLERANCE;
+
+    /* compare a few tied fields one by one */
+
+    f=sequence+i_pos;
+    i_best=i_min;
+    t_best=slew_time(f->ra,f->dec,sequence[i_min].ra,sequence[i_min].dec);
+    n_tied=0;
+
+    for(k=0;k<2&&n_tied<=SLEW_SCAN_MAX;k++){
+       h=tie.h[k];
+       if(h==NULL)continue;
+       n=0;
+       sel->stack[n++]=0;
+       while(n>0&&n_tied<=SLEW_SCAN_MAX){
+          p=sel->stack[--n];
+          if(p>=h->n||h->key[p]>tie.bound)continue;
+          sel->stack[n++]=2*p+1;
+          sel->stack[n++]=2*p+2;
+          n_tied++;
+
+          i=h->elem[p]/NUM_SLOTS;
+          if(!tied_field(i,(void *)&tie))continue;
+          t=slew_time(f->ra,f->dec,sequence[i].ra,sequence[i].dec);
+          if(t<t_best||(t==t_best&&i<i_best)){
+             t_best=t;
+             i_best=i;
+          }
+       }
+    }
+
+    if(n_tied<=SLEW_SCAN_MAX)return(i_best);
+
+    i=nearest_sky_grid_field(&(sel->grid),sequence,f->ra,f->dec,tied_field,(void *)&tie);
+
+    return(i>=0 ? i : i_min);
+}
+
+/************************************************************/
+
+/* first n_left with a non-empty heap in bucket[], of n_buckets */
+
+static int min_n_left(Field_Heap **bucket, int n_buckets)
+{
+    int n;
+
+    for(n=0;n<n_buckets;n++){
+       if(bucket[n]->n>0)return(n);
+    }
+
+    return(-1);
+}
+
+/************************************************************/
+
+static int selected_field(Field *sequence, int index, double jd,
+        int bad_weather, enum Selection_Code code)
+{
+    /* bring time_left etc. up to date for the caller */
+    update_field_status(sequence+index,jd,bad_weather);
+
+    (sequence+index)->selection_code=code;
+
+    return(index);
+}
+
+/************************************************************/
+
+/* Same as get_next_field(), see there for the selection rules, but
+   working incrementally from the status at the last call. sel must
+   have been initialized with init_field_selector(), and must be told of
+   any change to a field made outside this routine with touch_field() */
+
+int select_next_field(Field_Selector *sel, Field *sequence, int num_fields,
+        int i_prev, double jd, int bad_weather)
+{
+     Field *f,*f_prev,*f_next;
+     double time_left_min,time_left_max;
+     int i,j,n,i_min,i_max,i_pos;
+     int n_left_min,n_left_min_must_do;
+
+     /* fields may only be added */
+
+     if(num_fields<sel->num_fields){
+        fprintf(stderr,"select_next_field: sequence shrank from %d to %d fields\n",
+          sel->num_fields,num_fields);
+        return(-1);
+     }
+
+     if(grow_field_selector(sel,num_fields)!=0){
+        fprintf(stderr,"select_next_field: can't allocate %d fields\n",num_fields);
+        return(-1);
+     }
+
+     /* collect the fields to re-evaluate: new fields, fields touched by
+        the caller, fields whose event has passed, and if the weather
+        changed, the weather-dependent fields */
+
+     n=0;
+     sel->call_id++;
+
+     for(i=sel->num_fields;i<num_fields;i++){
+        f=sequence+i;
+        if(f->shutter==EVENING_FLAT_CODE||f->shutter==MORNING_FLAT_CODE||
+           f->shutter==FOCUS_CODE||f->shutter==OFFSET_CODE){
+           sel->weather[sel->n_weather]=i;
+           sel->n_weather++;
+        }
+        if(add_sky_grid_field(&(sel->grid),i,f->ra,f->dec)!=0)return(-1);
+        sel->stamp[i]=sel->call_id;
+        sel->work[n++]=i;
+     }
+     sel->num_fields=num_fields;
+
+     for(j=0;j<sel->n_dirty;j++){
+        i=sel->dirty[j];
+        sel->stamp[i]=sel->call_id;
+        sel->work[n++]=i;
+     }
+     sel->n_dirty=0;
+
+     if(bad_weather!=sel->bad_weather){
+        for(j=0;j<sel->n_weather;j++){
+           i=sel->weather[j];
+           if(sel->stamp[i]!=sel->call_id){
+              sel->stamp[i]=sel->call_id;
+              sel->work[n++]=i;
+           }
+        }
+        sel->bad_weather=bad_weather;
+     }
+
+     while(sel->events.n>0&&sel->events.key[0]<=jd){
+        i=heap_top(&(sel->events));
+        heap_remove(sel,i,EVENT_SLOT);
+        if(sel->stamp[i]!=sel->call_id){
+           sel->stamp[i]=sel->call_id;
+           sel->work[n++]=i;
+        }
+     }
+
+     if(LOG_ON(LOG_SELECT,LOG_VERBOSE)){
+        sched_log(LOG_SELECT,LOG_VERBOSE,"select_next_field: updating status of %d of %d fields\n",
+           n,num_fields);
+     }
+
+     for(j=0;j<n;j++){
+        if(evaluate_field(sel,sequence,sel->work[j],jd,bad_weather)!=0){
+           fprintf(stderr,"select_next_field: can't allocate heap space\n");
+           return(-1);
+        }
+     }
+
+     if(i_prev>=0&&i_prev<num_fields-1){
+       f_prev=sequence+i_prev;
+       f_next=sequence+i_prev+1;
+     }
+     else{
+       f_prev=NULL;
+       f_next=NULL;
+     }
+
+     /* the telescope is at the previous field */
+
+     i_pos=(i_prev>=0&&i_prev<num_fields) ? i_prev : -1;
+
+     /* If there are MUST_DO fields with READY_STATUS,
+        choose the one that has least time left to complete the
+        required observations */
+
+     n_left_min_must_do=min_n_left(sel->ready_must_do,sel->n_buckets);
+     if(n_left_min_must_do>=0){
+        time_left_min=10000.0;
+        i_min=-1;
+        scan_heap_top(sel,sequence,sel->ready_must_do[n_left_min_must_do],
+            jd,bad_weather,0,&i_min,&time_left_min);
+        scan_heap_top(sel,sequence,&(sel->ready_must_do_6),
+            jd,bad_weather,0,&i_min,&time_left_min);
+        if(i_min>=0&&i_pos>=0){
+           i_min=nearest_tied_field(sel,sequence,
+                sel->ready_must_do[n_left_min_must_do],BUCKET_SLOT,
+                &(sel->ready_must_do_6),SUBSET_SLOT,i_min,i_pos,jd);
+        }
+        if(i_min>=0){
+           if(LOG_ON(LOG_SELECT,LOG_VERBOSE)){
+              sched_log(LOG_SELECT,LOG_VERBOSE,"select_next_field: returning ready must-do field : %d\n",i_min);
+           }
+           return(selected_field(sequence,i_min,jd,bad_weather,
+                LEAST_TIME_READY_MUST_DO));
+        }
+     }
+
+     /* If there are MUST-DO fields with TOO_LATE_STATUS, choose the one
+        that has the least time left, and shorten the interval so
+        that time_left=0. */
+
+     if(sel->late_must_do.n>0){
+        time_left_min=10000.0;
+        i_min=-1;
+        scan_heap_top(sel,sequence,&(sel->late_must_do),
+            jd,bad_weather,0,&i_min,&time_left_min);
+        if(i_min>=0){
+           if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+              sched_log(LOG_SELECT,LOG_DEBUG,
+               "select_next_field: choosing late must-do field %d to shorten intervals\n",
+               i_min);
+           }
+           shorten_interval(sequence+i_min);
+           evaluate_field(sel,sequence,i_min,jd,bad_weather);
+           return(selected_field(sequence,i_min,jd,bad_weather,
+                LEAST_TIME_LATE_MUST_DO));
+        }
+     }
+
+     /* If there are fields with DO_NOW_STATUS, choose the first flat,
+        or else the first dark, or else the first field */
+
+     if(sel->do_now.n>0){
+        if(sel->do_now_flat.n>0){
+           return(selected_field(sequence,heap_top(&(sel->do_now_flat)),
+                jd,bad_weather,FIRST_DO_NOW_FLAT));
+        }
+        else if(sel->do_now_dark.n>0){
+           return(selected_field(sequence,heap_top(&(sel->do_now_dark)),
+                jd,bad_weather,FIRST_DO_NOW_DARK));
+        }
+        else{
+           return(selected_field(sequence,heap_top(&(sel->do_now)),
+                jd,bad_weather,FIRST_DO_NOW));
+        }
+     }
+
+     /* if the pair to the previous fields is doable, choose the paired field */
+
+     if(f_prev!=NULL&&paired_fields(f_next,f_prev)&&f_next->doable){
+        i=i_prev+1;
+        if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+           sched_log(LOG_SELECT,LOG_DEBUG,"select_next_field: field %d is paired with field %d \n",
+              i,i_prev);
+        }
+        if(sel->status[i]==READY_STATUS){
+           return(selected_field(sequence,i,jd,bad_weather,FIRST_READY_PAIR));
+        }
+        else if(sel->status[i]==TOO_LATE_STATUS){
+           update_field_status(f_next,jd,bad_weather);
+           shorten_interval(f_next);
+           evaluate_field(sel,sequence,i,jd,bad_weather);
+           if(sel->status[i]==READY_STATUS){
+              return(selected_field(sequence,i,jd,bad_weather,FIRST_LATE_PAIR));
+           }
+           else{
+              return(selected_field(sequence,i,jd,bad_weather,
+                  FIRST_NOT_READY_LATE_PAIR));
+           }
+        }
+        else{
+           return(selected_field(sequence,i,jd,bad_weather,
+                FIRST_NOT_READY_NOT_LATE_PAIR));
+        }
+     }
+
+     /* If there are fields with READY_STATUS, choose the one
+        that has least time left to complete the required observations */
+
+     n_left_min=min_n_left(sel->ready,sel->n_buckets);
+     if(n_left_min>=0){
+        time_left_min=10000.0;
+        i_min=-1;
+        scan_heap_top(sel,sequence,sel->ready[n_left_min],
+            jd,bad_weather,0,&i_min,&time_left_min);
+        if(i_min>=0&&i_pos>=0){
+           i_min=nearest_tied_field(sel,sequence,sel->ready[n_left_min],BUCKET_SLOT,
+                NULL,0,i_min,i_pos,jd);
+        }
+        if(i_min>=0){
+           if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+              sched_log(LOG_SELECT,LOG_DEBUG,"select_next_field: returning ready field : %d\n",i_min);
+           }
+           return(selected_field(sequence,i_min,jd,bad_weather,LEAST_TIME_READY));
+        }
+     }
+
+     /* If there are fields with TOO_LATE_STATUS, choose the one with
+        the most time left and shorten its interval. If it is then
+        ready, choose it */
+
+     if(sel->late.n>0){
+        time_left_max=-1000;
+        i_max=-1;
+        scan_heap_top(sel,sequence,&(sel->late),
+            jd,bad_weather,1,&i_max,&time_left_max);
+        if(i_max>=0){
+           if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+              sched_log(LOG_SELECT,LOG_DEBUG,
+                 "select_next_field: choosing field %d to shorten intervals\n",
+                 i_max);
+           }
+           shorten_interval(sequence+i_max);
+           evaluate_field(sel,sequence,i_max,jd,bad_weather);
+           if(sel->status[i_max]==READY_STATUS){
+              return(selected_field(sequence,i_max,jd,bad_weather,
+                   MOST_TIME_READY_LATE));
+           }
+           else if(LOG_ON(LOG_SELECT,LOG_DEBUG)){
+              sched_log(LOG_SELECT,LOG_DEBUG,
+                 "select_next_field: could not shorten interval of field %d\n",
+                 i_max);
+           }
+        }
+     }
+
+     if(LOG_ON(LOG_SELECT,LOG_VERBOSE)) {
+        sched_log(LOG_SELECT,LOG_VERBOSE,"select_next_field: No fields to observe\n");
+     }
+
+     return(-1);
+}
+
+/************************************************************/
@@ -17,7 +17,7 @@
 #define SIGUSR2 12
 
 extern int verbose;
-extern int pause_flag;
+extern _Atomic int pause_flag;
 
 /*********************************************/
 
@@ -0,0 +1,252 @@
+/* scheduler_slew.c
+
+   2026 Oct 14
+
+   Telescope slew-time model, and a grid index of field positions for
+   finding the field nearest the telescope.
+
+   The two axes of the mount move at once, at SLEW_RATE_RA and
+   SLEW_RATE_DEC, so a slew takes as long as the slower axis needs,
+   plus SLEW_SETTLE_SEC for the mount to settle. The slew to the next
+   field happens while the camera reads out the last exposure (see
+   observe_next_field()), so only the part of it longer than the readout
+   adds to the time of an observation (slew_overhead()).
+
+   The grid splits the sky into Dec bands SKY_GRID_DEG wide, and each
+   band into RA cells about SKY_GRID_DEG wide on the sky, so the cells
+   have about the same area (as HEALPix pixels do) and hold about the
+   same number of fields of an evenly spaced survey grid.
+   nearest_sky_grid_field() searches outward from the telescope in
+   boxes of growing slew time, so it looks only at the cells near the
+   telescope unless the fields it wants are all far away.
+*/
+
+#include "scheduler.h"
+
+extern int verbose;
+
+double slew_time(double ra1, double dec1, double ra2, double dec2);
+double slew_overhead(double ra1, double dec1, double ra2, double dec2);
+int init_sky_grid(Sky_Grid *grid);
+int free_sky_grid(Sky_Grid *grid);
+int add_sky_grid_field(Sky_Grid *grid, int index, double ra, double dec);
+int nearest_sky_grid_field(Sky_Grid *grid, Field *sequence, double ra, double dec,
+        int (*accept)(int index, void *arg), void *arg);
+
+/************************************************************/
+
+/* time (sec) for the slower axis to move from ra1,dec1 to ra2,dec2
+   (hours, deg) */
+
+static double axis_time(double ra1, double dec1, double ra2, double dec2)
+{
+    double dra,t_ra,t_dec;
+
+    dra=ra2-ra1;
+    while(dra>12.0)dra=dra-24.0;
+    while(dra<-12.0)dra=dra+24.0;
+
+    t_ra=fabs(dra)*15.0/SLEW_RATE_RA;
+    t_dec=fabs(dec2-dec1)/SLEW_RATE_DEC;
+
+    return(t_ra>t_dec ? t_ra : t_dec);
+}
+
+/************************************************************/
+
+/* time (hours) to slew from ra1,dec1 to ra2,dec2 (hours, deg) and
+   settle. 0 if the two positions are the same */
+
+double slew_time(double ra1, double dec1, double ra2, double dec2)
+{
+    double t;
+
+    t=axis_time(ra1,dec1,ra2,dec2);
+    if(t<=0.0)return(0.0);
+
+    return((t+SLEW_SETTLE_SEC)/3600.0);
+}
+
+/************************************************************/
+
+/* time (hours) the slew from ra1,dec1 to ra2,dec2 adds to an
+   observation, beyond the readout of the previous exposure that it
+   overlaps */
+
+double slew_overhead(double ra1, double dec1, double ra2, double dec2)
+{
+    double t;
+
+    t=slew_time(ra1,dec1,ra2,dec2)-(READOUT_TIME_SEC/3600.0);
+
+    return(t>0.0 ? t : 0.0);
+}
+
+/************************************************************/
+
+static int sky_grid_band(double dec)
+{
+    int b;
+
+    b=(int)floor((dec+90.0)/SKY_GRID_DEG);
+    if(b<0)b=0;
+    if(b>=SKY_GRID_BANDS)b=SKY_GRID_BANDS-1;
+
+    return(b);
+}
+
+/************************************************************/
+
+/* RA cell in band b holding ra (hours). ra need not be in 0 to 24 */
+
+static int sky_grid_cell(Sky_Grid *grid, int b, double ra)
+{
+    int c,n;
+
+    n=grid->band_cells[b];
+    c=(int)floor(ra*n/24.0);
+    c=c%n;
+    if(c<0)c=c+n;
+
+    return(c);
+}
+
+/************************************************************/
+
+int init_sky_grid(Sky_Grid *grid)
+{
+    int b,n;
+    double dec;
+
+    memset((void *)grid,0,sizeof(Sky_Grid));
+
+    for(b=0;b<SKY_GRID_BANDS;b++){
+       dec=-90.0+(b+0.5)*SKY_GRID_DEG;
+       n=(int)floor(360.0*cos(dec*DEG_TO_RAD)/SKY_GRID_DEG+0.5);
+       if(n<1)n=1;
+       grid->band_start[b]=grid->n_cells;
+       grid->band_cells[b]=n;
+       grid->n_cells=grid->n_cells+n;
+    }
+
+    grid->cell=(int **)calloc(grid->n_cells,sizeof(int *));
+    grid->cell_n=(int *)calloc(grid->n_cells,sizeof(int));
+    grid->cell_max=(int *)calloc(grid->n_cells,sizeof(int));
+    if(grid->cell==NULL||grid->cell_n==NULL||grid->cell_max==NULL){
+       fprintf(stderr,"init_sky_grid: can't allocate %d cells\n",grid->n_cells);
+       fflush(stderr);
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+int free_sky_grid(Sky_Grid *grid)
+{
+    int c;
+
+    if(grid->cell!=NULL){
+       for(c=0;c<grid->n_cells;c++)free(grid->cell[c]);
+    }
+    free(grid->cell);
+    free(grid->cell_n);
+    free(grid->cell_max);
+    memset((void *)grid,0,sizeof(Sky_Grid));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* add field index at ra,dec (hours, deg) to the grid */
+
+int add_sky_grid_field(Sky_Grid *grid, int index, double ra, double dec)
+{
+    int b,c,n,*p;
+
+    b=sky_grid_band(dec);
+    c=grid->band_start[b]+sky_grid_cell(grid,b,ra);
+
+    if(grid->cell_n[c]>=grid->cell_max[c]){
+       n=grid->cell_max[c]+SKY_GRID_CHUNK;
+       p=(int *)realloc(grid->cell[c],n*sizeof(int));
+       if(p==NULL){
+          fprintf(stderr,"add_sky_grid_field: can't grow cell %d to %d fields\n",c,n);
+          fflush(stderr);
+          return(-1);
+       }
+       grid->cell[c]=p;
+       grid->cell_max[c]=n;
+    }
+
+    grid->cell[c][grid->cell_n[c]]=index;
+    grid->cell_n[c]++;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return the index of the field in the grid with the least slew time
+   from ra,dec (hours, deg) of those for which accept(index,arg) is
+   true, the lower index if two are the same. Return -1 if there is
+   none */
+
+int nearest_sky_grid_field(Sky_Grid *grid, Field *sequence, double ra, double dec,
+        int (*accept)(int index, void *arg), void *arg)
+{
+    int b,b0,b1,c,c0,c1,k,j,n,i,i_best,all;
+    double t,t_best,t_box,w;
+
+    i_best=-1;
+    t_best=HUGE_VAL;
+
+    /* the fields in the box searched are all those that the slower
+       axis can reach in t_box. Once the best found can be reached in
+       t_box, no field outside the box can be nearer */
+
+    t_box=SKY_GRID_DEG/(SLEW_RATE_RA>SLEW_RATE_DEC ? SLEW_RATE_RA : SLEW_RATE_DEC);
+
+    while(1){
+       b0=sky_grid_band(dec-t_box*SLEW_RATE_DEC);
+       b1=sky_grid_band(dec+t_box*SLEW_RATE_DEC);
+       w=t_box*SLEW_RATE_RA/15.0;
+       all=(b0==0&&b1==SKY_GRID_BANDS-1&&w>=12.0);
+
+       for(b=b0;b<=b1;b++){
+          n=grid->band_cells[b];
+          if(w>=12.0){
+             c0=0;
+             c1=n-1;
+          }
+          else{
+             c0=(int)floor((ra-w)*n/24.0);
+             c1=(int)floor((ra+w)*n/24.0);
+             if(c1-c0>=n)c1=c0+n-1;
+          }
+          for(k=c0;k<=c1;k++){
+             c=k%n;
+             if(c<0)c=c+n;
+             c=grid->band_start[b]+c;
+             for(j=0;j<grid->cell_n[c];j++){
+                i=grid->cell[c][j];
+                if(!accept(i,arg))continue;
+                t=axis_time(ra,dec,sequence[i].ra,sequence[i].dec);
+                if(t<t_best||(t==t_best&&i<i_best)){
+                   t_best=t;
+                   i_best=i;
+                }
+             }
+          }
+       }
+
+       if((i_best>=0&&t_best<=t_box)||all)break;
+       t_box=2.0*t_box;
+    }
+
+    return(i_best);
+}
+
+/************************************************************/
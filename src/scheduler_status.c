@@ -8,6 +8,7 @@
 #include <string.h>
 #include <ctype.h>
 
+extern int verbose;
 
 char *state_name[NUM_STATES];
 
@@ -239,24 +240,133 @@ int  get_string_status(char *keyword, char *reply, char *status)
 
 /* parse the keyword values from the reply string and store in
  * Camera_Status record.
+ *
+ * The reply is read once, from left to right. Each 'keyword': value
+ * pair is split out as it is reached and its keyword compared in full
+ * with the keywords of interest, so one keyword that is a prefix of
+ * another (ERROR and ERRORED, error and cmd_error) or that also
+ * appears in the reply header ("[ERROR ...") can't be mistaken for it.
+ * Keywords missing from the reply keep the values UNKNOWN, False and -1.
 */
 
-int parse_status(char *reply,Camera_Status *status)
+#define STATUS_READY_KEY (NUM_STATES)
+#define STATUS_ERROR_KEY (NUM_STATES+1)
+#define STATUS_STATE_KEY (NUM_STATES+2)
+#define STATUS_COMMENT_KEY (NUM_STATES+3)
+#define STATUS_DATE_KEY (NUM_STATES+4)
+#define NUM_STATUS_KEYS (NUM_STATES+5)
+
+/* return the index of the keyword of length n at key (STATUS_xxx_KEY,
+   or the state index), or -1 if it is not one we want */
+
+static int status_key_index(char *key, int n)
 {
+  static char *other_keys[]={"ready","error","state","comment","date"};
   int i;
-  char temp_string[1024];
 
-  status->ready= get_bool_status("ready",reply);
-  status->error= get_bool_status("error",reply);
+  for (i=0;i<NUM_STATES;i++){
+     if (strncmp(key,state_name[i],n)==0 && state_name[i][n]==0) return(i);
+  }
+  for (i=0;i<NUM_STATUS_KEYS-NUM_STATES;i++){
+     if (strncmp(key,other_keys[i],n)==0 && other_keys[i][n]==0) return(NUM_STATES+i);
+  }
+
+  return(-1);
+}
 
-  get_string_status("state",reply,status->state);
-  get_string_status("comment",reply,status->comment);
-  get_string_status("date",reply,status->date);
+/*****************************************************/
 
-  for (i=0;i<NUM_STATES;i++){
-     status->state_val[i]=-1;
-     get_string_status(state_name[i],reply,temp_string);
-     status->state_val[i]=binary_string_to_int(temp_string);
+int parse_status(char *reply,Camera_Status *status)
+{
+  int i,k,n,n_found;
+  char *p,*key,*value,quote;
+  int key_length,value_length;
+  char temp_string[1024];
+  bool found[NUM_STATUS_KEYS];
+
+  status->ready=False;
+  status->error=False;
+  strcpy(status->state,"UNKNOWN");
+  strcpy(status->comment,"UNKNOWN");
+  strcpy(status->date,"UNKNOWN");
+  for (i=0;i<NUM_STATES;i++) status->state_val[i]=-1;
+  for (i=0;i<NUM_STATUS_KEYS;i++) found[i]=False;
+  n_found=0;
+
+  p=reply;
+  while (*p!=0){
+
+     /* find the next quoted keyword */
+
+     while (*p!=0 && *p!='\'' && *p!='"') p++;
+     if (*p==0) break;
+     quote=*p++;
+     key=p;
+     while (*p!=0 && *p!=quote) p++;
+     if (*p==0) break;
+     key_length=p-key;
+     p++;
+
+     /* a keyword is followed by ":". Anything else was a quoted value
+        of a keyword we skipped, so keep looking */
+
+     while (*p==' ' || *p=='\t' || *p=='\n' || *p=='\r') p++;
+     if (*p!=':') continue;
+     p++;
+     while (*p==' ' || *p=='\t' || *p=='\n' || *p=='\r') p++;
+
+     /* the value is either quoted, or runs to the next separator */
+
+     if (*p=='\'' || *p=='"'){
+        quote=*p++;
+        value=p;
+        while (*p!=0 && *p!=quote) p++;
+        value_length=p-value;
+        if (*p!=0) p++;
+     }
+     else{
+        value=p;
+        while (*p!=0 && *p!=',' && *p!='}' && *p!=']') p++;
+        value_length=p-value;
+        while (value_length>0 && (value[value_length-1]==' '||
+               value[value_length-1]=='\n'||value[value_length-1]=='\r'))value_length--;
+     }
+
+     k=status_key_index(key,key_length);
+     if (k<0 || found[k]) continue;
+     found[k]=True;
+     n_found++;
+
+     n=value_length<(int)sizeof(temp_string)-1 ? value_length : (int)sizeof(temp_string)-1;
+     strncpy(temp_string,value,n);
+     temp_string[n]=0;
+
+     if (k<NUM_STATES){
+        status->state_val[k]=binary_string_to_int(temp_string);
+     }
+     else if (k==STATUS_READY_KEY){
+        status->ready=string_to_bool(temp_string);
+     }
+     else if (k==STATUS_ERROR_KEY){
+        status->error=string_to_bool(temp_string);
+     }
+     else if (k==STATUS_STATE_KEY){
+        strcpy(status->state,temp_string);
+     }
+     else if (k==STATUS_COMMENT_KEY){
+        strcpy(status->comment,temp_string);
+     }
+     else if (k==STATUS_DATE_KEY){
+        strcpy(status->date,temp_string);
+     }
+
+     if (n_found==NUM_STATUS_KEYS) break;
+  }
+
+  if (n_found<NUM_STATUS_KEYS && verbose){
+     fprintf(stderr,"parse_status: %d of %d keywords missing from status string [%s]\n",
+             NUM_STATUS_KEYS-n_found,NUM_STATUS_KEYS,reply);
+     fflush(stderr);
   }
 
   return (0);
@@ -0,0 +1,204 @@
+/* scheduler_store.c
+
+   2026 Oct 14
+
+   Storage for the fields of the observing sequence.
+
+   The Field scheduling records are kept in one contiguous array that
+   grows FIELD_STORE_CHUNK fields at a time, so the number of fields
+   is limited only by memory. Because the array may move when it grows,
+   callers should not keep Field pointers across calls that add fields
+   (load_sequence(), load_obs_record()).
+
+   Each field's Field_History (script line and completed observations)
+   is allocated separately when the field is added, with room for
+   n_required observations, and grown if n_required later increases
+   (long exposures split into several shorter ones).
+*/
+
+#include "scheduler.h"
+
+extern int verbose;
+
+int init_field_store(Field_Store *store);
+int add_field(Field_Store *store, Field *field, char *script_line);
+int grow_field_history(Field *f, int max_obs);
+int truncate_field_store(Field_Store *store, int num_fields);
+int restore_fields(Field_Store *store, Field *saved, int num_fields);
+
+/************************************************************/
+
+int init_field_store(Field_Store *store)
+{
+    store->fields=NULL;
+    store->num_fields=0;
+    store->max_fields=0;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* point the per-observation arrays of history h into block obs, which has
+   room for max_obs observations */
+
+static void set_history_arrays(Field_History *h, char *obs, int max_obs)
+{
+    h->max_obs=max_obs;
+    h->ut=(double *)obs;
+    h->jd=h->ut+max_obs;
+    h->lst=h->jd+max_obs;
+    h->ha=h->lst+max_obs;
+    h->am=h->ha+max_obs;
+    h->actual_expt=h->am+max_obs;
+    h->filename=(char *)(h->actual_expt+max_obs);
+}
+
+/************************************************************/
+
+static size_t history_block_size(int max_obs)
+{
+    return(max_obs*(6*sizeof(double)+FILENAME_LENGTH));
+}
+
+/************************************************************/
+
+/* Append a copy of field to the store, with a new history holding
+   script_line and room for field->n_required observations. Return the
+   index of the new field, or -1 if memory is exhausted */
+
+int add_field(Field_Store *store, Field *field, char *script_line)
+{
+    Field *fields;
+    Field_History *h;
+    char *obs;
+    int n,max_obs;
+
+    if(store->num_fields>=store->max_fields){
+       n=store->max_fields+FIELD_STORE_CHUNK;
+       fields=(Field *)realloc(store->fields,n*sizeof(Field));
+       if(fields==NULL){
+          fprintf(stderr,"add_field: can't grow field store to %d fields\n",n);
+          fflush(stderr);
+          return(-1);
+       }
+       store->fields=fields;
+       store->max_fields=n;
+    }
+
+    max_obs=field->n_required;
+    if(max_obs<1)max_obs=1;
+
+    h=(Field_History *)malloc(sizeof(Field_History)+strlen(script_line)+1);
+    obs=(char *)calloc(1,history_block_size(max_obs));
+    if(h==NULL||obs==NULL){
+       fprintf(stderr,"add_field: can't allocate history for field %d\n",
+            store->num_fields);
+       fflush(stderr);
+       if(h!=NULL)free(h);
+       if(obs!=NULL)free(obs);
+       return(-1);
+    }
+
+    h->script_line=(char *)(h+1);
+    strcpy(h->script_line,script_line);
+    set_history_arrays(h,obs,max_obs);
+
+    n=store->num_fields;
+    store->fields[n]=*field;
+    store->fields[n].history=h;
+    store->fields[n].n_saved=-1;
+    store->fields[n].jd_saved=0.0;
+    store->num_fields++;
+
+    return(n);
+}
+
+/************************************************************/
+
+/* make room in the history of field f for at least max_obs
+   observations, keeping the observations already recorded */
+
+int grow_field_history(Field *f, int max_obs)
+{
+    Field_History old,*h;
+    char *obs;
+    int n;
+
+    h=f->history;
+    if(max_obs<=h->max_obs)return(0);
+
+    obs=(char *)calloc(1,history_block_size(max_obs));
+    if(obs==NULL){
+       fprintf(stderr,"grow_field_history: can't allocate %d obs for field %d\n",
+          max_obs,f->field_number);
+       fflush(stderr);
+       return(-1);
+    }
+
+    old=*h;
+    set_history_arrays(h,obs,max_obs);
+
+    n=old.max_obs;
+    memcpy(h->ut,old.ut,n*sizeof(double));
+    memcpy(h->jd,old.jd,n*sizeof(double));
+    memcpy(h->lst,old.lst,n*sizeof(double));
+    memcpy(h->ha,old.ha,n*sizeof(double));
+    memcpy(h->am,old.am,n*sizeof(double));
+    memcpy(h->actual_expt,old.actual_expt,n*sizeof(double));
+    memcpy(h->filename,old.filename,n*FILENAME_LENGTH);
+
+    free((void *)old.ut);
+
+    if(verbose){
+       fprintf(stderr,"grow_field_history: field %d now has room for %d obs\n",
+          f->field_number,max_obs);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* drop the fields from index num_fields onwards, freeing their
+   histories */
+
+int truncate_field_store(Field_Store *store, int num_fields)
+{
+    int i;
+
+    for(i=num_fields;i<store->num_fields;i++){
+       free((void *)store->fields[i].history->ut);
+       free((void *)store->fields[i].history);
+    }
+
+    if(num_fields<store->num_fields)store->num_fields=num_fields;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Set the first num_fields fields of store back to saved (a copy of
+   store->fields, or of another store read from the same script),
+   keeping their histories. The simulators use this to start each night
+   from the sequence as read, since observing changes intervals and
+   n_required */
+
+int restore_fields(Field_Store *store, Field *saved, int num_fields)
+{
+    Field_History *h;
+    int i;
+
+    if(num_fields>store->num_fields)return(-1);
+
+    for(i=0;i<num_fields;i++){
+       h=store->fields[i].history;
+       store->fields[i]=saved[i];
+       store->fields[i].history=h;
+    }
+
+    return(0);
+}
+
+/************************************************************/
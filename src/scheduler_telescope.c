@@ -7,6 +7,8 @@
 */
 
 #include "scheduler.h"
+#include <pthread.h>
+#include <sys/time.h>
 
 
 
@@ -16,7 +18,8 @@
 #define DAYTIME_TEL_COMMAND_PORT 3912
 
 
-#define COMMAND_WAIT_TIME 100000 /* useconds to wait between commands */
+#define COMMAND_WAIT_TIME 0 /* useconds to wait between commands. Not needed
+                              now that send_command() waits for the full reply */
 
 /* first word in reply from telescope controller */
 #define TEL_ERROR_REPLY "error"
@@ -56,6 +59,8 @@
 
 #define FOCUS_SCRIPT "~/questops.dir/focus/bin/get_best_focus.csh"
 #define FOCUS_OUTPUT_FILE "/tmp/best_focus.tmp"
+#define FWHM_SCRIPT "~/questops.dir/focus/bin/get_fwhm.csh" /* image quality of one exposure */
+#define FWHM_OUTPUT_FILE "/tmp/focus_fwhm.tmp"
 
 #define TELESCOPE_OFFSETS_FILE "/home/observer/telescope_offsets.dat"
 #define OFFSET_SCRIPT "/home/observer/palomar/scripts/get_telescope_offsets.csh"
@@ -167,16 +172,13 @@ int get_telescope_offsets(Field *f, Telescope_Status *status)
 
         /* form system command for offset script*/
 
-        sprintf(command_string,"%s %s\n",OFFSET_SCRIPT,f->filename);
+        sprintf(command_string,"%s %s\n",OFFSET_SCRIPT,f->history->filename);
 
         if(verbose){
            fprintf(stderr,"get_telescope_offsets: %s\n",command_string);
            fflush(stderr);
         }
 
-#if FAKE_RUN
-
-#else
 
         /* run offset script. Output will be in TELESCOPE_OFFSETS_FILE */
 
@@ -230,7 +232,6 @@ int get_telescope_offsets(Field *f, Telescope_Status *status)
            status->dec_offset=dec_offset;
         }
 
-#endif
 
         fprintf(stderr,
              "get_telescope_offset: setting telescope offsets to  %8.5f %8.5f\n",
@@ -266,7 +267,7 @@ int focus_telescope(Field *f, Telescope_Status *status, double focus_default)
         sprintf(command_string,"%s ",FOCUS_SCRIPT);
         for(i=0;i<f->n_done;i++){
            sprintf(command_string+strlen(command_string),"%s ",
-		f->filename+(i*FILENAME_LENGTH));
+		f->history->filename+(i*FILENAME_LENGTH));
         }
         sprintf(command_string+strlen(command_string),"\n");
 
@@ -275,10 +276,6 @@ int focus_telescope(Field *f, Telescope_Status *status, double focus_default)
            fflush(stderr);
         }
 
-#if FAKE_RUN
-
-        status->focus=focus_default;
-#else
 
         /* run focus script. Output will be in FOCUS_OUTPUT_FILE */
 
@@ -305,33 +302,96 @@ int focus_telescope(Field *f, Telescope_Status *status, double focus_default)
            fprintf(stderr,"focus_telescope: best focus is %8.5f mm\n",focus);
         }
 
+        if(set_best_focus(focus,status)!=0)return(-1);
+
+
+        fprintf(stderr,"focus_telescope: telescope focus now set at %8.5f mm\n",
+		status->focus);
+	
+
+        return(0);
+
+}
 
-        fprintf(stderr,"focus_telescope: setting focus to %8.5f mm\n",focus);
+/*****************************************************/
+
+/* set the telescope focus to the best focus found and update status.
+   Return 0, or -1 if the telescope won't focus */
+
+int set_best_focus(double focus, Telescope_Status *status)
+{
+        fprintf(stderr,"set_best_focus: setting focus to %8.5f mm\n",focus);
         fflush(stderr);
-        
+
         if(set_telescope_focus(focus)!=0){
-           fprintf(stderr,"focus_telescope: could not set telescope focus\n");
+           fprintf(stderr,"set_best_focus: could not set telescope focus\n");
            return(-1);
         }
 
         if(verbose){
-           fprintf(stderr,"focus_telescope: updating telescope status\n");
+           fprintf(stderr,"set_best_focus: updating telescope status\n");
            fflush(stderr);
         }
 
         if(update_telescope_status(status)!=0){
-           fprintf(stderr,"focus_telescope: could not update telescope status\n");
+           fprintf(stderr,"set_best_focus: could not update telescope status\n");
            return(-1);
         }
 
-#endif
+        return(0);
+}
 
-        fprintf(stderr,"focus_telescope: telescope focus now set at %8.5f mm\n",
-		status->focus);
-	
+/*****************************************************/
 
-        return(0);
+/* use system call to FWHM_SCRIPT to measure the image quality of the
+   exposure filename, taken at focus. FWHM_SCRIPT writes a line
+   "fwhm: value" to FWHM_OUTPUT_FILE. Return the fwhm, or -1 if it
+   can't be measured */
+
+double measure_focus_fwhm(char *filename, double focus)
+{
+        char command_string[STR_BUF_LEN],string[STR_BUF_LEN],s[256];
+        FILE *input;
+        double fwhm;
+
+        unlink(FWHM_OUTPUT_FILE);
+
+        sprintf(command_string,"%s %s\n",FWHM_SCRIPT,filename);
+        if(verbose){
+           fprintf(stderr,"measure_focus_fwhm: %s",command_string);
+           fflush(stderr);
+        }
 
+        if(system(command_string)==-1){
+           fprintf(stderr,"measure_focus_fwhm: system command unsucessfull\n");
+           fflush(stderr);
+           return(-1.0);
+        }
+
+        input=fopen(FWHM_OUTPUT_FILE,"r");
+        if(input==NULL){
+           fprintf(stderr,"measure_focus_fwhm: could not open file %s\n",
+              FWHM_OUTPUT_FILE);
+           fflush(stderr);
+           return(-1.0);
+        }
+
+        fwhm=-1.0;
+        while(fgets(string,STR_BUF_LEN,input)!=NULL){
+           if(strstr(string,"fwhm:")!=NULL){
+              sscanf(string,"%s %lf",s,&fwhm);
+              break;
+           }
+        }
+        fclose(input);
+
+        if(verbose){
+           fprintf(stderr,"measure_focus_fwhm: %s at focus %8.5f: fwhm %7.3f\n",
+              filename,focus,fwhm);
+           fflush(stderr);
+        }
+
+        return(fwhm);
 }
 
 /*****************************************************/
@@ -638,21 +698,157 @@ int point_telescope(double ra, double dec, double ra_rate, double dec_rate)
 
 /*****************************************************/
 
-int update_telescope_status(Telescope_Status *status)
+/* Telescope status.
+
+   update_telescope_status() sends the DOMESTATUS, LST, GETFOCUS, POSRD
+   and WEATHER queries at the same time, each from its own thread over
+   its own pooled connection, so a status update costs one round trip
+   to the controller rather than five.
+
+   Each update is also published as a snapshot. get_telescope_status()
+   copies the snapshot without talking to the controller if it is no
+   older than max_age_sec, advancing ut and lst by its age. Otherwise it
+   does a fresh update. start_telescope_status_poller() starts a thread
+   that keeps the snapshot fresh between main loop iterations.
+
+   Only the fields read from the controller are copied into the
+   caller's status; ra_offset, dec_offset and filter_string are left to
+   their owners. */
+
+#define NUM_STATUS_QUERIES 5
+
+typedef struct {
+    char *command;
+    char reply[MAXBUFSIZE];
+    int result;
+} Status_Query;
+
+static Telescope_Status tel_snapshot;
+static int tel_snapshot_valid=0;
+static pthread_mutex_t tel_snapshot_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t tel_poller_thread;
+static int tel_poller_running=0;
+static double tel_poller_period_sec=0.0;
+static pthread_mutex_t tel_poller_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tel_poller_cond=PTHREAD_COND_INITIALIZER;
+
+/*****************************************************/
+
+static void *status_query_thread(void *args)
+{
+     Status_Query *q;
+
+     q=(Status_Query *)args;
+     q->result=do_telescope_command(q->command,q->reply,TELESCOPE_COMMAND_TIMEOUT,host_name);
+
+     return(NULL);
+}
+
+/*****************************************************/
+
+/* parse the reply to WEATHER_COMMAND into w */
+
+static void parse_weather_reply(char *reply, Weather_Info *w)
 {
-     char reply[MAXBUFSIZE];
-     char s[256],*s_ptr;
+     char *s_ptr;
 
+       s_ptr=reply;
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->temperature));
+       s_ptr++;
+
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->humidity));
+       s_ptr++;
+
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->wind_speed));
+       s_ptr++;
+
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->wind_direction));
+       s_ptr++;
+
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->dew_point));
+       s_ptr++;
+#if 0
+       s_ptr=strstr(s_ptr,":");
+       if(s_ptr!=NULL)
+          sscanf(s_ptr+1,"%lf",&(w->dome_states));
+#endif
+
+     return;
+}
+
+/*****************************************************/
+
+/* copy the fields read from the telescope controller from src to dest */
+
+static void copy_polled_status(Telescope_Status *dest, Telescope_Status *src)
+{
+     dest->lst=src->lst;
+     dest->focus=src->focus;
+     dest->dome_status=src->dome_status;
+     dest->ut=src->ut;
+     dest->ra=src->ra;
+     dest->dec=src->dec;
+     dest->weather=src->weather;
+     dest->update_time=src->update_time;
+
+     return;
+}
+
+/*****************************************************/
+
+/* query the telescope controller, filling in the polled fields of status */
+
+static int query_telescope_status(Telescope_Status *status)
+{
+     Status_Query q[NUM_STATUS_QUERIES];
+     pthread_t thread[NUM_STATUS_QUERIES];
+     int started[NUM_STATUS_QUERIES];
+     char s[256];
+     int i;
+
+     q[0].command=DOMESTATUS_COMMAND;
+     q[1].command=LST_COMMAND;
+     q[2].command=GETFOCUS_COMMAND;
+     q[3].command=POSRD_COMMAND;
+     q[4].command=WEATHER_COMMAND;
 
      status->ut=get_ut();
+     status->update_time=get_unix_time();
+
+     /* run the first query in this thread, the rest in parallel. If a
+        thread can't be started, run its query here afterwards */
+
+     for(i=1;i<NUM_STATUS_QUERIES;i++){
+        started[i]=(pthread_create(thread+i,NULL,status_query_thread,(void *)(q+i))==0);
+     }
+     status_query_thread((void *)q);
+     for(i=1;i<NUM_STATUS_QUERIES;i++){
+        if(started[i]){
+           pthread_join(thread[i],NULL);
+        }
+        else{
+           status_query_thread((void *)(q+i));
+        }
+     }
 
-     if(do_telescope_command(DOMESTATUS_COMMAND,reply,TELESCOPE_COMMAND_TIMEOUT,host_name)!=0){
+     if(q[0].result!=0){
        fprintf(stderr,"update_telescope_status: error getting domestatus\n");
        fflush(stderr);
        return(-1);
      }
-     else if (strstr(reply, TEL_DONE_REPLY)!=NULL){
-       if(strstr(reply,"open")!=NULL){
+     else if (strstr(q[0].reply, TEL_DONE_REPLY)!=NULL){
+       if(strstr(q[0].reply,"open")!=NULL){
          status->dome_status=1;
        }
        else{
@@ -660,24 +856,72 @@ int update_telescope_status(Telescope_Status *status)
        }
      }
 
-
-     if(do_telescope_command(LST_COMMAND,reply,TELESCOPE_COMMAND_TIMEOUT,host_name)!=0){
+     if(q[1].result!=0){
        fprintf(stderr,"update_telescope_status: error getting lst\n");
        fflush(stderr);
        return(-1);
      }
-     else if (strstr(reply, TEL_DONE_REPLY)!=NULL){
-       sscanf(reply,"%s %lf",s,&(status->lst));
+     else if (strstr(q[1].reply, TEL_DONE_REPLY)!=NULL){
+       sscanf(q[1].reply,"%s %lf",s,&(status->lst));
      }
 /* debug */
 /*status->lst=status->lst + 3.0;*/
 
-
-     if(get_telescope_focus(&(status->focus))!=0){
+     status->focus= NOMINAL_FOCUS_DEFAULT;
+     if(q[2].result!=0||strstr(q[2].reply, TEL_DONE_REPLY)==NULL){
        fprintf(stderr,"update_telescope_status: error getting focus\n");
+       if(q[2].result==0)fprintf(stderr,"get_telescope_focus: reply: %s\n",q[2].reply);
+       fflush(stderr);
+       return(-1);
+     }
+     sscanf(q[2].reply,"%s %lf",s,&(status->focus));
+
+     if(q[3].result!=0){
+       fprintf(stderr,"update_telescope_status: error getting position\n");
        fflush(stderr);
        return(-1);
      }
+     else if (strstr(q[3].reply, TEL_DONE_REPLY)!=NULL){
+       sscanf(q[3].reply,"%s %lf %lf",s,&(status->ra),&(status->dec));
+     }
+
+     if(q[4].result!=0){
+       fprintf(stderr,"update_telescope_status: error getting weather\n");
+       fflush(stderr);
+       return(-1);
+     }
+     else if (strstr(q[4].reply, TEL_DONE_REPLY)!=NULL){
+       parse_weather_reply(q[4].reply,&(status->weather));
+     }
+
+     return(0);
+}
+
+/*****************************************************/
+
+/* get a fresh telescope status from the controller, and publish it as
+   the latest snapshot */
+
+int update_telescope_status(Telescope_Status *status)
+{
+     Telescope_Status new_status;
+
+     pthread_mutex_lock(&tel_snapshot_mutex);
+     new_status=tel_snapshot;
+     pthread_mutex_unlock(&tel_snapshot_mutex);
+
+     if(query_telescope_status(&new_status)!=0){
+       return(-1);
+     }
+
+     pthread_mutex_lock(&tel_snapshot_mutex);
+     if(!tel_snapshot_valid||new_status.update_time>=tel_snapshot.update_time){
+        tel_snapshot=new_status;
+        tel_snapshot_valid=1;
+     }
+     pthread_mutex_unlock(&tel_snapshot_mutex);
+
+     copy_polled_status(status,&new_status);
 
 #if 0
      if(do_daytime_telescope_command(FILTER_COMMAND,reply,TELESCOPE_COMMAND_TIMEOUT,host)!=0){
@@ -691,61 +935,120 @@ int update_telescope_status(Telescope_Status *status)
 #endif
      sprintf(status->filter_string,"UNKNOWN");
 
+     return(0);
 
+}
 
-     if(do_telescope_command(POSRD_COMMAND,reply,TELESCOPE_COMMAND_TIMEOUT,host_name)!=0){
-       fprintf(stderr,"update_telescope_status: error getting position\n");
-       fflush(stderr);
-       return(-1);
+/*****************************************************/
+
+/* Fill in status from the latest snapshot if it is no more than
+   max_age_sec old, with ut and lst advanced to the present. Otherwise
+   get a fresh status from the controller */
+
+int get_telescope_status(Telescope_Status *status, double max_age_sec)
+{
+     Telescope_Status snapshot;
+     double age;
+     int valid;
+
+     pthread_mutex_lock(&tel_snapshot_mutex);
+     snapshot=tel_snapshot;
+     valid=tel_snapshot_valid;
+     pthread_mutex_unlock(&tel_snapshot_mutex);
+
+     age=get_unix_time()-snapshot.update_time;
+     if(!valid||age<0.0||age>max_age_sec){
+        return(update_telescope_status(status));
      }
-     else if (strstr(reply, TEL_DONE_REPLY)!=NULL){
-       sscanf(reply,"%s %lf %lf",s,&(status->ra),&(status->dec));
+
+     snapshot.ut=snapshot.ut+age/3600.0;
+     if(snapshot.ut>=24.0)snapshot.ut=snapshot.ut-24.0;
+     snapshot.lst=snapshot.lst+(age/3600.0)*(24.0/SIDEREAL_DAY_IN_HOURS);
+     if(snapshot.lst>=24.0)snapshot.lst=snapshot.lst-24.0;
+
+     copy_polled_status(status,&snapshot);
+     sprintf(status->filter_string,"UNKNOWN");
+
+     if(verbose1){
+        fprintf(stderr,"get_telescope_status: using status from %6.2f sec ago\n",age);
+        fflush(stderr);
      }
 
+     return(0);
+}
 
-     if(do_telescope_command(WEATHER_COMMAND,reply,TELESCOPE_COMMAND_TIMEOUT,host_name)!=0){
-       fprintf(stderr,"update_telescope_status: error getting weather\n");
-       fflush(stderr);
-       return(-1);
+/*****************************************************/
+
+static void *telescope_status_poller(void *args)
+{
+     Telescope_Status status;
+     struct timespec ts;
+     double t;
+
+     memset((void *)&status,0,sizeof(status));
+
+     pthread_mutex_lock(&tel_poller_mutex);
+     while(tel_poller_running){
+        pthread_mutex_unlock(&tel_poller_mutex);
+
+        if(update_telescope_status(&status)!=0&&verbose){
+           fprintf(stderr,"telescope_status_poller: could not update telescope status\n");
+           fflush(stderr);
+        }
+
+        t=get_wall_time()+tel_poller_period_sec/get_clock_speed();
+        ts.tv_sec=(time_t)t;
+        ts.tv_nsec=(long)((t-ts.tv_sec)*1.0e9);
+
+        pthread_mutex_lock(&tel_poller_mutex);
+        while(tel_poller_running&&
+              pthread_cond_timedwait(&tel_poller_cond,&tel_poller_mutex,&ts)==0);
      }
-     else if (strstr(reply, TEL_DONE_REPLY)!=NULL){
+     pthread_mutex_unlock(&tel_poller_mutex);
 
-       s_ptr=reply;
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).temperature));
-       s_ptr++;
+     return(NULL);
+}
 
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).humidity));
-       s_ptr++;
+/*****************************************************/
 
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).wind_speed));
-       s_ptr++;
+/* start a thread that updates the telescope status snapshot every
+   period_sec seconds. On a stepped clock (see set_clock_stepped()) time
+   only passes while the main thread waits, so there is nothing to poll
+   between, and get_telescope_status() asks for the status itself */
 
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).wind_direction));
-       s_ptr++;
+int start_telescope_status_poller(double period_sec)
+{
+     if(tel_poller_running||clock_is_stepped())return(0);
 
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).dew_point));
-       s_ptr++;
-#if 0
-       s_ptr=strstr(s_ptr,":");
-       if(s_ptr!=NULL)
-          sscanf(s_ptr+1,"%lf",&((status->weather).dome_states));
-#endif
+     tel_poller_period_sec=period_sec;
+     tel_poller_running=1;
 
+     if(pthread_create(&tel_poller_thread,NULL,telescope_status_poller,NULL)!=0){
+        fprintf(stderr,"start_telescope_status_poller: can't start thread\n");
+        fflush(stderr);
+        tel_poller_running=0;
+        return(-1);
      }
 
      return(0);
+}
+
+/*****************************************************/
+
+int stop_telescope_status_poller()
+{
+     if(!tel_poller_running)return(0);
+
+     pthread_mutex_lock(&tel_poller_mutex);
+     tel_poller_running=0;
+     pthread_cond_signal(&tel_poller_cond);
+     pthread_mutex_unlock(&tel_poller_mutex);
+
+     pthread_join(tel_poller_thread,NULL);
 
+     return(0);
 }
+
 /*****************************************************/
 
 int print_telescope_status(Telescope_Status *status,FILE *output)
@@ -775,6 +1078,22 @@ int print_telescope_status(Telescope_Status *status,FILE *output)
 
 /*****************************************************/
 
+/* add the telescope controller ports to the connection pool */
+
+int open_telescope_connections(char *host)
+{
+     if(add_socket_endpoint(host,TEL_COMMAND_PORT)!=0||
+        add_socket_endpoint(host,DAYTIME_TEL_COMMAND_PORT)!=0){
+        fprintf(stderr,"open_telescope_connections: can't add host %s\n",host);
+        fflush(stderr);
+        return(-1);
+     }
+
+     return(0);
+}
+
+/*****************************************************/
+
 int do_telescope_command(char *command, char *reply, int timeout, char *host)
 {
 
@@ -860,145 +1179,3 @@ int do_daytime_telescope_command(char *command, char *reply, int timeout, char *
 
 /*****************************************************/
 
-double get_ut() {
-
-  time_t t;
-  struct tm *tm;
-  double ut;
-
-  time(&t);
-  tm = gmtime(&t);
-
-  /* get ut time in fractional hour for current day */
-  ut = tm->tm_hour + tm->tm_min/60. + tm->tm_sec/3600.;
-
-/*debug*/
-
-  if(UT_OFFSET!=0.0){
-     ut=ut+UT_OFFSET;
-     if(ut>24.0)ut=ut-24.0;
-  }
-
-  return(ut);
-}
-
-/*****************************************************/
-
-/* return tm structure with year, month, day, hour,
-   minute, second filled out. Also return UT in hours */
-
-double get_tm(struct tm *tm_out) {
-
-  time_t t;
-  struct tm *tm;
-  double ut;
-
-  time(&t);
-  tm = gmtime(&t);
-
-
-  /* use convention Jan is month 1, not 0 */
-  tm->tm_mon=tm->tm_mon+1; 
-
-  /* change from year 0 = 1900 to year 1900 = 1900 */
-  tm->tm_year=tm->tm_year+1900;
-
-  /* get ut time in fractional hour for current day */
-  ut = tm->tm_hour + tm->tm_min/60. + tm->tm_sec/3600.;
-
-/*debug*/
-
-  if(UT_OFFSET!=0.0){
-
-     ut=ut+UT_OFFSET;
-     if(ut>24.0){
-         ut=ut-24.0;
-         advance_tm_day(tm);
-     }   
-     tm->tm_hour=ut;
-     tm->tm_min=(ut-tm->tm_hour)*60.0;
-     tm->tm_sec=(ut - tm->tm_hour - (tm->tm_min/60.0) )*3600.0;
-  }
-
-
-  if(tm_out!=NULL)*tm_out=*tm;
-
-  return(ut);
-}
-
-/*****************************************************/
-
-int advance_tm_day(struct tm *tm)
-{
-    tm->tm_mday=tm->tm_mday+1;
-
-    if(tm->tm_mday==29 && tm->tm_mon==2 && !leap_year_check(tm->tm_year)){ 
-       tm->tm_mon=3;
-       tm->tm_mday=1;
-    }
-    else if(tm->tm_mday==30 && tm->tm_mon==2 ){ 
-       tm->tm_mon=3;
-       tm->tm_mday=1;
-    }
-    else if (tm->tm_mday==31 && (tm->tm_mon == 4 || 
-        tm->tm_mon ==6 || tm->tm_mon == 9 || tm->tm_mon==11 ) ) {
-        tm->tm_mon=tm->tm_mon+1;
-        tm->tm_mday=1;
-    }
-    else if (tm->tm_mday==32) {
-        tm->tm_mon=tm->tm_mon+1;
-        tm->tm_mday=1;
-        if(tm->tm_mon==13){
-          tm->tm_mon=1;
-          tm->tm_year=tm->tm_year+1;
-        }
-    }
-    return(0);
-}
-
-/*****************************************************/
-
-int leap_year_check(int year)
-{
-   int n;
-   
-
-   n=year/4;
-   n=4*n;
-   if ( n != year ) return(0);
-
-   n = year/100;
-   n = n * 100;
-   if ( n != year ) return(1);
-
-   n =  year/400;
-   n = n*400;
-
-   if( n == year) return(1);
-
-   return(0);
-}
-
-/*****************************************************/
-
-double get_jd()
-{
-    struct tm tm;
-    struct date_time date;
-    double jd;
-
-    get_tm(&tm);
-
-    date.y=tm.tm_year;
-    date.mo=tm.tm_mon;
-    date.d=tm.tm_mday;
-    date.h=tm.tm_hour;
-    date.mn=tm.tm_min;
-    date.s=tm.tm_sec;
-
-    jd=date_to_jd(date);
-
-    return(jd);
-}
-/*****************************************************/
-
@@ -0,0 +1,399 @@
+/* scheduler_worker.c
+
+   2026 Oct 14
+
+   Camera command workers.
+
+   Commands for the camera control program (ls4_ccp) are not sent by the
+   thread that wants them done. They are put on the queue of a long-lived
+   worker thread, which sends them one at a time, in the order queued, and
+   records each reply. queue_camera_command() returns a ticket at once,
+   and wait_camera_command() later waits (with a timeout) for that
+   ticket's reply. So a caller can queue a clear, the header keywords and
+   the next exposure and get on with something else (moving the
+   telescope) while they are sent.
+
+   There is one worker for COMMAND_PORT (expose, clear and header
+   commands) and one for STATUS_PORT (status queries), so a status query
+   is never held up behind an exposure.
+
+   Every ticket must be waited for with wait_camera_command() and then
+   released with release_camera_command(), or queued with detach = True,
+   in which case the worker discards the reply itself (reporting any
+   error to stderr). A released ticket whose command is still queued or
+   running is discarded when it finishes.
+*/
+
+#include "scheduler.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#define SLOT_FREE 0
+#define SLOT_QUEUED 1
+#define SLOT_RUNNING 2
+#define SLOT_DONE 3
+
+extern int verbose;
+extern int verbose1;
+extern char *host_name;
+extern int command_id;
+
+typedef struct{
+   int state;
+   int ticket;
+   int type;
+   int id;
+   int timeout_sec;
+   int result;
+   bool detached;
+   char command[MAXBUFSIZE];
+   char reply[MAXBUFSIZE];
+   double t_done;          /* unix time the reply came (see get_unix_time()) */
+} Camera_Command_Slot;
+
+typedef struct{
+   char *name;
+   int port;
+   int running;
+   int head;               /* next slot to send */
+   int tail;               /* next slot to fill */
+   int next_ticket;
+   pthread_t thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t queued;  /* signalled when a command is queued */
+   pthread_cond_t done;    /* broadcast when a command finishes */
+   Camera_Command_Slot slot[CAMERA_QUEUE_SIZE];
+} Camera_Worker;
+
+static Camera_Worker command_worker={"command",COMMAND_PORT,0,0,0,0,0,
+   PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,PTHREAD_COND_INITIALIZER};
+static Camera_Worker status_worker={"status",STATUS_PORT,0,0,0,0,0,
+   PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,PTHREAD_COND_INITIALIZER};
+
+int start_camera_workers();
+int queue_camera_command(int type, char *command, int timeout_sec, bool detach);
+int wait_camera_command(int ticket, int timeout_sec, char *reply);
+int release_camera_command(int ticket);
+int run_camera_command(int type, char *command, char *reply, int timeout_sec);
+
+/************************************************************/
+
+/* tickets of the status worker are odd, those of the command worker
+   even, so a ticket identifies its worker */
+
+static Camera_Worker *ticket_worker(int ticket)
+{
+    return((ticket&1) ? &status_worker : &command_worker);
+}
+
+/************************************************************/
+
+static Camera_Command_Slot *ticket_slot(Camera_Worker *w, int ticket)
+{
+    return(w->slot+(ticket>>1)%CAMERA_QUEUE_SIZE);
+}
+
+/************************************************************/
+
+static void *camera_worker_thread(void *args)
+{
+    Camera_Worker *w;
+    Camera_Command_Slot *s;
+    double t_start;
+
+    w=(Camera_Worker *)args;
+
+    pthread_mutex_lock(&w->mutex);
+    while(w->running){
+       s=w->slot+w->head;
+       if(s->state!=SLOT_QUEUED){
+          pthread_cond_wait(&w->queued,&w->mutex);
+          continue;
+       }
+       s->state=SLOT_RUNNING;
+       pthread_mutex_unlock(&w->mutex);
+
+       t_start=get_ut();
+       if(verbose1){
+          fprintf(stderr,"camera_worker_thread[%s]: time %12.6f : sending command %d [%s]\n",
+             w->name,t_start,s->id,s->command);
+          fflush(stderr);
+       }
+
+       /* the slot is not touched by other threads while RUNNING */
+
+       s->result=do_command(s->command,s->reply,s->timeout_sec,w->port,s->id,host_name);
+       s->t_done=get_unix_time();
+
+       if(verbose1){
+          fprintf(stderr,"camera_worker_thread[%s]: time %12.6f : command %d done after %7.3f sec, result %d\n",
+             w->name,get_ut(),s->id,(get_ut()-t_start)*3600.0,s->result);
+          fflush(stderr);
+       }
+
+       pthread_mutex_lock(&w->mutex);
+       if(s->detached){
+          if(s->result!=0){
+             fprintf(stderr,"camera_worker_thread[%s]: detached command [%s] failed\n",
+                w->name,s->command);
+             fflush(stderr);
+          }
+          s->state=SLOT_FREE;
+       }
+       else{
+          s->state=SLOT_DONE;
+       }
+       w->head=(w->head+1)%CAMERA_QUEUE_SIZE;
+       pthread_cond_broadcast(&w->done);
+    }
+    pthread_mutex_unlock(&w->mutex);
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* wait until neither worker has a command queued or running. On a
+   stepped clock (see set_clock_stepped()) this is done before the clock
+   moves, so each command is sent at the time it was queued */
+
+static void settle_camera_workers()
+{
+    Camera_Worker *w;
+    int i,state;
+
+    for(i=0;i<2;i++){
+       w=(i==0 ? &command_worker : &status_worker);
+       pthread_mutex_lock(&w->mutex);
+       while(w->running){
+          state=w->slot[w->head].state;
+          if(state!=SLOT_QUEUED&&state!=SLOT_RUNNING)break;
+          pthread_cond_wait(&w->done,&w->mutex);
+       }
+       pthread_mutex_unlock(&w->mutex);
+    }
+}
+
+/************************************************************/
+
+static int start_worker(Camera_Worker *w)
+{
+    if(w->running)return(0);
+
+    if(clock_is_stepped())set_clock_settle(settle_camera_workers);
+
+    w->running=1;
+    if(pthread_create(&w->thread,NULL,camera_worker_thread,(void *)w)!=0){
+       fprintf(stderr,"start_camera_workers: can't start %s worker thread\n",w->name);
+       fflush(stderr);
+       w->running=0;
+       return(-1);
+    }
+    pthread_detach(w->thread);
+
+    if(verbose){
+       fprintf(stderr,"start_camera_workers: %s worker sending to port %d\n",
+          w->name,w->port);
+       fflush(stderr);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* start both workers, if they are not already running. They are also
+   started by the first command queued to them */
+
+int start_camera_workers()
+{
+    int result;
+
+    pthread_mutex_lock(&command_worker.mutex);
+    result=start_worker(&command_worker);
+    pthread_mutex_unlock(&command_worker.mutex);
+    if(result!=0)return(-1);
+
+    pthread_mutex_lock(&status_worker.mutex);
+    result=start_worker(&status_worker);
+    pthread_mutex_unlock(&status_worker.mutex);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* Queue command (of type CAMERA_CMD_xxx) to be sent with reply timeout
+   timeout_sec. Return its ticket, or -1 if the queue is full or the
+   command too long */
+
+int queue_camera_command(int type, char *command, int timeout_sec, bool detach)
+{
+    Camera_Worker *w;
+    Camera_Command_Slot *s;
+    int ticket;
+
+    if(strlen(command)>=MAXBUFSIZE){
+       fprintf(stderr,"queue_camera_command: command too long : [%s]\n",command);
+       fflush(stderr);
+       return(-1);
+    }
+
+    w=(type==CAMERA_CMD_STATUS) ? &status_worker : &command_worker;
+
+    pthread_mutex_lock(&w->mutex);
+
+    if(start_worker(w)!=0){
+       pthread_mutex_unlock(&w->mutex);
+       return(-1);
+    }
+
+    s=w->slot+w->tail;
+    if(s->state!=SLOT_FREE){
+       fprintf(stderr,"queue_camera_command: %s queue is full, can't queue [%s]\n",
+          w->name,command);
+       fflush(stderr);
+       pthread_mutex_unlock(&w->mutex);
+       return(-1);
+    }
+
+    /* the ticket maps back to this slot (see ticket_slot()) */
+
+    ticket=w->next_ticket*2*CAMERA_QUEUE_SIZE+2*w->tail+(w==&status_worker);
+    w->next_ticket++;
+    if(w->next_ticket>=(1<<20))w->next_ticket=0;
+
+    s->state=SLOT_QUEUED;
+    s->ticket=ticket;
+    s->type=type;
+    s->id=command_id++;
+    s->timeout_sec=timeout_sec;
+    s->result=-1;
+    s->detached=detach;
+    strcpy(s->command,command);
+    s->reply[0]=0;
+    w->tail=(w->tail+1)%CAMERA_QUEUE_SIZE;
+
+    pthread_cond_signal(&w->queued);
+    pthread_mutex_unlock(&w->mutex);
+
+    return(ticket);
+}
+
+/************************************************************/
+
+/* Wait up to timeout_sec (forever if timeout_sec <= 0) for the command
+   with ticket to be sent. Copy its reply to reply (if not NULL). Return
+   0 if the command succeeded, -1 if it failed or the ticket is not
+   valid, or CAMERA_WAIT_TIMEOUT if it has not finished yet. The ticket
+   stays valid until it is released */
+
+int wait_camera_command(int ticket, int timeout_sec, char *reply)
+{
+    Camera_Worker *w;
+    Camera_Command_Slot *s;
+    struct timespec ts;
+    double t_done;
+    int result;
+
+    if(ticket<0)return(-1);
+
+    w=ticket_worker(ticket);
+    s=ticket_slot(w,ticket);
+
+    clock_gettime(CLOCK_REALTIME,&ts);
+    ts.tv_sec=ts.tv_sec+timeout_sec;
+
+    pthread_mutex_lock(&w->mutex);
+
+    if(s->ticket!=ticket||s->state==SLOT_FREE||s->detached){
+       pthread_mutex_unlock(&w->mutex);
+       fprintf(stderr,"wait_camera_command: ticket %d is not valid\n",ticket);
+       fflush(stderr);
+       return(-1);
+    }
+
+    while(s->state!=SLOT_DONE){
+       if(timeout_sec<=0){
+          pthread_cond_wait(&w->done,&w->mutex);
+       }
+       else if(pthread_cond_timedwait(&w->done,&w->mutex,&ts)==ETIMEDOUT){
+          break;
+       }
+    }
+
+    t_done=-1.0;
+    if(s->state==SLOT_DONE){
+       result=s->result;
+       if(reply!=NULL)strcpy(reply,s->reply);
+       t_done=s->t_done;
+    }
+    else{
+       result=CAMERA_WAIT_TIMEOUT;
+    }
+
+    pthread_mutex_unlock(&w->mutex);
+
+    /* the reply came at t_done on a stepped clock, which the caller has
+       waited until */
+
+    if(t_done>0.0)clock_sync(t_done);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* Give up the ticket. If its command has not finished, the worker still
+   sends it but discards the reply */
+
+int release_camera_command(int ticket)
+{
+    Camera_Worker *w;
+    Camera_Command_Slot *s;
+
+    if(ticket<0)return(-1);
+
+    w=ticket_worker(ticket);
+    s=ticket_slot(w,ticket);
+
+    pthread_mutex_lock(&w->mutex);
+    if(s->ticket==ticket&&s->state!=SLOT_FREE){
+       if(s->state==SLOT_DONE){
+          s->state=SLOT_FREE;
+       }
+       else{
+          s->detached=True;
+       }
+    }
+    pthread_mutex_unlock(&w->mutex);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* queue command and wait for its reply. Return 0 on success, -1 on
+   failure */
+
+int run_camera_command(int type, char *command, char *reply, int timeout_sec)
+{
+    int ticket,result;
+
+    ticket=queue_camera_command(type,command,timeout_sec,False);
+    if(ticket<0){
+       if(reply!=NULL)*reply=0;
+       return(-1);
+    }
+
+    /* the worker gives up on the reply after timeout_sec, so no need for
+       a second timeout here */
+
+    result=wait_camera_command(ticket,0,reply);
+    release_camera_command(ticket);
+
+    return(result);
+}
+
+/************************************************************/
@@ -0,0 +1,674 @@
+/* season_sim.c
+
+   2026 Oct 14
+
+   Monte Carlo simulation of an observing season on a pool of threads.
+
+   Each night of the season is simulated n_trials times, each time with
+   a different realisation of the weather, by run_night() on the
+   virtual hardware and a virtual clock (see sched_sim.c for a single
+   run with a weather file). Since the scheduler starts every night
+   afresh, the n_nights*n_trials runs are independent jobs, which
+   n_threads workers take from a shared counter.
+
+   Each worker has its own context (Season_Worker): its own copy of the
+   fields, clock, hardware, weather and running totals, so nothing it
+   changes is shared. The fields are set back to the sequence as read
+   (restore_fields()) before every job. The night times of the season
+   are worked out once before the workers start, since the cache of
+   get_night_times() is not locked. The weather of each job is drawn
+   from a generator seeded by the seed, the trial and the night, so the
+   results do not depend on the number of threads or the order the jobs
+   are run in.
+
+   The weather model: a night is clear with probability p_clear.
+   Otherwise the dome is closed for one stretch of it, with start and
+   end drawn uniformly over the night.
+
+   After all jobs are done the workers' totals are summed, and for each
+   survey code (stderr) and each field (stdout) the mean number of
+   exposures per night and the fraction of nights with all the
+   observations of the field completed are printed.
+
+   With -c, the season is instead run for each candidate mix of survey
+   codes, balanced the way sequencer.c used to balance a single night:
+   the season is simulated, and while the fraction of completed fields
+   of some code is more than CUT_TOLERANCE above its target, the lowest
+   priority fields of that code that were completed are cut (cut_fields())
+   and the season is simulated again, up to MAX_CUT_ITERATIONS times. A
+   cut field is kept in the sequence but never observed. The priority of
+   a field is the number after the survey code and one word on its
+   script line, as sequencer.c read it (0 if there is none). Each
+   candidate is scored by the largest difference between a fraction and
+   its target (stderr), and the sequence of the best candidate is
+   printed (stdout), with "## excluded" before the lines of the fields
+   cut.
+
+   syntax: season_sim [-c f0:f1:...[,f0:f1:...]] sequence_file yyyy mm dd n_nights n_trials
+       n_threads p_clear seed
+
+   where yyyy mm dd is the local date of the first night, and each
+   candidate of -c lists the target fractions of completed fields for
+   survey codes 0, 1, ... (a code left out, or given a negative
+   fraction, is never cut).
+*/
+
+#include "scheduler.h"
+#include <pthread.h>
+#include <sys/time.h>
+
+#define MAX_SEASON_THREADS 256
+#define MAX_CUT_CANDIDATES 64
+#define MAX_CUT_ITERATIONS 20
+#define CUT_TOLERANCE 0.05 /* largest difference from the target fractions */
+
+extern int verbose;
+
+typedef struct {
+    unsigned int seed; /* generator state of this night's weather */
+    double jd_closed; /* dome closed from jd_closed to jd_open */
+    double jd_open;
+} Season_Weather;
+
+/* night times of one night of the season */
+
+typedef struct {
+    struct date_time date;
+    Night_Times nt,nt_5day,nt_10day,nt_15day;
+} Season_Night;
+
+typedef struct Season Season;
+
+/* context of one worker thread */
+
+typedef struct {
+    Season *season;
+    pthread_t thread;
+    Field_Store store; /* this worker's copy of the fields */
+    Sched_Clock clock;
+    Sched_Hardware hw;
+    Season_Weather weather;
+    Telescope_Status tel_status;
+    double *n_exposures; /* per field, summed over this worker's jobs */
+    double *n_completed; /* per field, nights completed */
+    double t_observing,t_idle;
+    int n_jobs,n_errors;
+} Season_Worker;
+
+/* a mix of survey codes to balance the sequence to (see cut_fields()) */
+
+typedef struct {
+    double target[MAX_SURVEY_CODE+1]; /* fraction of completed fields, <0 if any */
+    double fraction[MAX_SURVEY_CODE+1]; /* fraction reached */
+    double deviation; /* largest difference from a target */
+    double exposures,completed; /* per night */
+    int n_iterations,n_cut;
+} Cut_Candidate;
+
+struct Season {
+    int n_nights,n_trials,n_jobs,num_fields;
+    double p_clear;
+    unsigned int seed;
+    Site_Params site;
+    Season_Night *nights;
+    Field *fields; /* the fields as read from the script */
+    double *priority; /* per field, for cut_fields() */
+    char *cut; /* per field, 1 if cut from the sequence */
+    int next_job; /* next job to hand out */
+    pthread_mutex_t mutex;
+    int result;
+};
+
+/************************************************************/
+
+static double uniform_deviate(unsigned int *seed)
+{
+    return(rand_r(seed)/((double)RAND_MAX+1.0));
+}
+
+/************************************************************/
+
+static int random_bad_weather(Sched_Hardware *hw, double jd, Night_Times *nt)
+{
+    Season_Weather *w;
+
+    w=(Season_Weather *)hw->arg;
+
+    return(jd>=w->jd_closed&&jd<w->jd_open);
+}
+
+/************************************************************/
+
+static double random_weather_clears(Sched_Hardware *hw, double jd, Night_Times *nt)
+{
+    Season_Weather *w;
+
+    w=(Season_Weather *)hw->arg;
+
+    if(jd>=w->jd_closed&&jd<w->jd_open)return(w->jd_open);
+
+    return(jd);
+}
+
+/************************************************************/
+
+/* draw the weather of trial on night n */
+
+static void init_season_weather(Season_Weather *w, Season *season, int trial, int n,
+        Night_Times *nt)
+{
+    double t1,t2,t;
+
+    w->seed=season->seed^(2654435761u*(unsigned int)(trial+1))^(40503u*(unsigned int)(n+1));
+    uniform_deviate(&(w->seed));
+
+    w->jd_closed=0.0;
+    w->jd_open=0.0;
+
+    if(uniform_deviate(&(w->seed))<season->p_clear)return;
+
+    t1=uniform_deviate(&(w->seed));
+    t2=uniform_deviate(&(w->seed));
+    if(t2<t1){
+       t=t1;
+       t1=t2;
+       t2=t;
+    }
+    w->jd_closed=nt->jd_sunset+t1*(nt->jd_sunrise-nt->jd_sunset);
+    w->jd_open=nt->jd_sunset+t2*(nt->jd_sunrise-nt->jd_sunset);
+}
+
+/************************************************************/
+
+/* take the next job, or return -1 if there are none left */
+
+static int next_season_job(Season *season)
+{
+    int job;
+
+    pthread_mutex_lock(&(season->mutex));
+    if(season->result!=0||season->next_job>=season->n_jobs){
+       job=-1;
+    }
+    else{
+       job=season->next_job;
+       season->next_job++;
+    }
+    pthread_mutex_unlock(&(season->mutex));
+
+    return(job);
+}
+
+/************************************************************/
+
+static void *season_worker_thread(void *args)
+{
+    Season_Worker *w;
+    Season *season;
+    Season_Night *night;
+    Night_Summary summary;
+    Field *f;
+    int job,i;
+
+    w=(Season_Worker *)args;
+    season=w->season;
+
+    while((job=next_season_job(season))>=0){
+       night=season->nights+job%season->n_nights;
+       init_season_weather(&(w->weather),season,job/season->n_nights,
+          job%season->n_nights,&(night->nt));
+
+       restore_fields(&(w->store),season->fields,season->num_fields);
+       init_fields(w->store.fields,season->num_fields,&(night->nt),&(night->nt_5day),
+          &(night->nt_10day),&(night->nt_15day),&(season->site),night->nt.jd_sunset,
+          &(w->tel_status));
+       for(i=0;i<season->num_fields;i++){
+          if(season->cut[i])w->store.fields[i].doable=0;
+       }
+
+       init_virtual_clock(&(w->clock),night->nt.jd_sunset);
+       init_virtual_hardware(&(w->hw),&(w->clock),NULL,NULL,night->date);
+       w->hw.bad_weather=random_bad_weather;
+       w->hw.weather_clears=random_weather_clears;
+       w->hw.arg=(void *)&(w->weather);
+
+       if(run_night(&(w->store),&(night->nt),&(w->clock),
+             &(w->hw),NULL,&summary)<0){
+          pthread_mutex_lock(&(season->mutex));
+          season->result=-1;
+          pthread_mutex_unlock(&(season->mutex));
+          break;
+       }
+
+       for(i=0;i<season->num_fields;i++){
+          f=w->store.fields+i;
+          w->n_exposures[i]=w->n_exposures[i]+f->n_done;
+          if(f->n_done==f->n_required)w->n_completed[i]=w->n_completed[i]+1.0;
+       }
+       w->t_observing=w->t_observing+summary.t_observing;
+       w->t_idle=w->t_idle+summary.t_idle;
+       w->n_errors=w->n_errors+summary.n_errors;
+       w->n_jobs++;
+    }
+
+    return(NULL);
+}
+
+/************************************************************/
+
+/* run all the jobs of the season on n_threads workers and sum their
+   totals into those of worker 0. Return 0, or -1 on error */
+
+static int run_season(Season *season, Season_Worker *workers, int n_threads)
+{
+    Season_Worker *w;
+    int i,k;
+
+    season->next_job=0;
+    season->result=0;
+    for(k=0;k<n_threads;k++){
+       w=workers+k;
+       memset((void *)w->n_exposures,0,season->num_fields*sizeof(double));
+       memset((void *)w->n_completed,0,season->num_fields*sizeof(double));
+       w->t_observing=0.0;
+       w->t_idle=0.0;
+       w->n_jobs=0;
+       w->n_errors=0;
+    }
+
+    for(k=0;k<n_threads;k++){
+       if(pthread_create(&(workers[k].thread),NULL,season_worker_thread,
+             (void *)(workers+k))!=0){
+          fprintf(stderr,"season_sim: can't start worker %d\n",k);
+          exit(-1);
+       }
+    }
+    for(k=0;k<n_threads;k++)pthread_join(workers[k].thread,NULL);
+
+    if(season->result!=0){
+       fprintf(stderr,"season_sim: error simulating the season\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    for(k=1;k<n_threads;k++){
+       w=workers+k;
+       for(i=0;i<season->num_fields;i++){
+          workers[0].n_exposures[i]=workers[0].n_exposures[i]+w->n_exposures[i];
+          workers[0].n_completed[i]=workers[0].n_completed[i]+w->n_completed[i];
+       }
+       workers[0].t_observing=workers[0].t_observing+w->t_observing;
+       workers[0].t_idle=workers[0].t_idle+w->t_idle;
+       workers[0].n_errors=workers[0].n_errors+w->n_errors;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* the fraction of the completed fields (summed over the runs in
+   n_completed) that is of each survey code, for c. Return the
+   completed fields per run */
+
+static double completed_fractions(Season *season, double *n_completed, Cut_Candidate *c)
+{
+    double total;
+    int i,code;
+
+    for(code=0;code<=MAX_SURVEY_CODE;code++)c->fraction[code]=0.0;
+
+    total=0.0;
+    for(i=0;i<season->num_fields;i++){
+       c->fraction[season->fields[i].survey_code]+=n_completed[i];
+       total=total+n_completed[i];
+    }
+
+    c->deviation=0.0;
+    for(code=0;code<=MAX_SURVEY_CODE;code++){
+       if(total>0.0)c->fraction[code]=c->fraction[code]/total;
+       if(c->target[code]>=0.0&&fabs(c->fraction[code]-c->target[code])>c->deviation){
+          c->deviation=fabs(c->fraction[code]-c->target[code]);
+       }
+    }
+
+    return(total/season->n_jobs);
+}
+
+/************************************************************/
+
+/* As sequencer.c did for a night: for each survey code whose fraction
+   of the completed fields is above its target, cut the lowest priority
+   completed fields of that code (and the field paired with each) until
+   the excess is gone. A field counts as the fraction of runs it was
+   completed in. Return the number of fields cut */
+
+static int cut_fields(Season *season, double *n_completed, Cut_Candidate *c,
+        double completed)
+{
+    double dn;
+    int i,i_min,code,n_cut;
+    Field *f;
+
+    n_cut=0;
+    for(code=0;code<=MAX_SURVEY_CODE;code++){
+       if(c->target[code]<0.0)continue;
+
+       dn=(c->fraction[code]-c->target[code])*completed;
+
+       while(dn>0.0){
+          i_min=-1;
+          for(i=0;i<season->num_fields;i++){
+             f=season->fields+i;
+             if(f->survey_code!=code||season->cut[i]||n_completed[i]<=0.0)continue;
+             if(i_min<0||season->priority[i]<season->priority[i_min])i_min=i;
+          }
+          if(i_min<0)break;
+
+          season->cut[i_min]=1;
+          dn=dn-n_completed[i_min]/season->n_jobs;
+          n_cut++;
+
+          i=i_min+1;
+          if(i<season->num_fields&&!season->cut[i]&&season->fields[i].survey_code==code&&
+                paired_fields(season->fields+i_min,season->fields+i)){
+             season->cut[i]=1;
+             dn=dn-n_completed[i]/season->n_jobs;
+             n_cut++;
+          }
+       }
+    }
+
+    return(n_cut);
+}
+
+/************************************************************/
+
+/* read the candidates of -c from string. Return the number read, or -1
+   if string can't be read */
+
+static int parse_cut_candidates(char *string, Cut_Candidate *candidates)
+{
+    char *s,*t,*save_s,*save_t;
+    int n,code;
+
+    n=0;
+    for(s=strtok_r(string,",",&save_s);s!=NULL;s=strtok_r(NULL,",",&save_s)){
+       if(n>=MAX_CUT_CANDIDATES)return(-1);
+       memset((void *)(candidates+n),0,sizeof(Cut_Candidate));
+       for(code=0;code<=MAX_SURVEY_CODE;code++)candidates[n].target[code]=-1.0;
+       code=0;
+       for(t=strtok_r(s,":",&save_t);t!=NULL;t=strtok_r(NULL,":",&save_t)){
+          if(code>MAX_SURVEY_CODE||sscanf(t,"%lf",candidates[n].target+code)!=1)return(-1);
+          code++;
+       }
+       n++;
+    }
+
+    return(n);
+}
+
+/************************************************************/
+
+/* priority of a field: the number after the survey code and one word
+   on its script line, or 0 */
+
+static double field_priority(Field *f)
+{
+    char s[STR_BUF_LEN];
+    double priority;
+
+    if(f->history==NULL||f->history->script_line==NULL)return(0.0);
+
+    if(sscanf(f->history->script_line,"%*f %*f %*s %*f %*f %*d %*d %s %lf",
+          s,&priority)!=2)return(0.0);
+
+    return(priority);
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    Season season;
+    Season_Worker *workers,*w;
+    Season_Night *night;
+    struct date_time date,d;
+    struct timeval t0,t1;
+    double *n_exposures,*n_completed,t_observing,t_idle,n_runs;
+    double code_exposures[MAX_SURVEY_CODE+1],code_completed[MAX_SURVEY_CODE+1];
+    int code_fields[MAX_SURVEY_CODE+1];
+    int n,i,k,n_threads,n_errors,code;
+    Cut_Candidate candidates[MAX_CUT_CANDIDATES],*c;
+    char *best_cut;
+    int n_candidates,best;
+    Field *f;
+
+    n_candidates=0;
+    if(argc==12&&strcmp(argv[1],"-c")==0){
+       n_candidates=parse_cut_candidates(argv[2],candidates);
+       if(n_candidates<1){
+          fprintf(stderr,"season_sim: can't read candidates %s (at most %d)\n",
+             argv[2],MAX_CUT_CANDIDATES);
+          exit(-1);
+       }
+       argc=argc-2;
+       argv=argv+2;
+    }
+
+    if(argc!=10){
+       fprintf(stderr,
+         "syntax: season_sim [-c f0:f1:...[,f0:f1:...]] sequence_file yyyy mm dd n_nights n_trials n_threads p_clear seed\n");
+       exit(-1);
+    }
+
+    memset((void *)&season,0,sizeof(Season));
+    sscanf(argv[2],"%hd",&(date.y));
+    sscanf(argv[3],"%hd",&(date.mo));
+    sscanf(argv[4],"%hd",&(date.d));
+    sscanf(argv[5],"%d",&(season.n_nights));
+    sscanf(argv[6],"%d",&(season.n_trials));
+    sscanf(argv[7],"%d",&n_threads);
+    sscanf(argv[8],"%lf",&(season.p_clear));
+    sscanf(argv[9],"%u",&(season.seed));
+    date.h=0;
+    date.mn=0;
+    date.s=0;
+
+    if(season.n_nights<1||season.n_trials<1||n_threads<1||n_threads>MAX_SEASON_THREADS){
+       fprintf(stderr,"season_sim: need n_nights, n_trials >= 1 and 1 <= n_threads <= %d\n",
+          MAX_SEASON_THREADS);
+       exit(-1);
+    }
+    season.n_jobs=season.n_nights*season.n_trials;
+    pthread_mutex_init(&(season.mutex),NULL);
+
+    /* the selection rules print their progress if verbose is set, from
+       every thread at once. Keep them quiet */
+
+    verbose=0;
+
+    /* same site as the scheduler */
+
+    strcpy(season.site.site_name,"Fake");
+    load_site(&season.site.longit,&season.site.lat,&season.site.stdz,&season.site.use_dst,
+            season.site.zone_name,&season.site.zabr,&season.site.elevsea,&season.site.elev,
+            &season.site.horiz,season.site.site_name);
+
+    /* night times for the whole season */
+
+    season.nights=(Season_Night *)calloc(season.n_nights,sizeof(Season_Night));
+    if(season.nights==NULL){
+       fprintf(stderr,"season_sim: can't allocate %d nights\n",season.n_nights);
+       exit(-1);
+    }
+    for(n=0;n<season.n_nights;n++){
+       night=season.nights+n;
+       night->date=date;
+       adjust_date(&(night->date),n);
+       init_night(night->date,&(night->nt),&(season.site),0);
+       d=night->date;
+       adjust_date(&d,5);
+       init_night(d,&(night->nt_5day),&(season.site),0);
+       d=night->date;
+       adjust_date(&d,10);
+       init_night(d,&(night->nt_10day),&(season.site),0);
+       d=night->date;
+       adjust_date(&d,15);
+       init_night(d,&(night->nt_15day),&(season.site),0);
+    }
+
+    /* the overheads the scheduler would use (see scheduler_overhead.c) */
+
+    init_overhead_model(&overhead_model);
+    if(load_overhead_model(OVERHEAD_MODEL_FILE,&overhead_model)>=0){
+       fprintf(stderr,"# overheads from %s, fitted from %d observations\n",
+          OVERHEAD_MODEL_FILE,overhead_model.n_fit);
+    }
+
+    /* each worker reads its own copy of the sequence. Reading sets
+       globals (focus settings, filter name), so it is done here before
+       the workers start */
+
+    workers=(Season_Worker *)calloc(n_threads,sizeof(Season_Worker));
+    if(workers==NULL){
+       fprintf(stderr,"season_sim: can't allocate %d workers\n",n_threads);
+       exit(-1);
+    }
+    for(k=0;k<n_threads;k++){
+       w=workers+k;
+       w->season=&season;
+       init_field_store(&(w->store));
+       season.num_fields=load_sequence(argv[1],&(w->store),0);
+       if(season.num_fields<1){
+          fprintf(stderr,"Error loading script %s\n",argv[1]);
+          exit(-1);
+       }
+       if(k==0){
+          season.fields=(Field *)malloc(season.num_fields*sizeof(Field));
+          if(season.fields==NULL){
+             fprintf(stderr,"season_sim: can't allocate %d fields\n",season.num_fields);
+             exit(-1);
+          }
+          memcpy((void *)season.fields,(void *)w->store.fields,
+             season.num_fields*sizeof(Field));
+          season.priority=(double *)malloc(season.num_fields*sizeof(double));
+          season.cut=(char *)calloc(season.num_fields,sizeof(char));
+          best_cut=(char *)calloc(season.num_fields,sizeof(char));
+          if(season.priority==NULL||season.cut==NULL||best_cut==NULL){
+             fprintf(stderr,"season_sim: can't allocate cuts for %d fields\n",
+                season.num_fields);
+             exit(-1);
+          }
+          for(i=0;i<season.num_fields;i++){
+             season.priority[i]=field_priority(season.fields+i);
+          }
+       }
+       w->n_exposures=(double *)calloc(season.num_fields,sizeof(double));
+       w->n_completed=(double *)calloc(season.num_fields,sizeof(double));
+       if(w->n_exposures==NULL||w->n_completed==NULL){
+          fprintf(stderr,"season_sim: can't allocate totals for %d fields\n",
+             season.num_fields);
+          exit(-1);
+       }
+    }
+
+    n_exposures=workers[0].n_exposures;
+    n_completed=workers[0].n_completed;
+    n_runs=season.n_jobs;
+
+    gettimeofday(&t0,NULL);
+
+    /* balance each candidate mix, from the full sequence each time */
+
+    best=-1;
+    for(n=0;n<n_candidates;n++){
+       c=candidates+n;
+       memset((void *)season.cut,0,season.num_fields*sizeof(char));
+       for(c->n_iterations=1;;c->n_iterations++){
+          if(run_season(&season,workers,n_threads)!=0)exit(-1);
+          c->completed=completed_fractions(&season,n_completed,c);
+          if(c->deviation<=CUT_TOLERANCE||c->n_iterations>=MAX_CUT_ITERATIONS)break;
+          if(cut_fields(&season,n_completed,c,c->completed)==0)break;
+          c->n_cut=0;
+          for(i=0;i<season.num_fields;i++)c->n_cut+=season.cut[i];
+       }
+       c->exposures=0.0;
+       for(i=0;i<season.num_fields;i++)c->exposures+=n_exposures[i];
+       c->exposures=c->exposures/n_runs;
+
+       if(best<0||c->deviation<candidates[best].deviation||
+             (c->deviation==candidates[best].deviation&&
+              c->exposures>candidates[best].exposures)){
+          best=n;
+          memcpy((void *)best_cut,(void *)season.cut,season.num_fields*sizeof(char));
+       }
+    }
+
+    if(n_candidates>0){
+       gettimeofday(&t1,NULL);
+
+       fprintf(stderr,"# %d candidates, %d nights x %d trials on %d threads in %7.3f sec\n",
+          n_candidates,season.n_nights,season.n_trials,n_threads,
+          (t1.tv_sec-t0.tv_sec)+(t1.tv_usec-t0.tv_usec)*1.0e-6);
+       fprintf(stderr,"# candidate iterations fields_cut deviation exposures_per_night fields_completed_per_night fractions\n");
+       for(n=0;n<n_candidates;n++){
+          c=candidates+n;
+          fprintf(stderr,"# %d %3d %6d %7.4f %10.3f %10.3f ",n,c->n_iterations,c->n_cut,
+             c->deviation,c->exposures,c->completed);
+          for(code=0;code<=MAX_SURVEY_CODE;code++){
+             fprintf(stderr," %d:%6.4f",code,c->fraction[code]);
+             if(c->target[code]>=0.0)fprintf(stderr,"(%6.4f)",c->target[code]);
+          }
+          fprintf(stderr,"%s\n",n==best ? "  best" : "");
+       }
+       fflush(stderr);
+
+       for(i=0;i<season.num_fields;i++){
+          f=season.fields+i;
+          printf("%s%s",best_cut[i] ? "## excluded " : "",f->history->script_line);
+       }
+
+       exit(0);
+    }
+
+    if(run_season(&season,workers,n_threads)!=0)exit(-1);
+
+    gettimeofday(&t1,NULL);
+
+    t_observing=workers[0].t_observing;
+    t_idle=workers[0].t_idle;
+    n_errors=workers[0].n_errors;
+
+    for(code=0;code<=MAX_SURVEY_CODE;code++){
+       code_fields[code]=0;
+       code_exposures[code]=0.0;
+       code_completed[code]=0.0;
+    }
+
+    printf("# field ra dec survey_code exposures_per_night fraction_completed\n");
+    for(i=0;i<season.num_fields;i++){
+       f=workers[0].store.fields+i;
+       code=f->survey_code;
+       code_fields[code]++;
+       code_exposures[code]=code_exposures[code]+n_exposures[i];
+       code_completed[code]=code_completed[code]+n_completed[i];
+       printf("%6d %10.6f %10.5f %d %9.4f %7.4f\n",i,f->ra,f->dec,code,
+          n_exposures[i]/n_runs,n_completed[i]/n_runs);
+    }
+
+    fprintf(stderr,"# %d nights x %d trials on %d threads in %7.3f sec\n",
+       season.n_nights,season.n_trials,n_threads,
+       (t1.tv_sec-t0.tv_sec)+(t1.tv_usec-t0.tv_usec)*1.0e-6);
+    fprintf(stderr,"# per night: observing %7.3f h  idle %7.3f h  errors %d\n",
+       t_observing/n_runs,t_idle/n_runs,n_errors);
+    fprintf(stderr,"# survey_code n_fields exposures_per_night fields_completed_per_night\n");
+    for(code=0;code<=MAX_SURVEY_CODE;code++){
+       if(code_fields[code]==0)continue;
+       fprintf(stderr,"# %d %6d %10.3f %10.3f\n",code,code_fields[code],
+          code_exposures[code]/n_runs,code_completed[code]/n_runs);
+    }
+    fflush(stderr);
+
+    exit(0);
+}
@@ -0,0 +1,256 @@
+/* sky_index.c
+
+   2026 Oct 14
+
+   A hashed index of positions on the sky.
+
+   The analysis tools used to find the field of an observation by
+   putting its ra and dec on a fixed grid (field_pointer() in
+   get_time_gaps.c), into arrays of fixed size. Here the sky is cut
+   into bins of bin_deg in ra and dec, and only the bins holding a
+   position are kept, in a hash table keyed by the bin number that
+   doubles as it fills. Each position (the center of a field of any
+   tiling) is added with the caller's id, and find_sky_index() returns
+   the id of the nearest position within a radius of an observation,
+   looking only in the bins that the radius reaches. There are no
+   limits on the number of positions except memory.
+
+   Positions are in deg, ra 0 to 360 and dec -90 to 90.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sky_index.h"
+
+#define SKY_INDEX_DEG_TO_RAD (M_PI/180.0)
+
+int init_sky_index(Sky_Index *s, double bin_deg);
+void free_sky_index(Sky_Index *s);
+int add_sky_index(Sky_Index *s, double ra, double dec, int id);
+int find_sky_index(Sky_Index *s, double ra, double dec, double radius);
+
+/************************************************************/
+
+/* Set up s for bins of bin_deg (or SKY_INDEX_BIN_DEG if bin_deg<=0).
+   Return 0, or -1 if out of memory */
+
+int init_sky_index(Sky_Index *s, double bin_deg)
+{
+    int i;
+
+    if(bin_deg<=0.0)bin_deg=SKY_INDEX_BIN_DEG;
+
+    s->bin_deg=bin_deg;
+    s->n_ra_bins=ceil(360.0/bin_deg);
+    s->n_dec_bins=ceil(180.0/bin_deg);
+    s->n_entries=0;
+    s->max_entries=SKY_INDEX_MIN_ENTRIES;
+    s->n_bins=0;
+    s->max_bins=SKY_INDEX_MIN_BINS;
+    s->entries=(Sky_Index_Entry *)malloc(s->max_entries*sizeof(Sky_Index_Entry));
+    s->bins=(Sky_Index_Bin *)malloc(s->max_bins*sizeof(Sky_Index_Bin));
+    if(s->entries==NULL||s->bins==NULL){
+       fprintf(stderr,"init_sky_index: can't allocate the index\n");
+       fflush(stderr);
+       free_sky_index(s);
+       return(-1);
+    }
+
+    for(i=0;i<s->max_bins;i++)s->bins[i].key=-1;
+
+    return(0);
+}
+
+/************************************************************/
+
+void free_sky_index(Sky_Index *s)
+{
+    if(s->entries!=NULL)free(s->entries);
+    if(s->bins!=NULL)free(s->bins);
+    s->entries=NULL;
+    s->bins=NULL;
+    s->n_entries=0;
+    s->n_bins=0;
+}
+
+/************************************************************/
+
+/* slot of the table for key: the slot holding it, or the empty slot
+   where it goes */
+
+static int sky_index_slot(Sky_Index *s, long key)
+{
+    unsigned long h;
+    int mask,i;
+
+    mask=s->max_bins-1;
+    h=(unsigned long)key*0x9E3779B97F4A7C15UL;
+    i=(h>>32)&mask;
+    while(s->bins[i].key!=-1&&s->bins[i].key!=key)i=(i+1)&mask;
+
+    return(i);
+}
+
+/************************************************************/
+
+/* double the slots of the table. Return 0, or -1 if out of memory */
+
+static int grow_sky_index_bins(Sky_Index *s)
+{
+    Sky_Index_Bin *old;
+    int i,j,n_old;
+
+    old=s->bins;
+    n_old=s->max_bins;
+    s->bins=(Sky_Index_Bin *)malloc(2*n_old*sizeof(Sky_Index_Bin));
+    if(s->bins==NULL){
+       fprintf(stderr,"grow_sky_index_bins: can't allocate %d bins\n",2*n_old);
+       fflush(stderr);
+       s->bins=old;
+       return(-1);
+    }
+    s->max_bins=2*n_old;
+    for(i=0;i<s->max_bins;i++)s->bins[i].key=-1;
+
+    for(i=0;i<n_old;i++){
+       if(old[i].key==-1)continue;
+       j=sky_index_slot(s,old[i].key);
+       s->bins[j]=old[i];
+    }
+    free(old);
+
+    return(0);
+}
+
+/************************************************************/
+
+static int sky_index_dec_bin(Sky_Index *s, double dec)
+{
+    int j;
+
+    j=floor((dec+90.0)/s->bin_deg);
+    if(j<0)j=0;
+    if(j>=s->n_dec_bins)j=s->n_dec_bins-1;
+
+    return(j);
+}
+
+/************************************************************/
+
+static int sky_index_ra_bin(Sky_Index *s, double ra)
+{
+    int i;
+
+    i=floor(ra/s->bin_deg);
+    i=i%s->n_ra_bins;
+    if(i<0)i=i+s->n_ra_bins;
+
+    return(i);
+}
+
+/************************************************************/
+
+/* Add the position ra, dec (deg) with id. Return 0, or -1 if out of
+   memory */
+
+int add_sky_index(Sky_Index *s, double ra, double dec, int id)
+{
+    Sky_Index_Entry *e;
+    long key;
+    int i;
+
+    if(s->n_entries==s->max_entries){
+       e=(Sky_Index_Entry *)realloc(s->entries,2*s->max_entries*sizeof(Sky_Index_Entry));
+       if(e==NULL){
+          fprintf(stderr,"add_sky_index: can't allocate %d entries\n",2*s->max_entries);
+          fflush(stderr);
+          return(-1);
+       }
+       s->entries=e;
+       s->max_entries=2*s->max_entries;
+    }
+
+    /* keep the table at most half full */
+
+    if(2*(s->n_bins+1)>s->max_bins&&grow_sky_index_bins(s)!=0)return(-1);
+
+    key=(long)sky_index_dec_bin(s,dec)*s->n_ra_bins+sky_index_ra_bin(s,ra);
+    i=sky_index_slot(s,key);
+    if(s->bins[i].key==-1){
+       s->bins[i].key=key;
+       s->bins[i].first=-1;
+       s->n_bins++;
+    }
+
+    e=s->entries+s->n_entries;
+    e->x=cos(dec*SKY_INDEX_DEG_TO_RAD)*cos(ra*SKY_INDEX_DEG_TO_RAD);
+    e->y=cos(dec*SKY_INDEX_DEG_TO_RAD)*sin(ra*SKY_INDEX_DEG_TO_RAD);
+    e->z=sin(dec*SKY_INDEX_DEG_TO_RAD);
+    e->id=id;
+    e->next=s->bins[i].first;
+    s->bins[i].first=s->n_entries;
+    s->n_entries++;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* Return the id of the position nearest ra, dec (deg) and within
+   radius (deg) of it, or -1 if there is none */
+
+int find_sky_index(Sky_Index *s, double ra, double dec, double radius)
+{
+    Sky_Index_Entry *e;
+    double x,y,z,dot,dot_best,cos_radius,dec_max,ra_span;
+    long key;
+    int i0,j,k,j1,j2,di,n,n_ra,slot,id_best;
+
+    if(s->n_entries==0)return(-1);
+
+    x=cos(dec*SKY_INDEX_DEG_TO_RAD)*cos(ra*SKY_INDEX_DEG_TO_RAD);
+    y=cos(dec*SKY_INDEX_DEG_TO_RAD)*sin(ra*SKY_INDEX_DEG_TO_RAD);
+    z=sin(dec*SKY_INDEX_DEG_TO_RAD);
+    cos_radius=cos(radius*SKY_INDEX_DEG_TO_RAD);
+
+    /* the bins in dec the radius reaches, and in ra at the dec of
+       those bins farthest from the equator */
+
+    j1=sky_index_dec_bin(s,dec-radius);
+    j2=sky_index_dec_bin(s,dec+radius);
+    dec_max=fabs(dec)+radius;
+    if(dec_max>=90.0){
+       n_ra=s->n_ra_bins;
+    }
+    else{
+       ra_span=radius/cos(dec_max*SKY_INDEX_DEG_TO_RAD);
+       di=ceil(ra_span/s->bin_deg);
+       n_ra=2*di+1;
+       if(n_ra>s->n_ra_bins)n_ra=s->n_ra_bins;
+    }
+
+    id_best=-1;
+    dot_best=cos_radius;
+    i0=(n_ra==s->n_ra_bins) ? 0 : sky_index_ra_bin(s,ra)-n_ra/2+s->n_ra_bins;
+    for(j=j1;j<=j2;j++){
+       for(k=0;k<n_ra;k++){
+          key=(long)j*s->n_ra_bins+(i0+k)%s->n_ra_bins;
+          slot=sky_index_slot(s,key);
+          if(s->bins[slot].key==-1)continue;
+          for(n=s->bins[slot].first;n>=0;n=e->next){
+             e=s->entries+n;
+             dot=x*e->x+y*e->y+z*e->z;
+             if(dot>=dot_best){
+                dot_best=dot;
+                id_best=e->id;
+             }
+          }
+       }
+    }
+
+    return(id_best);
+}
+
+/************************************************************/
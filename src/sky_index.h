@@ -0,0 +1,51 @@
+#ifndef __sky_index_h
+#define __sky_index_h
+
+/* sky_index.h
+
+   A hashed index of positions on the sky, for finding the field (tile)
+   an observation belongs to in any tiling (see sky_index.c).
+
+   2026 Oct 14
+*/
+
+#define SKY_INDEX_BIN_DEG 1.0 /* default bin size (deg) */
+#define SKY_INDEX_MIN_BINS 1024 /* bins in the hash table to start */
+#define SKY_INDEX_MIN_ENTRIES 1024 /* entries to start */
+
+/* a position in the index */
+
+typedef struct {
+    double x,y,z; /* unit vector */
+    int id; /* number given by the caller */
+    int next; /* next entry in the same bin, or -1 */
+} Sky_Index_Entry;
+
+/* a bin with entries. key is -1 for an empty slot of the table */
+
+typedef struct {
+    long key;
+    int first; /* first entry in the bin */
+} Sky_Index_Bin;
+
+typedef struct {
+    double bin_deg; /* size of a bin in ra and dec (deg) */
+    int n_ra_bins; /* bins around in ra */
+    int n_dec_bins; /* bins from dec -90 to 90 */
+    int n_entries;
+    int max_entries;
+    Sky_Index_Entry *entries;
+    int n_bins; /* slots of the table used */
+    int max_bins; /* slots of the table (a power of 2) */
+    Sky_Index_Bin *bins;
+} Sky_Index;
+
+int init_sky_index(Sky_Index *s, double bin_deg);
+
+void free_sky_index(Sky_Index *s);
+
+int add_sky_index(Sky_Index *s, double ra, double dec, int id);
+
+int find_sky_index(Sky_Index *s, double ra, double dec, double radius);
+
+#endif
@@ -346,6 +346,7 @@ LEGALITIES:
 #include <ctype.h>
 #include <stdarg.h>
 #include <string.h>
+#include <stdlib.h>
 #include "sky_utils.h"
 //#define FAKE_TELESCOPE
 
@@ -1026,6 +1027,7 @@ void load_site(double *longit,double *lat,double *stdz,short *use_dst,
 		strcpy(site_name, "Fake Site");
 		strcpy(zone_name, "Fake Location");
 		*zabr = 'F';
+		*use_dst = 0;  /* was left unset, and read uninitialized */
 		*longit = 16.7153;
 		*stdz = 16.;
 		*lat = -29.257;
@@ -4218,6 +4220,202 @@ double ut_from_jd(double jd) {
 }
 
 
+static void fill_night_times(Night_Times *ntimes, double longit, double jdmid,
+		double jdsunset, double jdsunrise, double jdetw18, double jdmtw18,
+		double jdetw12, double jdmtw12, double jdmoonrise, double jdmoonset,
+		double ramoon, double decmoon, double ill_frac)
+
+/* fills in the twilight, rise and set times of ntimes (but not
+   the start and end of observing) from their jd's */
+
+{
+       ntimes->jd_evening12 = jdetw12;
+       ntimes->jd_morning12 = jdmtw12;
+       ntimes->jd_evening18 = jdetw18;
+       ntimes->jd_morning18 = jdmtw18;
+       ntimes->jd_sunrise = jdsunrise;
+       ntimes->jd_sunset = jdsunset;
+       ntimes->ut_sunset = ut_from_jd(jdsunset);
+       ntimes->ut_evening12 = ut_from_jd(jdetw12);
+       ntimes->ut_evening18 = ut_from_jd(jdetw18);
+       ntimes->ut_midnight = ut_from_jd(jdmid);
+       ntimes->ut_morning12 = ut_from_jd(jdmtw12);
+       ntimes->ut_morning18 = ut_from_jd(jdmtw18);
+       ntimes->ut_sunrise = ut_from_jd(jdsunrise);
+       ntimes->ut_moonrise = ut_from_jd(jdmoonrise);
+       ntimes->ut_moonset = ut_from_jd(jdmoonset);
+       ntimes->lst_sunset = lst(jdsunset,longit);
+       ntimes->lst_midnight = lst(jdmid,longit);
+       ntimes->lst_evening12 = lst(jdetw12,longit);
+       ntimes->lst_morning12 = lst(jdmtw12,longit);
+       ntimes->lst_evening18 = lst(jdetw18,longit);
+       ntimes->lst_morning18 = lst(jdmtw18,longit);
+       ntimes->lst_sunrise = lst(jdsunrise,longit);
+       ntimes->lst_moonrise = lst(jdmoonrise,longit);
+       ntimes->lst_moonset = lst(jdmoonset,longit);
+       ntimes->ra_moon=ramoon;
+       ntimes->dec_moon=decmoon;
+       ntimes->percent_moon=ill_frac;
+}
+
+void compute_night_times(struct date_time date, double lat, double longit,
+		double elevsea, double horiz, double stdz, short use_dst,
+		double *jdb, double *jde, Night_Times *ntimes)
+
+/* Works out the same night times as print_tonight, with the same
+   flow of control, but prints nothing and leaves no_print alone.
+   Only the twilight, rise and set times of ntimes are filled in. */
+
+{
+	double jd, jdmid, stmid, ramoon, decmoon, distmoon;
+	double geora, geodec, geodist;
+	double rasun, decsun, min_alt, max_alt;
+	double hasunset, jdsunset=0.0, jdsunrise=0.0;
+	double hamoonset, tmoonrise, tmoonset,
+		jdmoonrise, jdmoonset=0.0;
+	double hatwilight, jdetw18=0.0, jdmtw18=0.0;
+	double jdetw12=0.0, jdmtw12=0.0;
+	double ill_frac;
+
+	find_dst_bounds(date.y,stdz,use_dst,jdb,jde);
+	date.h = 18;  /* local afternoon */
+	date.mn = 0;
+	date.s = 0;
+	jd = date_to_jd(date) + .5;  /* local morning */
+	jd = jd - 0.25;  /* local midnight */
+	jdmid = jd + zone(use_dst,stdz,jd,*jdb,*jde) / 24.;
+	stmid = lst(jdmid,longit);
+
+	accumoon(jdmid,lat,stmid,elevsea,
+	   &geora,&geodec,&geodist,&ramoon,&decmoon,&distmoon);
+	lpsun(jdmid,&rasun,&decsun);
+
+	/* sunset and sunrise, unless the sun is up or down all night */
+
+	hasunset = ha_alt(decsun,lat,-(0.83+horiz));
+	if(hasunset <= 900. && hasunset >= -900.) {
+		jdsunset = jdmid + adj_time(rasun+hasunset-stmid)/24.;
+		jdsunset = jd_sun_alt(-(0.83+horiz),jdsunset,lat,longit);
+		jdsunrise = jdmid + adj_time(rasun-hasunset-stmid)/24.;
+		jdsunrise = jd_sun_alt(-(0.83+horiz),jdsunrise,lat,longit);
+	}
+
+	/* twilight is irrelevant if the sun is up all night; there is no
+	   12-degree twilight if it is dark (-18 deg) all day */
+
+	if(hasunset <= 900.) {
+		hatwilight = ha_alt(decsun,lat,-18.);
+		if(hatwilight <= 900. && hatwilight >= -900.) {
+			jdetw18 = jdmid + adj_time(rasun+hatwilight-stmid)/24.;
+			jdetw18 = jd_sun_alt(-18.,jdetw18,lat,longit);
+			jdmtw18 = jdmid + adj_time(rasun-hatwilight-stmid)/24.;
+			jdmtw18 = jd_sun_alt(-18.,jdmtw18,lat,longit);
+		}
+		if(hatwilight >= -900.) {
+			hatwilight = ha_alt(decsun,lat,-12.);
+			if(hatwilight <= 900. && hatwilight >= -900.) {
+				jdetw12 = jdmid + adj_time(rasun+hatwilight-stmid)/24.;
+				jdetw12 = jd_sun_alt(-12.,jdetw12,lat,longit);
+				jdmtw12 = jdmid + adj_time(rasun-hatwilight-stmid)/24.;
+				jdmtw12 = jd_sun_alt(-12.,jdmtw12,lat,longit);
+			}
+		}
+	}
+
+	/* moonrise and set if they're likely to occur */
+
+	min_max_alt(lat,decmoon,&min_alt,&max_alt);
+	if(max_alt < -(0.83+horiz)) jdmoonrise = -1.;
+	else if(min_alt > -(0.83+horiz)) jdmoonrise = 1.;
+	else {
+		hamoonset = ha_alt(decmoon,lat,-(0.83+horiz));
+		tmoonrise = adj_time(ramoon-hamoonset-stmid);
+		tmoonset = adj_time(ramoon+hamoonset-stmid);
+		jdmoonrise = jdmid + tmoonrise / 24.;
+		jdmoonrise = jd_moon_alt(-(0.83+horiz),jdmoonrise,lat,longit,elevsea);
+		jdmoonset = jdmid + tmoonset / 24.;
+		jdmoonset = jd_moon_alt(-(0.83+horiz),jdmoonset,lat,longit,elevsea);
+	}
+
+	ill_frac=0.5*(1.-cos(subtend(ramoon,decmoon,rasun,decsun)));
+
+	fill_night_times(ntimes,longit,jdmid,jdsunset,jdsunrise,jdetw18,jdmtw18,
+		jdetw12,jdmtw12,jdmoonrise,jdmoonset,ramoon,decmoon,ill_frac);
+}
+
+/* The nights worked out by get_night_times, kept for the life of the
+   program in a hash table keyed by the site and the local date. A
+   simulation of a season asks for each night several times (the
+   scheduler looks 5, 10 and 15 days ahead), and each is worked out once.
+   Not locked: call it from one thread. */
+
+#define NIGHT_CACHE_BUCKETS 1024
+
+typedef struct night_cache_entry {
+	double lat, longit, elevsea, horiz, stdz;
+	short use_dst;
+	short y, mo, d;
+	double jdb, jde;
+	Night_Times ntimes;
+	struct night_cache_entry *next;
+} Night_Cache_Entry;
+
+static Night_Cache_Entry *night_cache[NIGHT_CACHE_BUCKETS];
+
+void get_night_times(struct date_time date, double lat, double longit,
+		double elevsea, double horiz, double stdz, short use_dst,
+		double *jdb, double *jde, Night_Times *ntimes)
+
+/* As compute_night_times, but each night is only computed once per
+   site. The start and end of observing in ntimes are left as they are. */
+
+{
+	Night_Cache_Entry *e;
+	unsigned int h;
+
+	h = (unsigned int)(((long)date.y*372 + date.mo*31 + date.d) % NIGHT_CACHE_BUCKETS);
+
+	for(e = night_cache[h]; e != NULL; e = e->next) {
+		if(e->y == date.y && e->mo == date.mo && e->d == date.d &&
+		   e->lat == lat && e->longit == longit && e->elevsea == elevsea &&
+		   e->horiz == horiz && e->stdz == stdz && e->use_dst == use_dst)
+			break;
+	}
+
+	if(e == NULL) {
+		e = (Night_Cache_Entry *)malloc(sizeof(Night_Cache_Entry));
+		if(e == NULL) {  /* no room to keep it; just work it out */
+			compute_night_times(date,lat,longit,elevsea,horiz,stdz,use_dst,
+				jdb,jde,ntimes);
+			return;
+		}
+		memset((void *)e,0,sizeof(Night_Cache_Entry));
+		compute_night_times(date,lat,longit,elevsea,horiz,stdz,use_dst,
+			&(e->jdb),&(e->jde),&(e->ntimes));
+		e->lat = lat;
+		e->longit = longit;
+		e->elevsea = elevsea;
+		e->horiz = horiz;
+		e->stdz = stdz;
+		e->use_dst = use_dst;
+		e->y = date.y;
+		e->mo = date.mo;
+		e->d = date.d;
+		e->next = night_cache[h];
+		night_cache[h] = e;
+	}
+
+	*jdb = e->jdb;
+	*jde = e->jde;
+	e->ntimes.jd_start = ntimes->jd_start;
+	e->ntimes.jd_end = ntimes->jd_end;
+	e->ntimes.ut_start = ntimes->ut_start;
+	e->ntimes.ut_end = ntimes->ut_end;
+	e->ntimes.lst_start = ntimes->lst_start;
+	e->ntimes.lst_end = ntimes->lst_end;
+	*ntimes = e->ntimes;
+}
+
 void print_tonight(struct date_time date, double lat, double longit,
 		   double elevsea, double elev, double horiz,
 		   char *site_name, double stdz, char *zone_name,
@@ -4534,33 +4732,8 @@ void print_tonight(struct date_time date, double lat, double longit,
      printf("# LST_MOONSET %9.6f\n",lst(jdmoonset,longit));
 #endif
      if (ntimes != NULL) {
-       ntimes->jd_evening12 = jdetw12;
-       ntimes->jd_morning12 = jdmtw12;
-       ntimes->jd_evening18 = jdetw18;
-       ntimes->jd_morning18 = jdmtw18;
-       ntimes->jd_sunrise = jdsunrise;
-       ntimes->jd_sunset = jdsunset;
-       ntimes->ut_sunset = ut_from_jd(jdsunset);
-       ntimes->ut_evening12 = ut_from_jd(jdetw12);
-       ntimes->ut_evening18 = ut_from_jd(jdetw18);
-       ntimes->ut_midnight = ut_from_jd(jdmid);
-       ntimes->ut_morning12 = ut_from_jd(jdmtw12);
-       ntimes->ut_morning18 = ut_from_jd(jdmtw18);
-       ntimes->ut_sunrise = ut_from_jd(jdsunrise);
-       ntimes->ut_moonrise = ut_from_jd(jdmoonrise);
-       ntimes->ut_moonset = ut_from_jd(jdmoonset);
-       ntimes->lst_sunset = lst(jdsunset,longit);
-       ntimes->lst_midnight = lst(jdmid,longit);
-       ntimes->lst_evening12 = lst(jdetw12,longit);
-       ntimes->lst_morning12 = lst(jdmtw12,longit);
-       ntimes->lst_evening18 = lst(jdetw18,longit);
-       ntimes->lst_morning18 = lst(jdmtw18,longit);
-       ntimes->lst_sunrise = lst(jdsunrise,longit);
-       ntimes->lst_moonrise = lst(jdmoonrise,longit);
-       ntimes->lst_moonset = lst(jdmoonset,longit);
-       ntimes->ra_moon=ramoon;
-       ntimes->dec_moon=decmoon;
-       ntimes->percent_moon=ill_frac;
+       fill_night_times(ntimes,longit,jdmid,jdsunset,jdsunrise,jdetw18,jdmtw18,
+		jdetw12,jdmtw12,jdmoonrise,jdmoonset,ramoon,decmoon,ill_frac);
     }
 
     fflush(stderr);
@@ -158,6 +158,14 @@ void print_tonight(struct date_time date, double lat, double longit,
 		   char zabr, short use_dst, double *jdb, double *jde,
 		   short short_long, Night_Times *ntimes, int print_flag);
 
+void compute_night_times(struct date_time date, double lat, double longit,
+		double elevsea, double horiz, double stdz, short use_dst,
+		double *jdb, double *jde, Night_Times *ntimes);
+
+void get_night_times(struct date_time date, double lat, double longit,
+		double elevsea, double horiz, double stdz, short use_dst,
+		double *jdb, double *jde, Night_Times *ntimes);
+
 
 double altit(double dec, double ha, double lat, double *az);
  
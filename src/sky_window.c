@@ -0,0 +1,225 @@
+/* sky_window.c
+
+   Closed-form rise and set times for a fixed position on the sky.
+
+   A position is "up" when its airmass is below max_am and the absolute
+   value of its hour angle is below max_ha. Since the altitude depends
+   on hour angle only through cos(ha), both conditions reduce to a
+   single limit on the hour angle:
+
+      fabs(ha) < ha_limit
+
+   where ha_limit is the smaller of max_ha and the hour angle at which
+   the airmass crosses max_am. The rise and set times inside an
+   observing window then follow directly from the LST at the window
+   boundaries, with no stepwise search.
+
+   All times here are in sidereal hours. Callers convert offsets to jd
+   with the same LST rate they use elsewhere.
+
+   2026 Oct 14
+*/
+
+#include <math.h>
+#include "sky_utils.h"
+#include "sky_window.h"
+
+/************************************************************/
+
+/* get_ha_limit(), from the sines and cosines of dec and lat */
+
+static double ha_limit_sin_cos(double sin_dec, double cos_dec, double sin_lat,
+        double cos_lat, double max_am, double max_ha)
+{
+    double sin_alt_min,x,h;
+
+    if(max_am<=1.0||max_ha<=0.0)return(HA_LIMIT_NEVER);
+
+    /* airmass = 1/sin(alt), so airmass < max_am where sin(alt) > 1/max_am,
+       with sin(alt) = sin(dec)sin(lat) + cos(dec)cos(lat)cos(ha) */
+
+    sin_alt_min=1.0/max_am;
+
+    if(cos_dec*cos_lat==0.0){
+       /* at the pole the altitude does not depend on hour angle */
+       if(sin_dec*sin_lat>sin_alt_min){
+          h=HA_LIMIT_ALWAYS;
+       }
+       else{
+          return(HA_LIMIT_NEVER);
+       }
+    }
+    else{
+       x=(sin_alt_min-sin_dec*sin_lat)/(cos_dec*cos_lat);
+       if(x>=1.0){
+          return(HA_LIMIT_NEVER);
+       }
+       else if(x<=-1.0){
+          h=HA_LIMIT_ALWAYS;
+       }
+       else{
+          h=acos(x)*HRS_IN_RADIAN;
+       }
+    }
+
+    if(max_ha<h)h=max_ha;
+
+    return(h);
+}
+
+/************************************************************/
+
+/* return the hour angle limit (hours) inside which an object at
+   declination dec (deg) is above airmass max_am as seen from
+   latitude lat (deg), further limited by max_ha (hours).
+   Return HA_LIMIT_NEVER if the object never gets below max_am, and
+   HA_LIMIT_ALWAYS if it is always below max_am and max_ha does not
+   restrict it. */
+
+double get_ha_limit(double dec, double lat, double max_am, double max_ha)
+{
+    return(ha_limit_sin_cos(sin(dec/DEG_IN_RADIAN),cos(dec/DEG_IN_RADIAN),
+          sin(lat/DEG_IN_RADIAN),cos(lat/DEG_IN_RADIAN),max_am,max_ha));
+}
+
+/************************************************************/
+
+/* wrap an hour angle into the interval [-12,12) */
+
+static double wrap_ha(double ha)
+{
+    while(ha>=12.0)ha=ha-24.0;
+    while(ha<-12.0)ha=ha+24.0;
+    return(ha);
+}
+
+/************************************************************/
+
+/* Return the number of sidereal hours after lst0 at which an object
+   at right ascension ra (hours) first has fabs(ha) < ha_limit.
+   Return 0 if it is already up at lst0, and -1 if it does not come
+   up within lst_span hours of lst0 */
+
+double get_lst_rise_offset(double ra, double ha_limit, double lst0, double lst_span)
+{
+    double ha,t;
+
+    if(ha_limit<=0.0)return(-1.0);
+
+    ha=wrap_ha(lst0-ra);
+    if(fabs(ha)<ha_limit)return(0.0);
+
+    /* the hour angle increases with time, so the object rises when
+       ha next reaches -ha_limit */
+
+    t=-ha_limit-ha;
+    if(t<0.0)t=t+24.0;
+
+    if(t>lst_span)return(-1.0);
+
+    return(t);
+}
+
+/************************************************************/
+
+/* Return the number of sidereal hours before lst1 at which an object
+   at right ascension ra (hours) last had fabs(ha) < ha_limit.
+   Return 0 if it is still up at lst1, and -1 if it was not up at any
+   time within lst_span hours before lst1 */
+
+double get_lst_set_offset(double ra, double ha_limit, double lst1, double lst_span)
+{
+    double ha,t;
+
+    if(ha_limit<=0.0)return(-1.0);
+
+    ha=wrap_ha(lst1-ra);
+    if(fabs(ha)<ha_limit)return(0.0);
+
+    /* going back in time, the object was last up when ha was
+       +ha_limit */
+
+    t=ha-ha_limit;
+    if(t<0.0)t=t+24.0;
+
+    if(t>lst_span)return(-1.0);
+
+    return(t);
+}
+
+/************************************************************/
+
+/* Batched forms of get_ha_limit() and get_airmass() for n positions,
+   from the sines and cosines of their declinations (worked out once
+   when the positions are read). The arrays are separate so that each
+   loop runs down contiguous doubles with no calls but the maths
+   library, and can be vectorised by the compiler. */
+
+/* fill in ha_limit[i] as get_ha_limit() would for each position */
+
+void get_ha_limits(int n, double *sin_dec, double *cos_dec, double lat,
+        double max_am, double max_ha, double *ha_limit)
+{
+    double sin_lat,cos_lat;
+    int i;
+
+    sin_lat=sin(lat/DEG_IN_RADIAN);
+    cos_lat=cos(lat/DEG_IN_RADIAN);
+
+    for(i=0;i<n;i++){
+       ha_limit[i]=ha_limit_sin_cos(sin_dec[i],cos_dec[i],sin_lat,cos_lat,
+             max_am,max_ha);
+    }
+}
+
+/************************************************************/
+
+/* Batched galactic and ecliptic latitudes (J2000, deg) of n positions
+   at ra (hours), from the sines and cosines of their declinations. The
+   latitude cuts of a tiling need nothing else, and each is the dot
+   product of the position with a fixed pole:
+
+      sin(b) = sin(dec)sin(dec_ngp) + cos(dec)cos(dec_ngp)cos(ra-ra_ngp)
+      sin(beta) = sin(dec)cos(obl) - cos(dec)sin(obl)sin(ra)
+
+   with none of the precession of galact() and eclipt(), so they differ
+   from those by the motion of the pole from J2000 to the epoch asked of
+   them (well under a degree). */
+
+void get_galactic_latitudes(int n, double *ra, double *sin_dec, double *cos_dec,
+        double *gal_lat)
+{
+    double sin_ngp,cos_ngp,x;
+    int i;
+
+    sin_ngp=sin(NGP_DEC_J2000/DEG_IN_RADIAN);
+    cos_ngp=cos(NGP_DEC_J2000/DEG_IN_RADIAN);
+
+    for(i=0;i<n;i++){
+       x=sin_dec[i]*sin_ngp+cos_dec[i]*cos_ngp*cos((ra[i]-NGP_RA_J2000)/HRS_IN_RADIAN);
+       if(x>1.0)x=1.0;
+       if(x<-1.0)x=-1.0;
+       gal_lat[i]=asin(x)*DEG_IN_RADIAN;
+    }
+}
+
+/************************************************************/
+
+void get_ecliptic_latitudes(int n, double *ra, double *sin_dec, double *cos_dec,
+        double *ecl_lat)
+{
+    double sin_obl,cos_obl,x;
+    int i;
+
+    sin_obl=sin(OBLIQUITY_J2000/DEG_IN_RADIAN);
+    cos_obl=cos(OBLIQUITY_J2000/DEG_IN_RADIAN);
+
+    for(i=0;i<n;i++){
+       x=sin_dec[i]*cos_obl-cos_dec[i]*sin_obl*sin(ra[i]/HRS_IN_RADIAN);
+       if(x>1.0)x=1.0;
+       if(x<-1.0)x=-1.0;
+       ecl_lat[i]=asin(x)*DEG_IN_RADIAN;
+    }
+}
+
+/************************************************************/
@@ -0,0 +1,39 @@
+#ifndef __sky_window_h
+#define __sky_window_h
+
+/* sky_window.h
+
+   Closed-form visibility windows for fixed (ra, dec) positions.
+   Used by init_fields() (scheduler_core.c) in place of the
+   stepwise LST searches for rise and set times.
+
+   2026 Oct 14
+*/
+
+/* returned by get_ha_limit() for positions that never satisfy the
+   airmass limit, and for positions that always satisfy it */
+#define HA_LIMIT_NEVER 0.0
+#define HA_LIMIT_ALWAYS 12.0
+
+/* J2000 north galactic pole and obliquity, for get_galactic_latitudes()
+   and get_ecliptic_latitudes() */
+#define NGP_RA_J2000 12.8572987 /* hours */
+#define NGP_DEC_J2000 27.1282500 /* deg */
+#define OBLIQUITY_J2000 23.4392911 /* deg */
+
+double get_ha_limit(double dec, double lat, double max_am, double max_ha);
+
+double get_lst_rise_offset(double ra, double ha_limit, double lst0, double lst_span);
+
+double get_lst_set_offset(double ra, double ha_limit, double lst1, double lst_span);
+
+void get_ha_limits(int n, double *sin_dec, double *cos_dec, double lat,
+        double max_am, double max_ha, double *ha_limit);
+
+void get_galactic_latitudes(int n, double *ra, double *sin_dec, double *cos_dec,
+        double *gal_lat);
+
+void get_ecliptic_latitudes(int n, double *ra, double *sin_dec, double *cos_dec,
+        double *ecl_lat);
+
+#endif
@@ -7,13 +7,18 @@
 */
 
 #include "socket.h"
+#include "socket_trace.h"
+#include "scheduler_log.h"
 
 double get_ut();
+double get_unix_time();
 extern int verbose;
 extern int verbose1;
 
 int send_command(char *command, char *reply, char *machine, 
 			int port, int timeout_sec);
+int add_socket_endpoint(char *machine, int port);
+void close_socket_pool();
 void init_socket_status(int s,socket_status *s_status);
 int read_data(int s, char *buf, int n, int timeout_sec);
 int write_data(int s, char *buf, int n);
@@ -24,11 +29,385 @@ int get_connection(int s);
 
 /************************************************************/
 
-int send_command(char *command, char *reply, char *machine, int port, int timeout_sec)
+/* Connection pool.
+
+   Each (machine, port) the scheduler talks to is an endpoint. Its
+   address is resolved once, the first time it is used (or when
+   add_socket_endpoint() is called at startup), and up to
+   SOCKET_POOL_SIZE idle connections are kept open for reuse. A command
+   takes an idle connection if there is one, and opens a new one
+   otherwise, so commands sent from different threads still run in
+   parallel.
+
+   A reply is complete when it ends with a newline or a NUL, when the
+   server closes the connection, or when nothing more has arrived for
+   REPLY_GAP_USEC after the last data. Only connections whose reply
+   ended with a newline or NUL are returned to the pool. Servers that
+   close the connection after each reply still work, they just don't
+   benefit from the reuse.
+
+   Failed connects are retried CONNECT_TRIES times with a delay that
+   doubles from CONNECT_BACKOFF_USEC, and while an endpoint is failing
+   its address is resolved again before each retry. */
+
+typedef struct {
+    char machine[MAXHOSTNAME];
+    int port;
+    struct sockaddr_in sa;
+    int resolved;                   /* sa holds a valid address */
+    int idle[SOCKET_POOL_SIZE];     /* open, idle connections */
+    int num_idle;
+} Socket_Endpoint;
+
+static Socket_Endpoint endpoints[MAX_SOCKET_ENDPOINTS];
+static int num_endpoints=0;
+static pthread_mutex_t pool_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+/************************************************************/
+
+/* resolve the address of endpoint ep. Call with pool_mutex held, since
+   gethostbyname() is not reentrant */
+
+static int resolve_endpoint(Socket_Endpoint *ep)
+{
+    struct hostent *hp;
+
+    if ((hp= gethostbyname(ep->machine)) == NULL) {
+       fprintf(stderr,"resolve_endpoint: can't resolve host %s\n",ep->machine);
+       fflush(stderr);
+       return(-1);
+    }
+
+    bzero(&(ep->sa),sizeof(ep->sa));
+    bcopy(hp->h_addr,(char *)&(ep->sa.sin_addr),hp->h_length);
+    ep->sa.sin_family= hp->h_addrtype;
+    ep->sa.sin_port= htons((u_short)ep->port);
+    ep->resolved=1;
+
+    return(0);
+}
+
+/************************************************************/
+
+/* return the endpoint for machine and port, adding it to the pool if
+   it is new. Call with pool_mutex held */
+
+static Socket_Endpoint *find_endpoint(char *machine, int port)
+{
+    Socket_Endpoint *ep;
+    int i;
+
+    for(i=0;i<num_endpoints;i++){
+       if(endpoints[i].port==port&&strcmp(endpoints[i].machine,machine)==0){
+          return(endpoints+i);
+       }
+    }
+
+    if(num_endpoints>=MAX_SOCKET_ENDPOINTS||strlen(machine)>=MAXHOSTNAME){
+       fprintf(stderr,"find_endpoint: can't add endpoint %s port %d\n",machine,port);
+       fflush(stderr);
+       return(NULL);
+    }
+
+    ep=endpoints+num_endpoints;
+    bzero(ep,sizeof(Socket_Endpoint));
+    strcpy(ep->machine,machine);
+    ep->port=port;
+    if(resolve_endpoint(ep)!=0)return(NULL);
+    num_endpoints++;
+
+    return(ep);
+}
+
+/************************************************************/
+
+/* Resolve machine and open a connection to port in advance, so that
+   the first command does not pay for it. Return 0 if the endpoint was
+   added, even if the server is not up yet */
+
+int add_socket_endpoint(char *machine, int port)
+{
+    Socket_Endpoint *ep;
+    struct timeval tv;
+    int s;
+
+    /* a replay talks to no one (see socket_trace.c) */
+
+    if(socket_trace_mode()==SOCKET_TRACE_REPLAYING)return(0);
+
+    pthread_mutex_lock(&pool_mutex);
+    ep=find_endpoint(machine,port);
+    if(ep==NULL){
+       pthread_mutex_unlock(&pool_mutex);
+       return(-1);
+    }
+
+    if(ep->num_idle==0&&(s= socket(AF_INET,SOCK_STREAM,0)) >= 0){
+       tv.tv_sec = 0;
+       tv.tv_usec = 200000;
+       setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof tv);
+       if (connect(s,(const struct sockaddr* )&(ep->sa),sizeof(ep->sa)) == 0) {
+          ep->idle[ep->num_idle++]=s;
+       }
+       else{
+          close(s);
+       }
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* close all idle connections */
+
+void close_socket_pool()
 {
-  int i,s;
-  u_short p;
-  int command_pipe[2];
+    int i,j;
+
+    pthread_mutex_lock(&pool_mutex);
+    for(i=0;i<num_endpoints;i++){
+       for(j=0;j<endpoints[i].num_idle;j++)close(endpoints[i].idle[j]);
+       endpoints[i].num_idle=0;
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    return;
+}
+
+/************************************************************/
+
+/* return 1 if idle connection s is still usable: the server has not
+   closed it and has sent nothing unasked for */
+
+static int idle_connection_ok(int s)
+{
+    struct timeval tv;
+    fd_set read_set;
+
+    FD_ZERO(&read_set);
+    FD_SET(s,&read_set);
+    tv.tv_sec=0;
+    tv.tv_usec=0;
+
+    return(select(s+1,&read_set,NULL,NULL,&tv)==0);
+}
+
+/************************************************************/
+
+/* open a new connection to ep, retrying with backoff. Return the
+   socket, or -1 */
+
+static int connect_endpoint(Socket_Endpoint *ep, int read_timeout_sec)
+{
+    struct sockaddr_in sa;
+    struct timeval tv;
+    int s,i,flag,resolved;
+    long delay_usec;
+
+    delay_usec=CONNECT_BACKOFF_USEC;
+
+    for(i=0;i<CONNECT_TRIES;i++){
+
+       pthread_mutex_lock(&pool_mutex);
+       if(i>0)resolve_endpoint(ep);
+       resolved=ep->resolved;
+       sa=ep->sa;
+       pthread_mutex_unlock(&pool_mutex);
+
+       if(resolved){
+          if ((s= socket(AF_INET,SOCK_STREAM,0)) < 0)return(-1);
+
+          tv.tv_sec = read_timeout_sec;
+          tv.tv_usec = 0;
+          setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
+          flag=1;
+          setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof flag);
+
+          if (connect(s,(const struct sockaddr* )&sa,sizeof sa) == 0) return(s);
+          close(s);
+       }
+
+       if(i<CONNECT_TRIES-1){
+          if(verbose){
+             fprintf(stderr,"connect_endpoint: can't connect to %s port %d, retrying in %ld usec\n",
+                ep->machine,ep->port,delay_usec);
+             fflush(stderr);
+          }
+          usleep(delay_usec);
+          delay_usec=2*delay_usec;
+       }
+    }
+
+    return(-1);
+}
+
+/************************************************************/
+
+/* take an idle connection to ep from the pool, or open a new one.
+   *reused is set to 1 if the connection was already open */
+
+static int get_endpoint_connection(Socket_Endpoint *ep, int timeout_sec, int *reused)
+{
+    int s;
+    struct timeval tv;
+
+    s=-1;
+    pthread_mutex_lock(&pool_mutex);
+    while(s<0&&ep->num_idle>0){
+       s=ep->idle[--ep->num_idle];
+       if(!idle_connection_ok(s)){
+          close(s);
+          s=-1;
+       }
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    if(s>=0){
+       *reused=1;
+       tv.tv_sec = timeout_sec;
+       tv.tv_usec = 0;
+       setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
+       return(s);
+    }
+
+    *reused=0;
+
+    return(connect_endpoint(ep,timeout_sec));
+}
+
+/************************************************************/
+
+/* give connection s back to the pool of ep, or close it if the pool
+   is full */
+
+static void release_endpoint_connection(Socket_Endpoint *ep, int s)
+{
+    pthread_mutex_lock(&pool_mutex);
+    if(ep->num_idle<SOCKET_POOL_SIZE){
+       ep->idle[ep->num_idle++]=s;
+       s=-1;
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    if(s>=0)close(s);
+
+    return;
+}
+
+/************************************************************/
+
+/* Read the reply to a command from s into reply (n bytes). Return the
+   number of bytes read, or -1 on error or timeout. *complete is set to
+   1 if the reply ended with a newline or NUL, so that the connection
+   can carry another command, and *eof to 1 if the server closed the
+   connection */
+
+static int read_reply(int s, char *reply, int n, int timeout_sec, int *complete, int *eof)
+{
+    struct timeval tv,now,t_end;
+    fd_set read_set;
+    int bcount,br,result;
+
+    *complete=0;
+    *eof=0;
+    bcount=0;
+
+    gettimeofday(&t_end,NULL);
+    t_end.tv_sec=t_end.tv_sec+timeout_sec;
+
+    while(bcount<n-1){
+
+       /* wait up to the command timeout for the first byte, then up to
+          REPLY_GAP_USEC for each further piece of the reply */
+
+       if(bcount==0){
+          gettimeofday(&now,NULL);
+          timersub(&t_end,&now,&tv);
+          if(tv.tv_sec<0){
+             fprintf(stderr,"read_reply: timeout after %d sec waiting for reply\n",timeout_sec);
+             fflush(stderr);
+             return(-1);
+          }
+       }
+       else{
+          tv.tv_sec=0;
+          tv.tv_usec=REPLY_GAP_USEC;
+       }
+
+       FD_ZERO(&read_set);
+       FD_SET(s,&read_set);
+       result=select(s+1,&read_set,NULL,NULL,&tv);
+       if(result<0){
+          if(errno==EINTR)continue;
+          perror("read_reply: select");
+          return(-1);
+       }
+       else if(result==0){
+          if(bcount>0)return(bcount);
+          continue;
+       }
+
+       br=read(s,reply+bcount,n-1-bcount);
+       if(br<0&&errno==ECONNRESET&&bcount==0){
+          /* closed by the server, as for br==0 */
+          *eof=1;
+          return(0);
+       }
+       else if(br<0){
+          if(errno==EINTR)continue;
+          perror("read_reply: read");
+          return(-1);
+       }
+       else if(br==0){
+          *eof=1;
+          return(bcount);
+       }
+
+       bcount+=br;
+       if(memchr(reply+bcount-br,0,br)!=NULL||reply[bcount-1]=='\n'){
+          *complete=1;
+          return(bcount);
+       }
+
+       if(verbose1){
+          fprintf(stderr,"read_reply: %d bytes read\n",bcount);
+          fflush(stderr);
+       }
+    }
+
+    return(bcount);
+}
+
+/************************************************************/
+
+/* commands that only query the state of a controller, so that sending
+   one twice does no harm */
+
+static char *query_commands[]={"status","domestatus","lst","getfocus","posrd",
+   "weather",NULL};
+
+static int query_command(char *command)
+{
+  int i,len;
+
+  command+=strspn(command," \t");
+  len=strcspn(command," \t\r\n");
+  for(i=0;query_commands[i]!=NULL;i++){
+     if(strlen(query_commands[i])==(size_t)len&&
+        strncmp(command,query_commands[i],len)==0)return(1);
+  }
+
+  return(0);
+}
+
+/************************************************************/
+
+static int exchange_command(char *command, char *reply, char *machine, int port, int timeout_sec)
+{
+  int i,s,n,reused,complete,eof,tries;
+  Socket_Endpoint *ep;
 
   for(i=0;i<MAXBUFSIZE;i++)reply[i]=0;
 
@@ -38,56 +417,112 @@ int send_command(char *command, char *reply, char *machine, int port, int timeou
      return(-1);
   }
 
-  if(verbose1){
-     fprintf(stderr,
-        "send_command [%d]: %12.6f calling socket with machine %s port %d\n",
-         port,get_ut(),machine,port);
+  pthread_mutex_lock(&pool_mutex);
+  ep=find_endpoint(machine,port);
+  pthread_mutex_unlock(&pool_mutex);
+  if(ep==NULL){
+     fprintf(stderr,"send_command [%d]: unknown machine %s\n",port,machine);
      fflush(stderr);
+     return(-1);
   }
 
-  p = port;
-  if ((s= call_socket(machine,p,timeout_sec)) < 0) { 
-        fprintf(stderr,"send_command [%d]: could not open socket with machine %s port %d\n",
-             port,machine,port);
-        fflush(stderr);
-        perror("send_command: call_socket");
-        return(-1);
-  }
+  /* a pooled connection may have been closed by the server while idle.
+     If the command can't be written to it, try once more on a new
+     connection. If the server closes it without replying, the command
+     may have been carried out (an exposure taken, the telescope moved),
+     so only a query is sent again */
 
+  for(tries=0;tries<2;tries++){
 
-  if(verbose1){
-            fprintf(stderr,"send_command [%d]: %12.6f writing command : %s\n",
-		port,get_ut(),command);
-            fflush(stderr);
-  }
+     if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+        sched_log(LOG_COMMAND,LOG_DEBUG,
+           "send_command [%d]: %12.6f calling socket with machine %s port %d\n",
+            port,get_ut(),machine,port);
+     }
+
+     if ((s= get_endpoint_connection(ep,timeout_sec,&reused)) < 0) {
+          fprintf(stderr,"send_command [%d]: could not open socket with machine %s port %d\n",
+               port,machine,port);
+          fflush(stderr);
+          perror("send_command: call_socket");
+          return(-1);
+     }
 
-  //DEBUG
-  if (write_data(s, (char *)command, strlen(command))
+     if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+        sched_log(LOG_COMMAND,LOG_DEBUG,"send_command [%d]: %12.6f writing command (%s connection) : %s\n",
+		port,get_ut(),reused ? "pooled" : "new",command);
+     }
+
+     if (write_data(s, (char *)command, strlen(command))
             != strlen(command)) {
-  //if (write_data(s, (char *)command, strlen(command)+1)
-  //        != strlen(command)+1) {
+          close(s);
+          if(reused)continue;
           fprintf(stderr,"send_command: can't write data to socket\n");
           return(-1);
-  }
- 
-  if(verbose1){
-          fprintf(stderr,"send_command[%d]: %12.6f reading reply with timeout %d sec \n",port,get_ut(),timeout_sec);
-          fflush(stderr);
-  }
+     }
+
+     if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+          sched_log(LOG_COMMAND,LOG_DEBUG,"send_command[%d]: %12.6f reading reply with timeout %d sec \n",port,get_ut(),timeout_sec);
+     }
 
-  if(read_data(s,reply,MAXBUFSIZE,timeout_sec)<=0){
+     n=read_reply(s,reply,MAXBUFSIZE,timeout_sec,&complete,&eof);
+     if(n==0&&eof&&reused){
+          close(s);
+          if(query_command(command))continue;
+          fprintf(stderr,"send_command[%d]: pooled connection to %s closed without reply to %s\n",
+               port,machine,command);
+          fflush(stderr);
+          return(-1);
+     }
+     if(n<=0){
+          close(s);
           fprintf(stderr,"send_command[%d]: error reading command reply\n",port);fflush(stderr);
           return(-1);
+     }
+
+     if(LOG_ON(LOG_COMMAND,LOG_DEBUG)){
+          sched_log(LOG_COMMAND,LOG_DEBUG,"send_command[%d]: %12.6f reply is %s",port,get_ut(),reply);
+     }
+
+     if(complete&&!eof){
+          release_endpoint_connection(ep,s);
+     }
+     else{
+          close(s);
+     }
+
+     return(0);
   }
 
-  if(verbose1){
-          fprintf(stderr,"send_command[%d]: %12.6f reply is %s",port,get_ut(),reply);
-          fflush(stderr);
+  fprintf(stderr,"send_command[%d]: connection to %s closed without reply\n",port,machine);
+  fflush(stderr);
+
+  return(-1);
+}
+
+/************************************************************/
+
+/* send command to port of machine and read the reply. Each command is
+   recorded, or answered from a recording, if there is a trace (see
+   socket_trace.c) */
+
+int send_command(char *command, char *reply, char *machine, int port, int timeout_sec)
+{
+  double t_send;
+  int result;
+
+  if(socket_trace_mode()==SOCKET_TRACE_REPLAYING){
+     return(replay_command(command,reply,port));
   }
 
-  close(s);
+  t_send=get_unix_time();
+  result=exchange_command(command,reply,machine,port,timeout_sec);
 
-  return(0);
+  if(socket_trace_mode()==SOCKET_TRACE_RECORDING){
+     record_command(command,reply,port,result,t_send,get_unix_time());
+  }
+
+  return(result);
 }
 
 
@@ -220,7 +655,7 @@ int write_data(int s,         /* connected socket */
     bcount= 0;
     br= 0;
     while (bcount < n) { /* loop until full buffer */
- 	if ((br= write(s,buf,n-bcount)) > 0) {
+ 	if ((br= send(s,buf,n-bcount,MSG_NOSIGNAL)) > 0) {
  	    bcount += br; /* increment byte counter */
  	    buf += br; /* move buffer ptr for next read */
  	}
@@ -27,6 +27,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <pthread.h>
 
 typedef struct {
 	int max_fd;
@@ -40,6 +41,13 @@ typedef struct {
 #define MAXBUFSIZE 1024
 #define COMMAND_TIMEOUT_SEC 120
 
+/* connection pool (see send_command()) */
+#define MAX_SOCKET_ENDPOINTS 16   /* distinct (machine, port) pairs */
+#define SOCKET_POOL_SIZE 4        /* idle connections kept per endpoint */
+#define REPLY_GAP_USEC 20000      /* reply ends if no more data for this long */
+#define CONNECT_TRIES 4           /* connection attempts per command */
+#define CONNECT_BACKOFF_USEC 100000 /* delay before first retry, doubled after */
+
 #if 0
 
 int send_command(char *command, char *reply, char *machine, int port);
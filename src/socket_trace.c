@@ -0,0 +1,523 @@
+/* socket_trace.c
+
+   2026 Oct 14
+
+   Record the commands sent to the camera and telescope controllers and
+   their replies, and replay them, so a night observed on the mountain
+   can be run again, without the hardware, by the same scheduler.
+
+   With SOCKET_TRACE_RECORD set to a file name, send_command() appends
+   each command, its reply, what it returned, when it was sent and how
+   long the reply took to the file (see socket_trace.h for the format).
+   The file is flushed after each command, so a night is kept up to a
+   crash.
+
+   With SOCKET_TRACE_REPLAY set instead, send_command() opens no
+   sockets. The scheduler's clock starts at the time the recording
+   started, and is stepped (see set_clock_stepped()): it moves only as
+   the scheduler waits, so a night replays as fast as it can be run and
+   with the same times on every run. With SOCKET_TRACE_SPEED set, it
+   runs that many times faster than the system clock instead (see
+   set_clock_scale()), for watching a replay as it goes. Each command is
+   answered after its recorded latency with the reply recorded on the
+   same port:
+
+     - the last reply to the same command sent at or before the time it
+       is asked, so status polls see the camera and telescope as they
+       were then,
+     - else the next reply to the same command within
+       SOCKET_TRACE_SEARCH records, if the replay has got ahead of the
+       recording,
+     - else either of those for a command with the same first word (an
+       expose or point command whose arguments differ).
+
+   There is a cursor for each port and first word of a command, and
+   records of that command older than the one used are not looked at
+   again, so the replay moves through the night with the clock. Records
+   of other commands are left for when those are asked. The sleeps and
+   timeouts the scheduler waits on run on the same clock, so a replay
+   sees the same sequence of replies as the night did, and the whole
+   observing loop can be profiled on a laptop.
+
+   Scripts run with system() (focus, fwhm) are not traced.
+
+   dump_socket_trace prints a trace as text.
+*/
+
+#include "socket.h"
+#include "socket_trace.h"
+
+double get_unix_time();
+void set_clock_scale(double t_origin, double speed);
+void set_clock_stepped(double t_origin);
+void clock_sleep(double sec);
+extern int verbose;
+
+int init_socket_trace();
+int open_socket_trace(char *file_name, int mode, double speed);
+void close_socket_trace();
+int socket_trace_mode();
+int record_command(char *command, char *reply, int port, int status,
+        double t_send, double t_reply);
+int replay_command(char *command, char *reply, int port);
+int read_socket_trace_header(FILE *input, Socket_Trace_Header *header);
+int read_socket_trace_record(FILE *input, Socket_Trace_Record *r, char *command,
+        char *reply, int n);
+
+/* a recorded command, in memory for the replay */
+
+typedef struct {
+    Socket_Trace_Record r;
+    char *command; /* in trace_data, not NUL terminated */
+    char *reply;
+} Trace_Entry;
+
+/* where the replay is for the commands to port starting with word */
+
+typedef struct {
+    int port;
+    char word[SOCKET_TRACE_WORD_LEN];
+    int cursor; /* first entry still to look at */
+} Trace_Cursor;
+
+static int trace_mode=SOCKET_TRACE_OFF;
+static FILE *trace_file=NULL; /* being recorded */
+static Socket_Trace_Header trace_header;
+static pthread_mutex_t trace_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+static char *trace_data=NULL; /* the whole replayed file */
+static Trace_Entry *trace_entries=NULL;
+static int num_trace_entries=0;
+static Trace_Cursor trace_cursors[SOCKET_TRACE_MAX_CURSORS];
+static int num_trace_cursors=0;
+
+/************************************************************/
+
+/* open the trace named by SOCKET_TRACE_RECORD or SOCKET_TRACE_REPLAY,
+   if either is set. Call before the first get_ut() when replaying */
+
+int init_socket_trace()
+{
+    char *record,*replay,*speed_string;
+    double speed;
+
+    record=getenv(SOCKET_TRACE_RECORD_ENV);
+    replay=getenv(SOCKET_TRACE_REPLAY_ENV);
+    speed_string=getenv(SOCKET_TRACE_SPEED_ENV);
+
+    if(record!=NULL&&replay!=NULL){
+       fprintf(stderr,"init_socket_trace: can't set both %s and %s\n",
+          SOCKET_TRACE_RECORD_ENV,SOCKET_TRACE_REPLAY_ENV);
+       fflush(stderr);
+       return(-1);
+    }
+
+    /* 0 to replay on the stepped clock */
+
+    speed=0.0;
+    if(speed_string!=NULL){
+       speed=atof(speed_string);
+       if(speed<=0.0){
+          fprintf(stderr,"init_socket_trace: bad %s : %s\n",SOCKET_TRACE_SPEED_ENV,speed_string);
+          fflush(stderr);
+          return(-1);
+       }
+    }
+
+    if(record!=NULL)return(open_socket_trace(record,SOCKET_TRACE_RECORDING,speed));
+    if(replay!=NULL)return(open_socket_trace(replay,SOCKET_TRACE_REPLAYING,speed));
+
+    return(0);
+}
+
+/************************************************************/
+
+/* load the trace in input for the replay */
+
+static int load_socket_trace(FILE *input, char *file_name)
+{
+    Socket_Trace_Record r;
+    long size,offset;
+    int n_alloc;
+    char *p;
+
+    if(read_socket_trace_header(input,&trace_header)!=0){
+       fprintf(stderr,"load_socket_trace: %s is not a socket trace of this version\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    offset=ftell(input);
+    fseek(input,0,SEEK_END);
+    size=ftell(input)-offset;
+    fseek(input,offset,SEEK_SET);
+
+    trace_data=(char *)malloc(size>0 ? size : 1);
+    if(trace_data==NULL||fread(trace_data,1,size,input)!=(size_t)size){
+       fprintf(stderr,"load_socket_trace: can't read %s\n",file_name);
+       fflush(stderr);
+       return(-1);
+    }
+
+    n_alloc=0;
+    p=trace_data;
+    while(p+sizeof(r)<=trace_data+size){
+       memcpy((void *)&r,p,sizeof(r));
+       if(p+sizeof(r)+r.command_len+r.reply_len>trace_data+size){
+          fprintf(stderr,"load_socket_trace: %s ends in a partial record\n",file_name);
+          fflush(stderr);
+          break;
+       }
+       if(num_trace_entries>=n_alloc){
+          n_alloc=n_alloc>0 ? 2*n_alloc : 1024;
+          trace_entries=(Trace_Entry *)realloc(trace_entries,n_alloc*sizeof(Trace_Entry));
+          if(trace_entries==NULL){
+             fprintf(stderr,"load_socket_trace: out of memory\n");
+             fflush(stderr);
+             return(-1);
+          }
+       }
+       trace_entries[num_trace_entries].r=r;
+       trace_entries[num_trace_entries].command=p+sizeof(r);
+       trace_entries[num_trace_entries].reply=p+sizeof(r)+r.command_len;
+       num_trace_entries++;
+       p=p+sizeof(r)+r.command_len+r.reply_len;
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+/* start recording to, or replaying from, file_name. A replay runs the
+   clock speed times faster than it was recorded, or on the stepped
+   clock if speed is 0 */
+
+int open_socket_trace(char *file_name, int mode, double speed)
+{
+    FILE *input;
+    double t_end;
+
+    if(trace_mode!=SOCKET_TRACE_OFF)close_socket_trace();
+
+    if(mode==SOCKET_TRACE_RECORDING){
+       trace_file=fopen(file_name,"w");
+       if(trace_file==NULL){
+          fprintf(stderr,"open_socket_trace: can't open %s\n",file_name);
+          fflush(stderr);
+          return(-1);
+       }
+       memset((void *)&trace_header,0,sizeof(trace_header));
+       memcpy(trace_header.magic,SOCKET_TRACE_MAGIC,sizeof(trace_header.magic));
+       trace_header.version=SOCKET_TRACE_VERSION;
+       trace_header.record_size=sizeof(Socket_Trace_Record);
+       trace_header.t_start=get_unix_time();
+       if(fwrite((void *)&trace_header,sizeof(trace_header),1,trace_file)!=1){
+          fprintf(stderr,"open_socket_trace: can't write %s\n",file_name);
+          fflush(stderr);
+          fclose(trace_file);
+          trace_file=NULL;
+          return(-1);
+       }
+       fflush(trace_file);
+       trace_mode=SOCKET_TRACE_RECORDING;
+       fprintf(stderr,"open_socket_trace: recording commands to %s\n",file_name);
+       fflush(stderr);
+    }
+    else if(mode==SOCKET_TRACE_REPLAYING){
+       input=fopen(file_name,"r");
+       if(input==NULL){
+          fprintf(stderr,"open_socket_trace: can't open %s\n",file_name);
+          fflush(stderr);
+          return(-1);
+       }
+       if(load_socket_trace(input,file_name)!=0){
+          fclose(input);
+          close_socket_trace();
+          return(-1);
+       }
+       fclose(input);
+
+       num_trace_cursors=0;
+       if(speed>0.0)set_clock_scale(trace_header.t_start,speed);
+       else set_clock_stepped(trace_header.t_start);
+       trace_mode=SOCKET_TRACE_REPLAYING;
+
+       t_end=num_trace_entries>0 ? trace_entries[num_trace_entries-1].r.t_send : 0.0;
+       if(speed>0.0){
+          fprintf(stderr,"open_socket_trace: replaying %d commands over %.3f h from %s at %.1f times real time\n",
+             num_trace_entries,t_end/3600.0,file_name,speed);
+       }
+       else{
+          fprintf(stderr,"open_socket_trace: replaying %d commands over %.3f h from %s on a stepped clock\n",
+             num_trace_entries,t_end/3600.0,file_name);
+       }
+       fflush(stderr);
+    }
+    else{
+       fprintf(stderr,"open_socket_trace: bad mode %d\n",mode);
+       fflush(stderr);
+       return(-1);
+    }
+
+    return(0);
+}
+
+/************************************************************/
+
+void close_socket_trace()
+{
+    pthread_mutex_lock(&trace_mutex);
+    if(trace_file!=NULL){
+       fclose(trace_file);
+       trace_file=NULL;
+    }
+    if(trace_data!=NULL){
+       free(trace_data);
+       trace_data=NULL;
+    }
+    if(trace_entries!=NULL){
+       free(trace_entries);
+       trace_entries=NULL;
+    }
+    num_trace_entries=0;
+    num_trace_cursors=0;
+    trace_mode=SOCKET_TRACE_OFF;
+    pthread_mutex_unlock(&trace_mutex);
+}
+
+/************************************************************/
+
+int socket_trace_mode()
+{
+    return(trace_mode);
+}
+
+/************************************************************/
+
+/* append command, sent to port at unix time t_send, and its reply, read
+   at t_reply, to the trace */
+
+int record_command(char *command, char *reply, int port, int status,
+        double t_send, double t_reply)
+{
+    Socket_Trace_Record r;
+    size_t command_len,reply_len;
+    int result;
+
+    command_len=strlen(command);
+    reply_len=strlen(reply);
+    if(command_len>UINT16_MAX)command_len=UINT16_MAX;
+    if(reply_len>UINT16_MAX)reply_len=UINT16_MAX;
+
+    memset((void *)&r,0,sizeof(r));
+    r.t_send=t_send-trace_header.t_start;
+    r.latency=t_reply-t_send;
+    r.port=port;
+    r.status=status;
+    r.command_len=command_len;
+    r.reply_len=reply_len;
+
+    result=0;
+    pthread_mutex_lock(&trace_mutex);
+    if(trace_file!=NULL){
+       if(fwrite((void *)&r,sizeof(r),1,trace_file)!=1||
+          fwrite(command,1,command_len,trace_file)!=command_len||
+          fwrite(reply,1,reply_len,trace_file)!=reply_len){
+          fprintf(stderr,"record_command: can't write trace, recording stopped\n");
+          fflush(stderr);
+          fclose(trace_file);
+          trace_file=NULL;
+          result=-1;
+       }
+       else{
+          fflush(trace_file);
+       }
+    }
+    pthread_mutex_unlock(&trace_mutex);
+
+    return(result);
+}
+
+/************************************************************/
+
+/* return 1 if entry e is command, 2 if only the first words match */
+
+static int trace_match(Trace_Entry *e, char *command, size_t len, size_t word_len)
+{
+    if(e->r.command_len==len&&strncmp(e->command,command,len)==0)return(1);
+    if(e->r.command_len>=word_len&&strncmp(e->command,command,word_len)==0&&
+       (e->r.command_len==word_len||e->command[word_len]==' '||
+        e->command[word_len]=='\n'||e->command[word_len]=='\r'))return(2);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* the cursor for commands to port with first word the word_len bytes
+   of command, or NULL if there are too many. Call with trace_mutex held */
+
+static Trace_Cursor *get_trace_cursor(int port, char *command, size_t word_len)
+{
+    Trace_Cursor *c;
+    int j;
+
+    if(word_len>SOCKET_TRACE_WORD_LEN-1)word_len=SOCKET_TRACE_WORD_LEN-1;
+
+    for(j=0;j<num_trace_cursors;j++){
+       c=trace_cursors+j;
+       if(c->port==port&&strncmp(c->word,command,word_len)==0&&c->word[word_len]==0)return(c);
+    }
+    if(num_trace_cursors>=SOCKET_TRACE_MAX_CURSORS)return(NULL);
+
+    c=trace_cursors+num_trace_cursors++;
+    c->port=port;
+    strncpy(c->word,command,word_len);
+    c->word[word_len]=0;
+    c->cursor=0;
+
+    return(c);
+}
+
+/************************************************************/
+
+/* answer command to port from the trace, as described at the top. Copy
+   the reply to reply (MAXBUFSIZE bytes) and return what send_command()
+   returned when it was recorded, or -1 if no reply was recorded */
+
+int replay_command(char *command, char *reply, int port)
+{
+    Trace_Entry *e;
+    Trace_Cursor *c;
+    double t,t_record;
+    size_t len,word_len;
+    int i,m,exact,word,exact_next,word_next,status;
+    float latency;
+
+    memset(reply,0,MAXBUFSIZE);
+    len=strlen(command);
+    word_len=strcspn(command," \n\r");
+
+    pthread_mutex_lock(&trace_mutex);
+
+    c=get_trace_cursor(port,command,word_len);
+    if(c==NULL){
+       pthread_mutex_unlock(&trace_mutex);
+       fprintf(stderr,"replay_command: too many commands\n");
+       fflush(stderr);
+       return(-1);
+    }
+
+    t=get_unix_time()-trace_header.t_start;
+
+    /* the last match recorded by now, then the next ones after */
+
+    exact=-1;
+    word=-1;
+    for(i=c->cursor;i<num_trace_entries&&trace_entries[i].r.t_send<=t;i++){
+       if(trace_entries[i].r.port!=port)continue;
+       m=trace_match(trace_entries+i,command,len,word_len);
+       if(m==1)exact=i;
+       else if(m==2)word=i;
+    }
+
+    exact_next=-1;
+    word_next=-1;
+    if(exact<0){
+       for(m=0;i<num_trace_entries&&m<SOCKET_TRACE_SEARCH;i++,m++){
+          if(trace_entries[i].r.port!=port)continue;
+          switch(trace_match(trace_entries+i,command,len,word_len)){
+             case 1:
+                exact_next=i;
+                break;
+             case 2:
+                if(word_next<0)word_next=i;
+                break;
+          }
+          if(exact_next>=0)break;
+       }
+    }
+
+    if(exact>=0)i=exact;
+    else if(exact_next>=0)i=exact_next;
+    else if(word>=0)i=word;
+    else i=word_next;
+
+    if(i<0){
+       pthread_mutex_unlock(&trace_mutex);
+       fprintf(stderr,"replay_command[%d]: no reply recorded for command %s\n",port,command);
+       fflush(stderr);
+       return(-1);
+    }
+
+    e=trace_entries+i;
+    m=e->r.reply_len<MAXBUFSIZE ? e->r.reply_len : MAXBUFSIZE-1;
+    memcpy(reply,e->reply,m);
+    status=e->r.status;
+    latency=e->r.latency;
+    t_record=e->r.t_send;
+    c->cursor=i+1;
+
+    pthread_mutex_unlock(&trace_mutex);
+
+    if(verbose>1){
+       fprintf(stderr,"replay_command[%d]: %9.3f sec : %s answered with record %d of %9.3f sec\n",
+          port,t,command,i,t_record);
+       fflush(stderr);
+    }
+
+    clock_sleep(latency);
+
+    return(status);
+}
+
+/************************************************************/
+
+/* read and check the header of a trace. Return 0, or -1 if it is not a
+   trace this build can read */
+
+int read_socket_trace_header(FILE *input, Socket_Trace_Header *header)
+{
+    if(fread((void *)header,sizeof(Socket_Trace_Header),1,input)!=1)return(-1);
+
+    if(memcmp(header->magic,SOCKET_TRACE_MAGIC,sizeof(header->magic))!=0||
+       header->version!=SOCKET_TRACE_VERSION||
+       header->record_size!=sizeof(Socket_Trace_Record))return(-1);
+
+    return(0);
+}
+
+/************************************************************/
+
+/* read the next record of a trace into r, and its command and reply,
+   NUL terminated and cut to n bytes. Return 0, 1 at the end of the
+   trace, or -1 on error */
+
+int read_socket_trace_record(FILE *input, Socket_Trace_Record *r, char *command,
+        char *reply, int n)
+{
+    size_t len;
+    int i;
+    char *s;
+
+    if(fread((void *)r,sizeof(Socket_Trace_Record),1,input)!=1)return(1);
+
+    for(i=0;i<2;i++){
+       s=(i==0 ? command : reply);
+       len=(i==0 ? r->command_len : r->reply_len);
+       if(len<(size_t)n){
+          if(fread(s,1,len,input)!=len)return(-1);
+          s[len]=0;
+       }
+       else{
+          if(fread(s,1,n-1,input)!=(size_t)(n-1))return(-1);
+          s[n-1]=0;
+          if(fseek(input,(long)(len-(n-1)),SEEK_CUR)!=0)return(-1);
+       }
+    }
+
+    return(0);
+}
+
+/************************************************************/
@@ -0,0 +1,69 @@
+#ifndef __socket_trace_h
+#define __socket_trace_h
+
+/* socket_trace.h
+
+   A trace of every command send_command() sent to the camera and
+   telescope controllers and the reply it got, with the times. The
+   scheduler records one when SOCKET_TRACE_RECORD names a file, and
+   answers its commands from one, with no hardware, when
+   SOCKET_TRACE_REPLAY does (see socket_trace.c).
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define SOCKET_TRACE_RECORD_ENV "SOCKET_TRACE_RECORD" /* file to record the commands to */
+#define SOCKET_TRACE_REPLAY_ENV "SOCKET_TRACE_REPLAY" /* file to replay the replies from */
+#define SOCKET_TRACE_SPEED_ENV "SOCKET_TRACE_SPEED" /* replay on the system clock, this many times faster than recorded */
+
+#define SOCKET_TRACE_MAGIC "LS4TRACE"
+#define SOCKET_TRACE_VERSION 1
+#define SOCKET_TRACE_SEARCH 2000 /* records looked ahead for a reply recorded after the time asked */
+#define SOCKET_TRACE_MAX_CURSORS 256 /* port and first word pairs replayed */
+#define SOCKET_TRACE_WORD_LEN 32 /* first words longer than this are cut */
+
+#define SOCKET_TRACE_OFF 0
+#define SOCKET_TRACE_RECORDING 1
+#define SOCKET_TRACE_REPLAYING 2
+
+/* the file is a header, then a record for each command, each followed
+   by command_len bytes of command and reply_len bytes of reply */
+
+typedef struct {
+    char magic[8]; /* SOCKET_TRACE_MAGIC */
+    int32_t version; /* SOCKET_TRACE_VERSION */
+    int32_t record_size; /* sizeof(Socket_Trace_Record) of the recording build */
+    double t_start; /* unix time the recording started */
+} Socket_Trace_Header;
+
+typedef struct {
+    double t_send; /* sec after t_start the command was sent */
+    float latency; /* sec from sending the command to having the reply */
+    int32_t port;
+    int16_t status; /* what send_command() returned */
+    uint16_t command_len;
+    uint16_t reply_len;
+} Socket_Trace_Record;
+
+int init_socket_trace();
+
+int open_socket_trace(char *file_name, int mode, double speed);
+
+void close_socket_trace();
+
+int socket_trace_mode();
+
+int record_command(char *command, char *reply, int port, int status,
+        double t_send, double t_reply);
+
+int replay_command(char *command, char *reply, int port);
+
+int read_socket_trace_header(FILE *input, Socket_Trace_Header *header);
+
+int read_socket_trace_record(FILE *input, Socket_Trace_Record *r, char *command,
+        char *reply, int n);
+
+#endif
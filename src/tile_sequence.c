@@ -0,0 +1,436 @@
+/* tile_sequence.c
+
+   2026 Oct 14
+
+   Write a sequence of sky fields, ready for load_sequence(), straight
+   from a tiling, with the declination, galactic latitude, ecliptic
+   latitude and visibility cuts made as the tiles go by.
+
+   make_sequence fills a fixed grid of MAX_GRID_POINTS, and the
+   latitude cuts are separate passes over its output. Here the tiles
+   are generated (or read) TILE_BATCH at a time, each batch is cut with
+   the batched forms of sky_window.c (the sines and cosines of dec
+   worked out once per tile, then the latitudes and hour angle limits in
+   loops over contiguous arrays), and the tiles that pass are written
+   before the next batch is made. So there is no limit on the number of
+   tiles, and the memory used is the same for a thousand or millions.
+
+   The tilings are
+
+      grid ra1 ra2 dec1 dec2 step
+         rings of dec from dec1 to dec2 (deg) every step (deg), with the
+         tiles of each ring step/cos(dec) apart in ra from ra1 to ra2
+         (deg), so each covers about the same area. A full circle in ra
+         is split evenly.
+
+      list [file|-]
+         the positions in file (or the standard input): lines of ra and
+         dec in deg, with anything after them (a probability, a name)
+         kept as the comment of the field. Lines starting with # are
+         skipped.
+
+   and the cuts
+
+      -d dec_min dec_max    declination (deg), MIN_DEC to MAX_DEC by default
+      -g gal_lat_min        |galactic latitude| at least this (deg)
+      -e ecl_lat_min ecl_lat_max  |ecliptic latitude| in this range (deg)
+      -v year month day     up for long enough on this night, as for
+                            init_fields() at the DEFAULT site: inside
+                            MAX_AIRMASS and MAX_HOURANGLE for the time
+                            to make all n_required exposures
+
+   and the fields are written as
+
+      ra(hours) dec(deg) Y expt interval n_required survey_code # t<index> [comment]
+
+   with -x expt (sec, 60), -i interval (sec, 1800), -n n_required (3)
+   and -s survey_code (1). With -p each tile is followed by its pair,
+   RA_STEP0 hours further in ra (as in make_sequence). -V prints the
+   number of tiles each cut took out to stderr.
+
+   syntax: tile_sequence [options] grid ra1 ra2 dec1 dec2 step
+           tile_sequence [options] list [file|-]
+*/
+
+#include "scheduler.h"
+#include <sys/time.h>
+
+#define TILE_BATCH 4096 /* tiles made and cut at a time */
+#define TILE_COMMENT_LEN 128 /* room for the comment of a listed position */
+
+/* where the tiling has got to */
+
+typedef struct {
+    int list; /* 1 to read positions, 0 for a grid */
+    FILE *input;
+    double ra1,ra2,dec1,dec2,step; /* the grid (deg) */
+    int full_circle;
+    double dec; /* ring being made */
+    int n_ra,k; /* tiles in the ring, next one */
+    int done;
+} Tiling;
+
+/* one batch of tiles */
+
+typedef struct {
+    int n;
+    double ra[TILE_BATCH]; /* hours */
+    double dec[TILE_BATCH];
+    double sin_dec[TILE_BATCH];
+    double cos_dec[TILE_BATCH];
+    double work[TILE_BATCH]; /* latitudes, then hour angle limits */
+    char keep[TILE_BATCH];
+    char comment[TILE_BATCH][TILE_COMMENT_LEN];
+} Tile_Batch;
+
+/* the cuts, and what they took out */
+
+typedef struct {
+    double dec_min,dec_max;
+    int gal_cut;
+    double gal_lat_min;
+    int ecl_cut;
+    double ecl_lat_min,ecl_lat_max;
+    int vis_cut;
+    Night_Times nt;
+    Site_Params site;
+    double time_required; /* hours */
+    long n_tiles,n_dec,n_gal,n_ecl,n_vis,n_written;
+} Tile_Cuts;
+
+Tile_Batch batch;
+
+/************************************************************/
+
+static void syntax()
+{
+    fprintf(stderr,"syntax: tile_sequence [options] grid ra1 ra2 dec1 dec2 step\n");
+    fprintf(stderr,"        tile_sequence [options] list [file|-]\n");
+    fprintf(stderr,"options: -d dec_min dec_max  -g gal_lat_min  -e ecl_lat_min ecl_lat_max\n");
+    fprintf(stderr,"         -v year month day  -x expt  -i interval  -n n_required\n");
+    fprintf(stderr,"         -s survey_code  -p  -V\n");
+    exit(-1);
+}
+
+/************************************************************/
+
+/* set up the ring of the grid at t->dec */
+
+static void start_ring(Tiling *t)
+{
+    double c,span;
+
+    c=cos(t->dec/DEG_IN_RADIAN);
+    span=t->ra2-t->ra1;
+
+    if(t->full_circle){
+       t->n_ra=(int)ceil(360.0*c/t->step-1.0e-9);
+    }
+    else{
+       t->n_ra=1+(int)floor(span*c/t->step+1.0e-9);
+    }
+    if(t->n_ra<1)t->n_ra=1;
+    t->k=0;
+}
+
+/************************************************************/
+
+/* fill b with the next tiles of t. Return the number, 0 at the end */
+
+static int next_tiles(Tiling *t, Tile_Batch *b)
+{
+    char string[STR_BUF_LEN],*s,*end;
+    double ra,dec,c;
+    size_t len;
+
+    b->n=0;
+    while(b->n<TILE_BATCH&&!t->done){
+
+       if(t->list){
+          if(fgets(string,STR_BUF_LEN,t->input)==NULL){
+             t->done=1;
+             break;
+          }
+          if(string[0]=='#'||string[0]=='\n')continue;
+          ra=strtod(string,&end);
+          if(end==string)continue;
+          s=end;
+          dec=strtod(s,&end);
+          if(end==s)continue;
+          while(*end==' '||*end=='\t')end++;
+          len=strcspn(end,"\n");
+          if(len>TILE_COMMENT_LEN-1)len=TILE_COMMENT_LEN-1;
+          memcpy(b->comment[b->n],end,len);
+          b->comment[b->n][len]=0;
+       }
+       else{
+          if(t->k>=t->n_ra){
+             t->dec=t->dec+t->step;
+             if(t->dec>t->dec2+1.0e-9){
+                t->done=1;
+                break;
+             }
+             start_ring(t);
+          }
+          if(t->full_circle){
+             ra=t->ra1+t->k*360.0/t->n_ra;
+          }
+          else{
+             c=cos(t->dec/DEG_IN_RADIAN);
+             ra=t->ra1+(c>0.0 ? t->k*t->step/c : 0.0);
+          }
+          dec=t->dec;
+          t->k++;
+          b->comment[b->n][0]=0;
+       }
+
+       ra=fmod(ra,360.0);
+       if(ra<0.0)ra=ra+360.0;
+       b->ra[b->n]=ra/15.0;
+       b->dec[b->n]=dec;
+       b->n++;
+    }
+
+    return(b->n);
+}
+
+/************************************************************/
+
+/* mark the tiles of b that pass the cuts */
+
+static void cut_tiles(Tile_Batch *b, Tile_Cuts *c)
+{
+    double lst,jd_rise,jd_set;
+    int i;
+
+    for(i=0;i<b->n;i++){
+       b->keep[i]=(b->dec[i]>=c->dec_min&&b->dec[i]<=c->dec_max);
+       if(!b->keep[i])c->n_dec++;
+       b->sin_dec[i]=sin(b->dec[i]/DEG_IN_RADIAN);
+       b->cos_dec[i]=cos(b->dec[i]/DEG_IN_RADIAN);
+    }
+    c->n_tiles+=b->n;
+
+    if(c->gal_cut){
+       get_galactic_latitudes(b->n,b->ra,b->sin_dec,b->cos_dec,b->work);
+       for(i=0;i<b->n;i++){
+          if(b->keep[i]&&fabs(b->work[i])<c->gal_lat_min){
+             b->keep[i]=0;
+             c->n_gal++;
+          }
+       }
+    }
+
+    if(c->ecl_cut){
+       get_ecliptic_latitudes(b->n,b->ra,b->sin_dec,b->cos_dec,b->work);
+       for(i=0;i<b->n;i++){
+          if(b->keep[i]&&(fabs(b->work[i])<c->ecl_lat_min||fabs(b->work[i])>c->ecl_lat_max)){
+             b->keep[i]=0;
+             c->n_ecl++;
+          }
+       }
+    }
+
+    /* up for the time to make all the exposures, as init_fields() has it */
+
+    if(c->vis_cut){
+       get_ha_limits(b->n,b->sin_dec,b->cos_dec,c->site.lat,MAX_AIRMASS,
+          MAX_HOURANGLE,b->work);
+       for(i=0;i<b->n;i++){
+          if(!b->keep[i])continue;
+          jd_rise=get_jd_rise_in_window(b->ra[i],b->work[i],&c->nt,&lst);
+          jd_set=get_jd_set_in_window(b->ra[i],b->work[i],&c->nt,&lst);
+          if(jd_rise<0.0||jd_set<0.0||(jd_set-jd_rise)*24.0<c->time_required){
+             b->keep[i]=0;
+             c->n_vis++;
+          }
+       }
+    }
+}
+
+/************************************************************/
+
+/* write the tiles of b that passed the cuts, numbered from first */
+
+static void write_tiles(Tile_Batch *b, Tile_Cuts *c, long first, double expt,
+        double interval, int n_required, int survey_code, int pairs)
+{
+    double ra;
+    int i;
+
+    for(i=0;i<b->n;i++){
+       if(!b->keep[i])continue;
+
+       fprintf(stdout,"%10.6f %10.5f Y %6.1f %7.1f %d %d # t%ld%s%s\n",
+          b->ra[i],b->dec[i],expt,interval,n_required,survey_code,first+i,
+          b->comment[i][0] ? " " : "",b->comment[i]);
+       c->n_written++;
+
+       if(pairs){
+          ra=b->ra[i]+RA_STEP0/b->cos_dec[i];
+          if(ra>=24.0)ra=ra-24.0;
+          fprintf(stdout,"%10.6f %10.5f Y %6.1f %7.1f %d %d # t%ld pair\n",
+             ra,b->dec[i],expt,interval,n_required,survey_code,first+i);
+          c->n_written++;
+       }
+    }
+}
+
+/************************************************************/
+
+/* set up the night of year month day at the DEFAULT site for the
+   visibility cut. load_site() announces the site on the standard
+   output, which is the sequence here, so it goes to stderr instead */
+
+static void init_visibility(Tile_Cuts *c, int year, int month, int day)
+{
+    struct date_time date;
+    int saved;
+
+    fflush(stdout);
+    saved=dup(1);
+    dup2(2,1);
+
+    init_overhead_model(&overhead_model);
+
+    strcpy(c->site.site_name,"DEFAULT");
+    load_site(&c->site.longit,&c->site.lat,&c->site.stdz,&c->site.use_dst,
+       c->site.zone_name,&c->site.zabr,&c->site.elevsea,&c->site.elev,
+       &c->site.horiz,c->site.site_name);
+
+    memset((void *)&date,0,sizeof(date));
+    date.y=year;
+    date.mo=month;
+    date.d=day;
+    init_night(date,&c->nt,&c->site,0);
+
+    fflush(stdout);
+    dup2(saved,1);
+    close(saved);
+}
+
+/************************************************************/
+
+int main(int argc, char **argv)
+{
+    Tiling t;
+    Tile_Cuts c;
+    double expt,interval,dt;
+    int i,n,n_required,survey_code,pairs,report,year,month,day;
+    long first;
+    struct timeval t0,t1;
+
+    memset((void *)&t,0,sizeof(t));
+    memset((void *)&c,0,sizeof(c));
+    c.dec_min=MIN_DEC;
+    c.dec_max=MAX_DEC;
+    expt=60.0;
+    interval=1800.0;
+    n_required=3;
+    survey_code=1;
+    pairs=0;
+    report=0;
+    year=0;
+    month=0;
+    day=0;
+
+    for(i=1;i<argc&&argv[i][0]=='-'&&argv[i][1]!=0;i++){
+       if(strcmp(argv[i],"-d")==0&&i+2<argc){
+          c.dec_min=atof(argv[++i]);
+          c.dec_max=atof(argv[++i]);
+       }
+       else if(strcmp(argv[i],"-g")==0&&i+1<argc){
+          c.gal_cut=1;
+          c.gal_lat_min=atof(argv[++i]);
+       }
+       else if(strcmp(argv[i],"-e")==0&&i+2<argc){
+          c.ecl_cut=1;
+          c.ecl_lat_min=atof(argv[++i]);
+          c.ecl_lat_max=atof(argv[++i]);
+       }
+       else if(strcmp(argv[i],"-v")==0&&i+3<argc){
+          c.vis_cut=1;
+          year=atoi(argv[++i]);
+          month=atoi(argv[++i]);
+          day=atoi(argv[++i]);
+       }
+       else if(strcmp(argv[i],"-x")==0&&i+1<argc)expt=atof(argv[++i]);
+       else if(strcmp(argv[i],"-i")==0&&i+1<argc)interval=atof(argv[++i]);
+       else if(strcmp(argv[i],"-n")==0&&i+1<argc)n_required=atoi(argv[++i]);
+       else if(strcmp(argv[i],"-s")==0&&i+1<argc)survey_code=atoi(argv[++i]);
+       else if(strcmp(argv[i],"-p")==0)pairs=1;
+       else if(strcmp(argv[i],"-V")==0)report=1;
+       else syntax();
+    }
+
+    if(i>=argc)syntax();
+
+    if(strcmp(argv[i],"grid")==0){
+       if(i+6!=argc)syntax();
+       t.ra1=atof(argv[i+1]);
+       t.ra2=atof(argv[i+2]);
+       t.dec1=atof(argv[i+3]);
+       t.dec2=atof(argv[i+4]);
+       t.step=atof(argv[i+5]);
+       if(t.step<=0.0||t.dec2<t.dec1){
+          fprintf(stderr,"tile_sequence: bad grid\n");
+          exit(-1);
+       }
+       if(t.ra2<t.ra1)t.ra2=t.ra2+360.0;
+       t.full_circle=(t.ra2-t.ra1>=360.0-1.0e-9);
+       t.dec=t.dec1;
+       start_ring(&t);
+    }
+    else if(strcmp(argv[i],"list")==0){
+       if(i+2<argc)syntax();
+       t.list=1;
+       if(i+1==argc||strcmp(argv[i+1],"-")==0){
+          t.input=stdin;
+       }
+       else{
+          t.input=fopen(argv[i+1],"r");
+          if(t.input==NULL){
+             fprintf(stderr,"tile_sequence: can't open file %s\n",argv[i+1]);
+             exit(-1);
+          }
+       }
+    }
+    else{
+       syntax();
+    }
+
+    if(n_required<1||interval<0.0||expt<0.0){
+       fprintf(stderr,"tile_sequence: bad exposure parameters\n");
+       exit(-1);
+    }
+
+    if(c.vis_cut){
+       init_visibility(&c,year,month,day);
+       c.time_required=(n_required-1)*interval/3600.0+
+          execution_time(SKY_CODE,expt/3600.0);
+    }
+
+    gettimeofday(&t0,NULL);
+
+    first=0;
+    while((n=next_tiles(&t,&batch))>0){
+       cut_tiles(&batch,&c);
+       write_tiles(&batch,&c,first,expt,interval,n_required,survey_code,pairs);
+       first=first+n;
+    }
+    fflush(stdout);
+
+    gettimeofday(&t1,NULL);
+    dt=(t1.tv_sec-t0.tv_sec)+1.0e-6*(t1.tv_usec-t0.tv_usec);
+
+    if(report){
+       fprintf(stderr,"tile_sequence: %ld tiles, cut %ld dec, %ld galactic, %ld ecliptic, %ld visibility. %ld fields written in %.3f sec\n",
+          c.n_tiles,c.n_dec,c.n_gal,c.n_ecl,c.n_vis,c.n_written,dt);
+    }
+
+    if(t.list&&t.input!=stdin)fclose(t.input);
+
+    exit(0);
+}
+
+/************************************************************/
@@ -0,0 +1,173 @@
+/* weather_timeline.c
+
+   Each line of a weather file gives an interval when the dome is open,
+
+      x x x t_on x duration
+
+   with t_on the ut day of year + ut/24 (days) and duration in hours.
+   check_weather() used to rewind the file for every check and read
+   lines until it reached the first interval ending at or after the
+   time asked for; the weather was clear if the time was inside that
+   interval. That is a running maximum of the interval ends, so with
+   the file read once here, and the running maximum kept with it, the
+   same interval is found by binary search. Any order of lines, and
+   lines that do not scan, give the same answers as the old scan.
+
+   2026 Oct 14
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "weather_timeline.h"
+
+#define WEATHER_LINE_LEN 1024 /* longest line read at once, as check_weather() did */
+#define WEATHER_INITIAL_INTERVALS 1024 /* intervals allocated before growing */
+
+/************************************************************/
+
+/* Read all of input into w, leaving input at the end of the file.
+   Return the number of lines read, or -1 if there is no room */
+
+int load_weather_timeline(FILE *input, Weather_Timeline *w)
+{
+    char string[WEATHER_LINE_LEN],s[256];
+    double t_on,duration,*p;
+    int max;
+
+    memset((void *)w,0,sizeof(Weather_Timeline));
+
+    max=WEATHER_INITIAL_INTERVALS;
+    w->t_on=(double *)malloc(3*max*sizeof(double));
+    if(w->t_on==NULL){
+       fprintf(stderr,"load_weather_timeline: can't allocate %d intervals\n",max);
+       fflush(stderr);
+       return(-1);
+    }
+    w->t_off=w->t_on+max;
+    w->t_max=w->t_off+max;
+
+    /* before the first line is read the interval is empty, at t=0 */
+
+    t_on=0.0;
+    duration=0.0;
+    w->t_on[0]=0.0;
+    w->t_off[0]=0.0;
+    w->t_max[0]=0.0;
+    w->n=1;
+
+    rewind(input);
+
+    while(fgets(string,WEATHER_LINE_LEN,input)!=NULL){
+
+       if(w->n==max){
+          p=(double *)malloc(6*max*sizeof(double));
+          if(p==NULL){
+             fprintf(stderr,"load_weather_timeline: can't allocate %d intervals\n",2*max);
+             fflush(stderr);
+             free_weather_timeline(w);
+             return(-1);
+          }
+          memcpy((void *)p,(void *)w->t_on,max*sizeof(double));
+          memcpy((void *)(p+2*max),(void *)w->t_off,max*sizeof(double));
+          memcpy((void *)(p+4*max),(void *)w->t_max,max*sizeof(double));
+          free(w->t_on);
+          max=2*max;
+          w->t_on=p;
+          w->t_off=p+max;
+          w->t_max=p+2*max;
+       }
+
+       /* a line that does not scan leaves the values of the line before,
+          as it did when the file was scanned for each check */
+
+       sscanf(string,"%s %s %s %lf %s %lf",s,s,s,&t_on,s,&duration);
+       duration=duration/24.0;
+
+       w->t_on[w->n]=t_on;
+       w->t_off[w->n]=t_on+duration;
+       w->t_max[w->n]=w->t_max[w->n-1];
+       if(w->t_off[w->n]>w->t_max[w->n])w->t_max[w->n]=w->t_off[w->n];
+       w->n++;
+    }
+
+    return(w->n-1);
+}
+
+/************************************************************/
+
+void free_weather_timeline(Weather_Timeline *w)
+{
+    if(w->t_on!=NULL)free(w->t_on);
+    memset((void *)w,0,sizeof(Weather_Timeline));
+}
+
+/************************************************************/
+
+/* index of the first interval ending at or after t, or of the last
+   interval if none does */
+
+static int find_interval(Weather_Timeline *w, double t)
+{
+    int lo,hi,mid;
+
+    lo=0;
+    hi=w->n-1;
+    if(w->t_max[hi]<t)return(hi);
+
+    while(lo<hi){
+       mid=(lo+hi)/2;
+       if(w->t_max[mid]>=t){
+          hi=mid;
+       }
+       else{
+          lo=mid+1;
+       }
+    }
+
+    return(lo);
+}
+
+/************************************************************/
+
+/* Return 0 if the dome is open at t, 1 if not */
+
+int weather_timeline_bad(Weather_Timeline *w, double t)
+{
+    int i;
+
+    if(w->n<1)return(1);
+
+    i=find_interval(w,t);
+
+    if(t>=w->t_on[i]&&t<=w->t_off[i]){
+       return(0);
+    }
+    else{
+       return(1);
+    }
+}
+
+/************************************************************/
+
+/* Return the time the dome next opens at or after t (t itself if it is
+   open at t), or -1 if it does not open again */
+
+double weather_timeline_clears(Weather_Timeline *w, double t)
+{
+    int i;
+
+    if(w->n<1)return(-1.0);
+
+    i=find_interval(w,t);
+
+    /* inside the interval found if t is at or after its start, and
+       otherwise in the gap before it. If no interval ends after t the
+       weather is bad for good */
+
+    if(w->t_off[i]<t)return(-1.0);
+    if(t>=w->t_on[i])return(t);
+
+    return(w->t_on[i]);
+}
+
+/************************************************************/
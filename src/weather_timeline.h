@@ -0,0 +1,32 @@
+#ifndef __weather_timeline_h
+#define __weather_timeline_h
+
+/* weather_timeline.h
+
+   The weather file (the times the dome is open) read once into arrays,
+   for check_weather() (scheduler_core.c) in
+   place of rereading the file for every check.
+
+   2026 Oct 14
+*/
+
+#include <stdio.h>
+
+/* Times are in days: ut day of year + ut/24, as in the weather file */
+
+typedef struct {
+    int n; /* intervals, including the empty one before the first line */
+    double *t_on; /* start of each interval the dome is open */
+    double *t_off; /* end of each interval */
+    double *t_max; /* latest t_off of this and all earlier intervals */
+} Weather_Timeline;
+
+int load_weather_timeline(FILE *input, Weather_Timeline *w);
+
+void free_weather_timeline(Weather_Timeline *w);
+
+int weather_timeline_bad(Weather_Timeline *w, double t);
+
+double weather_timeline_clears(Weather_Timeline *w, double t);
+
+#endif
@@ -254,6 +254,82 @@ def test_refraction():
         compare_values(f"Refraction at {alt}°", refr_orig, refr_py, tolerance=0.0001, unit="deg")
 
 
+def test_batch_visibility():
+    """Test the batched visibility calculations against the per-field ones"""
+    print("\n" + "="*70)
+    print("TESTING BATCHED VISIBILITY")
+    print("="*70)
+    
+    import time
+    import numpy as np
+    
+    jd_start = astro_py.julian_date(2025, 10, 3, 23, 30, 0)
+    jd_end = jd_start + 0.4
+    ra = np.array([0.0, 5.5, 12.0, 18.5, 21.0, 2.0])
+    dec = np.array([-89.0, -5.0, -30.0, -60.0, 45.0, 80.0])
+    min_altitude = 30.0
+    
+    # Coordinates, field by field and all at once
+    print("\nGalactic coordinates:")
+    l_batch, b_batch = astro_py.batch_galactic_coordinates(ra, dec)
+    for i in range(len(ra)):
+        l, b = astro_py.galactic_coordinates(ra[i], dec[i])
+        compare_values(f"b of RA={ra[i]}h Dec={dec[i]}", b, b_batch[i], tolerance=1e-6, unit="deg")
+    
+    # Altitudes on the grid, against altitude_azimuth() at the same LST
+    print("\nAltitudes at the start of the night:")
+    alt = astro_py.batch_altitudes(ra, dec, [jd_start], LA_SILLA_LONGITUDE, LA_SILLA_LATITUDE)
+    lst_start = astro_py.lst(jd_start, LA_SILLA_LONGITUDE)
+    for i in range(len(ra)):
+        alt_single, az = astro_py.altitude_azimuth(ra[i], dec[i], lst_start, LA_SILLA_LATITUDE)
+        compare_values(f"Alt of RA={ra[i]}h Dec={dec[i]}", alt_single, alt[i, 0],
+                       tolerance=0.5, unit="deg")
+    
+    # The field is at the threshold at each interpolated crossing, in every window
+    print("\nWindows above 30 deg:")
+    vis = astro_py.batch_visibility(ra, dec, jd_start, jd_end,
+                                    LA_SILLA_LONGITUDE, LA_SILLA_LATITUDE, min_altitude)
+    for i in range(len(ra)):
+        if not np.isfinite(vis['rise_jd'][i]):
+            print(f"  RA={ra[i]}h Dec={dec[i]}: never above {min_altitude} deg "
+                  f"(max {vis['max_altitude'][i]:.1f})")
+            continue
+        for rise_jd, set_jd in zip(vis['window_rise_jd'][i], vis['window_set_jd'][i]):
+            if not np.isfinite(rise_jd):
+                break
+            for name, t in (("rise", rise_jd), ("set", set_jd)):
+                if jd_start < t < jd_end:
+                    a = astro_py.batch_altitudes(ra[i:i+1], dec[i:i+1], [t],
+                                                 LA_SILLA_LONGITUDE, LA_SILLA_LATITUDE)[0, 0]
+                    compare_values(f"Alt at {name} RA={ra[i]}h Dec={dec[i]}", min_altitude, a,
+                                   tolerance=0.1, unit="deg")
+    
+    # Against rise_set_times() clamped to the night, as Scheduler._get_rise_set() does,
+    # for the fields that rise after the start of the night
+    print("\nWindows against rise_set_times():")
+    for i in range(len(ra)):
+        if not (np.isfinite(vis['rise_jd'][i]) and vis['rise_jd'][i] > jd_start):
+            continue
+        rise_jd, set_jd = astro_py.rise_set_times(ra[i], dec[i], jd_start,
+                                                  LA_SILLA_LONGITUDE, LA_SILLA_LATITUDE,
+                                                  min_altitude)
+        if set_jd is not None and set_jd > jd_end:
+            set_jd = jd_end
+        compare_values(f"Rise RA={ra[i]}h Dec={dec[i]}", rise_jd, vis['rise_jd'][i],
+                       tolerance=2.0/1440, unit="JD")
+        compare_values(f"Set RA={ra[i]}h Dec={dec[i]}", set_jd, vis['set_jd'][i],
+                       tolerance=2.0/1440, unit="JD")
+    
+    # Timing for a large sequence
+    n = 5000
+    ra_many = np.linspace(0.0, 24.0, n, endpoint=False)
+    dec_many = np.linspace(-80.0, 20.0, n)
+    t0 = time.time()
+    astro_py.batch_visibility(ra_many, dec_many, jd_start, jd_end,
+                              LA_SILLA_LONGITUDE, LA_SILLA_LATITUDE, min_altitude)
+    print(f"\nBatched visibility of {n} fields: {time.time() - t0:.2f} sec")
+
+
 def main():
     """Main test function"""
     print("\n" + "="*70)
@@ -278,6 +354,7 @@ def main():
     test_twilight_times()
     test_altitude_azimuth()
     test_refraction()
+    test_batch_visibility()
     
     print("\n" + "="*70)
     print(" All comparison tests completed!")